@@ -429,7 +429,7 @@ AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource,
     return &mapInfo[nId];
 }
 
-void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
+void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
 {
     AssertLockHeld(cs);
 
@@ -589,7 +589,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
         // stochastic test: previous nRefCount == N: 2^N times harder to increase it
         if (pinfo->nRefCount > 0) {
             const int nFactor{1 << pinfo->nRefCount};
-            if (insecure_rand.randrange(nFactor) != 0) return false;
+            if (WITH_LOCK(m_rng_mutex, return insecure_rand.randrange(nFactor)) != 0) return false;
         }
     } else {
         pinfo = Create(addr, source, &nId);
@@ -712,7 +712,7 @@ void AddrManImpl::Attempt_(const CService& addr, bool fCountFailure, NodeSeconds
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::unordered_set<Network>& networks) const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     if (vRandom.empty()) return {};
 
@@ -744,7 +744,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::
     } else if (new_count == 0) {
         search_tried = true;
     } else {
-        search_tried = insecure_rand.randbool();
+        search_tried = WITH_LOCK(m_rng_mutex, return insecure_rand.randbool());
     }
 
     const int bucket_count{search_tried ? ADDRMAN_TRIED_BUCKET_COUNT : ADDRMAN_NEW_BUCKET_COUNT};
@@ -753,8 +753,12 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::
     double chance_factor = 1.0;
     while (1) {
         // Pick a bucket, and an initial position in that bucket.
-        int bucket = insecure_rand.randrange(bucket_count);
-        int initial_position = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
+        int bucket, initial_position;
+        {
+            LOCK(m_rng_mutex);
+            bucket = insecure_rand.randrange(bucket_count);
+            initial_position = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
+        }
 
         // Iterate over the positions of that bucket, starting at the initial one,
         // and looping around.
@@ -782,7 +786,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::
         const AddrInfo& info{it_found->second};
 
         // With probability GetChance() * chance_factor, return the entry.
-        if (insecure_rand.randbits<30>() < chance_factor * info.GetChance() * (1 << 30)) {
+        if (WITH_LOCK(m_rng_mutex, return insecure_rand.randbits<30>()) < chance_factor * info.GetChance() * (1 << 30)) {
             LogDebug(BCLog::ADDRMAN, "Selected %s from %s\n", info.ToStringAddrPort(), search_tried ? "tried" : "new");
             return {info, info.m_last_try};
         }
@@ -794,7 +798,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::
 
 nid_type AddrManImpl::GetEntry(bool use_tried, size_t bucket, size_t position) const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     if (use_tried) {
         if (Assume(position < ADDRMAN_BUCKET_SIZE) && Assume(bucket < ADDRMAN_TRIED_BUCKET_COUNT)) {
@@ -811,7 +815,7 @@ nid_type AddrManImpl::GetEntry(bool use_tried, size_t bucket, size_t position) c
 
 std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct, std::optional<Network> network, const bool filtered) const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     size_t nNodes = vRandom.size();
     if (max_pct != 0) {
@@ -821,17 +825,22 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
         nNodes = std::min(nNodes, max_addresses);
     }
 
-    // gather a list of random nodes, skipping those of low quality
+    // gather a list of random nodes, skipping those of low quality. The
+    // shuffle works on a copy of vRandom so that concurrent readers holding
+    // cs shared never modify shared state, and with its own random context
+    // seeded from insecure_rand, so that m_rng_mutex is not held throughout.
     const auto now{Now<NodeSeconds>()};
     std::vector<CAddress> addresses;
     addresses.reserve(nNodes);
-    for (unsigned int n = 0; n < vRandom.size(); n++) {
+    std::vector<nid_type> random_ids{vRandom};
+    FastRandomContext rng{WITH_LOCK(m_rng_mutex, return insecure_rand.rand256())};
+    for (unsigned int n = 0; n < random_ids.size(); n++) {
         if (addresses.size() >= nNodes)
             break;
 
-        int nRndPos = insecure_rand.randrange(vRandom.size() - n) + n;
-        SwapRandom(n, nRndPos);
-        const auto it{mapInfo.find(vRandom[n])};
+        int nRndPos = rng.randrange(random_ids.size() - n) + n;
+        std::swap(random_ids[n], random_ids[nRndPos]);
+        const auto it{mapInfo.find(random_ids[n])};
         assert(it != mapInfo.end());
 
         const AddrInfo& ai{it->second};
@@ -850,7 +859,7 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
 
 std::vector<std::pair<AddrInfo, AddressPosition>> AddrManImpl::GetEntries_(bool from_tried) const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     const int bucket_count = from_tried ? ADDRMAN_TRIED_BUCKET_COUNT : ADDRMAN_NEW_BUCKET_COUNT;
     std::vector<std::pair<AddrInfo, AddressPosition>> infos;
@@ -979,7 +988,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision_()
     std::set<nid_type>::iterator it = m_tried_collisions.begin();
 
     // Selects a random element from m_tried_collisions
-    std::advance(it, insecure_rand.randrange(m_tried_collisions.size()));
+    std::advance(it, WITH_LOCK(m_rng_mutex, return insecure_rand.randrange(m_tried_collisions.size())));
     nid_type id_new = *it;
 
     // If id_new not found in mapInfo remove it from m_tried_collisions
@@ -1023,7 +1032,7 @@ std::optional<AddressPosition> AddrManImpl::FindAddressEntry_(const CAddress& ad
 
 size_t AddrManImpl::Size_(std::optional<Network> net, std::optional<bool> in_new) const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     if (!net.has_value()) {
         if (in_new.has_value()) {
@@ -1045,11 +1054,11 @@ size_t AddrManImpl::Size_(std::optional<Network> net, std::optional<bool> in_new
 
 void AddrManImpl::Check() const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     // Run consistency checks 1 in m_consistency_check_ratio times if enabled
     if (m_consistency_check_ratio == 0) return;
-    if (insecure_rand.randrange(m_consistency_check_ratio) >= 1) return;
+    if (WITH_LOCK(m_rng_mutex, return insecure_rand.randrange(m_consistency_check_ratio)) >= 1) return;
 
     const int err{CheckAddrman()};
     if (err) {
@@ -1060,7 +1069,7 @@ void AddrManImpl::Check() const
 
 int AddrManImpl::CheckAddrman() const
 {
-    AssertLockHeld(cs);
+    AssertSharedLockHeld(cs);
 
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
         strprintf("new %i, tried %i, total %u", nNew, nTried, vRandom.size()), BCLog::ADDRMAN);
@@ -1165,7 +1174,7 @@ int AddrManImpl::CheckAddrman() const
 
 size_t AddrManImpl::Size(std::optional<Network> net, std::optional<bool> in_new) const
 {
-    LOCK(cs);
+    READ_LOCK(cs);
     Check();
     auto ret = Size_(net, in_new);
     Check();
@@ -1217,7 +1226,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision()
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::Select(bool new_only, const std::unordered_set<Network>& networks) const
 {
-    LOCK(cs);
+    READ_LOCK(cs);
     Check();
     auto addrRet = Select_(new_only, networks);
     Check();
@@ -1226,7 +1235,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select(bool new_only, const std::u
 
 std::vector<CAddress> AddrManImpl::GetAddr(size_t max_addresses, size_t max_pct, std::optional<Network> network, const bool filtered) const
 {
-    LOCK(cs);
+    READ_LOCK(cs);
     Check();
     auto addresses = GetAddr_(max_addresses, max_pct, network, filtered);
     Check();
@@ -1235,7 +1244,7 @@ std::vector<CAddress> AddrManImpl::GetAddr(size_t max_addresses, size_t max_pct,
 
 std::vector<std::pair<AddrInfo, AddressPosition>> AddrManImpl::GetEntries(bool from_tried) const
 {
-    LOCK(cs);
+    READ_LOCK(cs);
     Check();
     auto addrInfos = GetEntries_(from_tried);
     Check();
@@ -0,0 +1,96 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <util/check.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Block connection as seen by the coin database during IBD: every flush writes the outputs
+ * of the new blocks and deletes the coins they spent, after the cache missed on reading them.
+ * Each iteration reads and spends 2000 coins that were flushed earlier, creates 3000, and
+ * flushes.
+ */
+static void CoinsStoreFlush(benchmark::Bench& bench, CoinsBackend backend)
+{
+    FastRandomContext det_rand{true};
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    CCoinsViewDB db{{.path = testing_setup->m_args.GetDataDirNet() / "coins_bench", .cache_bytes = 8 << 20, .memory_only = false, .wipe_data = true},
+                    {.backend = backend}};
+
+    std::vector<COutPoint> unspent;
+    const auto add_coins{[&](CCoinsViewCache& cache, int count) {
+        for (int i{0}; i < count; ++i) {
+            const COutPoint outpoint{Txid::FromUint256(det_rand.rand256()), uint32_t(det_rand.randrange(3))};
+            CScript script;
+            script << OP_0 << det_rand.randbytes(20);
+            cache.AddCoin(outpoint, Coin{CTxOut{int64_t(det_rand.randrange(100'000'000)), script}, 1, false}, /*possible_overwrite=*/false);
+            unspent.push_back(outpoint);
+        }
+    }};
+    {
+        CCoinsViewCache cache{&db};
+        add_coins(cache, 100'000);
+        cache.SetBestBlock(det_rand.rand256());
+        Assert(cache.Flush());
+    }
+
+    bench.run([&] {
+        CCoinsViewCache cache{&db};
+        for (int i{0}; i < 2000; ++i) {
+            const size_t pos{det_rand.randrange(unspent.size())};
+            Assert(cache.SpendCoin(unspent[pos]));
+            unspent[pos] = unspent.back();
+            unspent.pop_back();
+        }
+        add_coins(cache, 3000);
+        cache.SetBestBlock(det_rand.rand256());
+        Assert(cache.Flush());
+    });
+}
+
+/** Cache misses on random unspent outputs, as when validating transactions of a new block. */
+static void CoinsStoreRead(benchmark::Bench& bench, CoinsBackend backend)
+{
+    FastRandomContext det_rand{true};
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    CCoinsViewDB db{{.path = testing_setup->m_args.GetDataDirNet() / "coins_bench", .cache_bytes = 8 << 20, .memory_only = false, .wipe_data = true},
+                    {.backend = backend}};
+
+    std::vector<COutPoint> unspent;
+    {
+        CCoinsViewCache cache{&db};
+        for (int i{0}; i < 200'000; ++i) {
+            const COutPoint outpoint{Txid::FromUint256(det_rand.rand256()), 0};
+            cache.AddCoin(outpoint, Coin{CTxOut{1, CScript() << OP_0 << det_rand.randbytes(20)}, 1, false}, /*possible_overwrite=*/false);
+            unspent.push_back(outpoint);
+        }
+        cache.SetBestBlock(det_rand.rand256());
+        Assert(cache.Flush());
+    }
+
+    bench.batch(1000).unit("coin").run([&] {
+        for (int i{0}; i < 1000; ++i) {
+            Assert(db.GetCoin(unspent[det_rand.randrange(unspent.size())]));
+        }
+    });
+}
+
+static void CoinsStoreFlushLevelDB(benchmark::Bench& bench) { CoinsStoreFlush(bench, CoinsBackend::LEVELDB); }
+static void CoinsStoreFlushHashStore(benchmark::Bench& bench) { CoinsStoreFlush(bench, CoinsBackend::HASHSTORE); }
+static void CoinsStoreReadLevelDB(benchmark::Bench& bench) { CoinsStoreRead(bench, CoinsBackend::LEVELDB); }
+static void CoinsStoreReadHashStore(benchmark::Bench& bench) { CoinsStoreRead(bench, CoinsBackend::HASHSTORE); }
+
+BENCHMARK(CoinsStoreFlushLevelDB, benchmark::PriorityLevel::LOW);
+BENCHMARK(CoinsStoreFlushHashStore, benchmark::PriorityLevel::LOW);
+BENCHMARK(CoinsStoreReadLevelDB, benchmark::PriorityLevel::LOW);
+BENCHMARK(CoinsStoreReadHashStore, benchmark::PriorityLevel::LOW);
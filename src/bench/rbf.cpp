@@ -0,0 +1,98 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/amount.h>
+#include <kernel/cs_main.h>
+#include <policy/feerate.h>
+#include <policy/policy.h>
+#include <policy/rbf.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/check.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+static void AddTx(const CTransactionRef& tx, CAmount fee, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
+{
+    LockPoints lp;
+    pool.addUnchecked(CTxMemPoolEntry(tx, fee, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
+                                      /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
+}
+
+static CTransactionRef MakeTx(const std::vector<COutPoint>& prevouts, size_t num_outputs)
+{
+    CMutableTransaction tx;
+    for (const auto& prevout : prevouts) {
+        tx.vin.emplace_back(prevout);
+        tx.vin.back().scriptSig = CScript() << OP_1;
+    }
+    tx.vout.resize(num_outputs);
+    for (auto& out : tx.vout) {
+        out.scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        out.nValue = COIN;
+    }
+    return MakeTransactionRef(tx);
+}
+
+/**
+ * Replacement storm against a large transaction tree: a root with as many descendants as a
+ * replacement may evict, and a stream of replacement attempts for the root with random fees,
+ * most of which cannot pay for what they would replace. Each attempt runs the fee and count
+ * checks of MemPoolAccept::ReplacementChecks().
+ */
+static void RbfReplacementStorm(benchmark::Bench& bench, bool precheck)
+{
+    FastRandomContext det_rand{true};
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    CTxMemPool& pool = *testing_setup->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+
+    // Root with 3 outputs; every descendant spends one output of a random earlier tree member.
+    std::vector<COutPoint> unspent;
+    const auto root{MakeTx({COutPoint{Txid::FromUint256(det_rand.rand256()), 0}}, 3)};
+    AddTx(root, 10'000, pool);
+    for (uint32_t i = 0; i < 3; ++i) unspent.emplace_back(root->GetHash(), i);
+    while (pool.size() < MAX_REPLACEMENT_CANDIDATES) {
+        const size_t pick{det_rand.randrange(unspent.size())};
+        const COutPoint prevout{unspent[pick]};
+        unspent.erase(unspent.begin() + pick);
+        const auto tx{MakeTx({prevout}, 2)};
+        AddTx(tx, 1'000 + det_rand.randrange(100'000), pool);
+        for (uint32_t i = 0; i < 2; ++i) unspent.emplace_back(tx->GetHash(), i);
+    }
+    const auto root_it{*Assert(pool.GetIter(root->GetHash()))};
+    const CTxMemPool::setEntries direct_conflicts{root_it};
+    const auto replacement{MakeTx({root->vin[0].prevout}, 1)};
+    const int64_t replacement_vsize{GetVirtualTransactionSize(*replacement)};
+    const CAmount tree_fees{root_it->GetModFeesWithDescendants()};
+
+    uint64_t accepted{0};
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        // One in 16 attempts pays enough to replace the tree.
+        const CAmount fees{det_rand.randrange(16) == 0 ? tree_fees + 1'000'000 : static_cast<CAmount>(det_rand.randrange(tree_fees))};
+        const uint256& txid{replacement->GetHash()};
+        if (PaysMoreThanConflicts(direct_conflicts, CFeeRate(fees, replacement_vsize), txid)) return;
+        if (precheck && PaysForRBFLowerBound(pool, direct_conflicts, fees, replacement_vsize, pool.m_opts.incremental_relay_feerate, txid)) return;
+        CTxMemPool::setEntries all_conflicts;
+        if (GetEntriesForConflicts(*replacement, pool, direct_conflicts, all_conflicts)) return;
+        CAmount conflicting_fees{0};
+        for (const auto& it : all_conflicts) conflicting_fees += it->GetModifiedFee();
+        if (PaysForRBF(conflicting_fees, fees, replacement_vsize, pool.m_opts.incremental_relay_feerate, txid)) return;
+        ++accepted;
+    });
+    assert(accepted > 0);
+}
+
+static void RbfReplacementStormPrecheck(benchmark::Bench& bench) { RbfReplacementStorm(bench, /*precheck=*/true); }
+static void RbfReplacementStormNoPrecheck(benchmark::Bench& bench) { RbfReplacementStorm(bench, /*precheck=*/false); }
+
+BENCHMARK(RbfReplacementStormPrecheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(RbfReplacementStormNoPrecheck, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,68 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <util/vecset.h>
+
+#include <cassert>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Compare VecSet against std::set for the access pattern of mempool entry
+// parents/children: fill the set, look elements up, then remove them in
+// sorted order (the worst case for VecSet, as every erase shifts the tail).
+
+static std::vector<uint64_t> RandomValues(size_t count)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<uint64_t> values(count);
+    for (auto& value : values) value = rng.rand64();
+    return values;
+}
+
+template <typename Set, size_t N>
+static void SetInsertEraseFront(benchmark::Bench& bench)
+{
+    const auto values{RandomValues(N)};
+    bench.batch(N).unit("elem").run([&] {
+        Set set;
+        for (const auto value : values) set.insert(value);
+        while (!set.empty()) set.erase(set.begin());
+    });
+}
+
+template <typename Set, size_t N>
+static void SetFind(benchmark::Bench& bench)
+{
+    const auto values{RandomValues(N)};
+    const Set set(values.begin(), values.end());
+    size_t found{0};
+    bench.batch(N).unit("elem").run([&] {
+        for (const auto value : values) found += set.count(value);
+    });
+    assert(found > 0);
+}
+
+#define VECSET_BENCH(name, size)                                                       \
+    static void VecSet##name##size(benchmark::Bench& bench)                            \
+    {                                                                                  \
+        Set##name<VecSet<uint64_t>, size>(bench);                                      \
+    }                                                                                  \
+    BENCHMARK(VecSet##name##size, benchmark::PriorityLevel::HIGH);                     \
+    static void StdSet##name##size(benchmark::Bench& bench)                            \
+    {                                                                                  \
+        Set##name<std::set<uint64_t>, size>(bench);                                    \
+    }                                                                                  \
+    BENCHMARK(StdSet##name##size, benchmark::PriorityLevel::HIGH);
+
+// 25 is the default ancestor/descendant count limit, which bounds the size of
+// these sets for standard transactions; 1000 shows the behaviour past that.
+VECSET_BENCH(InsertEraseFront, 4)
+VECSET_BENCH(InsertEraseFront, 25)
+VECSET_BENCH(InsertEraseFront, 1000)
+VECSET_BENCH(Find, 4)
+VECSET_BENCH(Find, 25)
+VECSET_BENCH(Find, 1000)
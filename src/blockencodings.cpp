@@ -15,8 +15,18 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <array>
 #include <unordered_map>
 
+namespace {
+/** Number of mempool short IDs computed per SipHashUint256Batch call in InitData. */
+constexpr size_t SHORTID_BATCH_SIZE{256};
+/** Number of bits in the short ID prefilter used by InitData. Must be a power of two. */
+constexpr size_t SHORTID_FILTER_SIZE{1 << 16};
+static_assert((SHORTID_FILTER_SIZE & (SHORTID_FILTER_SIZE - 1)) == 0);
+} // namespace
+
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, const uint64_t nonce) :
         nonce(nonce),
         shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
@@ -104,32 +114,51 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     if (shorttxids.size() != cmpctblock.shorttxids.size())
         return READ_STATUS_FAILED; // Short ID collision
 
+    // Cheap prefilter on the low bits of the block's short IDs, so that the vast
+    // majority of mempool transactions (which are not in the block) are rejected
+    // without a hash table lookup.
+    std::vector<bool> shortid_filter(SHORTID_FILTER_SIZE);
+    for (const uint64_t shortid : cmpctblock.shorttxids) {
+        shortid_filter[shortid & (SHORTID_FILTER_SIZE - 1)] = true;
+    }
+
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
-    for (const auto& tx : pool->txns_randomized) {
-        uint64_t shortid = cmpctblock.GetShortID(tx->GetWitnessHash());
-        std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
-        if (idit != shorttxids.end()) {
-            if (!have_txn[idit->second]) {
-                txn_available[idit->second] = tx;
-                have_txn[idit->second]  = true;
-                mempool_count++;
-            } else {
-                // If we find two mempool txn that match the short id, just request it.
-                // This should be rare enough that the extra bandwidth doesn't matter,
-                // but eating a round-trip due to FillBlock failure would be annoying
-                if (txn_available[idit->second]) {
-                    txn_available[idit->second].reset();
-                    mempool_count--;
+    // Short IDs are salted per block, so they cannot be indexed ahead of time. Instead hash the
+    // mempool's contiguous wtxid array in batches, and only touch the transactions themselves
+    // for candidates that match.
+    const std::vector<uint256>& wtxids = pool->wtxids_randomized;
+    std::array<uint64_t, SHORTID_BATCH_SIZE> batch_shortids;
+    for (size_t batch_start = 0; batch_start < wtxids.size() && mempool_count < shorttxids.size(); batch_start += SHORTID_BATCH_SIZE) {
+        const size_t batch_size = std::min(SHORTID_BATCH_SIZE, wtxids.size() - batch_start);
+        SipHashUint256Batch(cmpctblock.shorttxidk0, cmpctblock.shorttxidk1,
+                            Span{wtxids}.subspan(batch_start, batch_size), batch_shortids);
+        for (size_t i = 0; i < batch_size; i++) {
+            uint64_t shortid = batch_shortids[i] & 0xffffffffffffL;
+            if (!shortid_filter[shortid & (SHORTID_FILTER_SIZE - 1)]) continue;
+            std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
+            if (idit != shorttxids.end()) {
+                if (!have_txn[idit->second]) {
+                    txn_available[idit->second] = pool->txns_randomized[batch_start + i];
+                    have_txn[idit->second]  = true;
+                    mempool_count++;
+                } else {
+                    // If we find two mempool txn that match the short id, just request it.
+                    // This should be rare enough that the extra bandwidth doesn't matter,
+                    // but eating a round-trip due to FillBlock failure would be annoying
+                    if (txn_available[idit->second]) {
+                        txn_available[idit->second].reset();
+                        mempool_count--;
+                    }
                 }
             }
+            // Though ideally we'd continue scanning for the two-txn-match-shortid case,
+            // the performance win of an early exit here is too good to pass up and worth
+            // the extra risk.
+            if (mempool_count == shorttxids.size())
+                break;
         }
-        // Though ideally we'd continue scanning for the two-txn-match-shortid case,
-        // the performance win of an early exit here is too good to pass up and worth
-        // the extra risk.
-        if (mempool_count == shorttxids.size())
-            break;
     }
     }
 
@@ -182,6 +182,7 @@ public:
     }
 
     bool HasThreads() const { return !m_worker_threads.empty(); }
+    size_t WorkerThreadCount() const { return m_worker_threads.size(); }
 };
 
 /**
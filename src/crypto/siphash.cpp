@@ -5,6 +5,7 @@
 #include <crypto/siphash.h>
 
 #include <bit>
+#include <cassert>
 
 #define SIPROUND do { \
     v0 += v1; v1 = std::rotl(v1, 13); v1 ^= v0; \
@@ -92,9 +93,9 @@ uint64_t CSipHasher::Finalize() const
     return v0 ^ v1 ^ v2 ^ v3;
 }
 
-uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val)
+namespace {
+inline uint64_t SipHashUint256Impl(uint64_t k0, uint64_t k1, const uint256& val)
 {
-    /* Specialized implementation for efficiency */
     uint64_t d = val.GetUint64(0);
 
     uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
@@ -131,6 +132,30 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val)
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+} // namespace
+
+uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val)
+{
+    /* Specialized implementation for efficiency */
+    return SipHashUint256Impl(k0, k1, val);
+}
+
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, Span<const uint256> vals, Span<uint64_t> out)
+{
+    assert(out.size() >= vals.size());
+    // The inputs are independent, so unrolling lets the compiler interleave
+    // the rounds of several hashes and hide their latency.
+    size_t i = 0;
+    for (; i + 4 <= vals.size(); i += 4) {
+        out[i] = SipHashUint256Impl(k0, k1, vals[i]);
+        out[i + 1] = SipHashUint256Impl(k0, k1, vals[i + 1]);
+        out[i + 2] = SipHashUint256Impl(k0, k1, vals[i + 2]);
+        out[i + 3] = SipHashUint256Impl(k0, k1, vals[i + 3]);
+    }
+    for (; i < vals.size(); ++i) {
+        out[i] = SipHashUint256Impl(k0, k1, vals[i]);
+    }
+}
 
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra)
 {
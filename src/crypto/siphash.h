@@ -43,6 +43,13 @@ public:
  *      .Finalize()
  */
 uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val);
+/** Compute SipHashUint256(k0, k1, vals[i]) into out[i] for every element of vals.
+ *
+ *  Hashing a contiguous array in one call avoids per-element pointer chasing
+ *  and lets independent hashes be computed in an interleaved fashion.
+ *  out must be at least as large as vals.
+ */
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, Span<const uint256> vals, Span<uint64_t> out);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra);
 
 #endif // BITCOIN_CRYPTO_SIPHASH_H
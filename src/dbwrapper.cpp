@@ -9,9 +9,11 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <tinyformat.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
+#include <util/string.h>
 
 #include <algorithm>
 #include <cassert>
@@ -134,12 +136,14 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBOptions& db_options)
 {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.write_buffer_size = db_options.write_buffer_size.value_or(nCacheSize / 4); // up to two write buffers may be held in memory simultaneously
+    options.filter_policy = db_options.bloom_filter_bits > 0 ? leveldb::NewBloomFilterPolicy(db_options.bloom_filter_bits) : nullptr;
+    options.block_size = db_options.block_size;
+    options.max_file_size = db_options.max_file_size;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -147,7 +151,11 @@ static leveldb::Options GetOptions(size_t nCacheSize)
         // on corruption in later versions.
         options.paranoid_checks = true;
     }
-    SetMaxOpenFiles(&options);
+    if (db_options.max_open_files) {
+        options.max_open_files = *db_options.max_open_files;
+    } else {
+        SetMaxOpenFiles(&options);
+    }
     return options;
 }
 
@@ -219,14 +227,15 @@ struct LevelDBContext {
 };
 
 CDBWrapper::CDBWrapper(const DBParams& params)
-    : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
+    : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only},
+      m_cache_bytes{params.cache_bytes}, m_bloom_filter_bits{params.options.bloom_filter_bits}
 {
     DBContext().penv = nullptr;
     DBContext().readoptions.verify_checksums = true;
     DBContext().iteroptions.verify_checksums = true;
     DBContext().iteroptions.fill_cache = false;
     DBContext().syncoptions.sync = true;
-    DBContext().options = GetOptions(params.cache_bytes);
+    DBContext().options = GetOptions(params.cache_bytes, params.options);
     DBContext().options.create_if_missing = true;
     if (params.memory_only) {
         DBContext().penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -316,6 +325,61 @@ size_t CDBWrapper::DynamicMemoryUsage() const
     return parsed.value();
 }
 
+DBStats CDBWrapper::GetStats() const
+{
+    const leveldb::Options& options{DBContext().options};
+    DBStats stats;
+    stats.memory_usage = DynamicMemoryUsage();
+    stats.cache_bytes = m_cache_bytes;
+    stats.bloom_filter_bits = m_bloom_filter_bits;
+    stats.block_size = options.block_size;
+    stats.write_buffer_size = options.write_buffer_size;
+    stats.max_file_size = options.max_file_size;
+    stats.max_open_files = options.max_open_files;
+
+    // The number of table files of each level. LevelDB reports no property for levels
+    // past the last one.
+    std::string num_files;
+    while (DBContext().pdb->GetProperty(strprintf("leveldb.num-files-at-level%u", stats.levels.size()), &num_files)) {
+        stats.levels.emplace_back().files = ToIntegral<int>(num_files).value_or(0);
+    }
+
+    // The size of the table files, from their index blocks. Every key starts with a prefix
+    // byte below 0xff, so this range covers the whole database.
+    const leveldb::Range full_range{leveldb::Slice{}, leveldb::Slice{"\xff", 1}};
+    DBContext().pdb->GetApproximateSizes(&full_range, 1, &stats.approximate_bytes);
+
+    // Compaction totals, as rows of "<level> <files> <size MB> <time sec> <read MB> <write MB>" after a header.
+    std::string compactions;
+    if (DBContext().pdb->GetProperty("leveldb.stats", &compactions)) {
+        for (const std::string& line : util::SplitString(compactions, '\n')) {
+            std::vector<std::string> fields;
+            for (const std::string& field : util::SplitString(line, ' ')) {
+                if (!field.empty()) fields.push_back(field);
+            }
+            if (fields.size() != 6) continue;
+            const auto level{ToIntegral<size_t>(fields[0])};
+            const auto seconds{ToIntegral<int64_t>(fields[3])};
+            const auto read_mb{ToIntegral<uint64_t>(fields[4])};
+            const auto written_mb{ToIntegral<uint64_t>(fields[5])};
+            if (!level || !seconds || !read_mb || !written_mb) continue;
+            if (*level >= stats.levels.size()) stats.levels.resize(*level + 1);
+            stats.levels[*level].compaction_time = std::chrono::seconds{*seconds};
+            stats.levels[*level].compaction_read_bytes = *read_mb << 20;
+            stats.levels[*level].compaction_written_bytes = *written_mb << 20;
+        }
+    }
+
+    for (size_t level{0}; level < stats.levels.size(); ++level) {
+        if (level == 0) {
+            stats.read_amplification += stats.levels[level].files;
+        } else if (stats.levels[level].files > 0) {
+            ++stats.read_amplification;
+        }
+    }
+    return stats;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
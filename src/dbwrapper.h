@@ -12,7 +12,9 @@
 #include <util/check.h>
 #include <util/fs.h>
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <optional>
@@ -27,6 +29,41 @@ static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Bits per key of the bloom filter of each table, 0 for no filter.
+    int bloom_filter_bits = 10;
+    //! Size of uncompressed data packed into one table block.
+    size_t block_size = 4 << 10;
+    //! Size of the memtable written out as a level 0 table. Defaults to a quarter of the cache.
+    std::optional<size_t> write_buffer_size;
+    //! Size at which compaction starts a new table file.
+    size_t max_file_size = 2 << 20;
+    //! Number of table files kept open. Defaults to the LevelDB default, or 64 on 32-bit Unix.
+    std::optional<int> max_open_files;
+};
+
+//! LevelDB statistics of a database, see CDBWrapper::GetStats().
+struct DBStats {
+    struct Level {
+        int files{0};
+        //! Totals of the compactions that wrote to this level.
+        std::chrono::microseconds compaction_time{0};
+        uint64_t compaction_read_bytes{0};
+        uint64_t compaction_written_bytes{0};
+    };
+    std::vector<Level> levels;
+    //! Approximate size of the table files of all levels.
+    uint64_t approximate_bytes{0};
+    //! Tables a lookup of a missing key may have to search: each level 0 table, which
+    //! can overlap, and one table of every other non-empty level.
+    int read_amplification{0};
+    size_t memory_usage{0};
+    //! The options the database was opened with.
+    size_t cache_bytes{0};
+    int bloom_filter_bits{0};
+    size_t block_size{0};
+    size_t write_buffer_size{0};
+    size_t max_file_size{0};
+    int max_open_files{0};
 };
 
 //! Application-specific storage settings.
@@ -205,6 +242,10 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
+    //! options reported by GetStats() that LevelDB does not keep
+    const size_t m_cache_bytes;
+    const int m_bloom_filter_bits;
+
     std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
@@ -275,6 +316,9 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    //! Report the table layout, compaction totals and options of the database.
+    DBStats GetStats() const;
+
     CDBIterator* NewIterator();
 
     /**
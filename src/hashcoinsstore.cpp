@@ -0,0 +1,667 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hashcoinsstore.h>
+
+#include <coins.h>
+#include <crypto/siphash.h>
+#include <dbwrapper.h>
+#include <hash.h>
+#include <logging.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <serialize.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/fs_helpers.h>
+#include <util/thread.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <system_error>
+#include <tuple>
+
+namespace {
+constexpr uint32_t MANIFEST_VERSION{1};
+constexpr uint8_t RECORD_PUT{'P'};
+constexpr uint8_t RECORD_DEL{'D'};
+//! Record type, outpoint and value length.
+constexpr uint32_t RECORD_HEADER_SIZE{1 + 32 + 4 + 4};
+//! Amount of a segment that garbage collection copies per lock acquisition.
+constexpr uint64_t GC_CHUNK_BYTES{1 << 20};
+const fs::path LOCK_FILE{".lock"};
+
+fs::path ManifestPath(const fs::path& dir) { return dir / "HASHSTORE"; }
+
+fs::path SegmentPath(const fs::path& dir, uint32_t id)
+{
+    return dir / fs::u8path(strprintf("seg%06u.dat", id));
+}
+
+std::optional<uint32_t> SegmentId(const fs::path& file)
+{
+    const std::string name{fs::PathToString(file.filename())};
+    unsigned int id;
+    if (std::sscanf(name.c_str(), "seg%u.dat", &id) != 1 || name != strprintf("seg%06u.dat", id)) return std::nullopt;
+    return id;
+}
+
+bool IsLevelDBFile(const fs::path& file)
+{
+    const std::string name{fs::PathToString(file.filename())};
+    const std::string ext{fs::PathToString(file.extension())};
+    return name == "CURRENT" || name == "LOCK" || name == "LOG" || name == "LOG.old" ||
+           name.starts_with("MANIFEST-") || ext == ".ldb" || ext == ".log" || ext == ".sst" || ext == ".dbtmp";
+}
+
+void SerializeRecord(DataStream& out, uint8_t type, const COutPoint& outpoint, Span<const std::byte> value)
+{
+    out << type << outpoint << uint32_t(value.size());
+    out.write(value);
+}
+
+/** Iterates over the index entries as of its creation, reading from its own file handles. */
+class HashCoinsCursor final : public CCoinsViewCursor
+{
+public:
+    struct Entry {
+        COutPoint outpoint;
+        std::shared_ptr<HashCoinsStore::Segment> segment;
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::vector<Entry> m_entries;
+    size_t m_pos{0};
+    mutable std::unordered_map<const HashCoinsStore::Segment*, std::unique_ptr<AutoFile>> m_files;
+
+    explicit HashCoinsCursor(const uint256& best_block) : CCoinsViewCursor{best_block} {}
+
+    bool GetKey(COutPoint& key) const override
+    {
+        if (!Valid()) return false;
+        key = m_entries[m_pos].outpoint;
+        return true;
+    }
+
+    bool GetValue(Coin& coin) const override;
+
+    bool Valid() const override { return m_pos < m_entries.size(); }
+    void Next() override { ++m_pos; }
+};
+} // namespace
+
+struct HashCoinsStore::Segment {
+    const uint32_t id;
+    const unsigned int partition;
+    const fs::path path;
+    AutoFile file;
+    //! Bytes appended so far. The manifest records this as the committed size.
+    uint64_t size{0};
+    //! Bytes of the put records the index points to and of the delete records of tombstones.
+    uint64_t live_bytes{0};
+    //! Appended to since the last sync.
+    bool dirty{false};
+    //! Picked by garbage collection.
+    bool collecting{false};
+    //! Removed from the manifest. The file is deleted once the last user lets go.
+    bool dropped{false};
+
+    Segment(uint32_t id_in, unsigned int partition_in, fs::path path_in, std::FILE* file_in)
+        : id{id_in}, partition{partition_in}, path{std::move(path_in)}, file{file_in} {}
+
+    ~Segment()
+    {
+        file.fclose();
+        if (dropped) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+};
+
+bool HashCoinsCursor::GetValue(Coin& coin) const
+{
+    if (!Valid()) return false;
+    const Entry& entry{m_entries[m_pos]};
+    auto& file{m_files[entry.segment.get()]};
+    if (!file) {
+        file = std::make_unique<AutoFile>(fsbridge::fopen(entry.segment->path, "rb"));
+        if (file->IsNull()) return false;
+    }
+    try {
+        std::vector<std::byte> value(entry.size - RECORD_HEADER_SIZE);
+        file->seek(entry.offset + RECORD_HEADER_SIZE, SEEK_SET);
+        file->read(value);
+        SpanReader{MakeUCharSpan(value)} >> coin;
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+class HashCoinsStore::HashBatch final : public CoinsStore::Batch
+{
+public:
+    struct Op {
+        COutPoint outpoint;
+        bool put;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    const HashCoinsStore& m_store;
+    std::array<DataStream, PARTITIONS> m_data;
+    std::array<std::vector<Op>, PARTITIONS> m_ops;
+    std::optional<uint256> m_best_block;
+    std::optional<std::vector<uint256>> m_head_blocks;
+    size_t m_size{0};
+
+    explicit HashBatch(const HashCoinsStore& store) : m_store{store} {}
+
+    void WriteCoin(const COutPoint& outpoint, const Coin& coin) override
+    {
+        DataStream value;
+        value << coin;
+        Add(outpoint, RECORD_PUT, value);
+    }
+    void EraseCoin(const COutPoint& outpoint) override { Add(outpoint, RECORD_DEL, {}); }
+    void WriteBestBlock(const uint256& hash) override { m_best_block = hash; }
+    void EraseBestBlock() override { m_best_block = uint256{}; }
+    void WriteHeadBlocks(const std::vector<uint256>& hashes) override { m_head_blocks = hashes; }
+    void EraseHeadBlocks() override { m_head_blocks = std::vector<uint256>{}; }
+    size_t SizeEstimate() const override { return m_size; }
+
+    void Clear() override
+    {
+        for (auto& data : m_data) data.clear();
+        for (auto& ops : m_ops) ops.clear();
+        m_best_block.reset();
+        m_head_blocks.reset();
+        m_size = 0;
+    }
+
+private:
+    void Add(const COutPoint& outpoint, uint8_t type, Span<const std::byte> value)
+    {
+        const unsigned int partition{m_store.PartitionOf(outpoint)};
+        DataStream& data{m_data[partition]};
+        const size_t offset{data.size()};
+        SerializeRecord(data, type, outpoint, value);
+        m_ops[partition].push_back({outpoint, type == RECORD_PUT, uint32_t(offset), uint32_t(data.size() - offset)});
+        m_size += data.size() - offset;
+    }
+};
+
+HashCoinsStore::HashCoinsStore(Options options) : m_options{std::move(options)}
+{
+    TryCreateDirectories(m_options.path);
+    if (util::LockDirectory(m_options.path, LOCK_FILE) != util::LockResult::Success) {
+        throw dbwrapper_error{strprintf("Cannot obtain a lock on directory %s", fs::PathToString(m_options.path))};
+    }
+    try {
+        LOCK(m_mutex);
+        Open();
+    } catch (...) {
+        UnlockDirectory(m_options.path, LOCK_FILE);
+        throw;
+    }
+    if (m_options.background_gc) {
+        m_gc_thread = std::thread{&util::TraceThread, "coinsgc", [this] { ThreadGarbageCollection(); }};
+    }
+}
+
+HashCoinsStore::~HashCoinsStore()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_gc_cv.notify_all();
+    if (m_gc_thread.joinable()) m_gc_thread.join();
+    WITH_LOCK(m_mutex, m_partitions = {}; m_segments.clear());
+    UnlockDirectory(m_options.path, LOCK_FILE);
+}
+
+bool HashCoinsStore::IsHashStore(const fs::path& path)
+{
+    return fs::exists(ManifestPath(path));
+}
+
+void HashCoinsStore::Wipe(const fs::path& path)
+{
+    if (!fs::exists(path)) return;
+    for (const auto& entry : fs::directory_iterator{path}) {
+        const fs::path& file{entry.path()};
+        if (file == ManifestPath(path) || file == ManifestPath(path) + ".new" || SegmentId(file)) {
+            fs::remove(file);
+        }
+    }
+}
+
+unsigned int HashCoinsStore::PartitionOf(const COutPoint& outpoint) const
+{
+    return SipHashUint256Extra(m_salt_k0, m_salt_k1, outpoint.hash.ToUint256(), outpoint.n) % PARTITIONS;
+}
+
+void HashCoinsStore::Open()
+{
+    const fs::path& dir{m_options.path};
+    if (m_options.wipe_data) {
+        LogInfo("Wiping coins hash store in %s\n", fs::PathToString(dir));
+        Wipe(dir);
+        // Also drop a LevelDB database that was previously kept here.
+        for (const auto& entry : fs::directory_iterator{dir}) {
+            if (IsLevelDBFile(entry.path())) fs::remove(entry.path());
+        }
+    }
+
+    const auto start{SteadyClock::now()};
+    if (!IsHashStore(dir)) {
+        if (fs::exists(dir / "CURRENT")) {
+            throw dbwrapper_error{strprintf("%s holds a LevelDB coins database. Restart with -coinsbackend=leveldb, or with -reindex-chainstate to rebuild it as a hash store.", fs::PathToString(dir))};
+        }
+        FastRandomContext rng;
+        m_salt_k0 = rng.rand64();
+        m_salt_k1 = rng.rand64();
+    } else {
+        AutoFile file{fsbridge::fopen(ManifestPath(dir), "rb")};
+        if (file.IsNull()) throw dbwrapper_error{strprintf("Failed to open %s", fs::PathToString(ManifestPath(dir)))};
+        std::array<std::vector<std::pair<uint32_t, uint64_t>>, PARTITIONS> partitions;
+        try {
+            HashVerifier verifier{file};
+            uint32_t version;
+            verifier >> version;
+            if (version != MANIFEST_VERSION) throw dbwrapper_error{strprintf("Unsupported coins hash store version %u", version)};
+            verifier >> m_salt_k0 >> m_salt_k1 >> m_next_segment >> m_best_block >> m_head_blocks;
+            for (auto& segments : partitions) verifier >> segments;
+            uint256 checksum;
+            file >> checksum;
+            if (checksum != verifier.GetHash()) throw dbwrapper_error{"Coins hash store manifest checksum mismatch"};
+        } catch (const std::ios_base::failure& e) {
+            throw dbwrapper_error{strprintf("Corrupted coins hash store manifest: %s", e.what())};
+        }
+
+        for (unsigned int partition{0}; partition < PARTITIONS; ++partition) {
+            for (const auto& [id, size] : partitions[partition]) {
+                const fs::path path{SegmentPath(dir, id)};
+                auto segment{std::make_shared<Segment>(id, partition, path, fsbridge::fopen(path, "rb+"))};
+                if (segment->file.IsNull()) throw dbwrapper_error{strprintf("Missing coins hash store segment %s", fs::PathToString(path))};
+                if (id >= m_next_segment || size > std::numeric_limits<uint32_t>::max()) {
+                    throw dbwrapper_error{strprintf("Corrupted coins hash store manifest entry for %s", fs::PathToString(path))};
+                }
+                // Drop whatever a batch that was not committed left behind.
+                segment->file.seek(0, SEEK_END);
+                if (uint64_t(segment->file.tell()) < size) throw dbwrapper_error{strprintf("Truncated coins hash store segment %s", fs::PathToString(path))};
+                if (uint64_t(segment->file.tell()) > size && !segment->file.Truncate(size)) {
+                    throw dbwrapper_error{strprintf("Failed to truncate %s", fs::PathToString(path))};
+                }
+                segment->size = size;
+                m_partitions[partition].segments.emplace(id, segment);
+                m_segments.emplace(id, std::move(segment));
+            }
+        }
+        for (auto& partition : m_partitions) {
+            for (auto& [id, segment] : partition.segments) Replay(*segment);
+        }
+    }
+
+    // Segments that never made it into the manifest, or that garbage collection dropped.
+    for (const auto& entry : fs::directory_iterator{dir}) {
+        if (const auto id{SegmentId(entry.path())}; id && !m_segments.contains(*id)) fs::remove(entry.path());
+    }
+    CommitManifest();
+    LogInfo("Loaded %u coins from %u segments of the coins hash store in %.2fs\n",
+            m_index.size(), m_segments.size(), Ticks<SecondsDouble>(SteadyClock::now() - start));
+}
+
+void HashCoinsStore::Replay(Segment& segment)
+{
+    try {
+        segment.file.seek(0, SEEK_SET);
+        uint64_t pos{0};
+        while (pos < segment.size) {
+            uint8_t type;
+            COutPoint outpoint;
+            uint32_t value_size;
+            segment.file >> type >> outpoint >> value_size;
+            const uint64_t size{RECORD_HEADER_SIZE + uint64_t{value_size}};
+            if (pos + size > segment.size || PartitionOf(outpoint) != segment.partition ||
+                (type != RECORD_PUT && type != RECORD_DEL)) {
+                throw dbwrapper_error{strprintf("Corrupted record at offset %u of %s", pos, fs::PathToString(segment.path))};
+            }
+            segment.file.ignore(value_size);
+            Apply(outpoint, Location{segment.id, uint32_t(pos), uint32_t(size)}, type == RECORD_PUT);
+            pos += size;
+        }
+    } catch (const std::ios_base::failure& e) {
+        throw dbwrapper_error{strprintf("Failed to read %s: %s", fs::PathToString(segment.path), e.what())};
+    }
+}
+
+void HashCoinsStore::CommitManifest()
+{
+    for (auto& [id, segment] : m_segments) {
+        if (segment->dirty) {
+            if (!segment->file.Commit()) throw dbwrapper_error{strprintf("Failed to sync %s", fs::PathToString(segment->path))};
+            segment->dirty = false;
+        }
+    }
+
+    const fs::path path{ManifestPath(m_options.path)};
+    AutoFile file{fsbridge::fopen(path + ".new", "wb")};
+    if (file.IsNull()) throw dbwrapper_error{strprintf("Failed to open %s", fs::PathToString(path + ".new"))};
+    HashedSourceWriter writer{file};
+    writer << MANIFEST_VERSION << m_salt_k0 << m_salt_k1 << m_next_segment << m_best_block << m_head_blocks;
+    for (const auto& partition : m_partitions) {
+        std::vector<std::pair<uint32_t, uint64_t>> segments;
+        for (const auto& [id, segment] : partition.segments) segments.emplace_back(id, segment->size);
+        writer << segments;
+    }
+    file << writer.GetHash();
+    if (!file.Commit() || file.fclose() != 0 || !RenameOver(path + ".new", path)) {
+        throw dbwrapper_error{strprintf("Failed to write %s", fs::PathToString(path))};
+    }
+    DirectoryCommit(m_options.path);
+}
+
+HashCoinsStore::Segment& HashCoinsStore::ActiveSegment(unsigned int partition, uint64_t append_bytes)
+{
+    auto& segments{m_partitions[partition].segments};
+    if (!segments.empty()) {
+        Segment& active{*segments.rbegin()->second};
+        if (active.size == 0 || active.size + append_bytes <= m_options.segment_bytes) return active;
+    }
+    const uint32_t id{m_next_segment++};
+    const fs::path path{SegmentPath(m_options.path, id)};
+    auto segment{std::make_shared<Segment>(id, partition, path, fsbridge::fopen(path, "wb+"))};
+    if (segment->file.IsNull()) throw dbwrapper_error{strprintf("Failed to create %s", fs::PathToString(path))};
+    segments.emplace(id, segment);
+    return *m_segments.emplace(id, std::move(segment)).first->second;
+}
+
+void HashCoinsStore::Apply(const COutPoint& outpoint, const Location& location, bool put)
+{
+    auto it{m_index.find(outpoint)};
+    if (it != m_index.end()) {
+        // The put record the index pointed to is dead from now on.
+        m_segments.at(it->second.segment)->live_bytes -= it->second.size;
+        m_live_bytes -= it->second.size;
+        ++m_tombstones[outpoint].dead_puts;
+    }
+    const auto tombstone{m_tombstones.find(outpoint)};
+    // A newer record supersedes the previous delete record.
+    if (tombstone != m_tombstones.end()) DropTombstone(tombstone->second);
+    if (put) {
+        if (it != m_index.end()) {
+            it->second = location;
+        } else {
+            m_index.emplace(outpoint, location);
+        }
+    } else {
+        if (it != m_index.end()) m_index.erase(it);
+        // Without a put record on disk, there is nothing for the delete record to hide.
+        if (tombstone == m_tombstones.end()) return;
+        tombstone->second.location = location;
+    }
+    m_segments.at(location.segment)->live_bytes += location.size;
+    m_live_bytes += location.size;
+}
+
+void HashCoinsStore::Move(const Location& from, const Location& to)
+{
+    m_segments.at(from.segment)->live_bytes -= from.size;
+    m_segments.at(to.segment)->live_bytes += to.size;
+}
+
+void HashCoinsStore::DropTombstone(Tombstone& tombstone)
+{
+    if (!tombstone.location) return;
+    m_segments.at(tombstone.location->segment)->live_bytes -= tombstone.location->size;
+    m_live_bytes -= tombstone.location->size;
+    tombstone.location.reset();
+}
+
+Coin HashCoinsStore::ReadRecord(const Location& location) const
+{
+    Segment& segment{*m_segments.at(location.segment)};
+    std::vector<std::byte> value(location.size - RECORD_HEADER_SIZE);
+    try {
+        segment.file.seek(location.offset + RECORD_HEADER_SIZE, SEEK_SET);
+        segment.file.read(value);
+        Coin coin;
+        SpanReader{MakeUCharSpan(value)} >> coin;
+        return coin;
+    } catch (const std::ios_base::failure& e) {
+        throw dbwrapper_error{strprintf("Failed to read %s: %s", fs::PathToString(segment.path), e.what())};
+    }
+}
+
+std::optional<Coin> HashCoinsStore::ReadCoin(const COutPoint& outpoint) const
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find(outpoint)};
+    if (it == m_index.end()) return std::nullopt;
+    return ReadRecord(it->second);
+}
+
+bool HashCoinsStore::HaveCoin(const COutPoint& outpoint) const
+{
+    return WITH_LOCK(m_mutex, return m_index.contains(outpoint));
+}
+
+std::optional<uint256> HashCoinsStore::ReadBestBlock() const
+{
+    LOCK(m_mutex);
+    if (m_best_block.IsNull()) return std::nullopt;
+    return m_best_block;
+}
+
+std::vector<uint256> HashCoinsStore::ReadHeadBlocks() const
+{
+    return WITH_LOCK(m_mutex, return m_head_blocks);
+}
+
+std::unique_ptr<CoinsStore::Batch> HashCoinsStore::NewBatch()
+{
+    return std::make_unique<HashBatch>(*this);
+}
+
+void HashCoinsStore::WriteBatch(Batch& base)
+{
+    auto& batch{static_cast<HashBatch&>(base)};
+    LOCK(m_mutex);
+    for (unsigned int partition{0}; partition < PARTITIONS; ++partition) {
+        const DataStream& data{batch.m_data[partition]};
+        if (data.empty()) continue;
+        Segment& segment{ActiveSegment(partition, data.size())};
+        const uint64_t base_offset{segment.size};
+        if (base_offset + data.size() > std::numeric_limits<uint32_t>::max()) {
+            throw dbwrapper_error{"Coins hash store batch too large, lower -dbbatchsize"};
+        }
+        segment.file.seek(base_offset, SEEK_SET);
+        segment.file.write(MakeByteSpan(data));
+        segment.size += data.size();
+        segment.dirty = true;
+        for (const auto& op : batch.m_ops[partition]) {
+            Apply(op.outpoint, Location{segment.id, uint32_t(base_offset + op.offset), op.size}, op.put);
+        }
+    }
+    if (batch.m_best_block) m_best_block = *batch.m_best_block;
+    if (batch.m_head_blocks) m_head_blocks = *batch.m_head_blocks;
+    CommitManifest();
+    if (m_options.background_gc) m_gc_cv.notify_one();
+}
+
+std::unique_ptr<CCoinsViewCursor> HashCoinsStore::Cursor() const
+{
+    LOCK(m_mutex);
+    auto cursor{std::make_unique<HashCoinsCursor>(m_best_block)};
+    cursor->m_entries.reserve(m_index.size());
+    for (const auto& [outpoint, location] : m_index) {
+        cursor->m_entries.push_back({outpoint, m_segments.at(location.segment), location.offset, location.size});
+    }
+    // Same order as the LevelDB store, whose keys sort by txid bytes, then by output index.
+    std::sort(cursor->m_entries.begin(), cursor->m_entries.end(), [](const auto& a, const auto& b) { return a.outpoint < b.outpoint; });
+    return cursor;
+}
+
+size_t HashCoinsStore::EstimateSize() const
+{
+    return WITH_LOCK(m_mutex, return m_live_bytes);
+}
+
+size_t HashCoinsStore::SegmentCount() const
+{
+    return WITH_LOCK(m_mutex, return m_segments.size());
+}
+
+std::shared_ptr<HashCoinsStore::Segment> HashCoinsStore::PickGarbage()
+{
+    std::shared_ptr<Segment> victim;
+    double victim_ratio{m_options.gc_live_ratio};
+    for (const auto& partition : m_partitions) {
+        if (partition.segments.size() < 2) continue;
+        for (auto it{partition.segments.begin()}; std::next(it) != partition.segments.end(); ++it) {
+            const Segment& segment{*it->second};
+            if (segment.collecting) continue;
+            const double ratio{double(segment.live_bytes) / std::max<uint64_t>(segment.size, 1)};
+            if (ratio < victim_ratio) {
+                victim = it->second;
+                victim_ratio = ratio;
+            }
+        }
+    }
+    if (victim) victim->collecting = true;
+    return victim;
+}
+
+void HashCoinsStore::CollectGarbage(std::shared_ptr<Segment> victim)
+{
+    // Dead put records of the victim. They only stop counting once the victim is dropped,
+    // so that no other collection drops their delete records while they are still on disk.
+    std::unordered_map<COutPoint, uint32_t, SaltedOutpointHasher> dropped_puts;
+    uint64_t pos{0};
+    while (true) {
+        LOCK(m_mutex);
+        if (m_stop) {
+            victim->collecting = false;
+            return;
+        }
+        if (pos >= victim->size) break;
+
+        // Copy the live records of the next chunk to the partition's active segment.
+        DataStream data;
+        std::vector<std::tuple<COutPoint, bool, uint32_t, uint32_t>> moved;
+        try {
+            victim->file.seek(pos, SEEK_SET);
+            const uint64_t end{std::min(victim->size, pos + GC_CHUNK_BYTES)};
+            while (pos < end) {
+                uint8_t type;
+                COutPoint outpoint;
+                uint32_t value_size;
+                victim->file >> type >> outpoint >> value_size;
+                std::vector<std::byte> value(value_size);
+                victim->file.read(value);
+                const uint32_t size{RECORD_HEADER_SIZE + value_size};
+                const auto at_pos{[&](const Location& location) { return location.segment == victim->id && location.offset == pos; }};
+                bool live;
+                if (type == RECORD_PUT) {
+                    const auto it{m_index.find(outpoint)};
+                    live = it != m_index.end() && at_pos(it->second);
+                    if (!live) ++dropped_puts[outpoint];
+                } else {
+                    // A delete is live while it is the latest one and put records it hides
+                    // remain outside of what this collection drops.
+                    const auto it{m_tombstones.find(outpoint)};
+                    const auto dropped{dropped_puts.find(outpoint)};
+                    live = it != m_tombstones.end() && it->second.location && at_pos(*it->second.location) &&
+                           it->second.dead_puts > (dropped == dropped_puts.end() ? 0 : dropped->second);
+                }
+                if (live) {
+                    moved.emplace_back(outpoint, type == RECORD_PUT, data.size(), size);
+                    SerializeRecord(data, type, outpoint, value);
+                }
+                pos += size;
+            }
+        } catch (const std::ios_base::failure& e) {
+            victim->collecting = false;
+            throw dbwrapper_error{strprintf("Failed to read %s: %s", fs::PathToString(victim->path), e.what())};
+        }
+        if (data.empty()) continue;
+        Segment& active{ActiveSegment(victim->partition, data.size())};
+        const uint64_t base_offset{active.size};
+        if (base_offset + data.size() > std::numeric_limits<uint32_t>::max()) {
+            victim->collecting = false;
+            throw dbwrapper_error{"Coins hash store segment too large"};
+        }
+        active.file.seek(base_offset, SEEK_SET);
+        active.file.write(MakeByteSpan(data));
+        active.size += data.size();
+        active.dirty = true;
+        for (const auto& [outpoint, put, offset, size] : moved) {
+            const Location to{active.id, uint32_t(base_offset + offset), size};
+            Location& from{put ? m_index.at(outpoint) : *m_tombstones.at(outpoint).location};
+            Move(from, to);
+            from = to;
+            if (put) {
+                // The copy left in the victim is a dead put record until the victim is dropped.
+                ++m_tombstones[outpoint].dead_puts;
+                ++dropped_puts[outpoint];
+            }
+        }
+    }
+
+    LOCK(m_mutex);
+    for (const auto& [outpoint, count] : dropped_puts) {
+        const auto it{m_tombstones.find(outpoint)};
+        if (!Assume(it != m_tombstones.end())) continue;
+        if (it->second.dead_puts > count) {
+            it->second.dead_puts -= count;
+            continue;
+        }
+        // No put record is left for the delete record to hide.
+        DropTombstone(it->second);
+        m_tombstones.erase(it);
+    }
+    Assume(victim->live_bytes == 0);
+    m_partitions[victim->partition].segments.erase(victim->id);
+    m_segments.erase(victim->id);
+    CommitManifest();
+    victim->dropped = true;
+    LogDebug(BCLog::COINDB, "Garbage collected coins hash store segment %u (%u bytes)\n", victim->id, victim->size);
+}
+
+size_t HashCoinsStore::Compact()
+{
+    size_t dropped{0};
+    while (auto victim{WITH_LOCK(m_mutex, return PickGarbage())}) {
+        CollectGarbage(std::move(victim));
+        ++dropped;
+    }
+    return dropped;
+}
+
+void HashCoinsStore::ThreadGarbageCollection()
+{
+    while (true) {
+        std::shared_ptr<Segment> victim;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_gc_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || (victim = PickGarbage()); });
+            if (m_stop) {
+                if (victim) victim->collecting = false;
+                return;
+            }
+        }
+        try {
+            CollectGarbage(std::move(victim));
+        } catch (const std::exception& e) {
+            LogError("Coins hash store garbage collection failed: %s\n", e.what());
+            return;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_HASHCOINSSTORE_H
+#define BITCOIN_HASHCOINSSTORE_H
+
+#include <sync.h>
+#include <threadsafety.h>
+#include <txdb.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <util/hasher.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Coin;
+class COutPoint;
+
+/**
+ * Coins store built for the UTXO access pattern: point lookups of random
+ * outpoints, bulk inserts of new coins and deletes of spent ones, and no range
+ * queries other than a full scan.
+ *
+ * Outpoints are hash-partitioned. Each partition appends its records to log
+ * segment files, and an in-memory index maps every unspent outpoint to the
+ * location of its record, so a lookup costs one read. Spending a coin appends
+ * a delete record. A delete record is live while a put record of the same
+ * outpoint is still on disk, as replay would otherwise revive the coin.
+ * Garbage collection copies the live records out of mostly dead segments and
+ * then drops them. This runs on a background thread.
+ *
+ * The HASHSTORE manifest file lists the segments of every partition with their
+ * committed sizes, and it holds the best block and head blocks markers. Each
+ * WriteBatch() syncs the segments and atomically replaces the manifest, so a
+ * batch is either fully visible after a crash or not at all. On open the
+ * segments are replayed to rebuild the index. The index takes roughly 80 bytes
+ * of memory per unspent output, and per spent output whose put record has not
+ * been collected yet, on top of -dbcache.
+ */
+class HashCoinsStore final : public CoinsStore
+{
+public:
+    static constexpr unsigned int PARTITIONS{16};
+    static constexpr uint64_t DEFAULT_SEGMENT_BYTES{64 << 20};
+
+    struct Options {
+        fs::path path;
+        bool wipe_data{false};
+        //! A partition starts a new segment once its active one reaches this size.
+        uint64_t segment_bytes{DEFAULT_SEGMENT_BYTES};
+        //! Segments whose fraction of live bytes drops below this are garbage collected.
+        double gc_live_ratio{0.5};
+        //! Collect garbage on a background thread. Otherwise only Compact() does.
+        bool background_gc{true};
+    };
+
+    explicit HashCoinsStore(Options options);
+    ~HashCoinsStore() override;
+
+    //! Whether path holds a hash store.
+    static bool IsHashStore(const fs::path& path);
+    //! Remove the hash store files from path.
+    static void Wipe(const fs::path& path);
+
+    std::optional<Coin> ReadCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool HaveCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::optional<uint256> ReadBestBlock() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::vector<uint256> ReadHeadBlocks() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::unique_ptr<Batch> NewBatch() override;
+    void WriteBatch(Batch& batch) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::unique_ptr<CCoinsViewCursor> Cursor() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t EstimateSize() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::optional<fs::path> StoragePath() const override { return m_options.path; }
+
+    //! Garbage collect until no segment is below the live ratio. Returns the number of segments dropped.
+    size_t Compact() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Number of segment files currently in use.
+    size_t SegmentCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    struct Segment;
+    class HashBatch;
+
+private:
+    struct Location {
+        uint32_t segment;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    //! Spent outpoint whose put records are not all collected yet.
+    struct Tombstone {
+        //! Put records of the outpoint that are on disk but no longer live
+        uint32_t dead_puts{0};
+        //! The latest delete record, unless the outpoint was added again since
+        std::optional<Location> location;
+    };
+
+    struct Partition {
+        //! Segments in write order. The last one is the active segment.
+        std::map<uint32_t, std::shared_ptr<Segment>> segments;
+    };
+
+    const Options m_options;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_gc_cv;
+    //! Partitioning salt, fixed when the store is created.
+    uint64_t m_salt_k0{0};
+    uint64_t m_salt_k1{0};
+    uint32_t m_next_segment GUARDED_BY(m_mutex){0};
+    uint256 m_best_block GUARDED_BY(m_mutex);
+    std::vector<uint256> m_head_blocks GUARDED_BY(m_mutex);
+    std::array<Partition, PARTITIONS> m_partitions GUARDED_BY(m_mutex);
+    std::unordered_map<uint32_t, std::shared_ptr<Segment>> m_segments GUARDED_BY(m_mutex);
+    std::unordered_map<COutPoint, Location, SaltedOutpointHasher> m_index GUARDED_BY(m_mutex);
+    std::unordered_map<COutPoint, Tombstone, SaltedOutpointHasher> m_tombstones GUARDED_BY(m_mutex);
+    uint64_t m_live_bytes GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_gc_thread;
+
+    unsigned int PartitionOf(const COutPoint& outpoint) const;
+    Segment& ActiveSegment(unsigned int partition, uint64_t append_bytes) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    //! Point the index at a new put record, or remove the outpoint for a delete record.
+    void Apply(const COutPoint& outpoint, const Location& location, bool put) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    //! Account for a live record that garbage collection copied to a new location.
+    void Move(const Location& from, const Location& to) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    //! Stop counting the delete record of a tombstone as live.
+    void DropTombstone(Tombstone& tombstone) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    Coin ReadRecord(const Location& location) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    void Open() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Replay(Segment& segment) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    //! Sync the segments written to and atomically replace the manifest.
+    void CommitManifest() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    //! Non-active segment with the lowest live ratio below the threshold.
+    std::shared_ptr<Segment> PickGarbage() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void CollectGarbage(std::shared_ptr<Segment> victim) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void ThreadGarbageCollection() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+#endif // BITCOIN_HASHCOINSSTORE_H
@@ -19,6 +19,8 @@
 #include <util/translation.h>
 #include <validation.h> // For g_chainman
 
+#include <deque>
+#include <future>
 #include <string>
 #include <utility>
 
@@ -43,14 +45,19 @@ CBlockLocator GetLocator(interfaces::Chain& chain, const uint256& block_hash)
     return locator;
 }
 
-BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
+BaseIndex::DB::DB(const fs::path& path, std::string_view db_name, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
     CDBWrapper{DBParams{
         .path = path,
         .cache_bytes = n_cache_size,
         .memory_only = f_memory,
         .wipe_data = f_wipe,
         .obfuscate = f_obfuscate,
-        .options = [] { DBOptions options; node::ReadDatabaseArgs(gArgs, options); return options; }()}}
+        .options = [&] {
+            DBOptions options;
+            // Invalid options were already rejected at startup, see ApplyArgsManOptions().
+            (void)node::ReadDatabaseArgs(gArgs, options, db_name);
+            return options;
+        }()}}
 {}
 
 bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
@@ -147,6 +154,9 @@ void BaseIndex::Sync()
     if (!m_synced) {
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
+        // Blocks of the active chain read ahead of the one being indexed.
+        std::deque<std::pair<const CBlockIndex*, std::future<node::BlockAndUndo>>> read_ahead;
+        const size_t read_ahead_blocks = std::max(1, 2 * m_chainstate->m_blockman.BlockReadThreads());
         while (true) {
             if (m_interrupt) {
                 LogPrintf("%s: m_interrupt set; exiting ThreadSync\n", GetName());
@@ -185,15 +195,43 @@ void BaseIndex::Sync()
             }
             pindex = pindex_next;
 
+            // Keep the read-ahead window filled, and start over after a reorg.
+            if (!read_ahead.empty() && read_ahead.front().first != pindex) read_ahead.clear();
+            if (read_ahead.size() <= read_ahead_blocks / 2) {
+                std::vector<const CBlockIndex*> upcoming;
+                {
+                    LOCK(::cs_main);
+                    const CBlockIndex* next = read_ahead.empty() ? pindex : m_chainstate->m_chain.Next(read_ahead.back().first);
+                    for (; next && read_ahead.size() + upcoming.size() < read_ahead_blocks; next = m_chainstate->m_chain.Next(next)) {
+                        upcoming.push_back(next);
+                    }
+                }
+                if (NeedsUndoData()) {
+                    auto futures = m_chainstate->m_blockman.ReadBlocksAndUndoAsync(upcoming, /*use_cache=*/false);
+                    for (size_t i = 0; i < upcoming.size(); ++i) read_ahead.emplace_back(upcoming[i], std::move(futures[i]));
+                } else {
+                    auto futures = m_chainstate->m_blockman.ReadBlocksAsync(upcoming);
+                    for (size_t i = 0; i < upcoming.size(); ++i) {
+                        read_ahead.emplace_back(upcoming[i], std::async(std::launch::deferred, [block = std::move(futures[i])]() mutable {
+                            return node::BlockAndUndo{block.get(), nullptr};
+                        }));
+                    }
+                }
+            }
 
-            CBlock block;
             interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            node::BlockAndUndo data;
+            if (!read_ahead.empty() && read_ahead.front().first == pindex) {
+                data = read_ahead.front().second.get();
+                read_ahead.pop_front();
+            }
+            if (!data.block) {
                 FatalErrorf("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             } else {
-                block_info.data = &block;
+                block_info.data = data.block.get();
+                block_info.undo_data = data.undo.get();
             }
             if (!CustomAppend(block_info)) {
                 FatalErrorf("%s: Failed to write block %s to index database",
@@ -13,6 +13,7 @@
 #include <validationinterface.h>
 
 #include <string>
+#include <string_view>
 
 class CBlock;
 class CBlockIndex;
@@ -52,7 +53,8 @@ protected:
     class DB : public CDBWrapper
     {
     public:
-        DB(const fs::path& path, size_t n_cache_size,
+        /// db_name selects the -dboption settings, see node::DATABASE_NAMES.
+        DB(const fs::path& path, std::string_view db_name, size_t n_cache_size,
            bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false);
 
         /// Read block locator of the chain that the index is in sync with.
@@ -95,6 +97,10 @@ private:
 
     virtual bool AllowPrune() const = 0;
 
+    /// Whether CustomAppend() uses the undo data of the block. Sync() then reads it
+    /// together with the block.
+    virtual bool NeedsUndoData() const { return false; }
+
     template <typename... Args>
     void FatalErrorf(util::ConstevalFormatString<sizeof...(Args)> fmt, const Args&... args);
 
@@ -162,6 +168,9 @@ public:
 
     /// Get a summary of the index and its state.
     IndexSummary GetSummary() const;
+
+    /// Get the LevelDB statistics of the index database.
+    DBStats GetDBStats() const { return GetDB().GetStats(); }
 };
 
 #endif // BITCOIN_INDEX_BASE_H
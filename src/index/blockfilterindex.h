@@ -46,6 +46,7 @@ private:
     uint256 m_last_header{};
 
     bool AllowPrune() const override { return true; }
+    bool NeedsUndoData() const override { return true; }
 
     bool Write(const BlockFilter& filter, uint32_t block_height, const uint256& filter_header);
 
@@ -41,6 +41,7 @@ private:
     [[nodiscard]] bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
 
     bool AllowPrune() const override { return true; }
+    bool NeedsUndoData() const override { return true; }
 
 protected:
     bool CustomInit(const std::optional<interfaces::BlockRef>& block) override;
@@ -6,11 +6,17 @@
 
 #include <clientversion.h>
 #include <common/args.h>
+#include <core_memusage.h>
 #include <index/disktxpos.h>
 #include <logging.h>
+#include <memusage.h>
 #include <node/blockstorage.h>
+#include <streams.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <tuple>
+
 constexpr uint8_t DB_TXINDEX{'t'};
 
 std::unique_ptr<TxIndex> g_txindex;
@@ -31,7 +37,7 @@ public:
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", "txindex", n_cache_size, f_memory, f_wipe)
 {}
 
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
@@ -67,36 +73,128 @@ bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
     }
-    return m_db->WriteTxs(vPos);
+    if (!m_db->WriteTxs(vPos)) return false;
+
+    // Transactions included again after a reorg now point to this block. Drop them only
+    // after the write, and make lookups that read the old position before it skip caching.
+    LOCK(m_tx_cache_mutex);
+    for (const auto& [tx_hash, _] : vPos) {
+        if (const auto it{m_tx_cache_map.find(tx_hash)}; it != m_tx_cache_map.end()) {
+            m_tx_cache_usage -= RecursiveDynamicUsage(it->second->second.tx);
+            m_tx_cache.erase(it->second);
+            m_tx_cache_map.erase(it);
+        }
+    }
+    ++m_tx_cache_generation;
+    return true;
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
-bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+TxIndex::FoundTx TxIndex::AddToTxCache(const uint256& tx_hash, FoundTx found) const
 {
-    CDiskTxPos postx;
-    if (!m_db->ReadTxPos(tx_hash, postx)) {
-        return false;
+    if (const auto it{m_tx_cache_map.find(tx_hash)}; it != m_tx_cache_map.end()) return it->second->second;
+    m_tx_cache.emplace_front(tx_hash, found);
+    m_tx_cache_map.emplace(tx_hash, m_tx_cache.begin());
+    m_tx_cache_usage += RecursiveDynamicUsage(found.tx);
+    while (TxCacheUsage() > TX_CACHE_BYTES) {
+        m_tx_cache_usage -= RecursiveDynamicUsage(m_tx_cache.back().second.tx);
+        m_tx_cache_map.erase(m_tx_cache.back().first);
+        m_tx_cache.pop_back();
     }
+    return found;
+}
+
+size_t TxIndex::TxCacheUsage() const
+{
+    return m_tx_cache_usage + memusage::DynamicUsage(m_tx_cache) + memusage::DynamicUsage(m_tx_cache_map);
+}
 
-    AutoFile file{m_chainstate->m_blockman.OpenBlockFile(postx, true)};
-    if (file.IsNull()) {
-        LogError("%s: OpenBlockFile failed\n", __func__);
-        return false;
+bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+{
+    const auto found{FindTxs(std::span{&tx_hash, 1})};
+    if (!found[0]) return false;
+    block_hash = found[0]->block_hash;
+    tx = found[0]->tx;
+    return true;
+}
+
+std::vector<std::optional<TxIndex::FoundTx>> TxIndex::FindTxs(std::span<const uint256> tx_hashes) const
+{
+    std::vector<std::optional<FoundTx>> result(tx_hashes.size());
+    uint64_t cache_generation;
+    {
+        LOCK(m_tx_cache_mutex);
+        cache_generation = m_tx_cache_generation;
+        for (size_t i{0}; i < tx_hashes.size(); ++i) {
+            if (const auto it{m_tx_cache_map.find(tx_hashes[i])}; it != m_tx_cache_map.end()) {
+                m_tx_cache.splice(m_tx_cache.begin(), m_tx_cache, it->second);
+                result[i] = it->second->second;
+            }
+        }
     }
-    CBlockHeader header;
-    try {
-        file >> header;
-        file.seek(postx.nTxOffset, SEEK_CUR);
-        file >> TX_WITH_WITNESS(tx);
-    } catch (const std::exception& e) {
-        LogError("%s: Deserialize or I/O error - %s\n", __func__, e.what());
-        return false;
+
+    // Read the positions of the other transactions, and sort them so that each block is
+    // opened once and the block files are read front to back.
+    std::vector<std::pair<CDiskTxPos, size_t>> reads;
+    for (size_t i{0}; i < tx_hashes.size(); ++i) {
+        CDiskTxPos pos;
+        if (!result[i] && m_db->ReadTxPos(tx_hashes[i], pos)) reads.emplace_back(pos, i);
     }
-    if (tx->GetHash() != tx_hash) {
-        LogError("%s: txid mismatch\n", __func__);
-        return false;
+    std::ranges::sort(reads, {}, [](const auto& read) { return std::tie(read.first.nFile, read.first.nPos, read.first.nTxOffset); });
+
+    node::BlockManager& blockman{m_chainstate->m_blockman};
+    for (auto group_begin{reads.begin()}; group_begin != reads.end();) {
+        const FlatFilePos block_pos{group_begin->first};
+        const auto group_end{std::find_if(group_begin, reads.end(), [&](const auto& read) { return FlatFilePos{read.first} != block_pos; })};
+        const std::span group{group_begin, group_end};
+        group_begin = group_end;
+
+        const uint64_t compression_generation{blockman.GetCompressionGeneration()};
+        AutoFile file{blockman.OpenBlockFile(block_pos, true)};
+        if (file.IsNull()) {
+            LogError("%s: OpenBlockFile failed\n", __func__);
+            continue;
+        }
+        CBlockHeader header;
+        std::vector<CTransactionRef> txs(group.size());
+        try {
+            if (const auto block_data{blockman.ReadFromCompressedFile(file, block_pos, compression_generation)}) {
+                SpanReader stream{*block_data};
+                stream >> header;
+                const size_t txs_pos{block_data->size() - stream.size()};
+                for (size_t j{0}; j < group.size(); ++j) {
+                    SpanReader tx_stream{std::span{*block_data}.subspan(std::min(block_data->size(), txs_pos + group[j].first.nTxOffset))};
+                    tx_stream >> TX_WITH_WITNESS(txs[j]);
+                }
+            } else {
+                file >> header;
+                const int64_t txs_pos{file.tell()};
+                for (size_t j{0}; j < group.size(); ++j) {
+                    file.seek(txs_pos + group[j].first.nTxOffset, SEEK_SET);
+                    file >> TX_WITH_WITNESS(txs[j]);
+                }
+            }
+        } catch (const std::exception& e) {
+            LogError("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            continue;
+        }
+
+        const uint256 block_hash{header.GetHash()};
+        LOCK(m_tx_cache_mutex);
+        for (size_t j{0}; j < group.size(); ++j) {
+            const uint256& tx_hash{tx_hashes[group[j].second]};
+            if (txs[j]->GetHash() != tx_hash) {
+                LogError("%s: txid mismatch\n", __func__);
+                continue;
+            }
+            if (m_tx_cache_generation != cache_generation) {
+                // The index was updated since the positions were read.
+                result[group[j].second] = FoundTx{block_hash, txs[j]};
+            } else {
+                result[group[j].second] = AddToTxCache(tx_hash, {block_hash, txs[j]});
+            }
+        }
     }
-    block_hash = header.GetHash();
-    return true;
+    return result;
 }
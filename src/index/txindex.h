@@ -6,6 +6,14 @@
 #define BITCOIN_INDEX_TXINDEX_H
 
 #include <index/base.h>
+#include <sync.h>
+#include <util/hasher.h>
+
+#include <list>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 static constexpr bool DEFAULT_TXINDEX{false};
 
@@ -19,13 +27,38 @@ class TxIndex final : public BaseIndex
 protected:
     class DB;
 
+public:
+    /** A transaction found in the index, together with the hash of its block. */
+    struct FoundTx {
+        uint256 block_hash;
+        CTransactionRef tx;
+    };
+
+    //! Memory used by recently found transactions kept in memory, including the
+    //! cache's own list and map nodes.
+    static constexpr size_t TX_CACHE_BYTES{8 << 20};
+
 private:
     const std::unique_ptr<DB> m_db;
 
+    //! Recently found transactions, most recently used first.
+    mutable Mutex m_tx_cache_mutex;
+    mutable std::list<std::pair<uint256, FoundTx>> m_tx_cache GUARDED_BY(m_tx_cache_mutex);
+    mutable std::unordered_map<uint256, decltype(m_tx_cache)::iterator, SaltedTxidHasher> m_tx_cache_map GUARDED_BY(m_tx_cache_mutex);
+    mutable size_t m_tx_cache_usage GUARDED_BY(m_tx_cache_mutex){0};
+    //! Bumped whenever indexed transactions move, so that lookups racing with the
+    //! index update do not cache a stale position.
+    uint64_t m_tx_cache_generation GUARDED_BY(m_tx_cache_mutex){0};
+
+    //! Cache a found transaction, and return the cached entry, which is kept if the hash was already cached.
+    FoundTx AddToTxCache(const uint256& tx_hash, FoundTx found) const EXCLUSIVE_LOCKS_REQUIRED(m_tx_cache_mutex);
+    //! Memory used by the cache, see TX_CACHE_BYTES.
+    size_t TxCacheUsage() const EXCLUSIVE_LOCKS_REQUIRED(m_tx_cache_mutex);
+
     bool AllowPrune() const override { return false; }
 
 protected:
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomAppend(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_tx_cache_mutex);
 
     BaseIndex::DB& GetDB() const override;
 
@@ -42,7 +75,13 @@ public:
     /// @param[out]  block_hash  The hash of the block the transaction is found in.
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
-    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const EXCLUSIVE_LOCKS_REQUIRED(!m_tx_cache_mutex);
+
+    /// Look up transactions by hash. Recently found transactions are served from memory. The
+    /// others are read from disk in file and position order, opening each block once.
+    ///
+    /// @return  one entry per hash, std::nullopt if the transaction is not found
+    std::vector<std::optional<FoundTx>> FindTxs(std::span<const uint256> tx_hashes) const EXCLUSIVE_LOCKS_REQUIRED(!m_tx_cache_mutex);
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
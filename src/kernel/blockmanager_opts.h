@@ -9,12 +9,18 @@
 #include <util/fs.h>
 
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 class CChainParams;
 
 namespace kernel {
 
 static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
+static constexpr bool DEFAULT_BLOCK_INDEX_SNAPSHOT{false};
+static constexpr int DEFAULT_BLOCK_READ_THREADS{4};
+static constexpr int MAX_BLOCK_READ_THREADS{64};
+static constexpr bool DEFAULT_COMPRESS_BLOCKFILES{false};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -24,9 +30,19 @@ struct BlockManagerOpts {
     const CChainParams& chainparams;
     bool use_xor{DEFAULT_XOR_BLOCKSDIR};
     uint64_t prune_target{0};
+    //! Number of most recent blocks to keep when pruning, if more than MIN_BLOCKS_TO_KEEP
+    int prune_keep_recent{0};
+    //! Inclusive height ranges of blocks that survive the pruning of their block file
+    std::vector<std::pair<int, int>> prune_keep_heights{};
     bool fast_prune{false};
     const fs::path blocks_dir;
     Notifications& notifications;
+    //! Write a flat block index snapshot at shutdown and load from it on startup
+    bool block_index_snapshot{DEFAULT_BLOCK_INDEX_SNAPSHOT};
+    //! Threads serving batched block and undo reads. 0 reads in the calling thread.
+    int block_read_threads{DEFAULT_BLOCK_READ_THREADS};
+    //! Replace old block files by compressed ones in the background
+    bool compress_block_files{DEFAULT_COMPRESS_BLOCKFILES};
 };
 
 } // namespace kernel
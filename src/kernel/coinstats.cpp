@@ -20,15 +20,22 @@
 #include <uint256.h>
 #include <util/check.h>
 #include <util/overflow.h>
+#include <util/threadpool.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
+#include <future>
 #include <iosfwd>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace kernel {
 
@@ -111,6 +118,21 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
     }
 }
 
+//! Number of coins hashed by one task of ComputeUTXOStats.
+static constexpr size_t HASH_BATCH_COINS{4096};
+//! Maximum number of threads computing the MuHash of the UTXO set.
+static constexpr unsigned MAX_MUHASH_THREADS{8};
+
+using OutputsBatch = std::vector<std::pair<Txid, std::map<uint32_t, Coin>>>;
+
+//! Hash a part of the UTXO set, to be multiplied into the MuHash of the whole set.
+static MuHash3072 HashOutputs(const OutputsBatch& batch)
+{
+    MuHash3072 muhash;
+    for (const auto& [hash, outputs] : batch) ApplyHash(muhash, hash, outputs);
+    return muhash;
+}
+
 //! Calculate statistics about the unspent transaction output set
 template <typename T>
 static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
@@ -118,6 +140,47 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
 
+    // The coins are hashed in batches on worker threads while this thread reads the set. A
+    // MuHash does not depend on the order of its elements, so consecutive ranges of the set
+    // are hashed in parallel and their hashes multiplied together. The serialized hash does,
+    // so its batches are hashed in turn by a single worker.
+    constexpr bool hashing{!std::is_same_v<T, std::nullptr_t>};
+    constexpr bool parallel{std::is_same_v<T, MuHash3072>};
+    const size_t workers{parallel ? std::clamp(std::thread::hardware_concurrency(), 1U, MAX_MUHASH_THREADS) : 1};
+    ThreadPool pool{"coinstats"};
+    if (hashing) pool.Start(workers);
+    std::deque<std::future<std::conditional_t<parallel, MuHash3072, void>>> pending;
+    const auto finish_batch{[&] {
+        if constexpr (parallel) {
+            hash_obj *= pending.front().get();
+        } else {
+            pending.front().get();
+        }
+        pending.pop_front();
+    }};
+    OutputsBatch batch;
+    size_t batch_coins{0};
+    const auto submit_batch{[&] {
+        if constexpr (parallel) {
+            pending.push_back(pool.Submit([batch = std::move(batch)] { return HashOutputs(batch); }));
+        } else {
+            pending.push_back(pool.Submit([&hash_obj, batch = std::move(batch)] {
+                for (const auto& [hash, outputs] : batch) ApplyHash(hash_obj, hash, outputs);
+            }));
+        }
+        batch.clear();
+        batch_coins = 0;
+        // Bound the memory used by coins waiting to be hashed.
+        if (pending.size() > 2 * workers) finish_batch();
+    }};
+    const auto add_outputs{[&](const Txid& hash, std::map<uint32_t, Coin>& outputs) {
+        if constexpr (hashing) {
+            batch_coins += outputs.size();
+            batch.emplace_back(hash, std::move(outputs));
+            if (batch_coins >= HASH_BATCH_COINS) submit_batch();
+        }
+    }};
+
     Txid prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
@@ -127,7 +190,7 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
                 ApplyStats(stats, prevkey, outputs);
-                ApplyHash(hash_obj, prevkey, outputs);
+                add_outputs(prevkey, outputs);
                 outputs.clear();
             }
             prevkey = key.hash;
@@ -141,8 +204,10 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
     }
     if (!outputs.empty()) {
         ApplyStats(stats, prevkey, outputs);
-        ApplyHash(hash_obj, prevkey, outputs);
+        add_outputs(prevkey, outputs);
     }
+    if (!batch.empty()) submit_batch();
+    while (!pending.empty()) finish_batch();
 
     FinalizeHash(hash_obj, stats);
 
@@ -13,6 +13,7 @@
 #include <primitives/transaction.h>
 #include <util/epochguard.h>
 #include <util/overflow.h>
+#include <util/vecset.h>
 
 #include <chrono>
 #include <functional>
@@ -66,9 +67,11 @@ class CTxMemPoolEntry
 {
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
-    // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    // two aliases, should the types ever diverge. Most entries have only a
+    // few in-mempool parents and children, so these are sorted vectors rather
+    // than node-based sets: one allocation per entry instead of one per link.
+    typedef VecSet<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
+    typedef VecSet<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
 
 private:
     CTxMemPoolEntry(const CTxMemPoolEntry&) = default;
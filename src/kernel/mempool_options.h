@@ -10,6 +10,7 @@
 #include <policy/policy.h>
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 
@@ -27,6 +28,8 @@ static constexpr bool DEFAULT_MEMPOOL_FULL_RBF{true};
 static constexpr bool DEFAULT_PERSIST_V1_DAT{false};
 /** Default for -acceptnonstdtxn */
 static constexpr bool DEFAULT_ACCEPT_NON_STD_TXN{false};
+/** Number of recent mempool changes kept for clients following the mempool */
+static constexpr size_t DEFAULT_MEMPOOL_DELTA_JOURNAL_SIZE{20'000};
 
 namespace kernel {
 /**
@@ -57,6 +60,8 @@ struct MemPoolOptions {
     bool require_standard{true};
     bool full_rbf{DEFAULT_MEMPOOL_FULL_RBF};
     bool persist_v1_dat{DEFAULT_PERSIST_V1_DAT};
+    /** Maximum number of changes kept in the delta journal, see CTxMemPool::GetDeltas() */
+    size_t delta_journal_size{DEFAULT_MEMPOOL_DELTA_JOURNAL_SIZE};
     MemPoolLimits limits{};
 
     ValidationSignals* signals{nullptr};
@@ -8,6 +8,7 @@
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
+#include <util/vecset.h>
 
 #include <cassert>
 #include <cstdlib>
@@ -90,6 +91,12 @@ static inline size_t DynamicUsage(const std::vector<X>& v)
     return MallocUsage(v.capacity() * sizeof(X));
 }
 
+template<typename X, typename Y>
+static inline size_t DynamicUsage(const VecSet<X, Y>& s)
+{
+    return MallocUsage(s.capacity() * sizeof(X));
+}
+
 template<unsigned int N, typename X, typename S, typename D>
 static inline size_t DynamicUsage(const prevector<N, X, S, D>& v)
 {
@@ -635,6 +635,11 @@ void CNode::CopyStats(CNodeStats& stats)
         stats.m_transport_type = info.transport_type;
         if (info.session_id) stats.m_session_id = HexStr(*info.session_id);
     }
+    {
+        LOCK(m_processing_time_mutex);
+        stats.m_processing_time = m_processing_time_total;
+        stats.m_processing_time_per_msg_type = m_processing_time_per_msg_type;
+    }
     X(m_permission_flags);
 
     X(m_last_ping_time);
@@ -648,6 +653,16 @@ void CNode::CopyStats(CNodeStats& stats)
 }
 #undef X
 
+void CNode::AccountForProcessingTime(const std::string& msg_type, const MsgProcessingTime& time)
+{
+    // To prevent a memory DOS, only track known message types.
+    const bool known{std::find(ALL_NET_MESSAGE_TYPES.begin(), ALL_NET_MESSAGE_TYPES.end(), msg_type) != ALL_NET_MESSAGE_TYPES.end()};
+    LOCK(m_processing_time_mutex);
+    m_processing_time_per_msg_type[known ? msg_type : NET_MESSAGE_TYPE_OTHER] += time;
+    m_processing_time_total += time;
+    m_processing_time = m_processing_time_total.total;
+}
+
 bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
 {
     complete = false;
@@ -1569,26 +1584,46 @@ Transport::Info V2Transport::GetInfo() const noexcept
     return info;
 }
 
+std::optional<SendPriority> CConnman::NextSendPriority(CNode& node) const
+{
+    if (m_historical_send_rate != 0) {
+        const auto now{GetTime<std::chrono::microseconds>()};
+        const double elapsed{Ticks<SecondsDouble>(std::max(now - node.m_historical_send_allowance_time, 0us))};
+        node.m_historical_send_allowance_time = now;
+        // Allow bursts of up to one second worth of data.
+        node.m_historical_send_allowance = std::min(node.m_historical_send_allowance + m_historical_send_rate * elapsed, double(m_historical_send_rate));
+    }
+    if (!node.m_send_queues[static_cast<size_t>(SendPriority::NORMAL)].empty()) return SendPriority::NORMAL;
+    if (node.m_send_queues[static_cast<size_t>(SendPriority::HISTORICAL)].empty()) return std::nullopt;
+    if (m_historical_send_rate == 0 || node.m_historical_send_allowance > 0) return SendPriority::HISTORICAL;
+    return std::nullopt;
+}
+
 std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
 {
-    auto it = node.vSendMsg.begin();
+    auto priority{NextSendPriority(node)};
     size_t nSentSize = 0;
     bool data_left{false}; //!< second return value (whether unsent data remains)
     std::optional<bool> expected_more;
 
     while (true) {
-        if (it != node.vSendMsg.end()) {
+        if (priority) {
             // If possible, move one message from the send queue to the transport. This fails when
             // there is an existing message still being sent, or (for v2 transports) when the
             // handshake has not yet completed.
-            size_t memusage = it->GetMemoryUsage();
-            if (node.m_transport->SetMessageToSend(*it)) {
-                // Update memory usage of send buffer (as *it will be deleted).
+            const size_t index{static_cast<size_t>(*priority)};
+            auto& queue{node.m_send_queues[index]};
+            size_t memusage = queue.front().GetMemoryUsage();
+            size_t size = queue.front().data.size();
+            if (node.m_transport->SetMessageToSend(queue.front())) {
+                // Update memory usage of send buffer and charge the rate limit of historical data.
                 node.m_send_memusage -= memusage;
-                ++it;
+                if (*priority == SendPriority::HISTORICAL && m_historical_send_rate != 0) node.m_historical_send_allowance -= size;
+                queue.pop_front();
+                priority = NextSendPriority(node);
             }
         }
-        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(it != node.vSendMsg.end());
+        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(priority.has_value());
         // We rely on the 'more' value returned by GetBytesToSend to correctly predict whether more
         // bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
         // verify that the previously returned 'more' was correct.
@@ -1641,10 +1676,9 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
 
     node.fPauseSend = node.m_send_memusage + node.m_transport->GetSendMemoryUsage() > nSendBufferMaxSize;
 
-    if (it == node.vSendMsg.end()) {
+    if (std::ranges::all_of(node.m_send_queues, [](const auto& queue) { return queue.empty(); })) {
         assert(node.m_send_memusage == 0);
     }
-    node.vSendMsg.erase(node.vSendMsg.begin(), it);
     return {nSentSize, data_left};
 }
 
@@ -1669,6 +1703,7 @@ bool CConnman::AttemptToEvictConnection()
                 .id = node->GetId(),
                 .m_connected = node->m_connected,
                 .m_min_ping_time = node->m_min_ping_time,
+                .m_processing_time = node->m_processing_time,
                 .m_last_block_time = node->m_last_block_time,
                 .m_last_tx_time = node->m_last_tx_time,
                 .fRelevantServices = node->m_has_all_wanted_services,
@@ -2008,9 +2043,10 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
         {
             LOCK(pnode->cs_vSend);
             // Sending is possible if either there are bytes to send right now, or if there will be
-            // once a potential message from vSendMsg is handed to the transport. GetBytesToSend
-            // determines both of these in a single call.
-            const auto& [to_send, more, _msg_type] = pnode->m_transport->GetBytesToSend(!pnode->vSendMsg.empty());
+            // once a potential message from the send queues is handed to the transport. GetBytesToSend
+            // determines both of these in a single call. Queues over their rate limit don't count,
+            // they are picked up again by a later iteration once their allowance has recovered.
+            const auto& [to_send, more, _msg_type] = pnode->m_transport->GetBytesToSend(NextSendPriority(*pnode).has_value());
             select_send = !to_send.empty() || more;
         }
         if (!select_recv && !select_send) continue;
@@ -3800,7 +3836,7 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
 }
 
-void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
+void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg, SendPriority priority)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
     size_t nMessageSize = msg.data.size();
@@ -3825,13 +3861,14 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         // give it a message to send.
         const auto& [to_send, more, _msg_type] =
             pnode->m_transport->GetBytesToSend(/*have_next_message=*/true);
-        const bool queue_was_empty{to_send.empty() && pnode->vSendMsg.empty()};
+        auto& queue{pnode->m_send_queues[static_cast<size_t>(priority)]};
+        const bool queue_was_empty{to_send.empty() && queue.empty()};
 
         // Update memory usage of send buffer.
         pnode->m_send_memusage += msg.GetMemoryUsage();
         if (pnode->m_send_memusage + pnode->m_transport->GetSendMemoryUsage() > nSendBufferMaxSize) pnode->fPauseSend = true;
-        // Move message to vSendMsg queue.
-        pnode->vSendMsg.push_back(std::move(msg));
+        // Move message to the send queue of its priority class.
+        queue.push_back(std::move(msg));
 
         // If there was nothing to send before, and there is now (predicted by the "more" value
         // returned by the GetBytesToSend call above), attempt "optimistic write":
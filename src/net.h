@@ -32,6 +32,7 @@
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -134,6 +135,18 @@ struct CSerializedNetMsg {
     size_t GetMemoryUsage() const noexcept;
 };
 
+/**
+ * Classes of outbound messages. Each peer has one send queue per class. All
+ * messages except historical data share the NORMAL queue and are sent in the
+ * order they were queued. HISTORICAL messages are only sent while the NORMAL
+ * queue is empty, and are the only ones subject to -peersendrate.
+ */
+enum class SendPriority : uint8_t {
+    NORMAL,     //!< Everything but historical data, in the order it was queued
+    HISTORICAL, //!< Serving blocks older than a week and compact block filters
+};
+static constexpr size_t NUM_SEND_PRIORITIES{2};
+
 /**
  * Look up IP addresses from all interfaces on the machine and add them to the
  * list of local addresses to self-advertise.
@@ -181,6 +194,28 @@ extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(g_maplocalho
 extern const std::string NET_MESSAGE_TYPE_OTHER;
 using mapMsgTypeSize = std::map</* message type */ std::string, /* total bytes */ uint64_t>;
 
+/** Time the message handler thread spent on behalf of a peer. */
+struct MsgProcessingTime {
+    //! Number of messages (or getdata/orphan processing passes) accounted
+    uint64_t count{0};
+    //! Total wall-clock time spent processing, including lock waits
+    std::chrono::microseconds total{0};
+    //! Part of total spent blocked waiting for cs_main
+    std::chrono::microseconds cs_main_wait{0};
+    //! Part of total spent blocked waiting for the transaction download mutex
+    std::chrono::microseconds tx_download_wait{0};
+
+    MsgProcessingTime& operator+=(const MsgProcessingTime& other)
+    {
+        count += other.count;
+        total += other.total;
+        cs_main_wait += other.cs_main_wait;
+        tx_download_wait += other.tx_download_wait;
+        return *this;
+    }
+};
+using mapMsgTypeProcessingTime = std::map</* message type */ std::string, MsgProcessingTime>;
+
 class CNodeStats
 {
 public:
@@ -203,6 +238,8 @@ public:
     mapMsgTypeSize mapSendBytesPerMsgType;
     uint64_t nRecvBytes;
     mapMsgTypeSize mapRecvBytesPerMsgType;
+    MsgProcessingTime m_processing_time;
+    mapMsgTypeProcessingTime m_processing_time_per_msg_type;
     NetPermissionFlags m_permission_flags;
     std::chrono::microseconds m_last_ping_time;
     std::chrono::microseconds m_min_ping_time;
@@ -685,12 +722,16 @@ public:
      */
     std::shared_ptr<Sock> m_sock GUARDED_BY(m_sock_mutex);
 
-    /** Sum of GetMemoryUsage of all vSendMsg entries. */
+    /** Sum of GetMemoryUsage of all m_send_queues entries. */
     size_t m_send_memusage GUARDED_BY(cs_vSend){0};
     /** Total number of bytes sent on the wire to this peer. */
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    /** Messages still to be fed to m_transport->SetMessageToSend. */
-    std::deque<CSerializedNetMsg> vSendMsg GUARDED_BY(cs_vSend);
+    /** Messages still to be fed to m_transport->SetMessageToSend, one queue per SendPriority. */
+    std::array<std::deque<CSerializedNetMsg>, NUM_SEND_PRIORITIES> m_send_queues GUARDED_BY(cs_vSend);
+    /** Bytes of HISTORICAL messages that may still be handed to the transport under -peersendrate. */
+    double m_historical_send_allowance GUARDED_BY(cs_vSend){0};
+    /** Last time m_historical_send_allowance was replenished. */
+    std::chrono::microseconds m_historical_send_allowance_time GUARDED_BY(cs_vSend){0};
     Mutex cs_vSend;
     Mutex m_sock_mutex;
     Mutex cs_vRecv;
@@ -754,6 +795,11 @@ public:
         mapSendBytesPerMsgType[msg_type] += sent_bytes;
     }
 
+    /** Account for time spent processing a message (or other work done on behalf of this peer)
+     * in the per msg type connection stats. */
+    void AccountForProcessingTime(const std::string& msg_type, const MsgProcessingTime& time)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_processing_time_mutex);
+
     bool IsOutboundOrBlockRelayConn() const {
         switch (m_conn_type) {
             case ConnectionType::OUTBOUND_FULL_RELAY:
@@ -875,6 +921,11 @@ public:
      * criterium in CConnman::AttemptToEvictConnection. */
     std::atomic<std::chrono::microseconds> m_min_ping_time{std::chrono::microseconds::max()};
 
+    /** Total time the message handler spent processing messages from this
+     * peer. Used as an inbound peer eviction criterium in
+     * CConnman::AttemptToEvictConnection. */
+    std::atomic<std::chrono::microseconds> m_processing_time{0us};
+
     CNode(NodeId id,
           std::shared_ptr<Sock> sock,
           const CAddress& addrIn,
@@ -940,7 +991,7 @@ public:
 
     void CloseSocketDisconnect() EXCLUSIVE_LOCKS_REQUIRED(!m_sock_mutex);
 
-    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv);
+    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv, !m_processing_time_mutex);
 
     std::string ConnectionTypeAsString() const { return ::ConnectionTypeAsString(m_conn_type); }
 
@@ -969,6 +1020,10 @@ private:
     mapMsgTypeSize mapSendBytesPerMsgType GUARDED_BY(cs_vSend);
     mapMsgTypeSize mapRecvBytesPerMsgType GUARDED_BY(cs_vRecv);
 
+    Mutex m_processing_time_mutex;
+    MsgProcessingTime m_processing_time_total GUARDED_BY(m_processing_time_mutex);
+    mapMsgTypeProcessingTime m_processing_time_per_msg_type GUARDED_BY(m_processing_time_mutex);
+
     /**
      * If an I2P session is created per connection (for outbound transient I2P
      * connections) then it is stored here so that it can be destroyed when the
@@ -1043,6 +1098,8 @@ public:
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundLimit = 0;
+        //! Per-peer send rate limit for HISTORICAL messages in bytes per second (0 = unlimited)
+        uint64_t m_historical_send_rate{0};
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
         std::vector<std::string> vSeedNodes;
         std::vector<NetWhitelistPermissions> vWhitelistedRangeIncoming;
@@ -1077,6 +1134,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        m_historical_send_rate = connOptions.m_historical_send_rate;
         m_peer_connect_timeout = std::chrono::seconds{connOptions.m_peer_connect_timeout};
         {
             LOCK(m_total_bytes_sent_mutex);
@@ -1126,7 +1184,7 @@ public:
 
     bool ForNode(NodeId id, std::function<bool(CNode* pnode)> func);
 
-    void PushMessage(CNode* pnode, CSerializedNetMsg&& msg) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
+    void PushMessage(CNode* pnode, CSerializedNetMsg&& msg, SendPriority priority = SendPriority::NORMAL) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
 
     using NodeFn = std::function<void(CNode*)>;
     void ForEachNode(const NodeFn& func)
@@ -1351,9 +1409,16 @@ private:
 
     NodeId GetNewNodeId();
 
-    /** (Try to) send data from node's vSendMsg. Returns (bytes_sent, data_left). */
+    /** (Try to) send data from node's send queues. Returns (bytes_sent, data_left). */
     std::pair<size_t, bool> SocketSendData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
 
+    /**
+     * Replenish node's allowance for HISTORICAL messages and return the send queue to
+     * take the next message from: NORMAL if it is not empty, otherwise HISTORICAL if it
+     * is not empty and within the rate limit, otherwise none.
+     */
+    std::optional<SendPriority> NextSendPriority(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+
     void DumpAddresses();
 
     // Network stats
@@ -1409,6 +1474,7 @@ private:
     std::vector<NetWhitelistPermissions> vWhitelistedRangeOutgoing;
 
     unsigned int nSendBufferMaxSize{0};
+    uint64_t m_historical_send_rate{0};
     unsigned int nReceiveFloodSize{0};
 
     std::vector<ListenSocket> vhListenSocket;
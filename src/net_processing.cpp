@@ -41,6 +41,7 @@
 #include <txorphanage.h>
 #include <txrequest.h>
 #include <util/check.h>
+#include <util/hasher.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <util/trace.h>
@@ -53,6 +54,7 @@
 #include <optional>
 #include <ranges>
 #include <typeinfo>
+#include <unordered_map>
 #include <utility>
 
 using namespace util::hex_literals;
@@ -173,6 +175,50 @@ struct QueuedBlock {
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
 };
 
+/**
+ * Measures the time the message handler thread spends on behalf of a peer,
+ * including how long it was blocked on cs_main and the transaction download
+ * mutex, and accounts it in the peer's per msg type stats on destruction.
+ */
+class ProcessingTimer final : public LockWaitObserver
+{
+    CNode& m_node;
+    const std::string m_msg_type;
+    const void* const m_tx_download_mutex;
+    const SteadyClock::time_point m_start{SteadyClock::now()};
+    std::chrono::nanoseconds m_cs_main_wait{0};
+    std::chrono::nanoseconds m_tx_download_wait{0};
+    bool m_discarded{false};
+    const LockWaitScope m_scope{*this};
+
+public:
+    ProcessingTimer(CNode& node, std::string msg_type, const Mutex& tx_download_mutex)
+        : m_node{node}, m_msg_type{std::move(msg_type)}, m_tx_download_mutex{&tx_download_mutex} {}
+
+    ~ProcessingTimer()
+    {
+        if (m_discarded) return;
+        m_node.AccountForProcessingTime(m_msg_type, {
+            .count = 1,
+            .total = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - m_start),
+            .cs_main_wait = std::chrono::duration_cast<std::chrono::microseconds>(m_cs_main_wait),
+            .tx_download_wait = std::chrono::duration_cast<std::chrono::microseconds>(m_tx_download_wait),
+        });
+    }
+
+    void LockWaited(const void* cs, std::chrono::nanoseconds waited) override
+    {
+        if (cs == &::cs_main) {
+            m_cs_main_wait += waited;
+        } else if (cs == m_tx_download_mutex) {
+            m_tx_download_wait += waited;
+        }
+    }
+
+    /** Don't account anything, e.g. because there turned out to be no work. */
+    void Discard() { m_discarded = true; }
+};
+
 /**
  * Data structure for an individual peer. This struct is not protected by
  * cs_main since it does not contain validation-critical data.
@@ -597,6 +643,11 @@ private:
      *                     one orphan will be reconsidered on each call of this function. If an
      *                     accepted orphan has orphaned children, those will need to be
      *                     reconsidered, creating more work, possibly for other peers.
+     *                     Orphan subtrees are not resolved in one pass: package validation only
+     *                     accepts a child with its parents, and draining a whole subtree would
+     *                     give this peer more processing per round than the others. An orphan
+     *                     that is too low-feerate on its own is retried together with one
+     *                     orphaned child that pays for it.
      * @return             True if meaningful work was done (an orphan was accepted/rejected).
      *                     If no meaningful work was done, then the work set for this peer
      *                     will be empty.
@@ -687,6 +738,12 @@ private:
     {
         m_connman.PushMessage(&node, NetMsg::Make(std::move(msg_type), std::forward<Args>(args)...));
     }
+    /** Send a message to a peer in the given send queue class, see SendPriority. */
+    template <typename... Args>
+    void MakeAndPushMessage(CNode& node, SendPriority priority, std::string msg_type, Args&&... args) const
+    {
+        m_connman.PushMessage(&node, NetMsg::Make(std::move(msg_type), std::forward<Args>(args)...), priority);
+    }
 
     /** Send a version message to a peer */
     void PushNodeVersion(CNode& pnode, const Peer& peer);
@@ -715,6 +772,33 @@ private:
     /** Send `feefilter` message. */
     void MaybeSendFeefilter(CNode& node, Peer& peer, std::chrono::microseconds current_time) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
 
+    /** Make sure m_tx_relay_info has an entry for every hash in `hashes`, discarding all cached
+     *  entries first if a new trickle round started since they were looked up.
+     *
+     * @param[in] hashes        Transaction hashes queued for announcement to a peer.
+     * @param[in] wtxid         Whether `hashes` are wtxids (true) or txids (false).
+     * @param[in] current_time  Used to tell trickle rounds apart.
+     */
+    void UpdateTxRelayInfo(const std::set<uint256>& hashes, bool wtxid, std::chrono::microseconds current_time) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_mempool.cs);
+
+    /** Mempool data used to order and filter a transaction announcement. */
+    struct TxRelayInfo {
+        /** The transaction, or nullptr if it is no longer in the mempool. */
+        CTransactionRef tx;
+        uint64_t ancestor_count{0};
+        CAmount fee{0};
+        int32_t vsize{0};
+    };
+
+    /** Relay info of transactions queued for announcement, keyed by txid and/or wtxid.
+     *  It is kept for one inbound trickle round (until m_tx_relay_info_expiry) and shared by all
+     *  peers trickling inventory in that round, so that the ordering keys of a transaction are
+     *  looked up once per round rather than once per peer and mempool change. Fee and size of
+     *  an entry never change and a stale ancestor count only affects the order, while presence
+     *  in the mempool is checked again before announcing. */
+    std::unordered_map<uint256, TxRelayInfo, SaltedTxidHasher> m_tx_relay_info GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+    std::chrono::microseconds m_tx_relay_info_expiry GUARDED_BY(NetEventsInterface::g_msgproc_mutex){0};
+
     FastRandomContext m_rng GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
 
     FeeFilterRounder m_fee_filter_rounder GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
@@ -1889,7 +1973,7 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
       m_banman(banman),
       m_chainman(chainman),
       m_mempool(pool),
-      m_txdownloadman(node::TxDownloadOptions{pool, m_rng, opts.max_orphan_txs, opts.deterministic_rng}),
+      m_txdownloadman(node::TxDownloadOptions{pool, m_rng, opts.max_orphan_txs, opts.deterministic_rng, opts.max_orphan_peer_usage}),
       m_warnings{warnings},
       m_opts{opts}
 {
@@ -2222,6 +2306,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     const CBlockIndex* pindex{nullptr};
     const CBlockIndex* tip{nullptr};
     bool can_direct_fetch{false};
+    bool historical{false};
     FlatFilePos block_pos{};
     {
         LOCK(cs_main);
@@ -2233,9 +2318,10 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             LogDebug(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom.GetId());
             return;
         }
+        historical = (m_chainman.m_best_header != nullptr) && (m_chainman.m_best_header->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE);
         // disconnect node in case we have reached the outbound limit for serving historical blocks
         if (m_connman.OutboundTargetReached(true) &&
-            (((m_chainman.m_best_header != nullptr) && (m_chainman.m_best_header->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.IsMsgFilteredBlk()) &&
+            (historical || inv.IsMsgFilteredBlk()) &&
             !pfrom.HasPermission(NetPermissionFlags::Download) // nodes with the download permission may exceed target
         ) {
             LogDebug(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom.GetId());
@@ -2243,9 +2329,11 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             return;
         }
         tip = m_chainman.ActiveChain().Tip();
-        // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
+        // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold,
+        // unless the block is in a range that -prunekeeprecent or -prunekeepheights was set to keep
+        const bool kept_when_pruning{tip->nHeight - pindex->nHeight < m_chainman.m_blockman.MinBlocksToKeep() || m_chainman.m_blockman.IsInPruneKeepRanges(pindex->nHeight)};
         if (!pfrom.HasPermission(NetPermissionFlags::NoBan) && (
-                (((peer.m_our_services & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((peer.m_our_services & NODE_NETWORK) != NODE_NETWORK) && (tip->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
+                (((peer.m_our_services & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((peer.m_our_services & NODE_NETWORK) != NODE_NETWORK) && (tip->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) && !kept_when_pruning)
            )) {
             LogDebug(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold, disconnect peer=%d\n", pfrom.GetId());
             //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
@@ -2261,6 +2349,9 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
         block_pos = pindex->GetBlockPos();
     }
 
+    // Historical blocks, and the messages that must follow them, are sent after everything
+    // else queued for the peer and are subject to -peersendrate.
+    const SendPriority priority{historical ? SendPriority::HISTORICAL : SendPriority::NORMAL};
     std::shared_ptr<const CBlock> pblock;
     if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
@@ -2277,7 +2368,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             pfrom.fDisconnect = true;
             return;
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
+        MakeAndPushMessage(pfrom, priority, NetMsgType::BLOCK, Span{block_data});
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
@@ -2295,9 +2386,9 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     }
     if (pblock) {
         if (inv.IsMsgBlk()) {
-            MakeAndPushMessage(pfrom, NetMsgType::BLOCK, TX_NO_WITNESS(*pblock));
+            MakeAndPushMessage(pfrom, priority, NetMsgType::BLOCK, TX_NO_WITNESS(*pblock));
         } else if (inv.IsMsgWitnessBlk()) {
-            MakeAndPushMessage(pfrom, NetMsgType::BLOCK, TX_WITH_WITNESS(*pblock));
+            MakeAndPushMessage(pfrom, priority, NetMsgType::BLOCK, TX_WITH_WITNESS(*pblock));
         } else if (inv.IsMsgFilteredBlk()) {
             bool sendMerkleBlock = false;
             CMerkleBlock merkleBlock;
@@ -2309,7 +2400,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
                 }
             }
             if (sendMerkleBlock) {
-                MakeAndPushMessage(pfrom, NetMsgType::MERKLEBLOCK, merkleBlock);
+                MakeAndPushMessage(pfrom, priority, NetMsgType::MERKLEBLOCK, merkleBlock);
                 // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
                 // This avoids hurting performance by pointlessly requiring a round-trip
                 // Note that there is currently no way for a node to request any single transactions we didn't send here -
@@ -2318,7 +2409,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
                 // however we MUST always provide at least what the remote peer needs
                 typedef std::pair<unsigned int, uint256> PairType;
                 for (PairType& pair : merkleBlock.vMatchedTxn)
-                    MakeAndPushMessage(pfrom, NetMsgType::TX, TX_NO_WITNESS(*pblock->vtx[pair.first]));
+                    MakeAndPushMessage(pfrom, priority, NetMsgType::TX, TX_NO_WITNESS(*pblock->vtx[pair.first]));
             }
             // else
             // no response
@@ -2329,13 +2420,13 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // instead we respond with the full, non-compact block.
             if (can_direct_fetch && pindex->nHeight >= tip->nHeight - MAX_CMPCTBLOCK_DEPTH) {
                 if (a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                    MakeAndPushMessage(pfrom, NetMsgType::CMPCTBLOCK, *a_recent_compact_block);
+                    MakeAndPushMessage(pfrom, priority, NetMsgType::CMPCTBLOCK, *a_recent_compact_block);
                 } else {
                     CBlockHeaderAndShortTxIDs cmpctblock{*pblock, m_rng.rand64()};
-                    MakeAndPushMessage(pfrom, NetMsgType::CMPCTBLOCK, cmpctblock);
+                    MakeAndPushMessage(pfrom, priority, NetMsgType::CMPCTBLOCK, cmpctblock);
                 }
             } else {
-                MakeAndPushMessage(pfrom, NetMsgType::BLOCK, TX_WITH_WITNESS(*pblock));
+                MakeAndPushMessage(pfrom, priority, NetMsgType::BLOCK, TX_WITH_WITNESS(*pblock));
             }
         }
     }
@@ -2349,7 +2440,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // wait for other stuff first.
             std::vector<CInv> vInv;
             vInv.emplace_back(MSG_BLOCK, tip->GetBlockHash());
-            MakeAndPushMessage(pfrom, NetMsgType::INV, vInv);
+            MakeAndPushMessage(pfrom, priority, NetMsgType::INV, vInv);
             peer.m_continuation_block.SetNull();
         }
     }
@@ -3093,6 +3184,16 @@ bool PeerManagerImpl::ProcessOrphanTx(Peer& peer)
                        state.GetResult() != TxValidationResult::TX_NO_MEMPOOL &&
                        state.GetResult() != TxValidationResult::TX_RESULT_UNSET)) {
                 ProcessInvalidTx(peer.m_id, porphanTx, state, /*first_time_failure=*/false);
+                // The orphan was just evaluated with its inputs for the first time. If it is too
+                // low-feerate on its own, look once for an orphaned child that pays for it.
+                if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE) {
+                    if (auto package_to_validate{m_txdownloadman.Find1P1CPackage(porphanTx, peer.m_id)}) {
+                        const auto package_result{ProcessNewPackage(m_chainman.ActiveChainstate(), m_mempool, package_to_validate->m_txns, /*test_accept=*/false, /*client_maxfeerate=*/std::nullopt)};
+                        LogDebug(BCLog::TXPACKAGES, "package evaluation for %s: %s\n", package_to_validate->ToString(),
+                                 package_result.m_state.IsValid() ? "package accepted" : "package rejected");
+                        ProcessPackageResult(package_to_validate.value(), package_result);
+                    }
+                }
             }
             return true;
         }
@@ -3179,7 +3280,7 @@ void PeerManagerImpl::ProcessGetCFilters(CNode& node, Peer& peer, DataStream& vR
     }
 
     for (const auto& filter : filters) {
-        MakeAndPushMessage(node, NetMsgType::CFILTER, filter);
+        MakeAndPushMessage(node, SendPriority::HISTORICAL, NetMsgType::CFILTER, filter);
     }
 }
 
@@ -3218,7 +3319,7 @@ void PeerManagerImpl::ProcessGetCFHeaders(CNode& node, Peer& peer, DataStream& v
         return;
     }
 
-    MakeAndPushMessage(node, NetMsgType::CFHEADERS,
+    MakeAndPushMessage(node, SendPriority::HISTORICAL, NetMsgType::CFHEADERS,
               filter_type_ser,
               stop_index->GetBlockHash(),
               prev_header,
@@ -3257,7 +3358,7 @@ void PeerManagerImpl::ProcessGetCFCheckPt(CNode& node, Peer& peer, DataStream& v
         }
     }
 
-    MakeAndPushMessage(node, NetMsgType::CFCHECKPT,
+    MakeAndPushMessage(node, SendPriority::HISTORICAL, NetMsgType::CFCHECKPT,
               filter_type_ser,
               stop_index->GetBlockHash(),
               headers);
@@ -4939,11 +5040,17 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     {
         LOCK(peer->m_getdata_requests_mutex);
         if (!peer->m_getdata_requests.empty()) {
+            ProcessingTimer timer{*pfrom, NetMsgType::GETDATA, m_tx_download_mutex};
             ProcessGetData(*pfrom, *peer, interruptMsgProc);
         }
     }
 
-    const bool processed_orphan = ProcessOrphanTx(*peer);
+    bool processed_orphan;
+    {
+        ProcessingTimer timer{*pfrom, NetMsgType::TX, m_tx_download_mutex};
+        processed_orphan = ProcessOrphanTx(*peer);
+        if (!processed_orphan) timer.Discard();
+    }
 
     if (pfrom->fDisconnect)
         return false;
@@ -4982,6 +5089,7 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
         CaptureMessage(pfrom->addr, msg.m_type, MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
     }
 
+    ProcessingTimer timer{*pfrom, msg.m_type, m_tx_download_mutex};
     try {
         ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
         if (interruptMsgProc) return false;
@@ -5368,23 +5476,66 @@ void PeerManagerImpl::MaybeSendFeefilter(CNode& pto, Peer& peer, std::chrono::mi
     }
 }
 
+void PeerManagerImpl::UpdateTxRelayInfo(const std::set<uint256>& hashes, bool wtxid, std::chrono::microseconds current_time)
+{
+    if (current_time >= m_tx_relay_info_expiry) {
+        m_tx_relay_info.clear();
+        // Inbound peers trickle together until m_next_inv_to_inbounds. Without a pending inbound
+        // round, fall back to the average inbound interval.
+        const auto next_inv_to_inbounds{m_next_inv_to_inbounds.load()};
+        m_tx_relay_info_expiry = next_inv_to_inbounds > current_time ? next_inv_to_inbounds : current_time + INBOUND_INVENTORY_BROADCAST_INTERVAL;
+    }
+    LOCK(m_mempool.cs);
+    for (const uint256& hash : hashes) {
+        auto [info_it, inserted] = m_tx_relay_info.try_emplace(hash);
+        // Retry transactions that were not in the mempool when last looked up.
+        if (!inserted && info_it->second.tx) continue;
+        const CTxMemPoolEntry* entry{nullptr};
+        if (wtxid) {
+            const auto it{m_mempool.get_iter_from_wtxid(hash)};
+            if (it != m_mempool.mapTx.end()) entry = &*it;
+        } else {
+            entry = m_mempool.GetEntry(Txid::FromUint256(hash));
+        }
+        if (!entry) continue;
+        info_it->second = TxRelayInfo{
+            .tx = entry->GetSharedTx(),
+            .ancestor_count = entry->GetCountWithAncestors(),
+            .fee = entry->GetFee(),
+            .vsize = entry->GetTxSize(),
+        };
+    }
+}
+
 namespace {
+/** Orders announcements like CTxMemPool::CompareDepthAndScore, but using relay info that was
+ *  looked up once for all peers instead of querying the mempool for every comparison. Each
+ *  candidate carries a pointer to its relay info, so comparisons do no lookups at all. */
+template <typename RelayInfo>
 class CompareInvMempoolOrder
 {
-    CTxMemPool* mp;
-    bool m_wtxid_relay;
 public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool, bool use_wtxid)
-    {
-        mp = _mempool;
-        m_wtxid_relay = use_wtxid;
-    }
+    using Candidate = std::pair<const RelayInfo*, std::set<uint256>::iterator>;
 
-    bool operator()(std::set<uint256>::iterator a, std::set<uint256>::iterator b)
+    bool operator()(const Candidate& a, const Candidate& b) const
     {
         /* As std::make_heap produces a max-heap, we want the entries with the
          * fewest ancestors/highest fee to sort later. */
-        return mp->CompareDepthAndScore(*b, *a, m_wtxid_relay);
+        const RelayInfo& info_a{*a.first};
+        const RelayInfo& info_b{*b.first};
+        // Entries that left the mempool sort first, so they are discarded early.
+        if (!info_a.tx) return false;
+        if (!info_b.tx) return true;
+        if (info_a.ancestor_count != info_b.ancestor_count) {
+            return info_b.ancestor_count < info_a.ancestor_count;
+        }
+        // Same as CompareTxMemPoolEntryByScore(b, a)
+        double f1 = (double)info_b.fee * info_a.vsize;
+        double f2 = (double)info_a.fee * info_b.vsize;
+        if (f1 == f2) {
+            return info_a.tx->GetHash() < info_b.tx->GetHash();
+        }
+        return f1 > f2;
     }
 };
 } // namespace
@@ -5722,16 +5873,20 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
 
                 // Determine transactions to relay
                 if (fSendTrickle) {
+                    // The mempool data used for sorting and filtering is shared with all other peers
+                    // trickling in the same round.
+                    UpdateTxRelayInfo(tx_relay->m_tx_inventory_to_send, peer->m_wtxid_relay, current_time);
                     // Produce a vector with all candidates for sending
-                    std::vector<std::set<uint256>::iterator> vInvTx;
+                    using Compare = CompareInvMempoolOrder<TxRelayInfo>;
+                    std::vector<Compare::Candidate> vInvTx;
                     vInvTx.reserve(tx_relay->m_tx_inventory_to_send.size());
                     for (std::set<uint256>::iterator it = tx_relay->m_tx_inventory_to_send.begin(); it != tx_relay->m_tx_inventory_to_send.end(); it++) {
-                        vInvTx.push_back(it);
+                        vInvTx.emplace_back(&m_tx_relay_info.at(*it), it);
                     }
                     const CFeeRate filterrate{tx_relay->m_fee_filter_received.load()};
                     // Topologically and fee-rate sort the inventory we send for privacy and priority reasons.
                     // A heap is used so that not all items need sorting if only a few are being sent.
-                    CompareInvMempoolOrder compareInvMempoolOrder(&m_mempool, peer->m_wtxid_relay);
+                    Compare compareInvMempoolOrder;
                     std::make_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
                     // No reason to drain out at many times the network's capacity,
                     // especially since we have many peers and some will draw much shorter delays.
@@ -5742,7 +5897,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     while (!vInvTx.empty() && nRelayedTransactions < broadcast_max) {
                         // Fetch the top element from the heap
                         std::pop_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
-                        std::set<uint256>::iterator it = vInvTx.back();
+                        const auto [txinfo_ptr, it] = vInvTx.back();
                         vInvTx.pop_back();
                         uint256 hash = *it;
                         CInv inv(peer->m_wtxid_relay ? MSG_WTX : MSG_TX, hash);
@@ -5753,8 +5908,8 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             continue;
                         }
                         // Not in the mempool anymore? don't bother sending it.
-                        auto txinfo = m_mempool.info(ToGenTxid(inv));
-                        if (!txinfo.tx) {
+                        const TxRelayInfo& txinfo{*txinfo_ptr};
+                        if (!txinfo.tx || !m_mempool.exists(ToGenTxid(inv))) {
                             continue;
                         }
                         // Peer told you to not send transactions at that feerate? Don't bother sending it.
@@ -0,0 +1,190 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockcompression.h>
+
+#include <crypto/common.h>
+#include <span.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/strencodings.h>
+
+#include <crc32c/crc32c.h>
+
+#include <algorithm>
+#include <ios>
+
+using namespace util::hex_literals;
+
+namespace node {
+namespace {
+//! The null prevout and final sequence of coinbase inputs, the witness commitment output,
+//! transaction versions and segwit markers, sequence numbers, output script templates, and
+//! the encodings of signatures and public keys in scripts and witnesses.
+constexpr auto DICTIONARY{
+    "0000000000000000000000000000000000000000000000000000000000000000ffffffff"
+    "0000000000000000266a24aa21a9ed"
+    "0100000001" "0200000001" "01000000000101" "02000000000101" "feffffff" "fdffffff"
+    "0000000000" "220020" "225120" "17a914" "87" "160014" "1976a914" "88ac"
+    "4104" "2103" "2102" "0141" "0121" "4830450221" "4730440220" "02483045022100"
+    "024730440220" "ffffffff"_hex_u8};
+
+constexpr int HASH_BITS{16};
+constexpr size_t MIN_MATCH{4};
+constexpr size_t MAX_OFFSET{0xffff};
+
+uint32_t HashOf(uint32_t value) { return (value * 2654435761U) >> (32 - HASH_BITS); }
+
+void WriteLength(std::vector<uint8_t>& out, size_t length)
+{
+    for (length -= 15; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(uint8_t(length));
+}
+
+//! Append a sequence; a match length of 0 ends the frame after the literals.
+void WriteSequence(std::vector<uint8_t>& out, std::span<const uint8_t> literals, size_t offset, size_t match_length)
+{
+    const size_t extra_match{match_length > 0 ? match_length - MIN_MATCH : 0};
+    out.push_back(uint8_t(std::min<size_t>(literals.size(), 15) << 4 | std::min<size_t>(extra_match, 15)));
+    if (literals.size() >= 15) WriteLength(out, literals.size());
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match_length == 0) return;
+    out.push_back(uint8_t(offset));
+    out.push_back(uint8_t(offset >> 8));
+    if (extra_match >= 15) WriteLength(out, extra_match);
+}
+} // namespace
+
+std::vector<uint8_t> CompressBlockData(std::span<const uint8_t> data)
+{
+    // Matches are searched in the dictionary followed by the data.
+    std::vector<uint8_t> window(DICTIONARY.begin(), DICTIONARY.end());
+    window.insert(window.end(), data.begin(), data.end());
+    std::vector<uint32_t> table(1 << HASH_BITS); // last position + 1 of each hash
+    const auto insert{[&](size_t pos) { table[HashOf(ReadLE32(&window[pos]))] = pos + 1; }};
+    for (size_t pos{0}; pos < DICTIONARY.size() && pos + MIN_MATCH <= window.size(); ++pos) insert(pos);
+
+    std::vector<uint8_t> out;
+    out.reserve(data.size() / 2 + 16);
+    size_t anchor{DICTIONARY.size()};
+    size_t pos{anchor};
+    while (pos + MIN_MATCH <= window.size()) {
+        const size_t candidate{table[HashOf(ReadLE32(&window[pos]))]};
+        insert(pos);
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || ReadLE32(&window[candidate - 1]) != ReadLE32(&window[pos])) {
+            // Step faster through data that does not compress, such as signatures.
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+        const size_t match{candidate - 1};
+        size_t length{MIN_MATCH};
+        while (pos + length < window.size() && window[match + length] == window[pos + length]) ++length;
+        WriteSequence(out, std::span{window}.subspan(anchor, pos - anchor), pos - match, length);
+        for (size_t i{pos + 1}; i < pos + length && i + MIN_MATCH <= window.size(); ++i) insert(i);
+        pos += length;
+        anchor = pos;
+    }
+    if (anchor < window.size()) WriteSequence(out, std::span{window}.subspan(anchor), 0, 0);
+    return out;
+}
+
+std::optional<std::vector<uint8_t>> DecompressBlockData(std::span<const uint8_t> frame, uint32_t size, uint32_t max_size)
+{
+    const size_t end{DICTIONARY.size() + size};
+    const size_t limit{DICTIONARY.size() + std::min(size, max_size)};
+    std::vector<uint8_t> out(DICTIONARY.begin(), DICTIONARY.end());
+    out.reserve(limit);
+    size_t in{0};
+    const auto read_length{[&](size_t length) -> std::optional<size_t> {
+        if (length < 15) return length;
+        while (in < frame.size()) {
+            const uint8_t byte{frame[in++]};
+            length += byte;
+            if (byte != 255) return length;
+        }
+        return std::nullopt;
+    }};
+    while (in < frame.size() && out.size() < limit) {
+        const uint8_t token{frame[in++]};
+        const auto literals{read_length(token >> 4)};
+        if (!literals || *literals > frame.size() - in || *literals > end - out.size()) return std::nullopt;
+        out.insert(out.end(), frame.begin() + in, frame.begin() + in + *literals);
+        in += *literals;
+        if (in == frame.size()) break;
+        if (frame.size() - in < 2) return std::nullopt;
+        const size_t offset{size_t{frame[in]} | size_t{frame[in + 1]} << 8};
+        in += 2;
+        const auto extra_match{read_length(token & 15)};
+        if (!extra_match || offset == 0 || offset > out.size() || *extra_match + MIN_MATCH > end - out.size()) return std::nullopt;
+        for (size_t i{0}; i < *extra_match + MIN_MATCH; ++i) {
+            const uint8_t byte{out[out.size() - offset]};
+            out.push_back(byte);
+        }
+    }
+    if (out.size() < limit) return std::nullopt;
+    out.resize(limit);
+    out.erase(out.begin(), out.begin() + DICTIONARY.size());
+    return out;
+}
+
+bool IsCompressedBlockFile(AutoFile& file)
+{
+    std::array<uint8_t, COMPRESSED_BLOCKFILE_MAGIC.size()> magic;
+    return file.detail_fread(MakeWritableByteSpan(magic)) == magic.size() && magic == COMPRESSED_BLOCKFILE_MAGIC;
+}
+
+std::vector<CompressedBlockRecord> ReadCompressedBlockTable(AutoFile& file)
+{
+    std::vector<CompressedBlockRecord> table;
+    file >> table;
+    return table;
+}
+
+std::vector<uint8_t> ReadCompressedBlock(AutoFile& file, const CompressedBlockRecord& record, uint32_t max_size)
+{
+    std::vector<uint8_t> frame(record.frame_size);
+    file.seek(record.frame_pos, SEEK_SET);
+    file.read(MakeWritableByteSpan(frame));
+    if (crc32c::Crc32c(frame.data(), frame.size()) != record.frame_checksum) {
+        throw std::ios_base::failure(strprintf("checksum mismatch in compressed block frame at offset %u", record.frame_pos));
+    }
+    auto data{DecompressBlockData(frame, record.size, max_size)};
+    if (!data) throw std::ios_base::failure("corrupt compressed block frame");
+    return std::move(*data);
+}
+
+CompressedBlockFileWriter::CompressedBlockFileWriter(AutoFile& file, size_t block_count)
+    : m_file{file}, m_block_count{block_count}
+{
+    m_table.reserve(block_count);
+    m_pos = COMPRESSED_BLOCKFILE_MAGIC.size() + GetSizeOfCompactSize(block_count) + block_count * GetSerializeSize(CompressedBlockRecord{});
+    m_file.seek(m_pos, SEEK_SET);
+}
+
+void CompressedBlockFileWriter::Add(uint32_t pos, std::span<const uint8_t> data)
+{
+    Assume(m_table.size() < m_block_count);
+    Assume(m_table.empty() || m_table.back().pos < pos);
+    const std::vector<uint8_t> frame{CompressBlockData(data)};
+    m_file.write(MakeByteSpan(frame));
+    m_table.push_back({
+        .pos = pos,
+        .size = uint32_t(data.size()),
+        .frame_pos = uint32_t(m_pos),
+        .frame_size = uint32_t(frame.size()),
+        .frame_checksum = crc32c::Crc32c(frame.data(), frame.size()),
+    });
+    m_pos += frame.size();
+}
+
+uint64_t CompressedBlockFileWriter::Finish()
+{
+    Assume(m_table.size() == m_block_count);
+    m_file.seek(0, SEEK_SET);
+    m_file << COMPRESSED_BLOCKFILE_MAGIC << m_table;
+    return m_pos;
+}
+
+} // namespace node
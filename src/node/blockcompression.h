@@ -0,0 +1,103 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCOMPRESSION_H
+#define BITCOIN_NODE_BLOCKCOMPRESSION_H
+
+#include <serialize.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+class AutoFile;
+
+namespace node {
+
+/**
+ * Compressed block files
+ *
+ * A finalized block file can be replaced by a compressed file of the same name. It starts
+ * with COMPRESSED_BLOCKFILE_MAGIC and a table of the blocks it holds, followed by one
+ * independently compressed frame per block. The table holds a CRC32C checksum of each
+ * frame, which is verified whenever the frame is read. Blocks keep the position they had in the
+ * uncompressed file, so FlatFilePos values in the block index stay valid, and any block is
+ * read by decompressing just its frame. Data between blocks, such as the preallocated tail
+ * of the file, is not kept.
+ *
+ * Frames use a byte-oriented LZ77 format: a token byte holding the literal length in its
+ * high and the match length minus 4 in its low nibble (15 meaning more length bytes follow,
+ * each adding up to 255), the literals, and a 2-byte little-endian match offset. The stream
+ * may end after the literals of a sequence. Matches may reach into a built-in dictionary
+ * of byte strings common in blocks, which acts as history preceding every frame.
+ */
+
+//! Starts a compressed block file. Uncompressed block files start with the network magic.
+static constexpr std::array<uint8_t, 8> COMPRESSED_BLOCKFILE_MAGIC{'b', 'l', 'k', 'z', 0xc0, 0x01, 0x00, 0x02};
+
+/** Table entry of a compressed block file. */
+struct CompressedBlockRecord {
+    //! Position of the block data in the uncompressed file, after the message start and size
+    uint32_t pos{0};
+    //! Size of the block data
+    uint32_t size{0};
+    //! Position of the compressed frame in the compressed file
+    uint32_t frame_pos{0};
+    uint32_t frame_size{0};
+    //! CRC32C of the compressed frame
+    uint32_t frame_checksum{0};
+
+    SERIALIZE_METHODS(CompressedBlockRecord, obj) { READWRITE(obj.pos, obj.size, obj.frame_pos, obj.frame_size, obj.frame_checksum); }
+};
+
+//! Compress data into a single frame.
+std::vector<uint8_t> CompressBlockData(std::span<const uint8_t> data);
+
+/**
+ * Decompress a frame that holds size bytes. Decoding stops once max_size bytes are
+ * produced, which is enough to read the header of a block. Returns nullopt if the frame is
+ * corrupt.
+ */
+std::optional<std::vector<uint8_t>> DecompressBlockData(std::span<const uint8_t> frame, uint32_t size,
+                                                       uint32_t max_size = std::numeric_limits<uint32_t>::max());
+
+//! Whether file, positioned at its start, is a compressed block file.
+bool IsCompressedBlockFile(AutoFile& file);
+
+//! Read the block table of a compressed block file, positioned after its magic.
+std::vector<CompressedBlockRecord> ReadCompressedBlockTable(AutoFile& file);
+
+/**
+ * Read and decompress the frame of record from a compressed block file, see
+ * DecompressBlockData(). Throws if the frame does not match its checksum or is corrupt.
+ */
+std::vector<uint8_t> ReadCompressedBlock(AutoFile& file, const CompressedBlockRecord& record,
+                                         uint32_t max_size = std::numeric_limits<uint32_t>::max());
+
+/**
+ * Writes a compressed block file holding a known number of blocks, added in the order of
+ * their positions. The table is written last, once the frame positions are known, so the
+ * blocks need not be held in memory together.
+ */
+class CompressedBlockFileWriter
+{
+    AutoFile& m_file;
+    std::vector<CompressedBlockRecord> m_table;
+    const size_t m_block_count;
+    uint64_t m_pos;
+
+public:
+    CompressedBlockFileWriter(AutoFile& file, size_t block_count);
+
+    void Add(uint32_t pos, std::span<const uint8_t> data);
+    //! Write the table and return the size of the file.
+    uint64_t Finish();
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKCOMPRESSION_H
@@ -8,10 +8,15 @@
 #include <node/blockstorage.h>
 #include <tinyformat.h>
 #include <util/result.h>
+#include <util/strencodings.h>
+#include <util/string.h>
 #include <util/translation.h>
 #include <validation.h>
 
 #include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
 
 namespace node {
 util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Options& opts)
@@ -32,7 +37,37 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
     }
     opts.prune_target = nPruneTarget;
 
+    if (auto value{args.GetIntArg("-prunekeeprecent")}) {
+        if (*value < 0 || *value > std::numeric_limits<int>::max()) {
+            return util::Error{_("-prunekeeprecent cannot be configured with a negative value.")};
+        }
+        opts.prune_keep_recent = *value;
+    }
+    for (const std::string& range : args.GetArgs("-prunekeepheights")) {
+        const auto heights{util::SplitString(range, '-')};
+        std::optional<int> start, end;
+        if (heights.size() <= 2) {
+            start = ToIntegral<int>(heights.front());
+            end = ToIntegral<int>(heights.back());
+        }
+        if (!start || !end || *start < 0 || *end < *start) {
+            return util::Error{strprintf(_("Invalid -prunekeepheights range '%s'. Use <height> or <start>-<end>."), range)};
+        }
+        opts.prune_keep_heights.emplace_back(*start, *end);
+    }
+    if ((opts.prune_keep_recent > 0 || !opts.prune_keep_heights.empty()) && opts.prune_target == 0) {
+        return util::Error{_("-prunekeeprecent and -prunekeepheights require -prune.")};
+    }
+
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
+    if (auto value{args.GetBoolArg("-blockindexsnapshot")}) opts.block_index_snapshot = *value;
+    if (auto value{args.GetIntArg("-blockreadthreads")}) {
+        if (*value < 0 || *value > kernel::MAX_BLOCK_READ_THREADS) {
+            return util::Error{strprintf(_("-blockreadthreads must be between 0 and %d."), kernel::MAX_BLOCK_READ_THREADS)};
+        }
+        opts.block_read_threads = *value;
+    }
+    if (auto value{args.GetBoolArg("-compressblockfiles")}) opts.compress_block_files = *value;
 
     return {};
 }
@@ -6,8 +6,10 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <consensus/consensus.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -16,6 +18,8 @@
 #include <kernel/messagestartchars.h>
 #include <kernel/notifications_interface.h>
 #include <logging.h>
+#include <memusage.h>
+#include <node/blockcompression.h>
 #include <pow.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -31,13 +35,21 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <map>
+#include <numeric>
 #include <ranges>
+#include <tuple>
 #include <unordered_map>
 
 namespace kernel {
@@ -46,6 +58,7 @@ static constexpr uint8_t DB_BLOCK_INDEX{'b'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_BLOCK_INDEX_SNAPSHOT{'s'};
 // Keys used in previous version that might still be found in the DB:
 // BlockTreeDB::DB_TXINDEX_BLOCK{'T'};
 // BlockTreeDB::DB_TXINDEX{'t'}
@@ -82,12 +95,28 @@ bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFi
         batch.Write(std::make_pair(DB_BLOCK_FILES, file), *info);
     }
     batch.Write(DB_LAST_BLOCK, nLastFile);
+    if (!blockinfo.empty()) {
+        // Any block index snapshot on disk no longer matches.
+        batch.Erase(DB_BLOCK_INDEX_SNAPSHOT);
+    }
     for (const CBlockIndex* bi : blockinfo) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, bi->GetBlockHash()), CDiskBlockIndex{bi});
     }
     return WriteBatch(batch, true);
 }
 
+bool BlockTreeDB::WriteBlockIndexSnapshotId(uint64_t id)
+{
+    return Write(DB_BLOCK_INDEX_SNAPSHOT, id, /*fSync=*/true);
+}
+
+std::optional<uint64_t> BlockTreeDB::ReadBlockIndexSnapshotId()
+{
+    uint64_t id;
+    if (!Read(DB_BLOCK_INDEX_SNAPSHOT, id)) return std::nullopt;
+    return id;
+}
+
 bool BlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair(DB_FLAG, name), fValue ? uint8_t{'1'} : uint8_t{'0'});
@@ -235,11 +264,74 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
     return pindexNew;
 }
 
-void BlockManager::PruneOneBlockFile(const int fileNumber)
+uint64_t BlockManager::MoveBlockData(CBlockIndex& index)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_LastBlockFile);
+    std::vector<uint8_t> data;
+    if (!ReadRawBlockFromDisk(data, index.GetBlockPos())) return 0;
+    FlatFilePos pos{FindKeptBlockPos(data.size() + BLOCK_SERIALIZATION_HEADER_SIZE, index.nHeight, index.GetBlockTime())};
+    if (pos.IsNull()) return 0;
+    AutoFile file{OpenBlockFile(pos)};
+    if (file.IsNull()) return 0;
+    try {
+        file << GetParams().MessageStart() << uint32_t(data.size());
+        file.write(MakeByteSpan(data));
+    } catch (const std::exception& e) {
+        LogError("%s: failed to write block %s: %s\n", __func__, index.GetBlockHash().ToString(), e.what());
+        return 0;
+    }
+    index.nFile = pos.nFile;
+    index.nDataPos = pos.nPos + BLOCK_SERIALIZATION_HEADER_SIZE;
+    // Undo data is only needed to disconnect blocks near the tip.
+    index.nStatus &= ~BLOCK_HAVE_UNDO;
+    index.nUndoPos = 0;
+    m_dirty_blockindex.insert(&index);
+    return data.size() + BLOCK_SERIALIZATION_HEADER_SIZE;
+}
+
+std::set<int> BlockManager::KeptBlockFiles() const
+{
+    AssertLockHeld(cs_main);
+    if (m_opts.prune_keep_heights.empty()) return {};
+    std::set<int> kept, other;
+    for (const auto& [_, index] : m_block_index) {
+        if (!(index.nStatus & BLOCK_HAVE_DATA)) continue;
+        (IsInPruneKeepRanges(index.nHeight) ? kept : other).insert(index.nFile);
+    }
+    for (const int file : other) kept.erase(file);
+    return kept;
+}
+
+int BlockManager::MinBlocksToKeep() const
+{
+    return std::max(int{MIN_BLOCKS_TO_KEEP}, m_opts.prune_keep_recent);
+}
+
+bool BlockManager::IsInPruneKeepRanges(int height) const
+{
+    return std::ranges::any_of(m_opts.prune_keep_heights, [&](const auto& range) { return range.first <= height && height <= range.second; });
+}
+
+uint64_t BlockManager::PruneOneBlockFile(const int fileNumber)
 {
     AssertLockHeld(cs_main);
     LOCK(cs_LastBlockFile);
 
+    // Move the blocks to keep out of the file first, in height order, so that they end up
+    // next to each other.
+    std::vector<CBlockIndex*> kept;
+    for (auto& [_, index] : m_block_index) {
+        if (index.nFile == fileNumber && (index.nStatus & BLOCK_HAVE_DATA) && IsInPruneKeepRanges(index.nHeight)) kept.push_back(&index);
+    }
+    std::ranges::sort(kept, {}, &CBlockIndex::nHeight);
+    uint64_t moved_bytes{0};
+    for (CBlockIndex* index : kept) {
+        const uint64_t bytes{MoveBlockData(*index)};
+        if (bytes == 0) LogWarning("Failed to keep block %s at height %d, pruning it\n", index->GetBlockHash().ToString(), index->nHeight);
+        moved_bytes += bytes;
+    }
+
     for (auto& entry : m_block_index) {
         CBlockIndex* pindex = &entry.second;
         if (pindex->nFile == fileNumber) {
@@ -267,6 +359,7 @@ void BlockManager::PruneOneBlockFile(const int fileNumber)
 
     m_blockfile_info.at(fileNumber) = CBlockFileInfo{};
     m_dirty_fileinfo.insert(fileNumber);
+    return moved_bytes;
 }
 
 void BlockManager::FindFilesToPruneManual(
@@ -283,6 +376,7 @@ void BlockManager::FindFilesToPruneManual(
     }
 
     const auto [min_block_to_prune, last_block_can_prune] = chainman.GetPruneRange(chain, nManualPruneHeight);
+    const std::set<int> kept_files{KeptBlockFiles()};
 
     int count = 0;
     for (int fileNumber = 0; fileNumber < this->MaxBlockfileNum(); fileNumber++) {
@@ -290,6 +384,9 @@ void BlockManager::FindFilesToPruneManual(
         if (fileinfo.nSize == 0 || fileinfo.nHeightLast > (unsigned)last_block_can_prune || fileinfo.nHeightFirst < (unsigned)min_block_to_prune) {
             continue;
         }
+        if (kept_files.contains(fileNumber)) {
+            continue;
+        }
 
         PruneOneBlockFile(fileNumber);
         setFilesToPrune.insert(fileNumber);
@@ -341,6 +438,7 @@ void BlockManager::FindFilesToPrune(
             nBuffer += average_block_size * remaining_blocks;
         }
 
+        const std::set<int> kept_files{KeptBlockFiles()};
         for (int fileNumber = 0; fileNumber < this->MaxBlockfileNum(); fileNumber++) {
             const auto& fileinfo = m_blockfile_info[fileNumber];
             nBytesToPrune = fileinfo.nSize + fileinfo.nUndoSize;
@@ -359,7 +457,13 @@ void BlockManager::FindFilesToPrune(
                 continue;
             }
 
-            PruneOneBlockFile(fileNumber);
+            // Pruning a file of only kept blocks would free nothing.
+            if (kept_files.contains(fileNumber)) {
+                continue;
+            }
+
+            // Blocks that are kept move to another file and still count.
+            nBytesToPrune -= PruneOneBlockFile(fileNumber);
             // Queue up the files for removal
             setFilesToPrune.insert(fileNumber);
             nCurrentUsage -= nBytesToPrune;
@@ -394,12 +498,284 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
     return pindex;
 }
 
-bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
+namespace {
+/** File magic and format version of the flat block index snapshot. */
+constexpr std::array<uint8_t, 8> BLOCK_INDEX_SNAPSHOT_MAGIC{'b', 'l', 'k', 'i', 'n', 'd', 'e', 'x'};
+constexpr uint32_t BLOCK_INDEX_SNAPSHOT_VERSION{1};
+//! Magic, version, snapshot id and entry count.
+constexpr size_t BLOCK_INDEX_SNAPSHOT_HEADER_SIZE{8 + 4 + 8 + 8};
+constexpr uint32_t BLOCK_INDEX_SNAPSHOT_NO_PREV{std::numeric_limits<uint32_t>::max()};
+
+/**
+ * Fixed-size block index snapshot record. Records are stored in height order and refer
+ * to their parent by record number, so loading needs neither sorting, nor hashing, nor a
+ * lookup per entry. Position fields are zeroed when CDiskBlockIndex would not store them.
+ */
+struct BlockIndexSnapshotRecord {
+    static constexpr size_t SIZE{32 + 4 * 8 + 32 + 4 * 3};
+
+    uint256 hash;
+    uint32_t prev{BLOCK_INDEX_SNAPSHOT_NO_PREV};
+    int32_t height{0};
+    uint32_t status{0};
+    uint32_t tx{0};
+    int32_t file{0};
+    uint32_t data_pos{0};
+    uint32_t undo_pos{0};
+    int32_t version{0};
+    uint256 merkle_root;
+    uint32_t time{0};
+    uint32_t bits{0};
+    uint32_t nonce{0};
+
+    SERIALIZE_METHODS(BlockIndexSnapshotRecord, obj)
+    {
+        READWRITE(obj.hash, obj.prev, obj.height, obj.status, obj.tx, obj.file, obj.data_pos, obj.undo_pos,
+                  obj.version, obj.merkle_root, obj.time, obj.bits, obj.nonce);
+    }
+};
+
+/** Digest of one block index entry as the block tree database stores it. */
+uint256 BlockIndexEntryDigest(const uint256& hash, const CDiskBlockIndex& index)
+{
+    return (HashWriter{} << hash << index).GetSHA256();
+}
+} // namespace
+
+bool BlockManager::LoadBlockIndexSnapshot(std::vector<CBlockIndex*>& sorted_by_height)
+{
+    AssertLockHeld(cs_main);
+    if (!m_opts.block_index_snapshot || !m_block_index.empty()) return false;
+    const auto start{SteadyClock::now()};
+    const fs::path path{BlockIndexSnapshotPath()};
+    const std::optional<uint64_t> expected_id{m_block_tree_db->ReadBlockIndexSnapshotId()};
+    if (!expected_id) {
+        LogInfo("No block index snapshot matching the block index database, loading from the database\n");
+        return false;
+    }
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    if (file.IsNull()) {
+        LogInfo("Block index snapshot %s not found, loading from the database\n", fs::PathToString(path));
+        return false;
+    }
+
+    std::vector<std::byte> data;
+    std::array<uint8_t, 8> magic;
+    uint32_t version;
+    uint64_t id, count;
+    try {
+        data.resize(fs::file_size(path));
+        file.read(data);
+        SpanReader{MakeUCharSpan(data)} >> magic >> version >> id >> count;
+    } catch (const std::exception& e) {
+        LogError("%s: failed to read block index snapshot: %s\n", __func__, e.what());
+        return false;
+    }
+    if (magic != BLOCK_INDEX_SNAPSHOT_MAGIC || version != BLOCK_INDEX_SNAPSHOT_VERSION || id != *expected_id ||
+        count >= BLOCK_INDEX_SNAPSHOT_NO_PREV ||
+        data.size() != BLOCK_INDEX_SNAPSHOT_HEADER_SIZE + count * BlockIndexSnapshotRecord::SIZE + uint256::size()) {
+        LogInfo("Block index snapshot does not match the block index database, loading from the database\n");
+        return false;
+    }
+    const Span<const std::byte> contents{Span{data}.first(data.size() - uint256::size())};
+    if (Hash(contents) != uint256{MakeUCharSpan(Span{data}.last(uint256::size()))}) {
+        LogError("%s: block index snapshot checksum mismatch, loading from the database\n", __func__);
+        return false;
+    }
+
+    const Span<const std::byte> records{contents.subspan(BLOCK_INDEX_SNAPSHOT_HEADER_SIZE)};
+    SpanReader reader{MakeUCharSpan(records)};
+    sorted_by_height.clear();
+    sorted_by_height.reserve(count);
+    m_block_index.reserve(count);
+    const auto fail{[&](const std::string& reason) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+        LogError("%s: %s, loading from the database\n", __func__, reason);
+        sorted_by_height.clear();
+        m_block_index.clear();
+        return false;
+    }};
+    for (uint64_t i = 0; i < count; ++i) {
+        if (m_interrupt) return fail("interrupted");
+        BlockIndexSnapshotRecord record;
+        reader >> record;
+        CBlockIndex* pprev{nullptr};
+        if (record.prev != BLOCK_INDEX_SNAPSHOT_NO_PREV) {
+            if (record.prev >= i || sorted_by_height[record.prev]->nHeight + 1 != record.height) {
+                return fail(strprintf("invalid parent of block index snapshot entry %u", i));
+            }
+            pprev = sorted_by_height[record.prev];
+        } else if (record.height != 0) {
+            return fail(strprintf("block index snapshot entry %u has no parent", i));
+        }
+        const auto [it, inserted]{m_block_index.try_emplace(record.hash)};
+        if (!inserted) return fail(strprintf("duplicate block index snapshot entry %s", record.hash.ToString()));
+        CBlockIndex& index{it->second};
+        index.phashBlock = &it->first;
+        index.pprev = pprev;
+        index.nHeight = record.height;
+        index.nFile = record.file;
+        index.nDataPos = record.data_pos;
+        index.nUndoPos = record.undo_pos;
+        index.nVersion = record.version;
+        index.hashMerkleRoot = record.merkle_root;
+        index.nTime = record.time;
+        index.nBits = record.bits;
+        index.nNonce = record.nonce;
+        index.nStatus = record.status;
+        index.nTx = record.tx;
+        if (!CheckProofOfWork(index.GetBlockHash(), index.nBits, GetConsensus())) {
+            return fail(strprintf("CheckProofOfWork failed: %s", index.ToString()));
+        }
+        sorted_by_height.push_back(&index);
+    }
+    m_loaded_block_index_snapshot = true;
+    LogInfo("Loaded %u block index entries from %s in %.2fs\n", count, fs::PathToString(path), Ticks<SecondsDouble>(SteadyClock::now() - start));
+
+    // The database cursor sees the entries as of now, even if they are written to later.
+    auto cursor{std::shared_ptr<CDBIterator>{m_block_tree_db->NewIterator()}};
+    auto snapshot{std::make_shared<const std::vector<std::byte>>(std::move(data))};
+    m_block_index_snapshot_check = std::thread{&util::TraceThread, "blkidxcheck", [this, cursor, snapshot, count] {
+        CheckBlockIndexSnapshot(*cursor, Span{*snapshot}.subspan(BLOCK_INDEX_SNAPSHOT_HEADER_SIZE, count * BlockIndexSnapshotRecord::SIZE));
+    }};
+    return true;
+}
+
+void BlockManager::CheckBlockIndexSnapshot(CDBIterator& cursor, Span<const std::byte> records)
+{
+    const auto start{SteadyClock::now()};
+    arith_uint256 snapshot_sum, db_sum;
+    const uint64_t snapshot_count{records.size() / BlockIndexSnapshotRecord::SIZE};
+    uint64_t db_count{0};
+
+    SpanReader reader{MakeUCharSpan(records)};
+    for (uint64_t i = 0; i < snapshot_count; ++i) {
+        if (m_interrupt) return;
+        BlockIndexSnapshotRecord record;
+        reader >> record;
+        CDiskBlockIndex index;
+        if (record.prev != BLOCK_INDEX_SNAPSHOT_NO_PREV) {
+            index.hashPrev = uint256{MakeUCharSpan(records.subspan(record.prev * BlockIndexSnapshotRecord::SIZE, uint256::size()))};
+        }
+        index.nHeight = record.height;
+        index.nStatus = record.status;
+        index.nTx = record.tx;
+        index.nFile = record.file;
+        index.nDataPos = record.data_pos;
+        index.nUndoPos = record.undo_pos;
+        index.nVersion = record.version;
+        index.hashMerkleRoot = record.merkle_root;
+        index.nTime = record.time;
+        index.nBits = record.bits;
+        index.nNonce = record.nonce;
+        snapshot_sum += UintToArith256(BlockIndexEntryDigest(record.hash, index));
+    }
+
+    cursor.Seek(std::make_pair(kernel::DB_BLOCK_INDEX, uint256()));
+    for (; cursor.Valid(); cursor.Next()) {
+        if (m_interrupt) return;
+        std::pair<uint8_t, uint256> key;
+        if (!cursor.GetKey(key) || key.first != kernel::DB_BLOCK_INDEX) break;
+        CDiskBlockIndex index;
+        if (!cursor.GetValue(index)) break;
+        db_sum += UintToArith256(BlockIndexEntryDigest(key.second, index));
+        ++db_count;
+    }
+
+    if (snapshot_sum != db_sum || snapshot_count != db_count) {
+        LogError("Block index snapshot (%u entries) does not match the block index database (%u entries)\n", snapshot_count, db_count);
+        fs::remove(BlockIndexSnapshotPath());
+        m_opts.notifications.fatalError(_("The block index snapshot does not match the block index database and has been removed. Please restart."));
+        return;
+    }
+    m_block_index_snapshot_verified = true;
+    LogInfo("Block index snapshot matches the block index database (%u entries, checked in %.2fs)\n",
+            snapshot_count, Ticks<SecondsDouble>(SteadyClock::now() - start));
+}
+
+void BlockManager::WaitForBlockIndexSnapshotCheck()
+{
+    if (m_block_index_snapshot_check.joinable()) m_block_index_snapshot_check.join();
+}
+
+bool BlockManager::WriteBlockIndexSnapshot()
 {
-    if (!m_block_tree_db->LoadBlockIndexGuts(
-            GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, m_interrupt)) {
+    AssertLockHeld(cs_main);
+    if (!m_opts.block_index_snapshot) return true;
+    // After an interrupted or failed startup, m_block_index may be partial, and the block
+    // tree database may not even be open.
+    if (!m_block_index_loaded || !m_block_tree_db) return true;
+    // An index loaded from a snapshot that did not match the database, or whose check was
+    // interrupted, must not be persisted in any form.
+    if (m_loaded_block_index_snapshot) {
+        WaitForBlockIndexSnapshotCheck();
+        if (!m_block_index_snapshot_verified) {
+            LogInfo("Not writing the block index snapshot, as the loaded one was not verified\n");
+            return true;
+        }
+    }
+    const auto start{SteadyClock::now()};
+
+    // The snapshot must match the block index entries in the database.
+    if ((!m_dirty_blockindex.empty() || !m_dirty_fileinfo.empty()) && !WriteBlockIndexDB()) return false;
+
+    std::vector<CBlockIndex*> sorted_by_height{GetAllBlockIndices()};
+    std::sort(sorted_by_height.begin(), sorted_by_height.end(), CBlockIndexHeightOnlyComparator());
+    std::unordered_map<const CBlockIndex*, uint32_t> record_nums;
+    record_nums.reserve(sorted_by_height.size());
+
+    const fs::path path{BlockIndexSnapshotPath()};
+    const uint64_t id{FastRandomContext{}.rand64()};
+    AutoFile file{fsbridge::fopen(path + ".new", "wb")};
+    if (file.IsNull()) {
+        LogError("%s: failed to open %s\n", __func__, fs::PathToString(path + ".new"));
         return false;
     }
+    try {
+        HashedSourceWriter writer{file};
+        writer << BLOCK_INDEX_SNAPSHOT_MAGIC << BLOCK_INDEX_SNAPSHOT_VERSION << id << uint64_t{sorted_by_height.size()};
+        for (const CBlockIndex* pindex : sorted_by_height) {
+            BlockIndexSnapshotRecord record;
+            record.hash = pindex->GetBlockHash();
+            if (pindex->pprev) record.prev = record_nums.at(pindex->pprev);
+            record.height = pindex->nHeight;
+            record.status = pindex->nStatus;
+            record.tx = pindex->nTx;
+            if (pindex->nStatus & (BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO)) record.file = pindex->nFile;
+            if (pindex->nStatus & BLOCK_HAVE_DATA) record.data_pos = pindex->nDataPos;
+            if (pindex->nStatus & BLOCK_HAVE_UNDO) record.undo_pos = pindex->nUndoPos;
+            record.version = pindex->nVersion;
+            record.merkle_root = pindex->hashMerkleRoot;
+            record.time = pindex->nTime;
+            record.bits = pindex->nBits;
+            record.nonce = pindex->nNonce;
+            writer << record;
+            record_nums.emplace(pindex, record_nums.size());
+        }
+        file << writer.GetHash();
+        if (!file.Commit()) throw std::runtime_error("Commit failed");
+        if (file.fclose() != 0) throw std::runtime_error("Close failed");
+        if (!RenameOver(path + ".new", path)) throw std::runtime_error("Rename failed");
+    } catch (const std::exception& e) {
+        LogError("%s: failed to write block index snapshot: %s\n", __func__, e.what());
+        return false;
+    }
+    if (!m_block_tree_db->WriteBlockIndexSnapshotId(id)) return false;
+    LogInfo("Wrote %u block index entries to %s in %.2fs\n", sorted_by_height.size(), fs::PathToString(path), Ticks<SecondsDouble>(SteadyClock::now() - start));
+    return true;
+}
+
+bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
+{
+    std::vector<CBlockIndex*> vSortedByHeight;
+    if (!LoadBlockIndexSnapshot(vSortedByHeight)) {
+        if (!m_block_tree_db->LoadBlockIndexGuts(
+                GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, m_interrupt)) {
+            return false;
+        }
+        vSortedByHeight = GetAllBlockIndices();
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
+                  CBlockIndexHeightOnlyComparator());
+    }
 
     if (snapshot_blockhash) {
         const std::optional<AssumeutxoData> maybe_au_data = GetParams().AssumeutxoForBlockhash(*snapshot_blockhash);
@@ -426,10 +802,6 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
     Assert(m_snapshot_height.has_value() == snapshot_blockhash.has_value());
 
     // Calculate nChainWork
-    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
-
     CBlockIndex* previous_index{nullptr};
     for (CBlockIndex* pindex : vSortedByHeight) {
         if (m_interrupt) return false;
@@ -535,9 +907,15 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
     }
 
     {
-        // Initialize the blockfile cursors.
+        // Initialize the blockfile cursors. Files holding only kept blocks are not
+        // written to by the chainstates.
         LOCK(cs_LastBlockFile);
+        const std::set<int> kept_files{KeptBlockFiles()};
         for (size_t i = 0; i < m_blockfile_info.size(); ++i) {
+            if (kept_files.contains(static_cast<int>(i))) {
+                m_kept_blockfile = static_cast<int>(i);
+                continue;
+            }
             const auto last_height_in_file = m_blockfile_info[i].nHeightLast;
             m_blockfile_cursors[BlockfileTypeForHeight(last_height_in_file)] = {static_cast<int>(i), 0};
         }
@@ -554,6 +932,7 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
     m_block_tree_db->ReadReindexing(fReindexing);
     if (fReindexing) m_blockfiles_indexed = false;
 
+    m_block_index_loaded = true;
     return true;
 }
 
@@ -699,7 +1078,11 @@ bool BlockManager::UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos
 bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const
 {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    return UndoReadFromDisk(blockundo, pos, index.pprev->GetBlockHash());
+}
 
+bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_hash) const
+{
     // Open history file to read
     AutoFile filein{OpenUndoFile(pos, true)};
     if (filein.IsNull()) {
@@ -711,7 +1094,7 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& in
     uint256 hashChecksum;
     HashVerifier verifier{filein}; // Use HashVerifier as reserializing may lose data, c.f. commit d342424301013ec47dc146a4beb49d5c9319d80a
     try {
-        verifier << index.pprev->GetBlockHash();
+        verifier << prev_hash;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception& e) {
@@ -782,6 +1165,11 @@ bool BlockManager::FlushChainstateBlockFile(int tip_height)
     // If the cursor does not exist, it means an assumeutxo snapshot is loaded,
     // but no blocks past the snapshot height have been written yet, so there
     // is no data associated with the chainstate, and it is safe not to flush.
+    // Blocks moved by pruning must be on disk before the block index points to them.
+    if (m_kept_blockfile && !m_block_file_seq.Flush(FlatFilePos{*m_kept_blockfile, m_blockfile_info[*m_kept_blockfile].nSize})) {
+        m_opts.notifications.flushError(_("Flushing block file to disk failed. This is likely the result of an I/O error."));
+        return false;
+    }
     if (cursor) {
         return FlushBlockFile(cursor->file_num, /*fFinalize=*/false, /*finalize_undo=*/false);
     }
@@ -807,6 +1195,11 @@ void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
         FlatFilePos pos(*it, 0);
         const bool removed_blockfile{fs::remove(m_block_file_seq.FileName(pos), ec)};
         const bool removed_undofile{fs::remove(m_undo_file_seq.FileName(pos), ec)};
+        {
+            LOCK(m_compressed_tables_mutex);
+            m_compressed_tables.erase(*it);
+            m_uncompressed_files.erase(*it);
+        }
         if (removed_blockfile || removed_undofile) {
             LogDebug(BCLog::BLOCKSTORAGE, "Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
         }
@@ -919,6 +1312,38 @@ FlatFilePos BlockManager::FindNextBlockPos(unsigned int nAddSize, unsigned int n
     return pos;
 }
 
+FlatFilePos BlockManager::FindKeptBlockPos(unsigned int nAddSize, unsigned int nHeight, uint64_t nTime)
+{
+    AssertLockHeld(cs_LastBlockFile);
+
+    const unsigned int max_blockfile_size{m_opts.fast_prune ? std::max(0x10000U, nAddSize + 1) : MAX_BLOCKFILE_SIZE};
+    assert(nAddSize < max_blockfile_size);
+    if (!m_kept_blockfile || m_blockfile_info[*m_kept_blockfile].nSize + nAddSize >= max_blockfile_size) {
+        if (m_kept_blockfile && !m_block_file_seq.Flush(FlatFilePos{*m_kept_blockfile, m_blockfile_info[*m_kept_blockfile].nSize}, /*finalize=*/true)) {
+            LogPrintLevel(BCLog::BLOCKSTORAGE, BCLog::Level::Warning, "Failed to flush kept block file %05i\n", *m_kept_blockfile);
+        }
+        m_kept_blockfile = this->MaxBlockfileNum() + 1;
+        if (static_cast<int>(m_blockfile_info.size()) <= *m_kept_blockfile) {
+            m_blockfile_info.resize(*m_kept_blockfile + 1);
+        }
+        LogDebug(BCLog::BLOCKSTORAGE, "Moving kept blocks to block file %i\n", *m_kept_blockfile);
+    }
+    const int nFile{*m_kept_blockfile};
+    FlatFilePos pos{nFile, m_blockfile_info[nFile].nSize};
+    m_blockfile_info[nFile].AddBlock(nHeight, nTime);
+    m_blockfile_info[nFile].nSize += nAddSize;
+
+    bool out_of_space;
+    m_block_file_seq.Allocate(pos, nAddSize, out_of_space);
+    if (out_of_space) {
+        m_opts.notifications.fatalError(_("Disk space is too low!"));
+        return {};
+    }
+
+    m_dirty_fileinfo.insert(nFile);
+    return pos;
+}
+
 void BlockManager::UpdateBlockInfo(const CBlock& block, unsigned int nHeight, const FlatFilePos& pos)
 {
     LOCK(cs_LastBlockFile);
@@ -1031,6 +1456,7 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
     block.SetNull();
 
     // Open history file to read
+    const uint64_t compression_generation{GetCompressionGeneration()};
     AutoFile filein{OpenBlockFile(pos, true)};
     if (filein.IsNull()) {
         LogError("%s: OpenBlockFile failed for %s\n", __func__, pos.ToString());
@@ -1039,7 +1465,11 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
 
     // Read block
     try {
-        filein >> TX_WITH_WITNESS(block);
+        if (const auto data{ReadFromCompressedFile(filein, pos, compression_generation)}) {
+            SpanReader{*data} >> TX_WITH_WITNESS(block);
+        } else {
+            filein >> TX_WITH_WITNESS(block);
+        }
     } catch (const std::exception& e) {
         LogError("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
         return false;
@@ -1084,6 +1514,7 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
         return false;
     }
     hpos.nPos -= 8; // Seek back 8 bytes for meta header
+    const uint64_t compression_generation{GetCompressionGeneration()};
     AutoFile filein{OpenBlockFile(hpos, true)};
     if (filein.IsNull()) {
         LogError("%s: OpenBlockFile failed for %s\n", __func__, pos.ToString());
@@ -1091,6 +1522,11 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     }
 
     try {
+        if (auto data{ReadFromCompressedFile(filein, pos, compression_generation)}) {
+            block = std::move(*data);
+            return true;
+        }
+
         MessageStartChars blk_start;
         unsigned int blk_size;
 
@@ -1119,6 +1555,421 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+std::optional<std::vector<uint8_t>> BlockManager::ReadFromCompressedFile(AutoFile& file, const FlatFilePos& pos, uint64_t generation, uint32_t max_size) const
+{
+    // Block files are only ever replaced by compressed ones, so a file with a loaded
+    // table needs no check. Files known to be uncompressed are dropped from
+    // m_uncompressed_files when they are replaced.
+    std::shared_ptr<const std::vector<CompressedBlockRecord>> table;
+    {
+        LOCK(m_compressed_tables_mutex);
+        if (m_uncompressed_files.contains(pos.nFile)) return std::nullopt;
+        if (const auto it{m_compressed_tables.find(pos.nFile)}; it != m_compressed_tables.end()) table = it->second;
+    }
+    if (!table) {
+        const int64_t file_pos{file.tell()};
+        file.seek(0, SEEK_SET);
+        if (!IsCompressedBlockFile(file)) {
+            file.seek(file_pos, SEEK_SET);
+            // If the file was replaced since it was opened, its replacement is compressed.
+            LOCK(m_compressed_tables_mutex);
+            if (m_compression_generation.load() == generation) m_uncompressed_files.insert(pos.nFile);
+            return std::nullopt;
+        }
+        table = std::make_shared<const std::vector<CompressedBlockRecord>>(ReadCompressedBlockTable(file));
+        WITH_LOCK(m_compressed_tables_mutex, m_compressed_tables.try_emplace(pos.nFile, table));
+    }
+    const auto it{std::ranges::lower_bound(*table, pos.nPos, {}, &CompressedBlockRecord::pos)};
+    if (it == table->end() || it->pos != pos.nPos) {
+        throw std::ios_base::failure(strprintf("no block at offset %u of compressed block file", pos.nPos));
+    }
+    return ReadCompressedBlock(file, *it, max_size);
+}
+
+template <typename Read>
+auto BlockManager::ReadAsync(ThreadPool& pool, std::once_flag& pool_started, std::span<const FlatFilePos> positions, Read read) const
+{
+    using Result = std::invoke_result_t<Read, size_t>;
+    std::vector<std::future<Result>> results(positions.size());
+    // Neighbouring reads go out together, which helps readahead on spinning disks.
+    std::vector<size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::tie(positions[a].nFile, positions[a].nPos) < std::tie(positions[b].nFile, positions[b].nPos);
+    });
+    const int threads{m_opts.block_read_threads};
+    if (threads > 0) std::call_once(pool_started, [&] { pool.Start(threads); });
+    for (const size_t i : order) {
+        if (threads > 0) {
+            results[i] = pool.Submit([read, i] { return read(i); });
+        } else {
+            std::promise<Result> promise;
+            promise.set_value(read(i));
+            results[i] = promise.get_future();
+        }
+    }
+    return results;
+}
+
+std::vector<std::future<std::shared_ptr<const CBlock>>> BlockManager::ReadBlocksAsync(std::span<const CBlockIndex* const> blocks) const
+{
+    auto requests{std::make_shared<std::vector<std::pair<FlatFilePos, uint256>>>()};
+    requests->reserve(blocks.size());
+    {
+        LOCK(::cs_main);
+        for (const CBlockIndex* block : blocks) requests->emplace_back(block->GetBlockPos(), block->GetBlockHash());
+    }
+    std::vector<FlatFilePos> positions;
+    for (const auto& [pos, hash] : *requests) positions.push_back(pos);
+    return ReadAsync(positions, [this, requests](size_t i) -> std::shared_ptr<const CBlock> {
+        const auto& [pos, hash]{(*requests)[i]};
+        auto block{std::make_shared<CBlock>()};
+        if (!ReadBlockFromDisk(*block, pos)) return nullptr;
+        if (block->GetHash() != hash) {
+            LogError("%s: GetHash() doesn't match index for %s at %s\n", __func__, hash.ToString(), pos.ToString());
+            return nullptr;
+        }
+        return block;
+    });
+}
+
+std::vector<std::future<std::optional<std::vector<uint8_t>>>> BlockManager::ReadRawBlocksAsync(std::span<const FlatFilePos> positions) const
+{
+    auto requests{std::make_shared<std::vector<FlatFilePos>>(positions.begin(), positions.end())};
+    return ReadAsync(positions, [this, requests](size_t i) -> std::optional<std::vector<uint8_t>> {
+        std::vector<uint8_t> block;
+        if (!ReadRawBlockFromDisk(block, (*requests)[i])) return std::nullopt;
+        return block;
+    });
+}
+
+std::vector<std::future<std::shared_ptr<const CBlock>>> BlockManager::ReadBlocksAsync(std::span<const BlockFileEntry> entries) const
+{
+    auto requests{std::make_shared<std::vector<BlockFileEntry>>(entries.begin(), entries.end())};
+    std::vector<FlatFilePos> positions;
+    for (const BlockFileEntry& entry : entries) positions.push_back(entry.pos);
+    return ReadAsync(positions, [this, requests](size_t i) -> std::shared_ptr<const CBlock> {
+        const BlockFileEntry& entry{(*requests)[i]};
+        auto block{std::make_shared<CBlock>()};
+        if (!ReadBlockFromDisk(*block, entry.pos) || block->GetHash() != entry.hash) return nullptr;
+        return block;
+    });
+}
+
+std::optional<std::vector<BlockFileEntry>> BlockManager::ScanBlockFile(int file_number) const
+{
+    AutoFile file{OpenBlockFile(FlatFilePos{file_number, 0}, /*fReadOnly=*/true)};
+    if (file.IsNull()) return std::nullopt;
+
+    const MessageStartChars& message_start{GetParams().MessageStart()};
+    std::vector<BlockFileEntry> entries;
+    uint64_t pos{0};
+    try {
+        if (IsCompressedBlockFile(file)) {
+            for (const CompressedBlockRecord& record : ReadCompressedBlockTable(file)) {
+                if (m_interrupt) break;
+                pos = record.frame_pos;
+                CBlockHeader header;
+                SpanReader{ReadCompressedBlock(file, record, /*max_size=*/80)} >> header;
+                entries.push_back({header.GetHash(), header.hashPrevBlock, FlatFilePos{file_number, record.pos}});
+            }
+            return entries;
+        }
+        file.seek(0, SEEK_END);
+        const uint64_t file_size{uint64_t(file.tell())};
+        std::vector<std::byte> buffer(1 << 16);
+        while (pos + BLOCK_SERIALIZATION_HEADER_SIZE + 80 <= file_size) {
+            if (m_interrupt) break;
+            file.seek(pos, SEEK_SET);
+            MessageStartChars start;
+            unsigned int size;
+            file >> start >> size;
+            if (start != message_start || size < 80 || size > MAX_BLOCK_SERIALIZED_SIZE) {
+                // Search for the next message start, one byte further.
+                uint64_t search_pos{pos + 1};
+                pos = file_size;
+                while (search_pos + message_start.size() <= file_size) {
+                    const size_t len{size_t(std::min<uint64_t>(buffer.size(), file_size - search_pos))};
+                    file.seek(search_pos, SEEK_SET);
+                    file.read(Span{buffer}.first(len));
+                    const auto magic{std::as_bytes(std::span{message_start})};
+                    const auto found{std::search(buffer.begin(), buffer.begin() + len, magic.begin(), magic.end())};
+                    if (found != buffer.begin() + len) {
+                        pos = search_pos + (found - buffer.begin());
+                        break;
+                    }
+                    search_pos += len - (message_start.size() - 1);
+                }
+                continue;
+            }
+            const uint64_t block_pos{pos + BLOCK_SERIALIZATION_HEADER_SIZE};
+            // A block cut short at the end of the file, as after a crash, is not loaded.
+            if (block_pos + size > file_size) break;
+            CBlockHeader header;
+            file >> header;
+            entries.push_back({header.GetHash(), header.hashPrevBlock, FlatFilePos{file_number, unsigned(block_pos)}});
+            pos = block_pos + size;
+        }
+    } catch (const std::exception& e) {
+        LogDebug(BCLog::REINDEX, "%s: unexpected data in blk%05u.dat at offset 0x%x - %s\n", __func__, file_number, pos, e.what());
+    }
+    return entries;
+}
+
+std::vector<std::future<std::optional<std::vector<BlockFileEntry>>>> BlockManager::ScanBlockFilesAsync(int first_file, int count) const
+{
+    std::vector<FlatFilePos> positions;
+    for (int i{0}; i < count; ++i) positions.emplace_back(first_file + i, 0);
+    return ReadAsync(m_scan_pool, m_scan_pool_started, positions, [this, first_file](size_t i) { return ScanBlockFile(first_file + int(i)); });
+}
+
+bool BlockManager::CompressBlockFile(int file_number)
+{
+    {
+        LOCK(cs_LastBlockFile);
+        if (file_number < 0 || size_t(file_number) >= m_blockfile_info.size() || m_blockfile_info[file_number].nSize == 0) return false;
+        if (std::ranges::any_of(m_blockfile_cursors, [&](const auto& cursor) { return cursor && cursor->file_num == file_number; })) return false;
+        if (m_kept_blockfile == file_number) return false;
+    }
+    const fs::path path{GetBlockPosFilename(FlatFilePos{file_number, 0})};
+    const fs::path tmp_path{fs::PathFromString(fs::PathToString(path) + ".tmp")};
+    std::error_code ec;
+
+    // Returns the sizes of the original and the compressed file, or nullopt if it is not replaced.
+    const auto write_compressed{[&]() -> std::optional<std::pair<uint64_t, uint64_t>> {
+        AutoFile file{OpenBlockFile(FlatFilePos{file_number, 0}, /*fReadOnly=*/true)};
+        if (file.IsNull() || IsCompressedBlockFile(file)) return std::nullopt;
+        // The scan stops early when interrupted, so check before using its result.
+        const auto entries{ScanBlockFile(file_number)};
+        if (!entries || m_interrupt) return std::nullopt;
+        file.seek(0, SEEK_END);
+        const uint64_t size{uint64_t(file.tell())};
+
+        std::vector<uint8_t> data;
+        const auto read_block{[&](const BlockFileEntry& entry) {
+            unsigned int block_size;
+            file.seek(entry.pos.nPos - sizeof(block_size), SEEK_SET);
+            file >> block_size;
+            data.resize(block_size);
+            file.read(MakeWritableByteSpan(data));
+        }};
+
+        AutoFile out{fsbridge::fopen(tmp_path, "wb"), m_xor_key};
+        if (out.IsNull()) throw std::ios_base::failure("failed to create " + fs::PathToString(tmp_path));
+        CompressedBlockFileWriter writer{out, entries->size()};
+        for (const BlockFileEntry& entry : *entries) {
+            if (m_interrupt) return std::nullopt;
+            read_block(entry);
+            writer.Add(entry.pos.nPos, data);
+        }
+        const uint64_t compressed_size{writer.Finish()};
+        if (!out.Commit() || out.fclose() != 0) throw std::ios_base::failure("failed to write " + fs::PathToString(tmp_path));
+
+        // Decompress every frame of the written file and compare it with the original
+        // before the original is replaced.
+        AutoFile check{fsbridge::fopen(tmp_path, "rb"), m_xor_key};
+        if (check.IsNull() || !IsCompressedBlockFile(check)) throw std::ios_base::failure("failed to read back " + fs::PathToString(tmp_path));
+        const auto table{ReadCompressedBlockTable(check)};
+        if (table.size() != entries->size()) throw std::ios_base::failure("block table does not match after compression");
+        for (size_t i{0}; i < table.size(); ++i) {
+            if (m_interrupt) return std::nullopt;
+            read_block((*entries)[i]);
+            const std::vector<uint8_t> decompressed{ReadCompressedBlock(check, table[i])};
+            if (table[i].pos != (*entries)[i].pos.nPos || decompressed != data) {
+                throw std::ios_base::failure(strprintf("block at offset %u does not match after compression", (*entries)[i].pos.nPos));
+            }
+        }
+        return std::pair{size, compressed_size};
+    }};
+
+    std::optional<std::pair<uint64_t, uint64_t>> sizes;
+    try {
+        sizes = write_compressed();
+    } catch (const std::exception& e) {
+        LogError("%s: failed to compress blk%05u.dat: %s\n", __func__, file_number, e.what());
+    }
+    if (!sizes || sizes->second >= sizes->first) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    {
+        // Pruning may have deleted the file meanwhile, which the rename would undo.
+        LOCK(cs_LastBlockFile);
+        if (m_blockfile_info[file_number].nSize == 0 || !RenameOver(tmp_path, path)) {
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    {
+        LOCK(m_compressed_tables_mutex);
+        m_uncompressed_files.erase(file_number);
+        ++m_compression_generation;
+    }
+    DirectoryCommit(m_opts.blocks_dir);
+    LogDebug(BCLog::BLOCKSTORAGE, "Compressed blk%05u.dat from %u to %u bytes\n", file_number, sizes->first, sizes->second);
+    return true;
+}
+
+std::optional<int> BlockManager::NextBlockFileToCompress(const std::set<int>& skip)
+{
+    int max_height{0};
+    for (const CBlockFileInfo& info : m_blockfile_info) max_height = std::max(max_height, int(info.nHeightLast));
+    for (int file_number{0}; file_number < int(m_blockfile_info.size()); ++file_number) {
+        const CBlockFileInfo& info{m_blockfile_info[file_number]};
+        if (skip.contains(file_number) || info.nSize == 0 || int(info.nHeightLast) + COMPRESS_BLOCKFILE_MIN_DEPTH > max_height) continue;
+        if (std::ranges::any_of(m_blockfile_cursors, [&](const auto& cursor) { return cursor && cursor->file_num == file_number; })) continue;
+        if (m_kept_blockfile == file_number) continue;
+        return file_number;
+    }
+    return std::nullopt;
+}
+
+void BlockManager::ThreadCompressBlockFiles()
+{
+    // Files handled in this run. After a restart, files compressed earlier are skipped
+    // once their magic has been read.
+    std::set<int> done;
+    while (true) {
+        const auto file_number{WITH_LOCK(cs_LastBlockFile, return NextBlockFileToCompress(done))};
+        if (file_number) {
+            CompressBlockFile(*file_number);
+            done.insert(*file_number);
+        }
+        WAIT_LOCK(m_compression_mutex, lock);
+        if (!file_number) {
+            m_compression_cv.wait_for(lock, std::chrono::minutes{1}, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_compression_mutex) { return m_compression_stop; });
+        }
+        if (m_compression_stop || m_interrupt) return;
+    }
+}
+
+void BlockManager::StartBlockFileCompression()
+{
+    if (!m_opts.compress_block_files) return;
+    LOCK(m_compression_mutex);
+    if (m_compression_thread.joinable() || m_compression_stop) return;
+    m_compression_thread = std::thread{&util::TraceThread, "blkcompress", [this] { ThreadCompressBlockFiles(); }};
+}
+
+std::vector<std::future<std::shared_ptr<const CBlockUndo>>> BlockManager::UndoReadAsync(std::span<const CBlockIndex* const> blocks) const
+{
+    // A null previous hash marks the genesis block, which has no undo data, and a null
+    // position a block whose undo data was never written.
+    auto requests{std::make_shared<std::vector<std::pair<FlatFilePos, uint256>>>()};
+    requests->reserve(blocks.size());
+    {
+        LOCK(::cs_main);
+        for (const CBlockIndex* block : blocks) {
+            requests->emplace_back(block->nStatus & BLOCK_HAVE_UNDO ? block->GetUndoPos() : FlatFilePos{},
+                                   block->pprev ? block->pprev->GetBlockHash() : uint256{});
+        }
+    }
+    std::vector<FlatFilePos> positions;
+    for (const auto& [pos, prev_hash] : *requests) positions.push_back(pos);
+    return ReadAsync(positions, [this, requests](size_t i) -> std::shared_ptr<const CBlockUndo> {
+        const auto& [pos, prev_hash]{(*requests)[i]};
+        auto undo{std::make_shared<CBlockUndo>()};
+        if (prev_hash.IsNull()) return undo;
+        if (pos.IsNull() || !UndoReadFromDisk(*undo, pos, prev_hash)) return nullptr;
+        return undo;
+    });
+}
+
+/** Approximate memory usage of a block and its undo data. */
+static size_t BlockAndUndoUsage(const BlockAndUndo& data)
+{
+    size_t usage{RecursiveDynamicUsage(data.block) + memusage::DynamicUsage(data.undo) + memusage::DynamicUsage(data.undo->vtxundo)};
+    for (const CTxUndo& tx_undo : data.undo->vtxundo) {
+        usage += memusage::DynamicUsage(tx_undo.vprevout);
+        for (const Coin& coin : tx_undo.vprevout) usage += coin.DynamicMemoryUsage();
+    }
+    return usage;
+}
+
+std::vector<std::future<BlockAndUndo>> BlockManager::ReadBlocksAndUndoAsync(std::span<const CBlockIndex* const> blocks, bool use_cache) const
+{
+    std::vector<std::future<BlockAndUndo>> results(blocks.size());
+    std::vector<const CBlockIndex*> misses;
+    std::vector<size_t> miss_indices;
+    if (use_cache) {
+        // Cached blocks are only served while the block index still has their data and
+        // their files are there, so that a pruned block or a lost file is reported the
+        // same way with and without the cache. The files are looked up before any lock
+        // is taken.
+        std::vector<bool> have_data;
+        std::vector<std::pair<FlatFilePos, FlatFilePos>> positions;
+        have_data.reserve(blocks.size());
+        positions.reserve(blocks.size());
+        {
+            LOCK(::cs_main);
+            for (const CBlockIndex* block : blocks) {
+                have_data.push_back((block->nStatus & BLOCK_HAVE_DATA) && (!block->pprev || (block->nStatus & BLOCK_HAVE_UNDO)));
+                positions.emplace_back(block->GetBlockPos(), block->pprev ? block->GetUndoPos() : FlatFilePos{});
+            }
+        }
+        for (size_t i{0}; i < blocks.size(); ++i) {
+            const auto& [block_pos, undo_pos]{positions[i]};
+            have_data[i] = have_data[i] && fs::exists(m_block_file_seq.FileName(block_pos)) &&
+                           (undo_pos.IsNull() || fs::exists(m_undo_file_seq.FileName(undo_pos)));
+        }
+        LOCK(m_block_and_undo_cache_mutex);
+        for (size_t i{0}; i < blocks.size(); ++i) {
+            const auto it{std::ranges::find(m_block_and_undo_cache, blocks[i]->GetBlockHash(), [](const auto& entry) -> const uint256& { return std::get<0>(entry); })};
+            if (it == m_block_and_undo_cache.end() || !have_data[i]) {
+                misses.push_back(blocks[i]);
+                miss_indices.push_back(i);
+                continue;
+            }
+            m_block_and_undo_cache.splice(m_block_and_undo_cache.begin(), m_block_and_undo_cache, it);
+            std::promise<BlockAndUndo> promise;
+            promise.set_value(std::get<1>(*it));
+            results[i] = promise.get_future();
+        }
+    } else {
+        misses.assign(blocks.begin(), blocks.end());
+        miss_indices.resize(blocks.size());
+        std::iota(miss_indices.begin(), miss_indices.end(), 0);
+    }
+    if (misses.empty()) return results;
+
+    // Both reads of every block are queued before any result is waited for. The pair
+    // is put together, and cached, in the thread that asks for it.
+    auto block_futures{ReadBlocksAsync(misses)};
+    auto undo_futures{UndoReadAsync(misses)};
+    for (size_t j{0}; j < misses.size(); ++j) {
+        results[miss_indices[j]] = std::async(std::launch::deferred, [this, use_cache, hash = misses[j]->GetBlockHash(), block = std::move(block_futures[j]), undo = std::move(undo_futures[j])]() mutable {
+            BlockAndUndo result{block.get(), undo.get()};
+            if (use_cache && result.block && result.undo) {
+                const size_t usage{BlockAndUndoUsage(result)};
+                LOCK(m_block_and_undo_cache_mutex);
+                if (usage <= BLOCK_AND_UNDO_CACHE_BYTES &&
+                    std::ranges::find(m_block_and_undo_cache, hash, [](const auto& entry) -> const uint256& { return std::get<0>(entry); }) == m_block_and_undo_cache.end()) {
+                    m_block_and_undo_cache.emplace_front(hash, result, usage);
+                    m_block_and_undo_cache_usage += usage;
+                    while (m_block_and_undo_cache_usage > BLOCK_AND_UNDO_CACHE_BYTES) {
+                        m_block_and_undo_cache_usage -= std::get<2>(m_block_and_undo_cache.back());
+                        m_block_and_undo_cache.pop_back();
+                    }
+                }
+            }
+            return result;
+        });
+    }
+    return results;
+}
+
+BlockAndUndo BlockManager::ReadBlockAndUndo(const CBlockIndex& index) const
+{
+    const CBlockIndex* const block{&index};
+    return ReadBlocksAndUndoAsync({&block, 1}).front().get();
+}
+
+size_t BlockManager::BlockAndUndoCacheUsage() const
+{
+    LOCK(m_block_and_undo_cache_mutex);
+    return m_block_and_undo_cache_usage;
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight)
 {
     unsigned int nBlockSize = ::GetSerializeSize(TX_WITH_WITNESS(block));
@@ -1185,6 +2036,16 @@ BlockManager::BlockManager(const util::SignalInterrupt& interrupt, Options opts)
       m_undo_file_seq{FlatFileSeq{m_opts.blocks_dir, "rev", UNDOFILE_CHUNK_SIZE}},
       m_interrupt{interrupt} {}
 
+BlockManager::~BlockManager()
+{
+    WITH_LOCK(m_compression_mutex, m_compression_stop = true);
+    m_compression_cv.notify_all();
+    if (m_compression_thread.joinable()) m_compression_thread.join();
+    m_scan_pool.Stop();
+    m_read_pool.Stop();
+    WaitForBlockIndexSnapshotCheck();
+}
+
 class ImportingNow
 {
     std::atomic<bool>& m_importing;
@@ -1212,17 +2073,26 @@ void ImportBlocks(ChainstateManager& chainman, std::span<const fs::path> import_
         // Map of disk positions for blocks with unknown parent (only used for reindex);
         // parent hash -> child disk position, multiple children can have the same parent.
         std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
+        // The next files are scanned for their block headers on the scan threads while
+        // the blocks of the current one are loaded. Files are loaded in order, so the
+        // block index is built the same way as by a scan of one file after the other.
+        const size_t scan_ahead{size_t(std::max(1, chainman.m_blockman.BlockReadThreads()))};
+        std::deque<std::future<std::optional<std::vector<BlockFileEntry>>>> scans;
+        int next_scan{0};
         while (true) {
-            FlatFilePos pos(nFile, 0);
-            if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
+            while (scans.size() < scan_ahead && fs::exists(chainman.m_blockman.GetBlockPosFilename(FlatFilePos(next_scan, 0)))) {
+                scans.push_back(std::move(chainman.m_blockman.ScanBlockFilesAsync(next_scan++, 1).front()));
+            }
+            if (scans.empty()) {
                 break; // No block files left to reindex
             }
-            AutoFile file{chainman.m_blockman.OpenBlockFile(pos, true)};
-            if (file.IsNull()) {
+            const auto entries{scans.front().get()};
+            scans.pop_front();
+            if (!entries) {
                 break; // This error is logged in OpenBlockFile
             }
             LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            chainman.LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
+            chainman.LoadBlockFileEntries(*entries, blocks_with_unknown_parent);
             if (chainman.m_interrupt) {
                 LogPrintf("Interrupt requested. Exit %s\n", __func__);
                 return;
@@ -1263,6 +2133,8 @@ void ImportBlocks(ChainstateManager& chainman, std::span<const fs::path> import_
             return;
         }
     }
+    // Compression only starts now, as -reindex reads the block files as they are.
+    chainman.m_blockman.StartBlockFileCompression();
     // End scope of ImportingNow
 }
 
@@ -13,25 +13,34 @@
 #include <kernel/chainparams.h>
 #include <kernel/cs_main.h>
 #include <kernel/messagestartchars.h>
+#include <node/blockcompression.h>
 #include <primitives/block.h>
 #include <streams.h>
 #include <sync.h>
 #include <uint256.h>
 #include <util/fs.h>
 #include <util/hasher.h>
+#include <util/threadpool.h>
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <span>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -61,6 +70,10 @@ public:
     bool ReadFlag(const std::string& name, bool& fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Identifier of the block index snapshot matching the block index entries in this
+     * database. Erased by the first WriteBatchSync() that writes block index entries. */
+    bool WriteBlockIndexSnapshotId(uint64_t id);
+    std::optional<uint64_t> ReadBlockIndexSnapshotId();
 };
 } // namespace kernel
 
@@ -77,6 +90,9 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = std::tuple_size_v<MessageStartChars> + sizeof(unsigned int);
 
+/** Memory the recently read blocks kept with their undo data may use, see BlockManager::ReadBlocksAndUndoAsync() */
+static constexpr size_t BLOCK_AND_UNDO_CACHE_BYTES{32 << 20};
+
 // Because validation code takes pointers to the map's CBlockIndex objects, if
 // we ever switch to another associative container, we need to either use a
 // container that has stable addressing (true of all std associative
@@ -125,6 +141,22 @@ struct BlockfileCursor {
 std::ostream& operator<<(std::ostream& os, const BlockfileCursor& cursor);
 
 
+/** A block together with its undo data, see BlockManager::ReadBlockAndUndo(). */
+struct BlockAndUndo {
+    //! Null if the block could not be read.
+    std::shared_ptr<const CBlock> block;
+    //! Empty for the genesis block. Null if the block has no undo data or it could not be read.
+    std::shared_ptr<const CBlockUndo> undo;
+};
+
+/** A block found by scanning a block file, see BlockManager::ScanBlockFilesAsync(). */
+struct BlockFileEntry {
+    uint256 hash;
+    uint256 prev_hash;
+    //! Position of the block data, after the message start and size.
+    FlatFilePos pos;
+};
+
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
  * to determine where the most-work tip is.
@@ -148,6 +180,19 @@ private:
     bool LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Fill m_block_index from the flat block index snapshot, if enabled, and return the
+     * entries in height order. Fails, leaving m_block_index empty, if the snapshot is
+     * missing, corrupt, or does not match the block tree database.
+     */
+    bool LoadBlockIndexSnapshot(std::vector<CBlockIndex*>& sorted_by_height) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Compare a loaded block index snapshot against the block tree database, as seen
+     * by the given cursor, and stop the node if they differ. Runs in the background.
+     */
+    void CheckBlockIndexSnapshot(CDBIterator& cursor, Span<const std::byte> records);
+
     /** Return false if block file or undo file flushing fails. */
     [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo);
 
@@ -166,6 +211,12 @@ private:
     [[nodiscard]] FlatFilePos FindNextBlockPos(unsigned int nAddSize, unsigned int nHeight, uint64_t nTime);
     [[nodiscard]] bool FlushChainstateBlockFile(int tip_height);
     bool FindUndoPos(BlockValidationState& state, int nFile, FlatFilePos& pos, unsigned int nAddSize);
+    //! Like FindNextBlockPos(), but in the block file that kept blocks are moved to,
+    //! see m_kept_blockfile.
+    [[nodiscard]] FlatFilePos FindKeptBlockPos(unsigned int nAddSize, unsigned int nHeight, uint64_t nTime) EXCLUSIVE_LOCKS_REQUIRED(cs_LastBlockFile);
+    //! Copy the data of a block to the end of the kept block file and point its index
+    //! entry there, dropping its undo data. Returns the number of bytes written, 0 on failure.
+    uint64_t MoveBlockData(CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_LastBlockFile);
 
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
@@ -225,12 +276,16 @@ private:
             BlockfileCursor{},
             std::nullopt,
     };
+    //! Block file that blocks in the -prunekeepheights ranges are moved to when their
+    //! file is pruned. Kept apart from the files the chainstates write to, so that
+    //! later prunes do not move these blocks again.
+    std::optional<int> m_kept_blockfile GUARDED_BY(cs_LastBlockFile);
     int MaxBlockfileNum() const EXCLUSIVE_LOCKS_REQUIRED(cs_LastBlockFile)
     {
         static const BlockfileCursor empty_cursor;
         const auto& normal = m_blockfile_cursors[BlockfileType::NORMAL].value_or(empty_cursor);
         const auto& assumed = m_blockfile_cursors[BlockfileType::ASSUMED].value_or(empty_cursor);
-        return std::max(normal.file_num, assumed.file_num);
+        return std::max({normal.file_num, assumed.file_num, m_kept_blockfile.value_or(0)});
     }
 
     /** Global flag to indicate we should check to see if there are
@@ -249,6 +304,14 @@ private:
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
+    //! Whether m_block_index was loaded from the flat block index snapshot
+    bool m_loaded_block_index_snapshot{false};
+    //! Whether LoadBlockIndexDB() completed, so that m_block_index holds the whole block index
+    bool m_block_index_loaded{false};
+    std::thread m_block_index_snapshot_check;
+    //! Whether the background check found a loaded snapshot to match the block tree database
+    std::atomic_bool m_block_index_snapshot_verified{false};
+
     /**
      * Map from external index name to oldest block that must not be pruned.
      *
@@ -264,10 +327,59 @@ private:
     const FlatFileSeq m_block_file_seq;
     const FlatFileSeq m_undo_file_seq;
 
+    //! Serves the batched reads, started on first use.
+    mutable ThreadPool m_read_pool{"blkread"};
+    mutable std::once_flag m_read_pool_started;
+    //! Serves the -reindex block file scans, so that the block reads queued at the
+    //! same time don't wait behind scans of whole files. Started on first use.
+    mutable ThreadPool m_scan_pool{"blkscan"};
+    mutable std::once_flag m_scan_pool_started;
+
+    /**
+     * Run read(i) for every position, on the threads of pool in file and offset order
+     * when there are any. Returns the futures in the order of the positions.
+     */
+    template <typename Read>
+    auto ReadAsync(ThreadPool& pool, std::once_flag& pool_started, std::span<const FlatFilePos> positions, Read read) const;
+    template <typename Read>
+    auto ReadAsync(std::span<const FlatFilePos> positions, Read read) const
+    {
+        return ReadAsync(m_read_pool, m_read_pool_started, positions, std::move(read));
+    }
+
+    bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_hash) const;
+    std::optional<std::vector<BlockFileEntry>> ScanBlockFile(int file_number) const;
+
+    mutable Mutex m_block_and_undo_cache_mutex;
+    //! Most recently used first, together with the memory usage of each entry.
+    mutable std::list<std::tuple<uint256, BlockAndUndo, size_t>> m_block_and_undo_cache GUARDED_BY(m_block_and_undo_cache_mutex);
+    //! Total memory usage of m_block_and_undo_cache, at most BLOCK_AND_UNDO_CACHE_BYTES.
+    mutable size_t m_block_and_undo_cache_usage GUARDED_BY(m_block_and_undo_cache_mutex){0};
+
+    //! Block tables of compressed block files, loaded on the first read from each file.
+    mutable Mutex m_compressed_tables_mutex;
+    mutable std::unordered_map<int, std::shared_ptr<const std::vector<CompressedBlockRecord>>> m_compressed_tables GUARDED_BY(m_compressed_tables_mutex);
+    //! Block files found to be uncompressed on an earlier read, whose magic need not be read again.
+    mutable std::unordered_set<int> m_uncompressed_files GUARDED_BY(m_compressed_tables_mutex);
+    //! Incremented, with m_compressed_tables_mutex held, after a block file is replaced by a
+    //! compressed one, see GetCompressionGeneration().
+    std::atomic<uint64_t> m_compression_generation{0};
+
+    Mutex m_compression_mutex;
+    std::condition_variable m_compression_cv;
+    bool m_compression_stop GUARDED_BY(m_compression_mutex){false};
+    std::thread m_compression_thread;
+
+    void ThreadCompressBlockFiles() EXCLUSIVE_LOCKS_REQUIRED(!m_compression_mutex, !cs_LastBlockFile);
+    //! The oldest finalized block file that is not in skip and whose blocks are all
+    //! COMPRESS_BLOCKFILE_MIN_DEPTH below the highest stored block.
+    std::optional<int> NextBlockFileToCompress(const std::set<int>& skip) EXCLUSIVE_LOCKS_REQUIRED(cs_LastBlockFile);
+
 public:
     using Options = kernel::BlockManagerOpts;
 
     explicit BlockManager(const util::SignalInterrupt& interrupt, Options opts);
+    ~BlockManager();
 
     const util::SignalInterrupt& m_interrupt;
     std::atomic<bool> m_importing{false};
@@ -307,6 +419,20 @@ public:
     std::unique_ptr<BlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
     bool WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    /**
+     * Flush the block index and write all of it to a flat file that the next startup can
+     * load instead of reading every entry from the block tree database. No-op unless
+     * -blockindexsnapshot is set, or if the block index was not completely loaded. If it
+     * was loaded from a snapshot, waits for the background check of that snapshot, and
+     * writes nothing (not even dirty entries) unless the check completed with a match.
+     */
+    bool WriteBlockIndexSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    fs::path BlockIndexSnapshotPath() const { return m_opts.blocks_dir / "blockindex.dat"; }
+    bool LoadedBlockIndexSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main) { return m_loaded_block_index_snapshot; }
+    //! Wait for the background comparison of a loaded snapshot with the database. The
+    //! comparison does not take cs_main, so this may be called with it held.
+    void WaitForBlockIndexSnapshotCheck();
     bool LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
@@ -321,8 +447,12 @@ public:
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-    //! Mark one block file as pruned (modify associated database entries)
-    void PruneOneBlockFile(const int fileNumber) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /**
+     * Mark the blocks of a block file as pruned. Blocks in the -prunekeepheights ranges
+     * are first copied to the kept block file, without their undo data. Returns the
+     * number of bytes copied.
+     */
+    uint64_t PruneOneBlockFile(const int fileNumber) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     CBlockIndex* LookupBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     const CBlockIndex* LookupBlockIndex(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -357,6 +487,14 @@ public:
 
     /** Attempt to stay below this number of bytes of block files. */
     [[nodiscard]] uint64_t GetPruneTarget() const { return m_opts.prune_target; }
+
+    //! Number of most recent blocks that are not pruned, see -prunekeeprecent.
+    [[nodiscard]] int MinBlocksToKeep() const;
+    //! Whether a block survives the pruning of its block file, see -prunekeepheights.
+    [[nodiscard]] bool IsInPruneKeepRanges(int height) const;
+    //! Block files whose blocks are all in the -prunekeepheights ranges. Pruning them
+    //! would only move their blocks to another file, so they are skipped.
+    [[nodiscard]] std::set<int> KeptBlockFiles() const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     static constexpr auto PRUNE_TARGET_MANUAL{std::numeric_limits<uint64_t>::max()};
 
     [[nodiscard]] bool LoadingBlocks() const { return m_importing || !m_blockfiles_indexed; }
@@ -425,8 +563,83 @@ public:
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
 
+    /**
+     * Read before opening a block file and pass to ReadFromCompressedFile(), so that a file
+     * opened before it was replaced by a compressed one is not remembered as uncompressed.
+     */
+    uint64_t GetCompressionGeneration() const { return m_compression_generation.load(); }
+
+    /**
+     * If file is a compressed block file, return the data of the block at pos,
+     * decompressed up to max_size bytes. Returns std::nullopt for an uncompressed file,
+     * leaving it at the position it had. Throws if there is no block at pos or the file
+     * is corrupt.
+     *
+     * Which files are compressed is remembered, so the magic of a file is only read
+     * on the first call for it. generation is the value of GetCompressionGeneration()
+     * from before file was opened.
+     */
+    std::optional<std::vector<uint8_t>> ReadFromCompressedFile(AutoFile& file, const FlatFilePos& pos, uint64_t generation,
+                                                               uint32_t max_size = std::numeric_limits<uint32_t>::max()) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_tables_mutex);
+
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
+    /**
+     * Batched reads, served by -blockreadthreads threads so that many reads are in
+     * flight at once. Each returns one future per request, in request order. A future
+     * holds nullptr or std::nullopt if that read failed; undo data of the genesis
+     * block is empty. The block positions are
+     * looked up when the batch is submitted, so the futures may be waited on while
+     * holding cs_main.
+     */
+    std::vector<std::future<std::shared_ptr<const CBlock>>> ReadBlocksAsync(std::span<const CBlockIndex* const> blocks) const;
+    std::vector<std::future<std::optional<std::vector<uint8_t>>>> ReadRawBlocksAsync(std::span<const FlatFilePos> positions) const;
+    std::vector<std::future<std::shared_ptr<const CBlockUndo>>> UndoReadAsync(std::span<const CBlockIndex* const> blocks) const;
+    //! Read the blocks found by ScanBlockFilesAsync(), checking their hashes.
+    std::vector<std::future<std::shared_ptr<const CBlock>>> ReadBlocksAsync(std::span<const BlockFileEntry> entries) const;
+    /**
+     * Read blocks together with their undo data, for consumers that need both such as
+     * the coinstats and block filter indexes, getblockstats and getblock verbosity 3.
+     * The block and rev file reads are issued at the same time, and the most recent
+     * results, up to BLOCK_AND_UNDO_CACHE_BYTES, are shared between callers. Readers
+     * that go through the chain once, such as index sync, pass use_cache = false so
+     * that they neither look up nor evict the cached entries.
+     */
+    std::vector<std::future<BlockAndUndo>> ReadBlocksAndUndoAsync(std::span<const CBlockIndex* const> blocks, bool use_cache = true) const;
+    BlockAndUndo ReadBlockAndUndo(const CBlockIndex& index) const;
+    //! Memory usage of the blocks kept with their undo data.
+    size_t BlockAndUndoCacheUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_block_and_undo_cache_mutex);
+
+    /**
+     * Scan the block files first_file .. first_file + count - 1 for -reindex, one file
+     * per thread, on threads of their own next to the read threads. Only the message
+     * start, size and header of each block are read and hashed; the rest of the block
+     * is skipped without being read.
+     * Data between blocks that does not start with the message start is searched through
+     * as LoadExternalBlockFile() does. Each future holds the blocks of one file in file
+     * order, or std::nullopt if the file could not be opened.
+     */
+    std::vector<std::future<std::optional<std::vector<BlockFileEntry>>>> ScanBlockFilesAsync(int first_file, int count) const;
+
+    //! Number of threads serving batched reads; 0 if they run in the calling thread.
+    int BlockReadThreads() const { return m_opts.block_read_threads; }
+
+    //! Depth below the highest stored block from which block files are compressed.
+    static constexpr int COMPRESS_BLOCKFILE_MIN_DEPTH{1000};
+
+    /**
+     * Replace a finalized block file by a compressed file, see node/blockcompression.h.
+     * The file is written next to the original and renamed over it, so concurrent
+     * readers see either file. Returns false if the file was not replaced because it is
+     * already compressed, could not be read, is being written to, was pruned meanwhile,
+     * or does not get smaller.
+     */
+    bool CompressBlockFile(int file_number) EXCLUSIVE_LOCKS_REQUIRED(!cs_LastBlockFile, !m_compressed_tables_mutex);
+
+    //! Start compressing old block files in the background, if -compressblockfiles is set.
+    void StartBlockFileCompression() EXCLUSIVE_LOCKS_REQUIRED(!m_compression_mutex);
+
     void CleanupBlockRevFiles() const;
 };
 
@@ -49,9 +49,9 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
 
     if (auto value{args.GetIntArg("-maxtipage")}) opts.max_tip_age = std::chrono::seconds{*value};
 
-    ReadDatabaseArgs(args, opts.block_tree_db);
-    ReadDatabaseArgs(args, opts.coins_db);
-    ReadCoinsViewArgs(args, opts.coins_view);
+    if (auto result{ReadDatabaseArgs(args, opts.block_tree_db, "blockindex")}; !result) return util::Error{util::ErrorString(result)};
+    if (auto result{ReadDatabaseArgs(args, opts.coins_db, "chainstate")}; !result) return util::Error{util::ErrorString(result)};
+    if (auto result{ReadCoinsViewArgs(args, opts.coins_view)}; !result) return util::Error{util::ErrorString(result)};
 
     int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -70,6 +70,7 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
         // 2. Multiply first, divide after to avoid integer truncation.
         size_t clamped_size_each = std::max<int64_t>(*max_size, 0) * (1 << 20) / 2;
         opts.script_execution_cache_bytes = clamped_size_each;
+        opts.input_script_execution_cache_bytes = clamped_size_each / 4;
         opts.signature_cache_bytes = clamped_size_each;
     }
 
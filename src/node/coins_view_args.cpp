@@ -5,12 +5,23 @@
 #include <node/coins_view_args.h>
 
 #include <common/args.h>
+#include <tinyformat.h>
 #include <txdb.h>
+#include <util/result.h>
+#include <util/translation.h>
 
 namespace node {
-void ReadCoinsViewArgs(const ArgsManager& args, CoinsViewOptions& options)
+util::Result<void> ReadCoinsViewArgs(const ArgsManager& args, CoinsViewOptions& options)
 {
     if (auto value = args.GetIntArg("-dbbatchsize")) options.batch_write_bytes = *value;
     if (auto value = args.GetIntArg("-dbcrashratio")) options.simulate_crash_ratio = *value;
+    if (auto value = args.GetArg("-coinsbackend")) {
+        if (auto backend{CoinsBackendFromString(*value)}) {
+            options.backend = *backend;
+        } else {
+            return util::Error{strprintf(Untranslated("Unknown -coinsbackend value '%s', must be 'leveldb' or 'hashstore'"), *value)};
+        }
+    }
+    return {};
 }
 } // namespace node
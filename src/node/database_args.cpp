@@ -6,13 +6,52 @@
 
 #include <common/args.h>
 #include <dbwrapper.h>
+#include <tinyformat.h>
+#include <util/result.h>
+#include <util/strencodings.h>
+#include <util/translation.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
+util::Result<void> ReadDatabaseArgs(const ArgsManager& args, DBOptions& options, std::string_view db_name)
 {
     // Settings here apply to all databases (chainstate, blocks, and index
-    // databases), but it'd be easy to parse database-specific options by adding
-    // a database_type string or enum parameter to this function.
+    // databases), unless given per database with -dboption.
     if (auto value = args.GetBoolArg("-forcecompactdb")) options.force_compact = *value;
+
+    for (const std::string& arg : args.GetArgs("-dboption")) {
+        const size_t colon{arg.find(':')};
+        const size_t equals{arg.find('=', colon)};
+        if (colon == std::string::npos || equals == std::string::npos) {
+            return util::Error{strprintf(Untranslated("Invalid -dboption '%s', must be <database>:<option>=<value>"), arg)};
+        }
+        const std::string_view database{std::string_view{arg}.substr(0, colon)};
+        const std::string_view name{std::string_view{arg}.substr(colon + 1, equals - colon - 1)};
+        if (std::ranges::find(DATABASE_NAMES, database) == DATABASE_NAMES.end()) {
+            return util::Error{strprintf(Untranslated("Unknown database '%s' in -dboption, must be chainstate, blockindex, txindex, blockfilterindex or coinstatsindex"), database)};
+        }
+        const auto value{ToIntegral<int64_t>(arg.substr(equals + 1))};
+        const bool apply{database == db_name};
+        if (name == "bloom_filter_bits" && value && *value >= 0 && *value <= 64) {
+            if (apply) options.bloom_filter_bits = *value;
+        } else if (name == "block_size" && value && *value > 0) {
+            if (apply) options.block_size = *value;
+        } else if (name == "write_buffer_size" && value && *value > 0) {
+            if (apply) options.write_buffer_size = *value;
+        } else if (name == "max_file_size" && value && *value > 0) {
+            if (apply) options.max_file_size = *value;
+        } else if (name == "max_open_files" && value && *value > 0 && *value <= std::numeric_limits<int>::max()) {
+            if (apply) options.max_open_files = *value;
+        } else if (name == "bloom_filter_bits" || name == "block_size" || name == "write_buffer_size" || name == "max_file_size" || name == "max_open_files") {
+            return util::Error{strprintf(Untranslated("Invalid value in -dboption '%s'"), arg)};
+        } else {
+            return util::Error{strprintf(Untranslated("Unknown option '%s' in -dboption, must be bloom_filter_bits, block_size, write_buffer_size, max_file_size or max_open_files"), name)};
+        }
+    }
+    return {};
 }
 } // namespace node
@@ -5,11 +5,23 @@
 #ifndef BITCOIN_NODE_DATABASE_ARGS_H
 #define BITCOIN_NODE_DATABASE_ARGS_H
 
+#include <util/result.h>
+
+#include <array>
+#include <string_view>
+
 class ArgsManager;
 struct DBOptions;
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options);
+//! Databases that -dboption can tune.
+inline constexpr std::array<std::string_view, 5> DATABASE_NAMES{"chainstate", "blockindex", "txindex", "blockfilterindex", "coinstatsindex"};
+
+/**
+ * Read the options of the database db_name, one of DATABASE_NAMES. Every
+ * -dboption is checked, not only those for db_name.
+ */
+util::Result<void> ReadDatabaseArgs(const ArgsManager& args, DBOptions& options, std::string_view db_name);
 } // namespace node
 
 #endif // BITCOIN_NODE_DATABASE_ARGS_H
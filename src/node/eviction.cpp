@@ -4,6 +4,8 @@
 
 #include <node/eviction.h>
 
+#include <util/time.h>
+
 #include <algorithm>
 #include <array>
 #include <chrono>
@@ -235,6 +237,18 @@ void ProtectEvictionCandidatesByRatio(std::vector<NodeEvictionCandidate>& evicti
     // Reduce to the network group with the most connections
     vEvictionCandidates = std::move(mapNetGroupNodes[naMostConnections]);
 
-    // Disconnect from the network group with the most connections
-    return vEvictionCandidates.front().id;
+    // Disconnect from the network group with the most connections, choosing the
+    // member that has cost us the most message processing time per second
+    // connected, so that peers are not penalized for having been connected for
+    // long. At least a minute is counted, so that the work of a handshake does
+    // not make a new peer look expensive. Ties (e.g. all peers idle) go to the
+    // youngest member, as the group is still sorted by reverse connect time.
+    const auto now{GetTime<std::chrono::seconds>()};
+    const auto processing_time_rate{[&](const NodeEvictionCandidate& node) {
+        return double(node.m_processing_time.count()) / std::max(now - node.m_connected, std::chrono::seconds{60}).count();
+    }};
+    return std::max_element(vEvictionCandidates.begin(), vEvictionCandidates.end(),
+                            [&](const NodeEvictionCandidate& a, const NodeEvictionCandidate& b) {
+                                return processing_time_rate(a) < processing_time_rate(b);
+                            })->id;
 }
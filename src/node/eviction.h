@@ -19,6 +19,7 @@ struct NodeEvictionCandidate {
     NodeId id;
     std::chrono::seconds m_connected;
     std::chrono::microseconds m_min_ping_time;
+    std::chrono::microseconds m_processing_time;
     std::chrono::seconds m_last_block_time;
     std::chrono::seconds m_last_tx_time;
     bool fRelevantServices;
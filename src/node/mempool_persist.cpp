@@ -4,10 +4,14 @@
 
 #include <node/mempool_persist.h>
 
+#include <checkqueue.h>
 #include <clientversion.h>
+#include <coins.h>
 #include <consensus/amount.h>
 #include <logging.h>
+#include <policy/policy.h>
 #include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <random.h>
 #include <serialize.h>
 #include <streams.h>
@@ -38,6 +42,64 @@ namespace node {
 static const uint64_t MEMPOOL_DUMP_VERSION_NO_XOR_KEY{1};
 static const uint64_t MEMPOOL_DUMP_VERSION{2};
 
+/** Number of transactions read from the file and pre-verified together. */
+static constexpr size_t LOAD_BATCH_SIZE{1000};
+
+void PreVerifyScripts(const std::vector<CTransactionRef>& txs, CTxMemPool& pool, Chainstate& active_chainstate)
+{
+    ChainstateManager& chainman{active_chainstate.m_chainman};
+    if (txs.empty() || !chainman.GetCheckQueue().HasThreads()) return;
+
+    std::vector<PrecomputedTransactionData> txdata(txs.size());
+    // Transactions whose spent outputs were all found.
+    std::vector<size_t> resolved;
+    {
+        LOCK2(cs_main, pool.cs);
+        CCoinsViewMemPool view{&active_chainstate.CoinsTip(), pool};
+        for (size_t i = 0; i < txs.size(); ++i) {
+            const CTransaction& tx{*txs[i]};
+            std::vector<CTxOut> spent_outputs;
+            spent_outputs.reserve(tx.vin.size());
+            for (const CTxIn& txin : tx.vin) {
+                const auto coin{view.GetCoin(txin.prevout)};
+                if (!coin) break;
+                spent_outputs.push_back(coin->out);
+            }
+            view.PackageAddTransaction(txs[i]);
+            if (spent_outputs.size() != tx.vin.size()) continue;
+
+            txdata[i].Init(tx, std::move(spent_outputs));
+            resolved.push_back(i);
+        }
+    }
+
+    // The check queue stops running checks once one has failed. When a range fails, it is
+    // split and its halves are checked again, until every failing transaction is on its
+    // own and the scripts of all others have been checked. Checks that already passed are
+    // found in the signature cache the second time.
+    const std::function<void(size_t, size_t)> verify{[&](size_t begin, size_t end) {
+        std::vector<CScriptCheck> checks;
+        for (size_t r{begin}; r < end; ++r) {
+            const size_t i{resolved[r]};
+            for (unsigned int n = 0; n < txs[i]->vin.size(); ++n) {
+                checks.emplace_back(txdata[i].m_spent_outputs[n], *txs[i], chainman.m_validation_cache.m_signature_cache,
+                                    n, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheIn=*/true, &txdata[i]);
+            }
+        }
+        bool all_ok;
+        {
+            CCheckQueueControl<CScriptCheck> control(&chainman.GetCheckQueue());
+            control.Add(std::move(checks));
+            all_ok = control.Wait();
+        }
+        if (all_ok || end - begin == 1) return;
+        const size_t mid{begin + (end - begin) / 2};
+        verify(begin, mid);
+        verify(mid, end);
+    }};
+    if (!resolved.empty()) verify(0, resolved.size());
+}
+
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, ImportMempoolOptions&& opts)
 {
     if (load_path.empty()) return false;
@@ -72,51 +134,77 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         uint64_t txns_tried = 0;
         LogInfo("Loading %u mempool transactions from file...\n", total_txns_to_load);
         int next_tenth_to_report = 0;
-        while (txns_tried < total_txns_to_load) {
-            const int percentage_done(100.0 * txns_tried / total_txns_to_load);
-            if (next_tenth_to_report < percentage_done / 10) {
-                LogInfo("Progress loading mempool transactions from file: %d%% (tried %u, %u remaining)\n",
-                        percentage_done, txns_tried, total_txns_to_load - txns_tried);
-                next_tenth_to_report = percentage_done / 10;
-            }
-            ++txns_tried;
-
+        struct LoadedTx {
             CTransactionRef tx;
             int64_t nTime;
             int64_t nFeeDelta;
-            file >> TX_WITH_WITNESS(tx);
-            file >> nTime;
-            file >> nFeeDelta;
+        };
+        std::vector<LoadedTx> batch;
+        std::vector<CTransactionRef> to_verify;
+        while (txns_tried < total_txns_to_load) {
+            // Read the next batch and check its scripts in parallel before
+            // adding the transactions to the mempool in file order.
+            // A read error is only raised once the entries read before it
+            // have been processed, as if they had been read one at a time.
+            batch.clear();
+            to_verify.clear();
+            std::exception_ptr read_error;
+            try {
+                while (batch.size() < LOAD_BATCH_SIZE && txns_tried + batch.size() < total_txns_to_load) {
+                    LoadedTx loaded;
+                    file >> TX_WITH_WITNESS(loaded.tx);
+                    file >> loaded.nTime;
+                    file >> loaded.nFeeDelta;
 
-            if (opts.use_current_time) {
-                nTime = TicksSinceEpoch<std::chrono::seconds>(now);
+                    if (opts.use_current_time) {
+                        loaded.nTime = TicksSinceEpoch<std::chrono::seconds>(now);
+                    }
+                    if (loaded.nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_opts.expiry)) {
+                        to_verify.push_back(loaded.tx);
+                    }
+                    batch.push_back(std::move(loaded));
+                }
+            } catch (const std::exception&) {
+                read_error = std::current_exception();
             }
+            PreVerifyScripts(to_verify, pool, active_chainstate);
 
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta && opts.apply_fee_delta_priority) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
-            }
-            if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_opts.expiry)) {
-                LOCK(cs_main);
-                const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
-                if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
-                        ++already_there;
+            for (const auto& [tx, nTime, nFeeDelta] : batch) {
+                const int percentage_done(100.0 * txns_tried / total_txns_to_load);
+                if (next_tenth_to_report < percentage_done / 10) {
+                    LogInfo("Progress loading mempool transactions from file: %d%% (tried %u, %u remaining)\n",
+                            percentage_done, txns_tried, total_txns_to_load - txns_tried);
+                    next_tenth_to_report = percentage_done / 10;
+                }
+                ++txns_tried;
+
+                CAmount amountdelta = nFeeDelta;
+                if (amountdelta && opts.apply_fee_delta_priority) {
+                    pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                }
+                if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_opts.expiry)) {
+                    LOCK(cs_main);
+                    const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
+                    if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+                        ++count;
                     } else {
-                        ++failed;
+                        // mempool may contain the transaction already, e.g. from
+                        // wallet(s) having loaded it while we were processing
+                        // mempool transactions; consider these as valid, instead of
+                        // failed, but mark them as 'already there'
+                        if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
+                            ++already_there;
+                        } else {
+                            ++failed;
+                        }
                     }
+                } else {
+                    ++expired;
                 }
-            } else {
-                ++expired;
+                if (active_chainstate.m_chainman.m_interrupt)
+                    return false;
             }
-            if (active_chainstate.m_chainman.m_interrupt)
-                return false;
+            if (read_error) std::rethrow_exception(read_error);
         }
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
@@ -5,8 +5,11 @@
 #ifndef BITCOIN_NODE_MEMPOOL_PERSIST_H
 #define BITCOIN_NODE_MEMPOOL_PERSIST_H
 
+#include <primitives/transaction.h>
 #include <util/fs.h>
 
+#include <vector>
+
 class Chainstate;
 class CTxMemPool;
 
@@ -28,6 +31,17 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path,
                  Chainstate& active_chainstate,
                  ImportMempoolOptions&& opts);
 
+/**
+ * Verify the scripts of transactions read from the mempool file on the script check
+ * worker threads, so that the signature cache is warm by the time they go through
+ * AcceptToMemoryPool one by one. The dump lists parents before children, so outputs
+ * created earlier in txs are made available to the transactions after them. The
+ * outcome itself is not used: a transaction that fails here is fully checked (and
+ * rejected) by AcceptToMemoryPool as before, and does not keep the others from being
+ * checked.
+ */
+void PreVerifyScripts(const std::vector<CTransactionRef>& txs, CTxMemPool& pool, Chainstate& active_chainstate);
+
 } // namespace node
 
 
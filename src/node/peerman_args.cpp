@@ -16,6 +16,10 @@ void ApplyArgsManOptions(const ArgsManager& argsman, PeerManager::Options& optio
         options.max_orphan_txs = uint32_t((std::clamp<int64_t>(*value, 0, std::numeric_limits<uint32_t>::max())));
     }
 
+    if (auto value{argsman.GetIntArg("-maxorphanpeerusage")}) {
+        options.max_orphan_peer_usage = size_t(std::clamp<int64_t>(*value, 0, std::numeric_limits<int64_t>::max() / 1000) * 1000);
+    }
+
     if (auto value{argsman.GetIntArg("-blockreconstructionextratxn")}) {
         options.max_extra_txs = uint32_t((std::clamp<int64_t>(*value, 0, std::numeric_limits<uint32_t>::max())));
     }
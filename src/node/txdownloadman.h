@@ -45,6 +45,8 @@ struct TxDownloadOptions {
     const uint32_t m_max_orphan_txs;
     /** Instantiate TxRequestTracker as deterministic (used for tests). */
     bool m_deterministic_txrequest{false};
+    /** Serialized size of orphans each peer may have in the orphanage. */
+    size_t m_max_orphan_peer_usage{DEFAULT_MAX_ORPHAN_PEER_USAGE};
 };
 struct TxDownloadConnectionInfo {
     /** Whether this peer is preferred for transaction download. */
@@ -151,6 +153,10 @@ public:
     /** Respond to transaction rejected from mempool */
     RejectedTxTodo MempoolRejectedTx(const CTransactionRef& ptx, const TxValidationState& state, NodeId nodeid, bool first_time_failure);
 
+    /** Look for a child in the orphanage that may pay for a transaction which was just rejected as
+     * TX_RECONSIDERABLE, to be submitted together as a package. */
+    std::optional<PackageToValidate> Find1P1CPackage(const CTransactionRef& ptx, NodeId nodeid);
+
     /** Respond to package rejected from mempool */
     void MempoolRejectedPackage(const Package& package);
 
@@ -59,6 +59,10 @@ RejectedTxTodo TxDownloadManager::MempoolRejectedTx(const CTransactionRef& ptx,
 {
     return m_impl->MempoolRejectedTx(ptx, state, nodeid, first_time_failure);
 }
+std::optional<PackageToValidate> TxDownloadManager::Find1P1CPackage(const CTransactionRef& ptx, NodeId nodeid)
+{
+    return m_impl->Find1P1CPackage(ptx, nodeid);
+}
 void TxDownloadManager::MempoolRejectedPackage(const Package& package)
 {
     m_impl->MempoolRejectedPackage(package);
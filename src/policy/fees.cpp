@@ -103,6 +103,12 @@ private:
 
     double decay;
 
+    // The moving averages above are decayed lazily: they are stored divided by
+    // m_decay_factor, the product of the decays applied since they were last
+    // normalized. Decaying all of them is then a single multiplication, and new
+    // data points are added with weight 1 / m_decay_factor.
+    double m_decay_factor{1.0};
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -115,6 +121,9 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Fold m_decay_factor into the stored averages and reset it to 1 */
+    void NormalizeAverages();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -220,24 +229,34 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
+    const double weight{1 / m_decay_factor};
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += weight;
+    m_feerate_avg[bucketindex] += feerate * weight;
 }
 
-void TxConfirmStats::UpdateMovingAverages()
+void TxConfirmStats::NormalizeAverages()
 {
     assert(confAvg.size() == failAvg.size());
     for (unsigned int j = 0; j < buckets.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
+            confAvg[i][j] *= m_decay_factor;
+            failAvg[i][j] *= m_decay_factor;
         }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
+        m_feerate_avg[j] *= m_decay_factor;
+        txCtAvg[j] *= m_decay_factor;
     }
+    m_decay_factor = 1.0;
+}
+
+void TxConfirmStats::UpdateMovingAverages()
+{
+    m_decay_factor *= decay;
+    // Keep the weight of new data points well within double range. With the
+    // fastest decay this runs about once every 6000 blocks.
+    if (m_decay_factor < 1e-100) NormalizeAverages();
 }
 
 // returns -1 on error conditions
@@ -282,10 +301,10 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        partialNum += txCtAvg[bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * m_decay_factor;
+        partialNum += txCtAvg[bucket] * m_decay_factor;
+        totalNum += txCtAvg[bucket] * m_decay_factor;
+        failNum += failAvg[periodTarget - 1][bucket] * m_decay_factor;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -350,13 +369,13 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int minBucket = std::min(bestNearBucket, bestFarBucket);
     unsigned int maxBucket = std::max(bestNearBucket, bestFarBucket);
     for (unsigned int j = minBucket; j <= maxBucket; j++) {
-        txSum += txCtAvg[j];
+        txSum += txCtAvg[j] * m_decay_factor;
     }
     if (foundAnswer && txSum != 0) {
         txSum = txSum / 2;
         for (unsigned int j = minBucket; j <= maxBucket; j++) {
-            if (txCtAvg[j] < txSum)
-                txSum -= txCtAvg[j];
+            if (txCtAvg[j] * m_decay_factor < txSum)
+                txSum -= txCtAvg[j] * m_decay_factor;
             else { // we're in the right bucket
                 median = m_feerate_avg[j] / txCtAvg[j];
                 break;
@@ -409,12 +428,20 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(AutoFile& fileout) const
 {
+    // The file holds the actual averages, so its format does not depend on the lazy decay.
+    const auto scaled{[&](std::vector<double> v) {
+        for (double& x : v) x *= m_decay_factor;
+        return v;
+    }};
+    std::vector<std::vector<double>> conf_avg, fail_avg;
+    for (const auto& v : confAvg) conf_avg.push_back(scaled(v));
+    for (const auto& v : failAvg) fail_avg.push_back(scaled(v));
     fileout << Using<EncodedDoubleFormatter>(decay);
     fileout << scale;
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(txCtAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(scaled(m_feerate_avg));
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(scaled(txCtAvg));
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(conf_avg);
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(fail_avg);
 }
 
 void TxConfirmStats::Read(AutoFile& filein, size_t numBuckets)
@@ -433,6 +460,7 @@ void TxConfirmStats::Read(AutoFile& filein, size_t numBuckets)
     if (scale == 0) {
         throw std::runtime_error("Corrupt estimates file. Scale must be non-zero");
     }
+    m_decay_factor = 1.0;
 
     filein >> Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
     if (m_feerate_avg.size() != numBuckets) {
@@ -513,7 +541,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / m_decay_factor;
         }
     }
 }
@@ -682,6 +710,7 @@ void CBlockPolicyEstimator::processBlock(const std::vector<RemovedMempoolTransac
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
+    m_smart_fee_cache.clear();
 
     // Update unconfirmed circular buffer
     feeStats->ClearCurrent(nBlockHeight);
@@ -871,10 +900,22 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(m_cs_fee_estimator);
 
-    if (feeCalc) {
-        feeCalc->desiredTarget = confTarget;
-        feeCalc->returnedTarget = confTarget;
+    auto it{m_smart_fee_cache.find({confTarget, conservative})};
+    if (it == m_smart_fee_cache.end()) {
+        SmartFeeEstimate estimate;
+        estimate.feerate = estimateSmartFeeUncached(confTarget, estimate.calc, conservative);
+        it = m_smart_fee_cache.emplace(std::make_pair(confTarget, conservative), std::move(estimate)).first;
     }
+    if (feeCalc) *feeCalc = it->second.calc;
+    return it->second.feerate;
+}
+
+CFeeRate CBlockPolicyEstimator::estimateSmartFeeUncached(int confTarget, FeeCalculation& feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+
+    feeCalc.desiredTarget = confTarget;
+    feeCalc.returnedTarget = confTarget;
 
     double median = -1;
     EstimationResult tempResult;
@@ -891,7 +932,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     if ((unsigned int)confTarget > maxUsableEstimate) {
         confTarget = maxUsableEstimate;
     }
-    if (feeCalc) feeCalc->returnedTarget = confTarget;
+    feeCalc.returnedTarget = confTarget;
 
     if (confTarget <= 1) return CFeeRate(0); // error condition
 
@@ -907,36 +948,28 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * fluctuations lower our estimates by too much.
      */
     double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
-    if (feeCalc) {
-        feeCalc->est = tempResult;
-        feeCalc->reason = FeeReason::HALF_ESTIMATE;
-    }
+    feeCalc.est = tempResult;
+    feeCalc.reason = FeeReason::HALF_ESTIMATE;
     median = halfEst;
     double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
     if (actualEst > median) {
         median = actualEst;
-        if (feeCalc) {
-            feeCalc->est = tempResult;
-            feeCalc->reason = FeeReason::FULL_ESTIMATE;
-        }
+        feeCalc.est = tempResult;
+        feeCalc.reason = FeeReason::FULL_ESTIMATE;
     }
     double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
     if (doubleEst > median) {
         median = doubleEst;
-        if (feeCalc) {
-            feeCalc->est = tempResult;
-            feeCalc->reason = FeeReason::DOUBLE_ESTIMATE;
-        }
+        feeCalc.est = tempResult;
+        feeCalc.reason = FeeReason::DOUBLE_ESTIMATE;
     }
 
     if (conservative || median == -1) {
         double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
         if (consEst > median) {
             median = consEst;
-            if (feeCalc) {
-                feeCalc->est = tempResult;
-                feeCalc->reason = FeeReason::CONSERVATIVE;
-            }
+            feeCalc.est = tempResult;
+            feeCalc.reason = FeeReason::CONSERVATIVE;
         }
     }
 
@@ -1036,6 +1069,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             longStats = std::move(fileLongStats);
 
             nBestSeenHeight = nFileBestSeenHeight;
+            m_smart_fee_cache.clear();
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
         }
@@ -20,6 +20,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -300,9 +301,21 @@ private:
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
     std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
 
+    struct SmartFeeEstimate
+    {
+        CFeeRate feerate;
+        FeeCalculation calc;
+    };
+    /** Results of estimateSmartFee by (confTarget, conservative). Cleared when a block
+     *  is processed or estimates are read, so estimates are refreshed once per block.
+     *  Mempool transactions added or removed in between do not clear it. */
+    mutable std::map<std::pair<int, bool>, SmartFeeEstimate> m_smart_fee_cache GUARDED_BY(m_cs_fee_estimator);
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const RemovedMempoolTransactionInfo& tx) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** Helper for estimateSmartFee, computing the estimate without the cache */
+    CFeeRate estimateSmartFeeUncached(int confTarget, FeeCalculation& feeCalc, bool conservative) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
@@ -56,13 +56,11 @@ RBFTransactionState IsRBFOptInEmptyMempool(const CTransaction& tx)
     return SignalsOptInRBF(tx) ? RBFTransactionState::REPLACEABLE_BIP125 : RBFTransactionState::UNKNOWN;
 }
 
-std::optional<std::string> GetEntriesForConflicts(const CTransaction& tx,
-                                                  CTxMemPool& pool,
-                                                  const CTxMemPool::setEntries& iters_conflicting,
-                                                  CTxMemPool::setEntries& all_conflicts)
+std::optional<std::string> CheckReplacementCandidates(const CTxMemPool& pool,
+                                                      const CTxMemPool::setEntries& iters_conflicting,
+                                                      const uint256& txid)
 {
     AssertLockHeld(pool.cs);
-    const uint256 txid = tx.GetHash();
     uint64_t nConflictingCount = 0;
     for (const auto& mi : iters_conflicting) {
         nConflictingCount += mi->GetCountWithDescendants();
@@ -77,6 +75,18 @@ std::optional<std::string> GetEntriesForConflicts(const CTransaction& tx,
                              MAX_REPLACEMENT_CANDIDATES);
         }
     }
+    return std::nullopt;
+}
+
+std::optional<std::string> GetEntriesForConflicts(const CTransaction& tx,
+                                                  CTxMemPool& pool,
+                                                  const CTxMemPool::setEntries& iters_conflicting,
+                                                  CTxMemPool::setEntries& all_conflicts)
+{
+    AssertLockHeld(pool.cs);
+    if (const auto err_string{CheckReplacementCandidates(pool, iters_conflicting, tx.GetHash())}) {
+        return err_string;
+    }
     // Calculate the set of all transactions that would have to be evicted.
     for (CTxMemPool::txiter it : iters_conflicting) {
         pool.CalculateDescendants(it, all_conflicts);
@@ -184,6 +194,22 @@ std::optional<std::string> PaysForRBF(CAmount original_fees,
     return std::nullopt;
 }
 
+std::optional<std::string> PaysForRBFLowerBound(const CTxMemPool& pool,
+                                                const CTxMemPool::setEntries& iters_conflicting,
+                                                CAmount replacement_fees,
+                                                size_t replacement_vsize,
+                                                CFeeRate relay_fee,
+                                                const uint256& txid)
+{
+    AssertLockHeld(pool.cs);
+    if (pool.HasNegativeModifiedFees()) return std::nullopt;
+    CAmount min_original_fees{0};
+    for (const auto& mi : iters_conflicting) {
+        min_original_fees = std::max(min_original_fees, mi->GetModFeesWithDescendants());
+    }
+    return PaysForRBF(min_original_fees, replacement_fees, replacement_vsize, relay_fee, txid);
+}
+
 std::optional<std::pair<DiagramCheckError, std::string>> ImprovesFeerateDiagram(CTxMemPool& pool,
                                                 const CTxMemPool::setEntries& direct_conflicts,
                                                 const CTxMemPool::setEntries& all_conflicts,
@@ -56,6 +56,18 @@ enum class DiagramCheckError {
 RBFTransactionState IsRBFOptIn(const CTransaction& tx, const CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs);
 RBFTransactionState IsRBFOptInEmptyMempool(const CTransaction& tx);
 
+/** Enforce Rule #5 using the cached descendant counts of iters_conflicting, without walking
+ * their descendants. May overestimate if the entries in iters_conflicting have overlapping
+ * descendants.
+ * @param[in]   iters_conflicting   The set of iterators to mempool entries.
+ * @param[in]   txid                Transaction ID, included in the error message if violation occurs.
+ * @returns an error message if MAX_REPLACEMENT_CANDIDATES may be exceeded, otherwise a std::nullopt.
+ */
+std::optional<std::string> CheckReplacementCandidates(const CTxMemPool& pool,
+                                                      const CTxMemPool::setEntries& iters_conflicting,
+                                                      const uint256& txid)
+    EXCLUSIVE_LOCKS_REQUIRED(pool.cs);
+
 /** Get all descendants of iters_conflicting. Checks that there are no more than
  * MAX_REPLACEMENT_CANDIDATES potential entries. May overestimate if the entries in
  * iters_conflicting have overlapping descendants.
@@ -115,6 +127,26 @@ std::optional<std::string> PaysForRBF(CAmount original_fees,
                                       CFeeRate relay_fee,
                                       const uint256& txid);
 
+/** Cheap pre-check of PaysForRBF(), run before GetEntriesForConflicts() walks the descendants of
+ * the direct conflicts. Every transaction that would be evicted together with a direct conflict
+ * is counted in its cached descendant fees, so the largest of those is a lower bound on the
+ * fees of all transactions to be replaced, unless some entry has a negative modified fee.
+ * The cost is linear in the number of direct conflicts.
+ * @param[in]   pool                The mempool.
+ * @param[in]   iters_conflicting   The set of iterators to mempool entries.
+ * @param[in]   replacement_fees    Total modified fees of replacement transaction(s).
+ * @param[in]   replacement_vsize   Total virtual size of replacement transaction(s).
+ * @param[in]   relay_fee           The node's minimum feerate for transaction relay.
+ * @param[in]   txid                Transaction ID, included in the error message if violation occurs.
+ * @returns error string if PaysForRBF() is certain to fail for these conflicts, otherwise std::nullopt.
+ */
+std::optional<std::string> PaysForRBFLowerBound(const CTxMemPool& pool,
+                                                const CTxMemPool::setEntries& iters_conflicting,
+                                                CAmount replacement_fees,
+                                                size_t replacement_vsize,
+                                                CFeeRate relay_fee,
+                                                const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(pool.cs);
+
 /**
  * The replacement transaction must improve the feerate diagram of the mempool.
  * @param[in]   pool                The mempool.
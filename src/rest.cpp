@@ -11,6 +11,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
@@ -33,6 +34,7 @@
 #include <validation.h>
 
 #include <any>
+#include <optional>
 #include <vector>
 
 #include <univalue.h>
@@ -653,8 +655,8 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
 
     std::string param;
     const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
-    if (param != "contents" && param != "info") {
-        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info|contents>.json");
+    if (param != "contents" && param != "info" && param != "deltas") {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info|contents|deltas>.json");
     }
 
     const CTxMemPool* mempool = GetMemPool(context, req);
@@ -688,6 +690,26 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
                 return RESTERR(req, HTTP_BAD_REQUEST, "Verbose results cannot contain mempool sequence values. (hint: set \"verbose=false\")");
             }
             str_json = MempoolToJSON(*mempool, verbose, mempool_sequence).write() + "\n";
+        } else if (param == "deltas") {
+            std::optional<std::string> raw_since, raw_journal_id;
+            try {
+                raw_since = req->GetQueryParameter("since");
+                raw_journal_id = req->GetQueryParameter("journal_id");
+            } catch (const std::runtime_error& e) {
+                return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+            }
+            std::optional<uint64_t> since, journal_id;
+            if (raw_since) {
+                since = ToIntegral<uint64_t>(*raw_since);
+                if (!since) return RESTERR(req, HTTP_BAD_REQUEST, "The \"since\" query parameter must be a non-negative integer.");
+            }
+            if (raw_journal_id) {
+                if (raw_journal_id->size() != 16 || !IsHex(*raw_journal_id)) {
+                    return RESTERR(req, HTTP_BAD_REQUEST, "The \"journal_id\" query parameter must be 16 hex characters.");
+                }
+                journal_id = ReadBE64(ParseHex(*raw_journal_id).data());
+            }
+            str_json = MempoolDeltasToJSON(*mempool, since, journal_id).write() + "\n";
         } else {
             str_json = MempoolInfoToJSON(*mempool).write() + "\n";
         }
@@ -63,6 +63,7 @@ using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
 
 using interfaces::Mining;
+using node::BlockAndUndo;
 using node::BlockManager;
 using node::NodeContext;
 using node::SnapshotMetadata;
@@ -173,7 +174,7 @@ UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex
     return result;
 }
 
-UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
+UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const CBlockUndo* block_undo)
 {
     UniValue result = blockheaderToJSON(tip, blockindex);
 
@@ -192,15 +193,19 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
         case TxVerbosity::SHOW_DETAILS:
         case TxVerbosity::SHOW_DETAILS_AND_PREVOUT:
             CBlockUndo blockUndo;
-            const bool is_not_pruned{WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex))};
-            bool have_undo{is_not_pruned && WITH_LOCK(::cs_main, return blockindex.nStatus & BLOCK_HAVE_UNDO)};
-            if (have_undo && !blockman.UndoReadFromDisk(blockUndo, blockindex)) {
-                throw JSONRPCError(RPC_INTERNAL_ERROR, "Undo data expected but can't be read. This could be due to disk corruption or a conflict with a pruning event.");
+            bool have_undo{block_undo != nullptr};
+            if (!have_undo) {
+                const bool is_not_pruned{WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex))};
+                have_undo = is_not_pruned && WITH_LOCK(::cs_main, return blockindex.nStatus & BLOCK_HAVE_UNDO);
+                if (have_undo && !blockman.UndoReadFromDisk(blockUndo, blockindex)) {
+                    throw JSONRPCError(RPC_INTERNAL_ERROR, "Undo data expected but can't be read. This could be due to disk corruption or a conflict with a pruning event.");
+                }
+                block_undo = &blockUndo;
             }
             for (size_t i = 0; i < block.vtx.size(); ++i) {
                 const CTransactionRef& tx = block.vtx.at(i);
                 // coinbase transaction (i.e. i == 0) doesn't have undo data
-                const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
+                const CTxUndo* txundo = (have_undo && i > 0) ? &block_undo->vtxundo.at(i - 1) : nullptr;
                 UniValue objTx(UniValue::VOBJ);
                 TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, txundo, verbosity);
                 txs.push_back(std::move(objTx));
@@ -614,23 +619,6 @@ void CheckBlockDataAvailability(BlockManager& blockman, const CBlockIndex& block
     }
 }
 
-static CBlock GetBlockChecked(BlockManager& blockman, const CBlockIndex& blockindex)
-{
-    CBlock block;
-    {
-        LOCK(cs_main);
-        CheckBlockDataAvailability(blockman, blockindex, /*check_for_undo=*/false);
-    }
-
-    if (!blockman.ReadBlockFromDisk(block, blockindex)) {
-        // Block not found on disk. This shouldn't normally happen unless the block was
-        // pruned right after we released the lock above.
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
-    }
-
-    return block;
-}
-
 static std::vector<uint8_t> GetRawBlockChecked(BlockManager& blockman, const CBlockIndex& blockindex)
 {
     std::vector<uint8_t> data{};
@@ -650,23 +638,30 @@ static std::vector<uint8_t> GetRawBlockChecked(BlockManager& blockman, const CBl
     return data;
 }
 
-static CBlockUndo GetUndoChecked(BlockManager& blockman, const CBlockIndex& blockindex)
+/**
+ * Read a block together with its undo data. The undo data is read alongside the block and
+ * only required when require_undo is set; otherwise it is null if it is not available.
+ */
+static BlockAndUndo GetBlockAndUndoChecked(BlockManager& blockman, const CBlockIndex& blockindex, bool require_undo)
 {
-    CBlockUndo blockUndo;
-
-    // The Genesis block does not have undo data
-    if (blockindex.nHeight == 0) return blockUndo;
-
     {
         LOCK(cs_main);
-        CheckBlockDataAvailability(blockman, blockindex, /*check_for_undo=*/true);
+        CheckBlockDataAvailability(blockman, blockindex, /*check_for_undo=*/false);
+        // The Genesis block does not have undo data
+        if (require_undo && blockindex.nHeight > 0) CheckBlockDataAvailability(blockman, blockindex, /*check_for_undo=*/true);
     }
 
-    if (!blockman.UndoReadFromDisk(blockUndo, blockindex)) {
+    BlockAndUndo result{blockman.ReadBlockAndUndo(blockindex)};
+    if (!result.block) {
+        // Block not found on disk. This shouldn't normally happen unless the block was
+        // pruned right after we released the lock above.
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+    if (require_undo && !result.undo) {
         throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
     }
 
-    return blockUndo;
+    return result;
 }
 
 const RPCResult getblock_vin{
@@ -781,6 +776,12 @@ static RPCHelpMan getblock()
         }
     }
 
+    if (verbosity >= 3) {
+        // Prevouts come from the undo data, so read it alongside the block.
+        const BlockAndUndo block_and_undo{GetBlockAndUndoChecked(chainman.m_blockman, *pblockindex, /*require_undo=*/false)};
+        return blockToJSON(chainman.m_blockman, *block_and_undo.block, *tip, *pblockindex, TxVerbosity::SHOW_DETAILS_AND_PREVOUT, block_and_undo.undo.get());
+    }
+
     const std::vector<uint8_t> block_data{GetRawBlockChecked(chainman.m_blockman, *pblockindex)};
 
     if (verbosity <= 0) {
@@ -877,9 +878,9 @@ static RPCHelpMan pruneblockchain()
         throw JSONRPCError(RPC_MISC_ERROR, "Blockchain is too short for pruning.");
     } else if (height > chainHeight) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Blockchain is shorter than the attempted prune height.");
-    } else if (height > chainHeight - MIN_BLOCKS_TO_KEEP) {
+    } else if (height > chainHeight - chainman.m_blockman.MinBlocksToKeep()) {
         LogDebug(BCLog::RPC, "Attempt to prune blocks close to the tip.  Retaining the minimum number of blocks.\n");
-        height = chainHeight - MIN_BLOCKS_TO_KEEP;
+        height = chainHeight - chainman.m_blockman.MinBlocksToKeep();
     }
 
     PruneBlockFilesManual(active_chainstate, height);
@@ -1908,8 +1909,9 @@ static RPCHelpMan getblockstats()
         }
     }
 
-    const CBlock& block = GetBlockChecked(chainman.m_blockman, pindex);
-    const CBlockUndo& blockUndo = GetUndoChecked(chainman.m_blockman, pindex);
+    const BlockAndUndo block_and_undo{GetBlockAndUndoChecked(chainman.m_blockman, pindex, /*require_undo=*/true)};
+    const CBlock& block = *block_and_undo.block;
+    const CBlockUndo& blockUndo = *block_and_undo.undo;
 
     const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
     const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
@@ -2374,8 +2376,9 @@ public:
 
 static bool CheckBlockFilterMatches(BlockManager& blockman, const CBlockIndex& blockindex, const GCSFilter::ElementSet& needles)
 {
-    const CBlock block{GetBlockChecked(blockman, blockindex)};
-    const CBlockUndo block_undo{GetUndoChecked(blockman, blockindex)};
+    const BlockAndUndo block_and_undo{GetBlockAndUndoChecked(blockman, blockindex, /*require_undo=*/true)};
+    const CBlock& block{*block_and_undo.block};
+    const CBlockUndo& block_undo{*block_and_undo.undo};
 
     // Check if any of the outputs match the scriptPubKey
     for (const auto& tx : block.vtx) {
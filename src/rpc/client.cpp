@@ -115,6 +115,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "gettransaction", 2, "verbose" },
     { "getrawtransaction", 1, "verbosity" },
     { "getrawtransaction", 1, "verbose" },
+    { "getrawtransactions", 0, "txids" },
+    { "getrawtransactions", 1, "verbosity" },
+    { "getrawtransactions", 1, "verbose" },
     { "createrawtransaction", 0, "inputs" },
     { "createrawtransaction", 1, "outputs" },
     { "createrawtransaction", 2, "locktime" },
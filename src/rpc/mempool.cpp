@@ -14,9 +14,9 @@
 #include <net_processing.h>
 #include <node/mempool_persist_args.h>
 #include <node/types.h>
-#include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/mempool.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -282,33 +282,28 @@ static std::vector<RPCResult> MempoolEntryDescription()
     };
 }
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+static void entryToJSON(UniValue& info, const MempoolSnapshot::Entry& e)
 {
-    AssertLockHeld(pool.cs);
-
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("wtxid", e.GetTx().GetWitnessHash().ToString());
+    info.pushKV("vsize", (int)e.vsize);
+    info.pushKV("weight", (int)e.weight);
+    info.pushKV("time", count_seconds(e.time));
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.count_with_descendants);
+    info.pushKV("descendantsize", e.size_with_descendants);
+    info.pushKV("ancestorcount", e.count_with_ancestors);
+    info.pushKV("ancestorsize", e.size_with_ancestors);
+    info.pushKV("wtxid", e.tx->GetWitnessHash().ToString());
 
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.mod_fees_with_ancestors));
+    fees.pushKV("descendant", ValueFromAmount(e.mod_fees_with_descendants));
     info.pushKV("fees", std::move(fees));
 
-    const CTransaction& tx = e.GetTx();
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (pool.exists(GenTxid::Txid(txin.prevout.hash)))
-            setDepends.insert(txin.prevout.hash.ToString());
+    for (const Txid& parent : e.parents) {
+        setDepends.insert(parent.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -320,23 +315,14 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("depends", std::move(depends));
 
     UniValue spent(UniValue::VARR);
-    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+    for (const Txid& child : e.children) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", std::move(spent));
 
-    // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
-    if (rbfState == RBFTransactionState::UNKNOWN) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
-    }
-
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+    info.pushKV("bip125-replaceable", e.bip125_replaceable);
+    info.pushKV("unbroadcast", e.unbroadcast);
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
@@ -345,15 +331,15 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
+        const auto snapshot{pool.GetSnapshot()};
         UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.entryAll()) {
+        for (const MempoolSnapshot::Entry& e : snapshot->entries) {
             UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
+            entryToJSON(info, e);
             // Mempool has unique entries so there is no advantage in using
             // UniValue::pushKV, which checks if the key already exists in O(N).
             // UniValue::pushKVEnd is used instead which currently is O(1).
-            o.pushKVEnd(e.GetTx().GetHash().ToString(), std::move(info));
+            o.pushKVEnd(e.tx->GetHash().ToString(), std::move(info));
         }
         return o;
     } else {
@@ -377,6 +363,80 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+static std::string DeltaTypeToString(MempoolDelta::Type type)
+{
+    switch (type) {
+    case MempoolDelta::Type::ADDED: return "added";
+    case MempoolDelta::Type::REMOVED: return "removed";
+    case MempoolDelta::Type::UPDATED: return "updated";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+static UniValue DeltaToJSON(const MempoolDelta& delta)
+{
+    UniValue o(UniValue::VOBJ);
+    o.pushKV("sequence", delta.sequence);
+    o.pushKV("type", DeltaTypeToString(delta.type));
+    o.pushKV("txid", delta.txid.ToString());
+    o.pushKV("wtxid", delta.wtxid.ToString());
+    o.pushKV("fee", ValueFromAmount(delta.fee));
+    o.pushKV("modifiedfee", ValueFromAmount(delta.modified_fee));
+    o.pushKV("vsize", delta.vsize);
+    o.pushKV("ancestorcount", delta.count_with_ancestors);
+    o.pushKV("ancestorsize", delta.size_with_ancestors);
+    o.pushKV("ancestorfees", ValueFromAmount(delta.mod_fees_with_ancestors));
+    if (delta.type == MempoolDelta::Type::REMOVED) {
+        o.pushKV("reason", RemovalReasonToString(delta.reason));
+    }
+    return o;
+}
+
+UniValue MempoolDeltasToJSON(const CTxMemPool& pool, std::optional<uint64_t> since, std::optional<uint64_t> journal_id)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("journal_id", strprintf("%016x", pool.GetDeltaJournalId()));
+
+    std::optional<std::vector<MempoolDelta>> deltas;
+    if (since && journal_id == pool.GetDeltaJournalId()) {
+        deltas = pool.GetDeltas(*since, MAX_MEMPOOL_DELTAS_PER_REPLY);
+    }
+    if (deltas) {
+        ret.pushKV("reset", false);
+    } else {
+        // Start over from a current snapshot, followed by the changes made after
+        // it was taken. The snapshot is taken after the client's cursor, so it
+        // reflects every change the client may have missed.
+        const auto snapshot{pool.GetSnapshot()};
+        // An empty list if the journal has already moved past the snapshot, so
+        // that the client simply starts over again with its next request.
+        deltas = pool.GetDeltas(snapshot->delta_sequence, MAX_MEMPOOL_DELTAS_PER_REPLY).value_or(std::vector<MempoolDelta>{});
+        ret.pushKV("reset", true);
+        UniValue txs(UniValue::VOBJ);
+        for (const MempoolSnapshot::Entry& e : snapshot->entries) {
+            UniValue info(UniValue::VOBJ);
+            info.pushKV("wtxid", e.tx->GetWitnessHash().ToString());
+            info.pushKV("fee", ValueFromAmount(e.fee));
+            info.pushKV("modifiedfee", ValueFromAmount(e.modified_fee));
+            info.pushKV("vsize", e.vsize);
+            info.pushKV("ancestorcount", e.count_with_ancestors);
+            info.pushKV("ancestorsize", e.size_with_ancestors);
+            info.pushKV("ancestorfees", ValueFromAmount(e.mod_fees_with_ancestors));
+            txs.pushKVEnd(e.tx->GetHash().ToString(), std::move(info));
+        }
+        ret.pushKV("txs", std::move(txs));
+        since = snapshot->delta_sequence;
+    }
+
+    UniValue changes(UniValue::VARR);
+    for (const MempoolDelta& delta : *deltas) {
+        changes.push_back(DeltaToJSON(delta));
+    }
+    ret.pushKV("deltas", std::move(changes));
+    ret.pushKV("next", *since + deltas->size());
+    return ret;
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -479,7 +539,7 @@ static RPCHelpMan getmempoolancestors()
             const CTxMemPoolEntry &e = *ancestorIt;
             const uint256& _hash = e.GetTx().GetHash();
             UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
+            entryToJSON(info, mempool.GetSnapshotEntry(e));
             o.pushKV(_hash.ToString(), std::move(info));
         }
         return o;
@@ -544,7 +604,7 @@ static RPCHelpMan getmempooldescendants()
             const CTxMemPoolEntry &e = *descendantIt;
             const uint256& _hash = e.GetTx().GetHash();
             UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
+            entryToJSON(info, mempool.GetSnapshotEntry(e));
             o.pushKV(_hash.ToString(), std::move(info));
         }
         return o;
@@ -579,7 +639,7 @@ static RPCHelpMan getmempoolentry()
     }
 
     UniValue info(UniValue::VOBJ);
-    entryToJSON(mempool, info, *entry);
+    entryToJSON(info, mempool.GetSnapshotEntry(*entry));
     return info;
 },
     };
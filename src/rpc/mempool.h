@@ -5,13 +5,29 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
 class CTxMemPool;
 class UniValue;
 
+/** Maximum number of mempool changes returned by one MempoolDeltasToJSON() call */
+static constexpr size_t MAX_MEMPOOL_DELTAS_PER_REPLY{10'000};
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/**
+ * Mempool changes since a previous reply to JSON.
+ *
+ * If since is the "next" value of a previous reply with the same journal_id, only the changes
+ * made after that reply are returned. Otherwise the reply starts over with the full mempool
+ * contents, followed by the changes made after it was taken.
+ */
+UniValue MempoolDeltasToJSON(const CTxMemPool& pool, std::optional<uint64_t> since, std::optional<uint64_t> journal_id);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
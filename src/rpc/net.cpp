@@ -100,6 +100,26 @@ static RPCHelpMan ping()
     };
 }
 
+static std::vector<RPCResult> ProcessingTimeDoc()
+{
+    return {
+        {RPCResult::Type::NUM, "count", "The number of messages processed"},
+        {RPCResult::Type::NUM, "total", "The total processing time in seconds, including time waiting for locks"},
+        {RPCResult::Type::NUM, "cs_main_wait", "The part of the processing time spent waiting for the validation lock (cs_main), in seconds"},
+        {RPCResult::Type::NUM, "tx_download_wait", "The part of the processing time spent waiting for the transaction download lock, in seconds"},
+    };
+}
+
+static UniValue ProcessingTimeToJSON(const MsgProcessingTime& time)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("count", time.count);
+    ret.pushKV("total", Ticks<SecondsDouble>(time.total));
+    ret.pushKV("cs_main_wait", Ticks<SecondsDouble>(time.cs_main_wait));
+    ret.pushKV("tx_download_wait", Ticks<SecondsDouble>(time.tx_download_wait));
+    return ret;
+}
+
 /** Returns, given services flags, a list of humanly readable (known) network services */
 static UniValue GetServicesNames(ServiceFlags services)
 {
@@ -182,6 +202,16 @@ static RPCHelpMan getpeerinfo()
                                                       "Only known message types can appear as keys in the object and all bytes received\n"
                                                       "of unknown message types are listed under '"+NET_MESSAGE_TYPE_OTHER+"'."}
                     }},
+                    {RPCResult::Type::OBJ, "processing_time", "Time spent processing messages from this peer", ProcessingTimeDoc()},
+                    {RPCResult::Type::OBJ_DYN, "processing_time_per_msg", "",
+                    {
+                        {RPCResult::Type::OBJ, "msg", "The processing time aggregated by message type\n"
+                                                      "When a message type is not listed in this json object, no time was spent on it.\n"
+                                                      "Only known message types can appear as keys in the object and time spent on\n"
+                                                      "unknown message types is listed under '"+NET_MESSAGE_TYPE_OTHER+"'.\n"
+                                                      "Time spent serving getdata requests and reconsidering orphans is listed\n"
+                                                      "under 'getdata' and 'tx' respectively.", ProcessingTimeDoc()}
+                    }},
                     {RPCResult::Type::STR, "connection_type", "Type of connection: \n" + Join(CONNECTION_TYPE_DOC, ",\n") + ".\n"
                                                               "Please note this output is unlikely to be stable in upcoming releases as we iterate to\n"
                                                               "best capture connection behaviors."},
@@ -290,6 +320,13 @@ static RPCHelpMan getpeerinfo()
                 recvPerMsgType.pushKV(i.first, i.second);
         }
         obj.pushKV("bytesrecv_per_msg", std::move(recvPerMsgType));
+
+        obj.pushKV("processing_time", ProcessingTimeToJSON(stats.m_processing_time));
+        UniValue processingTimePerMsgType(UniValue::VOBJ);
+        for (const auto& [msg_type, time] : stats.m_processing_time_per_msg_type) {
+            processingTimePerMsgType.pushKV(msg_type, ProcessingTimeToJSON(time));
+        }
+        obj.pushKV("processing_time_per_msg", std::move(processingTimePerMsgType));
         obj.pushKV("connection_type", ConnectionTypeAsString(stats.m_conn_type));
         obj.pushKV("transport_protocol_type", TransportTypeAsString(stats.m_transport_type));
         obj.pushKV("session_id", stats.m_session_id);
@@ -6,6 +6,7 @@
 #include <bitcoin-build-config.h> // IWYU pragma: keep
 
 #include <chainparams.h>
+#include <dbwrapper.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
@@ -16,17 +17,24 @@
 #include <interfaces/ipc.h>
 #include <kernel/cs_main.h>
 #include <logging.h>
+#include <node/blockstorage.h>
 #include <node/context.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <scheduler.h>
+#include <txdb.h>
 #include <univalue.h>
 #include <util/any.h>
 #include <util/check.h>
 #include <util/time.h>
+#include <validation.h>
 
+#include <chrono>
+#include <functional>
+#include <optional>
 #include <stdint.h>
+#include <string_view>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
 #endif
@@ -400,12 +408,127 @@ static RPCHelpMan getindexinfo()
     };
 }
 
+static UniValue DBStatsToJSON(const DBStats& stats, std::string_view profile)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("profile", profile);
+    entry.pushKV("cache_bytes", stats.cache_bytes);
+    entry.pushKV("bloom_filter_bits", stats.bloom_filter_bits);
+    entry.pushKV("block_size", stats.block_size);
+    entry.pushKV("write_buffer_size", stats.write_buffer_size);
+    entry.pushKV("max_file_size", stats.max_file_size);
+    entry.pushKV("max_open_files", stats.max_open_files);
+    entry.pushKV("memory_usage", stats.memory_usage);
+    entry.pushKV("approximate_bytes", stats.approximate_bytes);
+    entry.pushKV("read_amplification", stats.read_amplification);
+    std::chrono::microseconds compaction_time{0};
+    UniValue levels(UniValue::VARR);
+    for (size_t i{0}; i < stats.levels.size(); ++i) {
+        const DBStats::Level& level{stats.levels[i]};
+        compaction_time += level.compaction_time;
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("level", i);
+        obj.pushKV("files", level.files);
+        obj.pushKV("compaction_time", Ticks<SecondsDouble>(level.compaction_time));
+        obj.pushKV("compaction_read_bytes", level.compaction_read_bytes);
+        obj.pushKV("compaction_written_bytes", level.compaction_written_bytes);
+        levels.push_back(std::move(obj));
+    }
+    entry.pushKV("compaction_time", Ticks<SecondsDouble>(compaction_time));
+    entry.pushKV("levels", std::move(levels));
+    return entry;
+}
+
+static RPCHelpMan getdbinfo()
+{
+    return RPCHelpMan{"getdbinfo",
+                "\nReturns the options and LevelDB statistics of the node's databases.\n"
+                "The options of each database can be set with -dboption=<profile>:<option>=<value>.\n",
+                {
+                    {"name", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Filter results for a database with a specific name."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ_DYN, "", "", {
+                        {
+                            RPCResult::Type::OBJ, "name", "The name of the database: chainstate, blockindex, or the name of the index",
+                            {
+                                {RPCResult::Type::STR, "profile", "The database name used by -dboption"},
+                                {RPCResult::Type::NUM, "cache_bytes", "Cache size given to the database, half of which is the block cache"},
+                                {RPCResult::Type::NUM, "bloom_filter_bits", "Bits per key of the bloom filter of each table, 0 for none"},
+                                {RPCResult::Type::NUM, "block_size", "Size of uncompressed data packed into one table block"},
+                                {RPCResult::Type::NUM, "write_buffer_size", "Size of the memtable written out as a level 0 table"},
+                                {RPCResult::Type::NUM, "max_file_size", "Size at which compaction starts a new table file"},
+                                {RPCResult::Type::NUM, "max_open_files", "Number of table files kept open"},
+                                {RPCResult::Type::NUM, "memory_usage", "Approximate memory used by the block cache and memtables"},
+                                {RPCResult::Type::NUM, "approximate_bytes", "Approximate total size of the table files"},
+                                {RPCResult::Type::NUM, "read_amplification", "Tables a lookup of a missing key may have to search: every level 0 table and one table of each other non-empty level"},
+                                {RPCResult::Type::NUM, "compaction_time", "Seconds spent in compactions since the database was opened"},
+                                {RPCResult::Type::ARR, "levels", "", {
+                                    {RPCResult::Type::OBJ, "", "", {
+                                        {RPCResult::Type::NUM, "level", "The level"},
+                                        {RPCResult::Type::NUM, "files", "Number of table files"},
+                                        {RPCResult::Type::NUM, "compaction_time", "Seconds spent in compactions writing to this level, rounded"},
+                                        {RPCResult::Type::NUM, "compaction_read_bytes", "Bytes read by those compactions, rounded to MiB"},
+                                        {RPCResult::Type::NUM, "compaction_written_bytes", "Bytes written by those compactions, rounded to MiB"},
+                                    }},
+                                }},
+                            }
+                        },
+                    },
+                },
+                RPCExamples{
+                    HelpExampleCli("getdbinfo", "")
+                  + HelpExampleRpc("getdbinfo", "")
+                  + HelpExampleCli("getdbinfo", "chainstate")
+                  + HelpExampleRpc("getdbinfo", "chainstate")
+                },
+                [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue result(UniValue::VOBJ);
+    const std::string name = request.params[0].isNull() ? "" : request.params[0].get_str();
+    const auto add{[&](const std::string& db_name, std::string_view profile, const std::function<std::optional<DBStats>()>& get_stats) {
+        if (!name.empty() && name != db_name) return;
+        if (const auto stats{get_stats()}) result.pushKV(db_name, DBStatsToJSON(*stats, profile));
+    }};
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    // Only the database pointers are looked up under cs_main. LevelDB takes its own lock
+    // to collect the statistics.
+    CCoinsViewDB* coins_db;
+    kernel::BlockTreeDB* block_tree_db;
+    {
+        LOCK(cs_main);
+        coins_db = &chainman.ActiveChainstate().CoinsDB();
+        block_tree_db = chainman.m_blockman.m_block_tree_db.get();
+    }
+    // The chainstate has no LevelDB statistics when it uses another -coinsbackend.
+    add("chainstate", "chainstate", [&] { return coins_db->GetDBStats(); });
+    add("blockindex", "blockindex", [&] { return block_tree_db->GetStats(); });
+
+    if (g_txindex) {
+        add(g_txindex->GetName(), "txindex", [&] { return g_txindex->GetDBStats(); });
+    }
+
+    if (g_coin_stats_index) {
+        add(g_coin_stats_index->GetName(), "coinstatsindex", [&] { return g_coin_stats_index->GetDBStats(); });
+    }
+
+    ForEachBlockFilterIndex([&](const BlockFilterIndex& index) {
+        add(index.GetName(), "blockfilterindex", [&] { return index.GetDBStats(); });
+    });
+
+    return result;
+},
+    };
+}
+
 void RegisterNodeRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"control", &getmemoryinfo},
         {"control", &logging},
         {"util", &getindexinfo},
+        {"util", &getdbinfo},
         {"hidden", &setmocktime},
         {"hidden", &mockscheduler},
         {"hidden", &echo},
@@ -420,6 +420,102 @@ static RPCHelpMan getrawtransaction()
     };
 }
 
+static RPCHelpMan getrawtransactions()
+{
+    return RPCHelpMan{
+                "getrawtransactions",
+
+                "Return several transactions from the mempool or, using -txindex, from any block.\n"
+                "Transactions that are not found are returned as null.\n\n"
+
+                "If verbosity is 0 or omitted, returns each transaction as a hex-encoded string.\n"
+                "If verbosity is 1, returns a JSON Object with information about each transaction, as getrawtransaction does.",
+                {
+                    {"txids", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction ids",
+                        {
+                            {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "A transaction id"},
+                        },
+                    },
+                    {"verbosity|verbose", RPCArg::Type::NUM, RPCArg::Default{0}, "0 for hex-encoded data, 1 for JSON objects",
+                     RPCArgOptions{.skip_type_check = true}},
+                },
+                {
+                    RPCResult{"if verbosity is not set or set to 0",
+                        RPCResult::Type::ARR, "", "",
+                        {
+                            {RPCResult::Type::STR, "data", "The serialized transaction as a hex-encoded string, or null if not found", {}, /*skip_type_check=*/true},
+                        }},
+                    RPCResult{"if verbosity is set to 1",
+                        RPCResult::Type::ARR, "", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "Same output as getrawtransaction with verbosity 1, or null if not found",
+                            {
+                                {RPCResult::Type::ELISION, "", ""},
+                            }, /*skip_type_check=*/true},
+                        }},
+                },
+                RPCExamples{
+                    HelpExampleCli("getrawtransactions", "'[\"mytxid\",...]'")
+            + HelpExampleCli("getrawtransactions", "'[\"mytxid\",...]' 1")
+            + HelpExampleRpc("getrawtransactions", "[\"mytxid\",...], 1")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+
+    const UniValue& txids{request.params[0].get_array()};
+    std::vector<uint256> hashes;
+    hashes.reserve(txids.size());
+    for (size_t i{0}; i < txids.size(); ++i) {
+        hashes.push_back(ParseHashV(txids[i], strprintf("txids[%d]", i)));
+    }
+
+    const int verbosity{ParseVerbosity(request.params[1], /*default_verbosity=*/0, /*allow_bool=*/true)};
+    if (verbosity > 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbosity must be 0 or 1");
+    }
+
+    if (!g_txindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "getrawtransactions requires -txindex");
+    }
+    if (!g_txindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Blockchain transactions are still in the process of being indexed");
+    }
+
+    std::vector<std::optional<TxIndex::FoundTx>> found(hashes.size());
+    std::vector<uint256> index_hashes;
+    std::vector<size_t> index_positions;
+    for (size_t i{0}; i < hashes.size(); ++i) {
+        if (CTransactionRef tx{node.mempool ? node.mempool->get(hashes[i]) : nullptr}) {
+            found[i] = TxIndex::FoundTx{uint256{}, std::move(tx)};
+        } else {
+            index_hashes.push_back(hashes[i]);
+            index_positions.push_back(i);
+        }
+    }
+    auto index_found{g_txindex->FindTxs(index_hashes)};
+    for (size_t i{0}; i < index_found.size(); ++i) {
+        found[index_positions[i]] = std::move(index_found[i]);
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const auto& entry : found) {
+        if (!entry) {
+            result.push_back(NullUniValue);
+        } else if (verbosity == 0) {
+            result.push_back(EncodeHexTx(*entry->tx));
+        } else {
+            UniValue tx_result(UniValue::VOBJ);
+            TxToJSON(*entry->tx, entry->block_hash, tx_result, chainman.ActiveChainstate());
+            result.push_back(std::move(tx_result));
+        }
+    }
+    return result;
+},
+    };
+}
+
 static RPCHelpMan createrawtransaction()
 {
     return RPCHelpMan{"createrawtransaction",
@@ -2008,6 +2104,7 @@ void RegisterRawTransactionRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"rawtransactions", &getrawtransaction},
+        {"rawtransactions", &getrawtransactions},
         {"rawtransactions", &createrawtransaction},
         {"rawtransactions", &decoderawtransaction},
         {"rawtransactions", &decodescript},
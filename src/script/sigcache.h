@@ -29,6 +29,9 @@ static constexpr size_t DEFAULT_VALIDATION_CACHE_BYTES{32 << 20};
 static constexpr size_t DEFAULT_SIGNATURE_CACHE_BYTES{DEFAULT_VALIDATION_CACHE_BYTES / 2};
 static constexpr size_t DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES{DEFAULT_VALIDATION_CACHE_BYTES / 2};
 static_assert(DEFAULT_VALIDATION_CACHE_BYTES == DEFAULT_SIGNATURE_CACHE_BYTES + DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES);
+// Per-input script execution entries are kept apart, so transactions with many
+// inputs cannot evict whole-transaction entries.
+static constexpr size_t DEFAULT_INPUT_SCRIPT_EXECUTION_CACHE_BYTES{DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES / 4};
 
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
@@ -14,8 +14,10 @@
 #include <threadsafety.h> // IWYU pragma: export
 #include <util/macros.h>
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 
@@ -60,6 +62,8 @@ void CheckLastCritical(void* cs, std::string& lockname, const char* guardname, c
 template <typename MutexType>
 void AssertLockHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) EXCLUSIVE_LOCKS_REQUIRED(cs);
 template <typename MutexType>
+void AssertSharedLockHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) SHARED_LOCKS_REQUIRED(cs);
+template <typename MutexType>
 void AssertLockNotHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) LOCKS_EXCLUDED(cs);
 void DeleteLock(void* cs);
 bool LockStackEmpty();
@@ -78,6 +82,8 @@ inline void CheckLastCritical(void* cs, std::string& lockname, const char* guard
 template <typename MutexType>
 inline void AssertLockHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) EXCLUSIVE_LOCKS_REQUIRED(cs) {}
 template <typename MutexType>
+inline void AssertSharedLockHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) SHARED_LOCKS_REQUIRED(cs) {}
+template <typename MutexType>
 void AssertLockNotHeldInternal(const char* pszName, const char* pszFile, int nLine, MutexType* cs) LOCKS_EXCLUDED(cs) {}
 inline void DeleteLock(void* cs) {}
 inline bool LockStackEmpty() { return true; }
@@ -110,6 +116,21 @@ public:
         return PARENT::try_lock();
     }
 
+    void lock_shared() SHARED_LOCK_FUNCTION()
+    {
+        PARENT::lock_shared();
+    }
+
+    void unlock_shared() UNLOCK_FUNCTION()
+    {
+        PARENT::unlock_shared();
+    }
+
+    bool try_lock_shared() SHARED_TRYLOCK_FUNCTION(true)
+    {
+        return PARENT::try_lock_shared();
+    }
+
     using unique_lock = std::unique_lock<PARENT>;
 #ifdef __clang__
     //! For negative capabilities in the Clang Thread Safety Analysis.
@@ -128,6 +149,12 @@ using RecursiveMutex = AnnotatedMixin<std::recursive_mutex>;
 /** Wrapped mutex: supports waiting but not recursive locking */
 using Mutex = AnnotatedMixin<std::mutex>;
 
+/**
+ * Wrapped reader/writer mutex: LOCK() takes it exclusively, READ_LOCK() takes
+ * it shared so that any number of readers may hold it at the same time.
+ */
+using SharedMutex = AnnotatedMixin<std::shared_mutex>;
+
 /** Different type to mark Mutex at global scope
  *
  * Thread safety analysis can't handle negative assertions about mutexes
@@ -139,10 +166,44 @@ using Mutex = AnnotatedMixin<std::mutex>;
  */
 class GlobalMutex : public Mutex { };
 
+/**
+ * Receives the time the current thread spends blocked acquiring a lock through
+ * LOCK()/WAIT_LOCK(), while installed for that thread with LockWaitScope.
+ * Only contended acquisitions are reported, uncontended ones cost nothing.
+ */
+class LockWaitObserver
+{
+public:
+    virtual ~LockWaitObserver() = default;
+    virtual void LockWaited(const void* cs, std::chrono::nanoseconds waited) = 0;
+};
+
+/** Observer for the current thread, if any. Use LockWaitScope to install one. */
+extern thread_local LockWaitObserver* g_lock_wait_observer;
+
+/** RAII helper installing a LockWaitObserver for the current thread. */
+class LockWaitScope
+{
+    LockWaitObserver* const m_prev;
+
+public:
+    explicit LockWaitScope(LockWaitObserver& observer) : m_prev{g_lock_wait_observer}
+    {
+        g_lock_wait_observer = &observer;
+    }
+    ~LockWaitScope() { g_lock_wait_observer = m_prev; }
+
+    LockWaitScope(const LockWaitScope&) = delete;
+    LockWaitScope& operator=(const LockWaitScope&) = delete;
+};
+
 #define AssertLockHeld(cs) AssertLockHeldInternal(#cs, __FILE__, __LINE__, &cs)
+//! Assert that a SharedMutex is held, either shared (READ_LOCK) or exclusively (LOCK).
+#define AssertSharedLockHeld(cs) AssertSharedLockHeldInternal(#cs, __FILE__, __LINE__, &cs)
 
 inline void AssertLockNotHeldInline(const char* name, const char* file, int line, Mutex* cs) EXCLUSIVE_LOCKS_REQUIRED(!cs) { AssertLockNotHeldInternal(name, file, line, cs); }
 inline void AssertLockNotHeldInline(const char* name, const char* file, int line, RecursiveMutex* cs) LOCKS_EXCLUDED(cs) { AssertLockNotHeldInternal(name, file, line, cs); }
+inline void AssertLockNotHeldInline(const char* name, const char* file, int line, SharedMutex* cs) EXCLUSIVE_LOCKS_REQUIRED(!cs) { AssertLockNotHeldInternal(name, file, line, cs); }
 inline void AssertLockNotHeldInline(const char* name, const char* file, int line, GlobalMutex* cs) LOCKS_EXCLUDED(cs) { AssertLockNotHeldInternal(name, file, line, cs); }
 #define AssertLockNotHeld(cs) AssertLockNotHeldInline(#cs, __FILE__, __LINE__, &cs)
 
@@ -156,10 +217,16 @@ private:
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex());
-#ifdef DEBUG_LOCKCONTENTION
         if (Base::try_lock()) return;
+#ifdef DEBUG_LOCKCONTENTION
         LOG_TIME_MICROS_WITH_CATEGORY(strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine), BCLog::LOCK);
 #endif
+        if (LockWaitObserver* observer{g_lock_wait_observer}) {
+            const auto start{std::chrono::steady_clock::now()};
+            Base::lock();
+            observer->LockWaited(Base::mutex(), std::chrono::steady_clock::now() - start);
+            return;
+        }
         Base::lock();
     }
 
@@ -240,6 +307,26 @@ public:
      friend class reverse_lock;
 };
 
+/** Wrapper around std::shared_lock for a SharedMutex, with lock order checking. */
+template <typename MutexType>
+class SCOPED_LOCKABLE SharedLock : public std::shared_lock<MutexType>
+{
+private:
+    using Base = std::shared_lock<MutexType>;
+
+public:
+    SharedLock(MutexType& mutex_in, const char* name, const char* file, int line) SHARED_LOCK_FUNCTION(mutex_in) : Base(mutex_in, std::defer_lock)
+    {
+        EnterCritical(name, file, line, Base::mutex());
+        Base::lock();
+    }
+
+    ~SharedLock() UNLOCK_FUNCTION()
+    {
+        if (Base::owns_lock()) LeaveCritical();
+    }
+};
+
 #define REVERSE_LOCK(g) typename std::decay<decltype(g)>::type::reverse_lock UNIQUE_NAME(revlock)(g, #g, __FILE__, __LINE__)
 
 // When locking a Mutex, require negative capability to ensure the lock
@@ -258,6 +345,7 @@ inline MutexType* MaybeCheckNotHeld(MutexType* m) LOCKS_EXCLUDED(m) LOCK_RETURNE
 #define LOCK2(cs1, cs2)                                               \
     UniqueLock criticalblock1(MaybeCheckNotHeld(cs1), #cs1, __FILE__, __LINE__); \
     UniqueLock criticalblock2(MaybeCheckNotHeld(cs2), #cs2, __FILE__, __LINE__)
+#define READ_LOCK(cs) SharedLock UNIQUE_NAME(criticalblock)(MaybeCheckNotHeld(cs), #cs, __FILE__, __LINE__)
 #define TRY_LOCK(cs, name) UniqueLock name(MaybeCheckNotHeld(cs), #cs, __FILE__, __LINE__, true)
 #define WAIT_LOCK(cs, name) UniqueLock name(MaybeCheckNotHeld(cs), #cs, __FILE__, __LINE__)
 
@@ -17,8 +17,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std::literals;
 using node::NodeContext;
@@ -1167,4 +1170,51 @@ BOOST_AUTO_TEST_CASE(addrman_size)
     BOOST_CHECK_EQUAL(addrman->Size(/*net=*/std::nullopt, /*in_new=*/false), 1U);
 }
 
+BOOST_AUTO_TEST_CASE(addrman_concurrent_readers)
+{
+    // Collisions may evict entries, so the result is compared to an addrman that goes
+    // through the same changes without readers.
+    auto addrman = std::make_unique<AddrMan>(EMPTY_NETGROUPMAN, DETERMINISTIC, GetCheckRatio(m_node));
+    auto reference = std::make_unique<AddrMan>(EMPTY_NETGROUPMAN, DETERMINISTIC, GetCheckRatio(m_node));
+    const CNetAddr source = ResolveIP("252.2.2.2");
+    for (int i = 1; i < 100; ++i) {
+        const CAddress addr{ResolveService(strprintf("250.%d.1.1", i), 8333), NODE_NONE};
+        for (auto* am : {addrman.get(), reference.get()}) {
+            am->Add({addr}, source);
+            if (i % 4 == 0) am->Good(addr);
+        }
+    }
+    const size_t expected_size{addrman->Size()};
+    BOOST_REQUIRE_GT(expected_size, 0U);
+
+    std::vector<CAddress> new_addrs;
+    for (int i = 1; i < 50; ++i) {
+        new_addrs.emplace_back(ResolveService(strprintf("251.%d.1.1", i), 8333), NODE_NONE);
+    }
+
+    // Readers only take the lock shared and must be able to run alongside
+    // each other and alongside a writer without corrupting state.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 50; ++i) {
+                const auto addrs{addrman->GetAddr(/*max_addresses=*/10, /*max_pct=*/0, /*network=*/std::nullopt)};
+                assert(addrs.size() <= 10);
+                assert(addrman->Select().first.IsValid());
+                assert(addrman->Size() >= expected_size);
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        for (const auto& addr : new_addrs) {
+            addrman->Add({addr}, source);
+        }
+    });
+    for (auto& thread : threads) thread.join();
+
+    for (const auto& addr : new_addrs) reference->Add({addr}, source);
+    BOOST_CHECK_EQUAL(addrman->Size(), reference->Size());
+    BOOST_CHECK_EQUAL(addrman->GetAddr(/*max_addresses=*/0, /*max_pct=*/0, /*network=*/std::nullopt, /*filtered=*/false).size(), reference->Size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,19 +5,29 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
+#include <common/args.h>
+#include <consensus/consensus.h>
+#include <node/blockcompression.h>
+#include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <undo.h>
 #include <util/chaintype.h>
+#include <util/strencodings.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
+using namespace util::hex_literals;
+using node::BLOCK_AND_UNDO_CACHE_BYTES;
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockAndUndo;
+using node::BlockFileEntry;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
@@ -133,6 +143,512 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_block_data_availability, TestChain100Setup)
     BOOST_CHECK(!blockman.CheckBlockDataAvailability(tip, *last_pruned_block));
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_block_index_snapshot, TestChain100Setup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    WITH_LOCK(::cs_main, chainman.ActiveChainstate().ForceFlushStateToDisk());
+    const BlockManager::Options blockman_opts{
+        .chainparams = chainman.GetParams(),
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = chainman.GetNotifications(),
+        .block_index_snapshot = true,
+    };
+    // Hand the block tree database from one BlockManager to the next, as after a restart.
+    auto block_tree_db{WITH_LOCK(::cs_main, return std::move(chainman.m_blockman.m_block_tree_db))};
+    const auto check_loaded_index{[&](BlockManager& blockman) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        BOOST_CHECK_EQUAL(blockman.m_block_index.size(), chainman.m_blockman.m_block_index.size());
+        for (const auto& [hash, expected] : chainman.m_blockman.m_block_index) {
+            const CBlockIndex* index{blockman.LookupBlockIndex(hash)};
+            BOOST_REQUIRE(index);
+            BOOST_CHECK_EQUAL(index->nHeight, expected.nHeight);
+            BOOST_CHECK_EQUAL(index->nStatus, expected.nStatus);
+            BOOST_CHECK_EQUAL(index->nTx, expected.nTx);
+            BOOST_CHECK_EQUAL(index->nDataPos, expected.nDataPos);
+            BOOST_CHECK(index->nChainWork == expected.nChainWork);
+            BOOST_CHECK(index->GetBlockHeader().GetHash() == hash);
+            BOOST_CHECK_EQUAL(index->pprev ? index->pprev->GetBlockHash() : uint256{}, expected.pprev ? expected.pprev->GetBlockHash() : uint256{});
+        }
+    }};
+
+    {
+        // Nothing is written before the block index is loaded, with or without a database.
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        LOCK(::cs_main);
+        BOOST_CHECK(blockman.WriteBlockIndexSnapshot());
+        blockman.m_block_tree_db = std::move(block_tree_db);
+        BOOST_CHECK(blockman.WriteBlockIndexSnapshot());
+        BOOST_CHECK(!fs::exists(blockman.BlockIndexSnapshotPath()));
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+    {
+        // Without a snapshot the index comes from the database; then write one.
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        LOCK(::cs_main);
+        blockman.m_block_tree_db = std::move(block_tree_db);
+        BOOST_CHECK(blockman.LoadBlockIndexDB({}));
+        BOOST_CHECK(!blockman.LoadedBlockIndexSnapshot());
+        check_loaded_index(blockman);
+        BOOST_CHECK(blockman.WriteBlockIndexSnapshot());
+        BOOST_CHECK(fs::exists(blockman.BlockIndexSnapshotPath()));
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+    {
+        // The snapshot matches the database, so it is loaded and the background check passes.
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        {
+            LOCK(::cs_main);
+            blockman.m_block_tree_db = std::move(block_tree_db);
+            BOOST_CHECK(blockman.LoadBlockIndexDB({}));
+            BOOST_CHECK(blockman.LoadedBlockIndexSnapshot());
+            check_loaded_index(blockman);
+        }
+        blockman.WaitForBlockIndexSnapshotCheck();
+        BOOST_CHECK(fs::exists(blockman.BlockIndexSnapshotPath()));
+
+        // Writing block index entries to the database invalidates the snapshot.
+        LOCK(::cs_main);
+        int last_file{0};
+        blockman.m_block_tree_db->ReadLastBlockFile(last_file);
+        BOOST_CHECK(blockman.m_block_tree_db->ReadBlockIndexSnapshotId());
+        BOOST_CHECK(blockman.m_block_tree_db->WriteBatchSync({}, last_file, {blockman.LookupBlockIndex(chainman.ActiveTip()->GetBlockHash())}));
+        BOOST_CHECK(!blockman.m_block_tree_db->ReadBlockIndexSnapshotId());
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+    {
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        LOCK(::cs_main);
+        blockman.m_block_tree_db = std::move(block_tree_db);
+        BOOST_CHECK(blockman.LoadBlockIndexDB({}));
+        BOOST_CHECK(!blockman.LoadedBlockIndexSnapshot());
+        check_loaded_index(blockman);
+        BOOST_CHECK(blockman.WriteBlockIndexSnapshot());
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+    {
+        // Change the database behind the snapshot's back. The background check then finds a
+        // mismatch and removes the snapshot, and the index loaded from it is not written out.
+        // Block index entries are stored under 'b' followed by the block hash.
+        const auto tip_key{std::make_pair(uint8_t{'b'}, WITH_LOCK(::cs_main, return chainman.ActiveTip()->GetBlockHash()))};
+        BOOST_CHECK(block_tree_db->Erase(tip_key));
+        const auto snapshot_id{block_tree_db->ReadBlockIndexSnapshotId()};
+        BOOST_CHECK(snapshot_id);
+
+        KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+        notifications.m_shutdown_on_fatal_error = false;
+        const BlockManager::Options corrupt_opts{
+            .chainparams = chainman.GetParams(),
+            .blocks_dir = m_args.GetBlocksDirPath(),
+            .notifications = notifications,
+            .block_index_snapshot = true,
+        };
+        BlockManager blockman{*Assert(m_node.shutdown_signal), corrupt_opts};
+        {
+            LOCK(::cs_main);
+            blockman.m_block_tree_db = std::move(block_tree_db);
+            BOOST_CHECK(blockman.LoadBlockIndexDB({}));
+            BOOST_CHECK(blockman.LoadedBlockIndexSnapshot());
+        }
+        {
+            ASSERT_DEBUG_LOG("does not match the block index database");
+            blockman.WaitForBlockIndexSnapshotCheck();
+        }
+        BOOST_CHECK(!fs::exists(blockman.BlockIndexSnapshotPath()));
+
+        LOCK(::cs_main);
+        {
+            ASSERT_DEBUG_LOG("Not writing the block index snapshot");
+            BOOST_CHECK(blockman.WriteBlockIndexSnapshot());
+        }
+        BOOST_CHECK(!fs::exists(blockman.BlockIndexSnapshotPath()));
+        BOOST_CHECK(blockman.m_block_tree_db->ReadBlockIndexSnapshotId() == snapshot_id);
+        BOOST_CHECK(!blockman.m_block_tree_db->Exists(tip_key));
+
+        BOOST_CHECK(blockman.m_block_tree_db->Write(tip_key, CDiskBlockIndex{chainman.ActiveTip()}));
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+    {
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        LOCK(::cs_main);
+        blockman.m_block_tree_db = std::move(block_tree_db);
+        BOOST_CHECK(blockman.LoadBlockIndexDB({}));
+        BOOST_CHECK(!blockman.LoadedBlockIndexSnapshot());
+        check_loaded_index(blockman);
+        chainman.m_blockman.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_async, TestChain100Setup)
+{
+    auto& blockman{m_node.chainman->m_blockman};
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(::cs_main);
+        // Out of file order, with a repeat, to check that results follow the request order.
+        for (const int height : {100, 3, 50, 0, 3, 99}) blocks.push_back(m_node.chainman->ActiveChain()[height]);
+    }
+    // The null position fails to read.
+    ASSERT_DEBUG_LOG("OpenBlockFile failed");
+    auto block_futures{blockman.ReadBlocksAsync(blocks)};
+    auto undo_futures{blockman.UndoReadAsync(blocks)};
+    std::vector<FlatFilePos> positions;
+    for (const CBlockIndex* block : blocks) positions.push_back(WITH_LOCK(::cs_main, return block->GetBlockPos()));
+    positions.emplace_back(); // null position
+    auto raw_futures{blockman.ReadRawBlocksAsync(positions)};
+    BOOST_REQUIRE_EQUAL(block_futures.size(), blocks.size());
+    BOOST_REQUIRE_EQUAL(raw_futures.size(), blocks.size() + 1);
+
+    for (size_t i{0}; i < blocks.size(); ++i) {
+        CBlock expected;
+        BOOST_REQUIRE(blockman.ReadBlockFromDisk(expected, *blocks[i]));
+        const auto block{block_futures[i].get()};
+        BOOST_REQUIRE(block);
+        BOOST_CHECK_EQUAL(block->GetHash(), blocks[i]->GetBlockHash());
+
+        const auto raw{raw_futures[i].get()};
+        BOOST_REQUIRE(raw);
+        DataStream stream{*raw};
+        CBlock from_raw;
+        stream >> TX_WITH_WITNESS(from_raw);
+        BOOST_CHECK_EQUAL(from_raw.GetHash(), blocks[i]->GetBlockHash());
+
+        const auto undo{undo_futures[i].get()};
+        BOOST_REQUIRE(undo);
+        if (blocks[i]->nHeight == 0) {
+            BOOST_CHECK(undo->vtxundo.empty());
+        } else {
+            CBlockUndo expected_undo;
+            BOOST_REQUIRE(blockman.UndoReadFromDisk(expected_undo, *blocks[i]));
+            BOOST_CHECK_EQUAL(undo->vtxundo.size(), expected_undo.vtxundo.size());
+            BOOST_CHECK_EQUAL(undo->vtxundo.size(), block->vtx.size() - 1);
+        }
+    }
+    BOOST_CHECK(!raw_futures.back().get());
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_block_and_undo, TestChain100Setup)
+{
+    auto& blockman{m_node.chainman->m_blockman};
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(::cs_main);
+        for (const int height : {0, 42, 100}) blocks.push_back(m_node.chainman->ActiveChain()[height]);
+    }
+    std::vector<BlockAndUndo> first;
+    for (auto& future : blockman.ReadBlocksAndUndoAsync(blocks)) first.push_back(future.get());
+    for (size_t i{0}; i < blocks.size(); ++i) {
+        BOOST_REQUIRE(first[i].block && first[i].undo);
+        BOOST_CHECK_EQUAL(first[i].block->GetHash(), blocks[i]->GetBlockHash());
+        BOOST_CHECK_EQUAL(first[i].undo->vtxundo.size(), first[i].block->vtx.size() - 1);
+
+        // The second read is served from the cache.
+        const BlockAndUndo again{blockman.ReadBlockAndUndo(*blocks[i])};
+        BOOST_CHECK(again.block == first[i].block);
+        BOOST_CHECK(again.undo == first[i].undo);
+    }
+
+    const size_t usage{blockman.BlockAndUndoCacheUsage()};
+    BOOST_CHECK_GT(usage, 0U);
+    BOOST_CHECK_LE(usage, BLOCK_AND_UNDO_CACHE_BYTES);
+
+    // Reads that bypass the cache, as index sync does, neither use nor change it.
+    std::vector<const CBlockIndex*> others;
+    {
+        LOCK(::cs_main);
+        for (int height{1}; height <= 20; ++height) others.push_back(m_node.chainman->ActiveChain()[height]);
+    }
+    others.push_back(blocks[1]);
+    std::vector<BlockAndUndo> uncached;
+    for (auto& future : blockman.ReadBlocksAndUndoAsync(others, /*use_cache=*/false)) uncached.push_back(future.get());
+    for (const BlockAndUndo& result : uncached) BOOST_CHECK(result.undo);
+    BOOST_CHECK(uncached.back().block != first[1].block);
+    BOOST_CHECK_EQUAL(uncached.back().block->GetHash(), first[1].block->GetHash());
+    BOOST_CHECK_EQUAL(blockman.BlockAndUndoCacheUsage(), usage);
+    BOOST_CHECK(blockman.ReadBlockAndUndo(*blocks[1]).block == first[1].block);
+
+    // Once the block index no longer has the undo data, as after pruning, the cached
+    // entry is not served and the read fails as it does without the cache.
+    CBlockIndex& pruned{*Assert(WITH_LOCK(::cs_main, return blockman.LookupBlockIndex(blocks[1]->GetBlockHash())))};
+    WITH_LOCK(::cs_main, pruned.nStatus &= ~BLOCK_HAVE_UNDO);
+    const BlockAndUndo after_prune{blockman.ReadBlockAndUndo(*blocks[1])};
+    BOOST_CHECK(after_prune.block != first[1].block);
+    BOOST_CHECK(!after_prune.undo);
+    WITH_LOCK(::cs_main, pruned.nStatus |= BLOCK_HAVE_UNDO);
+    BOOST_CHECK(blockman.ReadBlockAndUndo(*blocks[1]).block == first[1].block);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_scan_block_files, TestChain100Setup)
+{
+    auto& blockman{m_node.chainman->m_blockman};
+    const MessageStartChars& message_start{Params().MessageStart()};
+
+    // A second file with data between blocks that has to be searched through, and a
+    // block cut short at the end.
+    std::vector<uint8_t> raw_block;
+    BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw_block, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[1]->GetBlockPos())));
+    {
+        AutoFile file{blockman.OpenBlockFile(FlatFilePos{1, 0})};
+        const auto junk{m_rng.randbytes(37)};
+        file << Span{junk} << message_start << uint32_t{MAX_BLOCK_SERIALIZED_SIZE + 1} << message_start.front();
+        file << message_start << uint32_t(raw_block.size()) << Span{raw_block};
+        file << message_start << uint32_t(raw_block.size()) << Span{raw_block}.first(100);
+    }
+
+    auto scans{blockman.ScanBlockFilesAsync(/*first_file=*/0, /*count=*/2)};
+    const auto entries{scans[0].get()};
+    BOOST_REQUIRE(entries);
+    BOOST_REQUIRE_EQUAL(entries->size(), 101U);
+    {
+        LOCK(::cs_main);
+        for (int height{0}; height <= 100; ++height) {
+            const CBlockIndex& index{*m_node.chainman->ActiveChain()[height]};
+            const BlockFileEntry& entry{(*entries)[height]};
+            BOOST_CHECK_EQUAL(entry.hash, index.GetBlockHash());
+            BOOST_CHECK_EQUAL(entry.prev_hash, index.pprev ? index.pprev->GetBlockHash() : uint256{});
+            BOOST_CHECK(entry.pos == index.GetBlockPos());
+        }
+    }
+
+    const auto garbage_entries{scans[1].get()};
+    BOOST_REQUIRE(garbage_entries);
+    BOOST_REQUIRE_EQUAL(garbage_entries->size(), 1U);
+    const BlockFileEntry& entry{garbage_entries->front()};
+    BOOST_CHECK_EQUAL(entry.hash, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[1]->GetBlockHash()));
+    BOOST_CHECK(entry.pos == (FlatFilePos{1, 37 + 4 + 4 + 1 + 4 + 4}));
+    auto blocks{blockman.ReadBlocksAsync(std::span{&entry, 1})};
+    const auto block{blocks[0].get()};
+    BOOST_REQUIRE(block);
+    BOOST_CHECK_EQUAL(block->GetHash(), entry.hash);
+
+    // A missing file is reported as such.
+    BOOST_CHECK(!blockman.ScanBlockFilesAsync(/*first_file=*/2, /*count=*/1)[0].get());
+}
+
+BOOST_AUTO_TEST_CASE(blockcompression_roundtrip)
+{
+    // Random bytes, runs and repeated strings, reaching into the dictionary and overlapping
+    // their own output.
+    std::vector<uint8_t> data{m_rng.randbytes<uint8_t>(1000)};
+    data.insert(data.end(), 300, 0x42);
+    const std::vector<uint8_t> repeated{data.begin() + 100, data.begin() + 400};
+    for (int i{0}; i < 4; ++i) data.insert(data.end(), repeated.begin(), repeated.end());
+    for (int i{0}; i < 50; ++i) {
+        const auto script{"1976a914"_hex_v_u8};
+        data.insert(data.end(), script.begin(), script.end());
+        const auto hash{m_rng.randbytes<uint8_t>(20)};
+        data.insert(data.end(), hash.begin(), hash.end());
+        data.push_back(0x88);
+        data.push_back(0xac);
+    }
+
+    const std::vector<uint8_t> frame{node::CompressBlockData(data)};
+    BOOST_CHECK_LT(frame.size(), data.size());
+    BOOST_CHECK(node::DecompressBlockData(frame, data.size()) == data);
+    const auto prefix{node::DecompressBlockData(frame, data.size(), /*max_size=*/80)};
+    BOOST_REQUIRE(prefix);
+    BOOST_CHECK(std::ranges::equal(*prefix, std::span{data}.first(80)));
+
+    BOOST_CHECK(node::CompressBlockData({}).empty());
+    BOOST_CHECK(node::DecompressBlockData({}, 0) == std::vector<uint8_t>{});
+
+    // Truncated frames, wrong sizes and offsets before the dictionary are rejected.
+    BOOST_CHECK(!node::DecompressBlockData(std::span{frame}.first(frame.size() - 1), data.size()));
+    BOOST_CHECK(!node::DecompressBlockData(frame, data.size() + 1));
+    BOOST_CHECK(!node::DecompressBlockData(frame, data.size() - 1));
+    BOOST_CHECK(!node::DecompressBlockData(std::vector<uint8_t>{0x10, 0x00, 0xff, 0xff}, 5));
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_compress_block_file, TestChain100Setup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    auto& blockman{chainman.m_blockman};
+    // Move on to a second block file, so that the first one is finalized.
+    WITH_LOCK(chainman.GetMutex(), blockman.GetBlockFileInfo(0)->nSize = MAX_BLOCKFILE_SIZE);
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(::cs_main);
+        for (int height{0}; height <= 100; ++height) blocks.push_back(chainman.ActiveChain()[height]);
+        BOOST_REQUIRE_EQUAL(chainman.ActiveChain().Tip()->GetBlockPos().nFile, 1);
+    }
+    std::vector<std::vector<uint8_t>> raw_blocks;
+    for (const CBlockIndex* index : blocks) {
+        BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw_blocks.emplace_back(), WITH_LOCK(::cs_main, return index->GetBlockPos())));
+    }
+    const auto entries{blockman.ScanBlockFilesAsync(/*first_file=*/0, /*count=*/1)[0].get()};
+    BOOST_REQUIRE(entries);
+    const auto file_size{[&] { return fs::file_size(blockman.GetBlockPosFilename(FlatFilePos{0, 0})); }};
+    const auto size_before{file_size()};
+
+    // The file being written to is left alone.
+    const uint64_t generation{blockman.GetCompressionGeneration()};
+    AutoFile old_file{blockman.OpenBlockFile(FlatFilePos{0, 0}, /*fReadOnly=*/true)};
+    BOOST_CHECK(!blockman.CompressBlockFile(1));
+    BOOST_CHECK(blockman.CompressBlockFile(0));
+    BOOST_CHECK_LT(file_size(), size_before);
+    BOOST_CHECK(!blockman.CompressBlockFile(0));
+
+    // A reader that opened the file before it was replaced finds it uncompressed, but
+    // that is not remembered for the compressed file.
+    BOOST_CHECK(!blockman.ReadFromCompressedFile(old_file, WITH_LOCK(::cs_main, return blocks[1]->GetBlockPos()), generation));
+    BOOST_CHECK_EQUAL(blockman.GetCompressionGeneration(), generation + 1);
+
+    // Blocks are read from their old positions.
+    for (size_t i{0}; i < blocks.size(); ++i) {
+        std::vector<uint8_t> raw_block;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(raw_block, WITH_LOCK(::cs_main, return blocks[i]->GetBlockPos())));
+        BOOST_CHECK(raw_block == raw_blocks[i]);
+        CBlock block;
+        BOOST_CHECK(blockman.ReadBlockFromDisk(block, *blocks[i]));
+        BOOST_CHECK_EQUAL(block.GetHash(), blocks[i]->GetBlockHash());
+    }
+    auto undo{blockman.ReadBlockAndUndo(*blocks[50])};
+    BOOST_CHECK(undo.block && undo.undo);
+    {
+        ASSERT_DEBUG_LOG("no block at offset");
+        CBlock block;
+        BOOST_CHECK(!blockman.ReadBlockFromDisk(block, FlatFilePos{0, WITH_LOCK(::cs_main, return blocks[1]->GetBlockPos().nPos) + 1}));
+    }
+
+    // A reindex finds the same blocks.
+    const auto compressed_entries{blockman.ScanBlockFilesAsync(/*first_file=*/0, /*count=*/1)[0].get()};
+    BOOST_REQUIRE(compressed_entries);
+    BOOST_REQUIRE_EQUAL(compressed_entries->size(), entries->size());
+    for (size_t i{0}; i < entries->size(); ++i) {
+        BOOST_CHECK_EQUAL((*compressed_entries)[i].hash, (*entries)[i].hash);
+        BOOST_CHECK_EQUAL((*compressed_entries)[i].prev_hash, (*entries)[i].prev_hash);
+        BOOST_CHECK((*compressed_entries)[i].pos == (*entries)[i].pos);
+    }
+
+    // A corrupted frame fails its checksum instead of being decompressed.
+    const FlatFilePos corrupt_pos{WITH_LOCK(::cs_main, return blocks[50]->GetBlockPos())};
+    uint32_t frame_pos;
+    {
+        AutoFile file{blockman.OpenBlockFile(FlatFilePos{0, 0}, /*fReadOnly=*/true)};
+        BOOST_REQUIRE(node::IsCompressedBlockFile(file));
+        const auto table{node::ReadCompressedBlockTable(file)};
+        const auto it{std::ranges::find(table, corrupt_pos.nPos, &node::CompressedBlockRecord::pos)};
+        BOOST_REQUIRE(it != table.end());
+        frame_pos = it->frame_pos + it->frame_size / 2;
+    }
+    {
+        FILE* file{fsbridge::fopen(blockman.GetBlockPosFilename(FlatFilePos{0, 0}), "rb+")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, frame_pos, SEEK_SET), 0);
+        const int byte{std::fgetc(file)};
+        BOOST_REQUIRE_EQUAL(std::fseek(file, frame_pos, SEEK_SET), 0);
+        BOOST_REQUIRE_EQUAL(std::fputc(byte ^ 1, file), byte ^ 1);
+        BOOST_REQUIRE_EQUAL(std::fclose(file), 0);
+    }
+    {
+        ASSERT_DEBUG_LOG("checksum mismatch in compressed block frame");
+        CBlock block;
+        BOOST_CHECK(!blockman.ReadBlockFromDisk(block, corrupt_pos));
+    }
+    std::vector<uint8_t> raw_block;
+    BOOST_CHECK(!blockman.ReadRawBlockFromDisk(raw_block, corrupt_pos));
+    BOOST_CHECK(blockman.ReadRawBlockFromDisk(raw_block, WITH_LOCK(::cs_main, return blocks[49]->GetBlockPos())));
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_prune_keep_heights)
+{
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    BlockManager blockman{*Assert(m_node.shutdown_signal), {
+        .chainparams = Params(),
+        .prune_target = BlockManager::PRUNE_TARGET_MANUAL,
+        .prune_keep_heights = {{2, 3}, {7, 7}},
+        .fast_prune = true,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+    }};
+    BOOST_CHECK_EQUAL(blockman.MinBlocksToKeep(), int{MIN_BLOCKS_TO_KEEP});
+    BOOST_CHECK(!blockman.IsInPruneKeepRanges(1));
+    BOOST_CHECK(blockman.IsInPruneKeepRanges(3));
+
+    // A chain of blocks without transactions, heights 0-5 in the first block file and
+    // 6-9 in the second.
+    std::vector<CBlockIndex*> indexes;
+    std::vector<std::vector<uint8_t>> raw_blocks;
+    CBlockIndex* best_header{nullptr};
+    uint256 prev_hash;
+    for (int height{0}; height < 10; ++height) {
+        CBlock block;
+        block.nVersion = height + 1;
+        block.hashPrevBlock = prev_hash;
+        prev_hash = block.GetHash();
+        LOCK(::cs_main);
+        if (height == 6) blockman.GetBlockFileInfo(0)->nSize = 0x10000;
+        CBlockIndex* index{blockman.AddToBlockIndex(block, best_header)};
+        BOOST_REQUIRE_EQUAL(index->nHeight, height);
+        const FlatFilePos pos{blockman.SaveBlockToDisk(block, height)};
+        BOOST_REQUIRE_EQUAL(pos.nFile, height < 6 ? 0 : 1);
+        index->nFile = pos.nFile;
+        index->nDataPos = pos.nPos;
+        index->nUndoPos = pos.nPos;
+        index->nStatus |= BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        indexes.push_back(index);
+        BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw_blocks.emplace_back(), pos));
+    }
+    BOOST_CHECK(WITH_LOCK(::cs_main, return blockman.KeptBlockFiles()).empty());
+
+    // The kept blocks of the first file move to a file of their own.
+    const uint64_t moved{WITH_LOCK(::cs_main, return blockman.PruneOneBlockFile(0))};
+    BOOST_CHECK_EQUAL(moved, 2 * (raw_blocks[2].size() + BLOCK_SERIALIZATION_HEADER_SIZE));
+    blockman.UnlinkPrunedFiles({0});
+    const FlatFilePos kept_pos{WITH_LOCK(::cs_main, return indexes[2]->GetBlockPos())};
+    BOOST_CHECK_EQUAL(kept_pos.nFile, 2);
+    BOOST_CHECK(WITH_LOCK(::cs_main, return blockman.KeptBlockFiles()) == std::set<int>{2});
+
+    // Pruning the second file adds its kept block to the same file, and leaves the
+    // blocks kept earlier where they are.
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return blockman.PruneOneBlockFile(1)), raw_blocks[7].size() + BLOCK_SERIALIZATION_HEADER_SIZE);
+    blockman.UnlinkPrunedFiles({1});
+
+    LOCK(::cs_main);
+    BOOST_CHECK(indexes[2]->GetBlockPos() == kept_pos);
+    for (int height{0}; height < 10; ++height) {
+        const CBlockIndex& index{*indexes[height]};
+        const bool kept{height == 2 || height == 3 || height == 7};
+        BOOST_CHECK_EQUAL(bool(index.nStatus & BLOCK_HAVE_DATA), kept);
+        BOOST_CHECK(!(index.nStatus & BLOCK_HAVE_UNDO));
+        if (!kept) continue;
+        BOOST_CHECK_EQUAL(index.nFile, 2);
+        std::vector<uint8_t> raw_block;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(raw_block, index.GetBlockPos()));
+        BOOST_CHECK(raw_block == raw_blocks[height]);
+    }
+    BOOST_CHECK_EQUAL(blockman.GetBlockFileInfo(2)->nBlocks, 3U);
+    BOOST_CHECK(blockman.KeptBlockFiles() == std::set<int>{2});
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_prune_keep_args)
+{
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    const auto apply{[&](std::vector<const char*> argv) -> std::optional<BlockManager::Options> {
+        ArgsManager args;
+        for (const char* name : {"-prune", "-prunekeeprecent", "-prunekeepheights"}) {
+            args.AddArg(name, "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        }
+        argv.insert(argv.begin(), "ignored");
+        std::string error;
+        BOOST_REQUIRE(args.ParseParameters(argv.size(), argv.data(), error));
+        BlockManager::Options opts{.chainparams = Params(), .blocks_dir = m_args.GetBlocksDirPath(), .notifications = notifications};
+        if (!node::ApplyArgsManOptions(args, opts)) return std::nullopt;
+        return opts;
+    }};
+    const auto opts{apply({"-prune=1", "-prunekeeprecent=1000", "-prunekeepheights=10-20", "-prunekeepheights=500"})};
+    BOOST_REQUIRE(opts);
+    BOOST_CHECK_EQUAL(opts->prune_keep_recent, 1000);
+    BOOST_CHECK((opts->prune_keep_heights == std::vector<std::pair<int, int>>{{10, 20}, {500, 500}}));
+
+    BOOST_CHECK(!apply({"-prunekeepheights=10-20"}));
+    BOOST_CHECK(!apply({"-prunekeeprecent=1000"}));
+    BOOST_CHECK(!apply({"-prune=1", "-prunekeeprecent=-1"}));
+    for (const char* range : {"-prunekeepheights=20-10", "-prunekeepheights=-5", "-prunekeepheights=1-2-3", "-prunekeepheights=a"}) {
+        BOOST_CHECK(!apply({"-prune=1", range}));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
 {
     KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
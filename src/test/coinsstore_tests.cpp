@@ -0,0 +1,247 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <dbwrapper.h>
+#include <hashcoinsstore.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <uint256.h>
+
+#include <map>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+Coin RandomCoin(FastRandomContext& rng)
+{
+    return Coin{CTxOut{int64_t(rng.randrange(MAX_MONEY)), CScript() << rng.randbytes(rng.randrange(40))}, int(rng.randrange(1000000)), rng.randbool()};
+}
+
+void WriteCoins(CoinsStore& store, const std::map<COutPoint, std::optional<Coin>>& changes, const uint256& best_block)
+{
+    auto batch{store.NewBatch()};
+    for (const auto& [outpoint, coin] : changes) {
+        if (coin) {
+            batch->WriteCoin(outpoint, *coin);
+        } else {
+            batch->EraseCoin(outpoint);
+        }
+    }
+    batch->WriteBestBlock(best_block);
+    store.WriteBatch(*batch);
+}
+
+void CheckCoins(const CoinsStore& store, const std::map<COutPoint, Coin>& expected)
+{
+    for (const auto& [outpoint, coin] : expected) {
+        const auto read{store.ReadCoin(outpoint)};
+        BOOST_REQUIRE(read);
+        BOOST_CHECK(read->out == coin.out);
+        BOOST_CHECK_EQUAL(read->nHeight, coin.nHeight);
+        BOOST_CHECK_EQUAL(read->fCoinBase, coin.fCoinBase);
+    }
+    // The cursor returns exactly the expected coins, in outpoint order.
+    auto cursor{store.Cursor()};
+    auto it{expected.begin()};
+    for (; cursor->Valid(); cursor->Next(), ++it) {
+        COutPoint outpoint;
+        Coin coin;
+        BOOST_REQUIRE(it != expected.end());
+        BOOST_REQUIRE(cursor->GetKey(outpoint));
+        BOOST_REQUIRE(cursor->GetValue(coin));
+        BOOST_CHECK(outpoint == it->first);
+        BOOST_CHECK(coin.out == it->second.out);
+    }
+    BOOST_CHECK(it == expected.end());
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(coinsstore_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(coins_backends)
+{
+    for (const CoinsBackend backend : {CoinsBackend::LEVELDB, CoinsBackend::HASHSTORE}) {
+        const fs::path path{m_args.GetDataDirBase() / fs::u8path("coins_" + CoinsBackendToString(backend))};
+        std::map<COutPoint, Coin> expected;
+        const uint256 best_block{m_rng.rand256()};
+        {
+            CCoinsViewDB db{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true}, {.backend = backend}};
+            CCoinsViewCache cache{&db};
+            for (int i{0}; i < 500; ++i) {
+                const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), uint32_t(m_rng.randrange(4))};
+                const Coin coin{RandomCoin(m_rng)};
+                cache.AddCoin(outpoint, Coin{coin}, /*possible_overwrite=*/false);
+                expected.emplace(outpoint, coin);
+            }
+            cache.SetBestBlock(m_rng.rand256());
+            BOOST_REQUIRE(cache.Flush());
+            // Spend some of the flushed coins in a second flush.
+            for (auto it{expected.begin()}; it != expected.end();) {
+                if (m_rng.randbool()) {
+                    BOOST_CHECK(cache.SpendCoin(it->first));
+                    it = expected.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            cache.SetBestBlock(best_block);
+            BOOST_REQUIRE(cache.Flush());
+        }
+        CCoinsViewDB db{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = false}, {.backend = backend}};
+        BOOST_CHECK_EQUAL(db.GetBestBlock(), best_block);
+        BOOST_CHECK(db.GetHeadBlocks().empty());
+        for (const auto& [outpoint, coin] : expected) {
+            BOOST_CHECK(db.HaveCoin(outpoint));
+            BOOST_CHECK(db.GetCoin(outpoint)->out == coin.out);
+        }
+        size_t count{0};
+        COutPoint prev;
+        for (auto cursor{db.Cursor()}; cursor->Valid(); cursor->Next(), ++count) {
+            COutPoint outpoint;
+            BOOST_REQUIRE(cursor->GetKey(outpoint));
+            BOOST_CHECK(count == 0 || prev < outpoint);
+            prev = outpoint;
+        }
+        BOOST_CHECK_EQUAL(count, expected.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coins_backend_mismatch)
+{
+    const fs::path path{m_args.GetDataDirBase() / "coins_mismatch"};
+    { CCoinsViewDB db{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true}, {.backend = CoinsBackend::HASHSTORE}}; }
+    BOOST_CHECK_THROW((CCoinsViewDB{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = false}, {.backend = CoinsBackend::LEVELDB}}), dbwrapper_error);
+    // Wiping converts the directory to the other backend, and back.
+    { CCoinsViewDB db{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true}, {.backend = CoinsBackend::LEVELDB}}; }
+    BOOST_CHECK(!HashCoinsStore::IsHashStore(path));
+    BOOST_CHECK_THROW((CCoinsViewDB{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = false}, {.backend = CoinsBackend::HASHSTORE}}), dbwrapper_error);
+    { CCoinsViewDB db{{.path = path, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true}, {.backend = CoinsBackend::HASHSTORE}}; }
+    BOOST_CHECK(HashCoinsStore::IsHashStore(path));
+    BOOST_CHECK(!fs::exists(path / "CURRENT"));
+}
+
+BOOST_AUTO_TEST_CASE(hashstore_garbage_collection)
+{
+    const fs::path path{m_args.GetDataDirBase() / "hashstore_gc"};
+    const HashCoinsStore::Options options{.path = path, .wipe_data = true, .segment_bytes = 4096, .background_gc = false};
+    std::map<COutPoint, Coin> expected;
+    uint256 best_block;
+    {
+        HashCoinsStore store{options};
+        BOOST_CHECK(!store.ReadBestBlock());
+        for (int round{0}; round < 20; ++round) {
+            std::map<COutPoint, std::optional<Coin>> changes;
+            for (int i{0}; i < 100; ++i) {
+                const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), 0};
+                changes.emplace(outpoint, RandomCoin(m_rng));
+            }
+            // Spend or overwrite about a quarter of the coins of earlier rounds.
+            for (auto it{expected.begin()}; it != expected.end(); ++it) {
+                if (m_rng.randrange(4) == 0) changes.emplace(it->first, m_rng.randbool() ? std::optional{RandomCoin(m_rng)} : std::nullopt);
+            }
+            best_block = m_rng.rand256();
+            WriteCoins(store, changes, best_block);
+            for (const auto& [outpoint, coin] : changes) {
+                if (coin) {
+                    expected.insert_or_assign(outpoint, *coin);
+                } else {
+                    expected.erase(outpoint);
+                }
+            }
+        }
+        CheckCoins(store, expected);
+
+        const size_t segments{store.SegmentCount()};
+        const auto cursor{store.Cursor()};
+        BOOST_CHECK(store.Compact() > 0);
+        BOOST_CHECK(store.SegmentCount() < segments);
+        BOOST_CHECK_EQUAL(store.Compact(), 0U);
+        CheckCoins(store, expected);
+        // A cursor created before the collection still reads the dropped segments.
+        size_t count{0};
+        for (; cursor->Valid(); cursor->Next(), ++count) {
+            Coin coin;
+            BOOST_CHECK(cursor->GetValue(coin));
+        }
+        BOOST_CHECK_EQUAL(count, expected.size());
+    }
+
+    // Everything survives a restart, including deletes whose puts are in older segments.
+    HashCoinsStore store{{.path = path, .segment_bytes = 4096, .background_gc = false}};
+    BOOST_CHECK_EQUAL(*store.ReadBestBlock(), best_block);
+    CheckCoins(store, expected);
+}
+
+BOOST_AUTO_TEST_CASE(hashstore_garbage_collection_tombstones)
+{
+    // Spend most coins of every round, so that the delete records take up many segments.
+    const fs::path path{m_args.GetDataDirBase() / "hashstore_gc_tombstones"};
+    const HashCoinsStore::Options options{.path = path, .wipe_data = true, .segment_bytes = 8192, .background_gc = false};
+    std::map<COutPoint, Coin> expected;
+    uint256 best_block;
+    {
+        HashCoinsStore store{options};
+        std::vector<COutPoint> previous;
+        for (int round{0}; round < 40; ++round) {
+            std::map<COutPoint, std::optional<Coin>> changes;
+            for (size_t i{0}; i < previous.size() * 9 / 10; ++i) {
+                changes.emplace(previous[i], std::nullopt);
+                expected.erase(previous[i]);
+            }
+            previous.clear();
+            for (int i{0}; i < 400; ++i) {
+                const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), 0};
+                const Coin coin{RandomCoin(m_rng)};
+                changes.emplace(outpoint, coin);
+                expected.emplace(outpoint, coin);
+                previous.push_back(outpoint);
+            }
+            best_block = m_rng.rand256();
+            WriteCoins(store, changes, best_block);
+        }
+
+        const size_t segments{store.SegmentCount()};
+        BOOST_CHECK(store.Compact() > 0);
+        BOOST_CHECK_EQUAL(store.Compact(), 0U);
+        // The delete records all went with the put records they hid.
+        BOOST_CHECK(store.SegmentCount() < segments / 2);
+        CheckCoins(store, expected);
+    }
+
+    HashCoinsStore store{{.path = path, .segment_bytes = 8192, .background_gc = false}};
+    BOOST_CHECK_EQUAL(*store.ReadBestBlock(), best_block);
+    CheckCoins(store, expected);
+    BOOST_CHECK_EQUAL(store.Compact(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(hashstore_uncommitted_write)
+{
+    const fs::path path{m_args.GetDataDirBase() / "hashstore_torn"};
+    const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), 1};
+    const Coin coin{RandomCoin(m_rng)};
+    {
+        HashCoinsStore store{{.path = path, .wipe_data = true, .background_gc = false}};
+        WriteCoins(store, {{outpoint, coin}}, m_rng.rand256());
+    }
+    // Simulate a crash after appending records but before the manifest was replaced.
+    for (const auto& entry : fs::directory_iterator{path}) {
+        if (fs::PathToString(entry.path().extension()) != ".dat") continue;
+        AutoFile file{fsbridge::fopen(entry.path(), "ab")};
+        file << uint8_t{'P'} << COutPoint{Txid::FromUint256(m_rng.rand256()), 0} << uint32_t{1000};
+    }
+    HashCoinsStore store{{.path = path, .background_gc = false}};
+    CheckCoins(store, {{outpoint, coin}});
+    // Writes after the recovery land behind the committed data.
+    const COutPoint outpoint2{Txid::FromUint256(m_rng.rand256()), 0};
+    const Coin coin2{RandomCoin(m_rng)};
+    WriteCoins(store, {{outpoint2, coin2}}, m_rng.rand256());
+    CheckCoins(store, {{outpoint, coin}, {outpoint2, coin2}});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <coins.h>
+#include <crypto/muhash.h>
+#include <hash.h>
 #include <index/coinstatsindex.h>
 #include <interfaces/chain.h>
 #include <kernel/coinstats.h>
@@ -11,6 +14,8 @@
 #include <test/util/validation.h>
 #include <validation.h>
 
+#include <memory>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_AUTO_TEST_SUITE(coinstatsindex_tests)
@@ -118,4 +123,44 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(coinstats_hash_batches, TestChain100Setup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    CCoinsViewDB& coins_db{WITH_LOCK(cs_main, return chainstate.CoinsDB())};
+    WITH_LOCK(cs_main, chainstate.ForceFlushStateToDisk());
+    // Add enough coins to be hashed in several batches on several threads.
+    {
+        CCoinsViewCache cache{&coins_db};
+        for (int i{0}; i < 10'000; ++i) {
+            const Txid txid{Txid::FromUint256(m_rng.rand256())};
+            for (uint32_t n : {0U, 1U, 300U}) {
+                cache.AddCoin(COutPoint{txid, n}, Coin{CTxOut{int64_t(m_rng.randrange(1'000'000)), CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+            }
+        }
+        cache.SetBestBlock(coins_db.GetBestBlock());
+        BOOST_REQUIRE(cache.Flush());
+    }
+
+    // The UTXO set hashes must match hashing each coin in order on a single thread.
+    MuHash3072 muhash;
+    HashWriter serialized{};
+    for (std::unique_ptr<CCoinsViewCursor> cursor{coins_db.Cursor()}; cursor->Valid(); cursor->Next()) {
+        COutPoint outpoint;
+        Coin coin;
+        BOOST_REQUIRE(cursor->GetKey(outpoint) && cursor->GetValue(coin));
+        kernel::ApplyCoinHash(muhash, outpoint, coin);
+        serialized << outpoint << uint32_t((coin.nHeight << 1) + coin.fCoinBase) << coin.out;
+    }
+    uint256 muhash_out;
+    muhash.Finalize(muhash_out);
+
+    const auto muhash_stats{kernel::ComputeUTXOStats(kernel::CoinStatsHashType::MUHASH, &coins_db, m_node.chainman->m_blockman)};
+    BOOST_REQUIRE(muhash_stats);
+    BOOST_CHECK_EQUAL(muhash_stats->hashSerialized, muhash_out);
+    BOOST_CHECK_EQUAL(muhash_stats->nTransactionOutputs, 100 + 30'000);
+    const auto serialized_stats{kernel::ComputeUTXOStats(kernel::CoinStatsHashType::HASH_SERIALIZED, &coins_db, m_node.chainman->m_blockman)};
+    BOOST_REQUIRE(serialized_stats);
+    BOOST_CHECK_EQUAL(serialized_stats->hashSerialized, serialized.GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,13 +2,19 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <common/args.h>
 #include <dbwrapper.h>
+#include <node/database_args.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <util/string.h>
 
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -400,4 +406,66 @@ BOOST_AUTO_TEST_CASE(unicodepath)
 }
 
 
+BOOST_AUTO_TEST_CASE(dbwrapper_options_and_stats)
+{
+    const fs::path ph = m_args.GetDataDirBase() / "dbwrapper_stats";
+    const DBOptions options{.bloom_filter_bits = 0, .block_size = 16 << 10, .write_buffer_size = 64 << 10, .max_file_size = 1 << 20, .max_open_files = 100};
+    {
+        CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .wipe_data = true, .options = options}};
+        for (uint32_t i{0}; i < 1000; ++i) BOOST_CHECK(dbw.Write(i, m_rng.randbytes(1000)));
+    }
+    // Reopening writes the memtable out, so every key is in a table.
+    CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .options = options}};
+    const DBStats stats{dbw.GetStats()};
+    BOOST_CHECK_EQUAL(stats.cache_bytes, 1U << 20);
+    BOOST_CHECK_EQUAL(stats.bloom_filter_bits, 0);
+    BOOST_CHECK_EQUAL(stats.block_size, 16U << 10);
+    BOOST_CHECK_EQUAL(stats.write_buffer_size, 64U << 10);
+    BOOST_CHECK_EQUAL(stats.max_file_size, 1U << 20);
+    BOOST_CHECK_EQUAL(stats.max_open_files, 100);
+    BOOST_REQUIRE_EQUAL(stats.levels.size(), 7U);
+    int files{0};
+    for (const DBStats::Level& level : stats.levels) files += level.files;
+    BOOST_CHECK_GE(files, 1);
+    BOOST_CHECK_GE(stats.approximate_bytes, 1000U * 1000U);
+    BOOST_CHECK_GE(stats.read_amplification, 1);
+    BOOST_CHECK_GE(stats.read_amplification, stats.levels[0].files);
+    uint32_t key{999};
+    std::vector<uint8_t> value;
+    BOOST_CHECK(dbw.Read(key, value));
+    BOOST_CHECK_EQUAL(value.size(), 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_database_args)
+{
+    const auto read{[](std::vector<const char*> argv, std::string_view db_name) {
+        ArgsManager args;
+        args.AddArg("-dboption", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        argv.insert(argv.begin(), "ignored");
+        std::string error;
+        BOOST_REQUIRE(args.ParseParameters(argv.size(), argv.data(), error));
+        DBOptions options;
+        const auto result{node::ReadDatabaseArgs(args, options, db_name)};
+        return result ? std::optional{options} : std::nullopt;
+    }};
+    const std::vector<const char*> argv{"-dboption=txindex:block_size=65536", "-dboption=chainstate:bloom_filter_bits=0", "-dboption=txindex:max_open_files=200"};
+    const auto txindex{read(argv, "txindex")};
+    BOOST_REQUIRE(txindex);
+    BOOST_CHECK_EQUAL(txindex->block_size, 65536U);
+    BOOST_CHECK_EQUAL(txindex->max_open_files.value(), 200);
+    BOOST_CHECK_EQUAL(txindex->bloom_filter_bits, 10);
+    const auto chainstate{read(argv, "chainstate")};
+    BOOST_REQUIRE(chainstate);
+    BOOST_CHECK_EQUAL(chainstate->bloom_filter_bits, 0);
+    BOOST_CHECK_EQUAL(chainstate->block_size, DBOptions{}.block_size);
+    BOOST_CHECK(!chainstate->max_open_files);
+
+    // Any invalid option is an error, also for other databases.
+    BOOST_CHECK(!read({"-dboption=txindex:block_size=0"}, "chainstate"));
+    BOOST_CHECK(!read({"-dboption=txindex:compression=1"}, "chainstate"));
+    BOOST_CHECK(!read({"-dboption=wallet:block_size=4096"}, "chainstate"));
+    BOOST_CHECK(!read({"-dboption=txindex"}, "chainstate"));
+    BOOST_CHECK(!read({"-dboption=txindex:bloom_filter_bits=65"}, "chainstate"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
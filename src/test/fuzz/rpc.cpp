@@ -129,6 +129,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getchainstates",
     "getchaintxstats",
     "getconnectioncount",
+    "getdbinfo",
     "getdeploymentinfo",
     "getdescriptorinfo",
     "getdifficulty",
@@ -149,6 +150,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getrawaddrman",
     "getrawmempool",
     "getrawtransaction",
+    "getrawtransactions",
     "getrpcinfo",
     "gettxout",
     "gettxoutsetinfo",
@@ -146,6 +146,20 @@ BOOST_AUTO_TEST_CASE(siphash)
         BOOST_CHECK_EQUAL(SipHashUint256(k1, k2, x), sip256.Finalize());
         BOOST_CHECK_EQUAL(SipHashUint256Extra(k1, k2, x, n), sip288.Finalize());
     }
+
+    // Check consistency between SipHashUint256Batch and SipHashUint256, including
+    // sizes that are not a multiple of the unroll factor.
+    for (size_t count = 0; count < 11; ++count) {
+        uint64_t k1 = m_rng.rand64();
+        uint64_t k2 = m_rng.rand64();
+        std::vector<uint256> vals(count);
+        for (auto& val : vals) val = m_rng.rand256();
+        std::vector<uint64_t> out(count);
+        SipHashUint256Batch(k1, k2, vals, out);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256(k1, k2, vals[i]));
+        }
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,14 +3,19 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <common/system.h>
+#include <memusage.h>
 #include <policy/policy.h>
+#include <test/util/logging.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
+#include <util/rbf.h>
+#include <util/translation.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <thread>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -547,7 +552,11 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
         pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
     pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
 
-    pool.TrimToSize(pool.DynamicMemoryUsage() / 2); // should maximize mempool size by only removing 5/7
+    // The randomized vectors keep their capacity when half of the entries go, so their
+    // allocation is not halved along with the rest of the usage.
+    const size_t half{(pool.DynamicMemoryUsage() + memusage::MallocUsage(pool.size() * sizeof(CTransactionRef)) + memusage::MallocUsage(pool.size() * sizeof(uint256))) / 2};
+    pool.TrimToSize(half); // should maximize mempool size by only removing 5/7
+    BOOST_CHECK_LE(pool.DynamicMemoryUsage(), half);
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx4.GetHash())));
     BOOST_CHECK(!pool.exists(GenTxid::Txid(tx5.GetHash())));
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx6.GetHash())));
@@ -600,6 +609,395 @@ inline CTransactionRef make_tx(std::vector<CAmount>&& output_values, std::vector
 }
 
 
+BOOST_AUTO_TEST_CASE(MempoolBatchTrimTest)
+{
+    // Trimming in one call must evict the same transactions, and bump the minimum fee
+    // the same way, as evicting the lowest-scoring package one call at a time.
+    LOCK(cs_main);
+    bilingual_str error;
+    CTxMemPool batch_pool{MemPoolOptionsForTest(m_node), error};
+    CTxMemPool single_pool{MemPoolOptionsForTest(m_node), error};
+    TestMemPoolEntryHelper entry;
+
+    const auto funding{make_tx(std::vector<CAmount>(40, COIN))};
+    std::vector<CTransactionRef> txs;
+    std::vector<CAmount> fees;
+    CTransactionRef prev_root;
+    for (uint32_t i = 0; i < 40; ++i) {
+        const auto root{make_tx({COIN / 2, COIN / 2}, {funding}, {i})};
+        txs.push_back(root);
+        fees.push_back(1000 + (i * 7919) % 50 * 100);
+        if (i % 4 == 0) {
+            // CPFP child, moves its parent up the descendant score order.
+            txs.push_back(make_tx({COIN / 4}, {root}));
+            fees.push_back(20000);
+        } else if (i % 10 == 5) {
+            // Child of this root and the previous one, so evicting either root alone
+            // changes the descendant score of the other.
+            txs.push_back(make_tx({COIN / 4}, {root, prev_root}, {1, 1}));
+            fees.push_back(500);
+        }
+        prev_root = root;
+    }
+    for (CTxMemPool* pool : {&batch_pool, &single_pool}) {
+        LOCK(pool->cs);
+        for (size_t i = 0; i < txs.size(); ++i) {
+            pool->addUnchecked(entry.Fee(fees[i]).FromTx(txs[i]));
+        }
+    }
+
+    const size_t limit{batch_pool.DynamicMemoryUsage() / 3};
+    {
+        LOCK(batch_pool.cs);
+        batch_pool.TrimToSize(limit);
+    }
+    {
+        LOCK(single_pool.cs);
+        while (single_pool.DynamicMemoryUsage() > limit) {
+            single_pool.TrimToSize(single_pool.DynamicMemoryUsage() - 1);
+        }
+    }
+    BOOST_CHECK_LE(batch_pool.DynamicMemoryUsage(), limit);
+    BOOST_CHECK_LT(batch_pool.size(), txs.size());
+    BOOST_CHECK_EQUAL(batch_pool.size(), single_pool.size());
+    for (const auto& tx : txs) {
+        BOOST_CHECK_EQUAL(batch_pool.exists(GenTxid::Txid(tx->GetHash())), single_pool.exists(GenTxid::Txid(tx->GetHash())));
+    }
+    BOOST_CHECK_EQUAL(batch_pool.GetMinFee().GetFeePerK(), single_pool.GetMinFee().GetFeePerK());
+}
+
+/** Check that a snapshot has the same entries, in the same order, as the mempool. */
+static void CheckSnapshotMatchesPool(const CTxMemPool& pool, const MempoolSnapshot& snapshot)
+{
+    LOCK(pool.cs);
+    BOOST_CHECK_EQUAL(snapshot.sequence, pool.GetSequence());
+    const auto entries{pool.entryAll()};
+    BOOST_REQUIRE_EQUAL(snapshot.entries.size(), entries.size());
+    BOOST_CHECK_EQUAL(snapshot.index.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto expected{pool.GetSnapshotEntry(entries[i])};
+        const auto& e{snapshot.entries[i]};
+        BOOST_CHECK(e.tx->GetHash() == expected.tx->GetHash());
+        BOOST_CHECK_EQUAL(snapshot.Find(e.tx->GetHash()), &e);
+        BOOST_CHECK_EQUAL(e.count_with_descendants, expected.count_with_descendants);
+        BOOST_CHECK_EQUAL(e.size_with_descendants, expected.size_with_descendants);
+        BOOST_CHECK_EQUAL(e.count_with_ancestors, expected.count_with_ancestors);
+        BOOST_CHECK_EQUAL(e.size_with_ancestors, expected.size_with_ancestors);
+        BOOST_CHECK_EQUAL(e.modified_fee, expected.modified_fee);
+        BOOST_CHECK_EQUAL(e.mod_fees_with_ancestors, expected.mod_fees_with_ancestors);
+        BOOST_CHECK_EQUAL(e.mod_fees_with_descendants, expected.mod_fees_with_descendants);
+        BOOST_CHECK(e.parents == expected.parents);
+        BOOST_CHECK(e.children == expected.children);
+        BOOST_CHECK_EQUAL(e.bip125_replaceable, expected.bip125_replaceable);
+        BOOST_CHECK_EQUAL(e.unbroadcast, expected.unbroadcast);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSnapshotTest)
+{
+    LOCK(cs_main);
+    bilingual_str error;
+    CTxMemPool pool{MemPoolOptionsForTest(m_node), error};
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction mtx_parent{*make_tx({COIN, COIN}, {make_tx({2 * COIN})})};
+    mtx_parent.vin[0].nSequence = MAX_BIP125_RBF_SEQUENCE;
+    const auto parent{MakeTransactionRef(mtx_parent)};
+    const auto child{make_tx({COIN / 2}, {parent}, {1})};
+    const auto other{make_tx({COIN})};
+
+    const auto empty{pool.GetSnapshot()};
+    BOOST_CHECK(empty->entries.empty());
+    BOOST_CHECK_EQUAL(pool.GetSnapshot(), empty);
+
+    {
+        LOCK(pool.cs);
+        pool.addUnchecked(entry.Fee(1000).FromTx(parent));
+        pool.addUnchecked(entry.Fee(2000).FromTx(child));
+        pool.addUnchecked(entry.Fee(3000).FromTx(other));
+    }
+    pool.AddUnbroadcastTx(other->GetHash());
+    // The journal continues from the snapshot
+    BOOST_CHECK_EQUAL(pool.GetDeltas(empty->delta_sequence, 10)->size(), 3U);
+
+    // Readers that find the snapshot stale at the same time share a single rebuild.
+    std::vector<std::shared_ptr<const MempoolSnapshot>> concurrent(4);
+    {
+        std::vector<std::thread> threads;
+        for (auto& result : concurrent) {
+            threads.emplace_back([&pool, &result] { result = pool.GetSnapshot(); });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+    const auto snapshot{pool.GetSnapshot()};
+    BOOST_CHECK(empty->entries.empty());
+    BOOST_CHECK_EQUAL(pool.GetSnapshot(), snapshot);
+    for (const auto& result : concurrent) BOOST_CHECK_EQUAL(result, snapshot);
+    BOOST_CHECK_EQUAL(snapshot->entries.size(), 3U);
+    CheckSnapshotMatchesPool(pool, *snapshot);
+
+    const auto* parent_entry{snapshot->Find(parent->GetHash())};
+    const auto* child_entry{snapshot->Find(child->GetHash())};
+    const auto* other_entry{snapshot->Find(other->GetHash())};
+    BOOST_REQUIRE(parent_entry && child_entry && other_entry);
+    BOOST_CHECK(snapshot->Find(Txid::FromUint256(uint256::ONE)) == nullptr);
+    BOOST_CHECK(parent_entry->parents.empty());
+    BOOST_CHECK(parent_entry->children == std::vector<Txid>{child->GetHash()});
+    BOOST_CHECK(child_entry->parents == std::vector<Txid>{parent->GetHash()});
+    BOOST_CHECK_EQUAL(child_entry->count_with_ancestors, 2U);
+    BOOST_CHECK_EQUAL(parent_entry->mod_fees_with_descendants, 3000);
+    // Replaceability is inherited from the signaling parent
+    BOOST_CHECK(parent_entry->bip125_replaceable);
+    BOOST_CHECK(child_entry->bip125_replaceable);
+    BOOST_CHECK(!other_entry->bip125_replaceable);
+    BOOST_CHECK(other_entry->unbroadcast);
+    BOOST_CHECK(!child_entry->unbroadcast);
+    {
+        LOCK(pool.cs);
+        const auto entry_copy{pool.GetSnapshotEntry(*pool.GetEntry(child->GetHash()))};
+        BOOST_CHECK(entry_copy.bip125_replaceable);
+        BOOST_CHECK_EQUAL(entry_copy.mod_fees_with_ancestors, child_entry->mod_fees_with_ancestors);
+    }
+
+    // Changes produce a new snapshot and leave the old one untouched. Only the
+    // changed transaction and its ancestors are copied again.
+    pool.PrioritiseTransaction(child->GetHash(), 500);
+    std::shared_ptr<const MempoolSnapshot> prioritised;
+    {
+        ASSERT_DEBUG_LOG("Refreshed mempool snapshot, copied 2 of 3 entries");
+        prioritised = pool.GetSnapshot();
+    }
+    CheckSnapshotMatchesPool(pool, *prioritised);
+    BOOST_CHECK(prioritised != snapshot);
+    BOOST_CHECK_GT(prioritised->epoch, snapshot->epoch);
+    BOOST_CHECK_EQUAL(prioritised->Find(child->GetHash())->modified_fee, 2500);
+    BOOST_CHECK_EQUAL(prioritised->Find(parent->GetHash())->mod_fees_with_descendants, 3500);
+    BOOST_CHECK_EQUAL(child_entry->modified_fee, 2000);
+
+    pool.RemoveUnbroadcastTx(other->GetHash());
+    {
+        ASSERT_DEBUG_LOG("Refreshed mempool snapshot, copied 0 of 3 entries");
+        BOOST_CHECK(!pool.GetSnapshot()->Find(other->GetHash())->unbroadcast);
+    }
+    {
+        LOCK(pool.cs);
+        pool.removeRecursive(*parent, REMOVAL_REASON_DUMMY);
+    }
+    BOOST_CHECK_EQUAL(pool.GetSnapshot()->entries.size(), 1U);
+    CheckSnapshotMatchesPool(pool, *pool.GetSnapshot());
+    BOOST_CHECK_EQUAL(snapshot->entries.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSnapshotRefreshTest)
+{
+    LOCK(cs_main);
+    bilingual_str error;
+    auto opts{MemPoolOptionsForTest(m_node)};
+    // Small enough for the journal to overflow now and then, forcing full rebuilds
+    opts.delta_journal_size = 5;
+    CTxMemPool pool{opts, error};
+    TestMemPoolEntryHelper entry;
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    // Change the mempool between snapshots in every way the snapshot has to
+    // follow, and compare each refreshed snapshot against the live entries.
+    const auto funding{make_tx({COIN})};
+    uint32_t next_funding_output{0};
+    std::vector<std::pair<CTransactionRef, uint32_t>> unspent;
+    std::vector<CTransactionRef> txs;
+    for (int round = 0; round < 100; ++round) {
+        const auto previous{pool.GetSnapshot()};
+        std::vector<std::pair<Txid, CAmount>> previous_entries;
+        for (const auto& e : previous->entries) previous_entries.emplace_back(e.tx->GetHash(), e.mod_fees_with_ancestors);
+        const int changes{1 + int(rng.randrange(3))};
+        for (int i = 0; i < changes; ++i) {
+            LOCK(pool.cs);
+            std::vector<CTransactionRef> in_pool;
+            for (const auto& tx : txs) {
+                if (pool.exists(GenTxid::Txid(tx->GetHash()))) in_pool.push_back(tx);
+            }
+            switch (in_pool.empty() ? 0 : rng.randrange(6)) {
+            case 0:
+            case 1: {
+                // A new transaction, spending up to two outputs of in-mempool transactions
+                std::vector<CTransactionRef> inputs{funding};
+                std::vector<uint32_t> indices{next_funding_output++};
+                for (int j = 0; j < 2 && !unspent.empty(); ++j) {
+                    const size_t pick{rng.randrange(unspent.size())};
+                    auto [parent, n] = unspent[pick];
+                    unspent.erase(unspent.begin() + pick);
+                    if (!pool.exists(GenTxid::Txid(parent->GetHash()))) continue;
+                    inputs.push_back(parent);
+                    indices.push_back(n);
+                }
+                CMutableTransaction mtx{*make_tx({COIN / 8, COIN / 8}, std::move(inputs), std::move(indices))};
+                if (rng.randbool()) mtx.vin[0].nSequence = MAX_BIP125_RBF_SEQUENCE;
+                txs.push_back(MakeTransactionRef(mtx));
+                unspent.emplace_back(txs.back(), 0);
+                unspent.emplace_back(txs.back(), 1);
+                pool.addUnchecked(entry.Fee(1000 + rng.randrange(5000)).FromTx(txs.back()));
+                break;
+            }
+            case 2:
+                pool.PrioritiseTransaction(in_pool[rng.randrange(in_pool.size())]->GetHash(), CAmount(rng.randrange(2000)) - 1000);
+                break;
+            case 3:
+                pool.removeRecursive(*in_pool[rng.randrange(in_pool.size())], REMOVAL_REASON_DUMMY);
+                break;
+            case 4:
+                // Confirm a transaction without in-mempool parents, leaving its descendants
+                for (const auto& tx : in_pool) {
+                    if (pool.GetEntry(tx->GetHash())->GetCountWithAncestors() == 1) {
+                        pool.removeForBlock({tx}, round);
+                        break;
+                    }
+                }
+                break;
+            case 5: {
+                const Txid& txid{in_pool[rng.randrange(in_pool.size())]->GetHash()};
+                if (pool.IsUnbroadcastTx(txid)) {
+                    pool.RemoveUnbroadcastTx(txid);
+                } else {
+                    pool.AddUnbroadcastTx(txid);
+                }
+                break;
+            }
+            }
+        }
+        CheckSnapshotMatchesPool(pool, *pool.GetSnapshot());
+        // Refreshing leaves the previous snapshot untouched
+        BOOST_REQUIRE_EQUAL(previous->entries.size(), previous_entries.size());
+        for (size_t i = 0; i < previous_entries.size(); ++i) {
+            BOOST_CHECK(previous->entries[i].tx->GetHash() == previous_entries[i].first);
+            BOOST_CHECK_EQUAL(previous->entries[i].mod_fees_with_ancestors, previous_entries[i].second);
+        }
+    }
+    // Enough churn to have exercised all of the above
+    BOOST_CHECK_GT(txs.size(), 50U);
+    BOOST_CHECK_GT(pool.size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolDeltaJournalTest)
+{
+    LOCK(cs_main);
+    bilingual_str error;
+    auto opts{MemPoolOptionsForTest(m_node)};
+    opts.delta_journal_size = 4;
+    CTxMemPool pool{opts, error};
+    TestMemPoolEntryHelper entry;
+
+    const auto parent{make_tx({COIN, COIN})};
+    const auto child{make_tx({COIN / 2}, {parent})};
+    const auto other{make_tx({COIN})};
+
+    const uint64_t start{pool.GetNextDeltaSequence()};
+    BOOST_CHECK(pool.GetDeltas(start, 10)->empty());
+    BOOST_CHECK(!pool.GetDeltas(start + 1, 10));
+    {
+        LOCK(pool.cs);
+        pool.addUnchecked(entry.Fee(1000).FromTx(parent));
+        pool.addUnchecked(entry.Fee(2000).FromTx(child));
+    }
+    const auto snapshot{pool.GetSnapshot()};
+    BOOST_CHECK_EQUAL(snapshot->delta_sequence, start + 2);
+
+    const auto deltas{pool.GetDeltas(start, 10)};
+    BOOST_REQUIRE(deltas && deltas->size() == 2);
+    BOOST_CHECK_EQUAL((*deltas)[0].sequence, start);
+    BOOST_CHECK((*deltas)[0].type == MempoolDelta::Type::ADDED);
+    BOOST_CHECK((*deltas)[0].txid == parent->GetHash());
+    BOOST_CHECK((*deltas)[1].txid == child->GetHash());
+    BOOST_CHECK((*deltas)[1].wtxid == child->GetWitnessHash());
+    BOOST_CHECK_EQUAL((*deltas)[1].fee, 2000);
+    BOOST_CHECK_EQUAL((*deltas)[1].count_with_ancestors, 2U);
+    BOOST_CHECK_EQUAL((*deltas)[1].mod_fees_with_ancestors, 3000);
+    BOOST_CHECK_EQUAL(pool.GetDeltas(start, 1)->size(), 1U);
+    BOOST_CHECK_EQUAL(pool.GetDeltas(start + 1, 10)->size(), 1U);
+
+    {
+        LOCK(pool.cs);
+        pool.removeRecursive(*parent, MemPoolRemovalReason::CONFLICT);
+        pool.addUnchecked(entry.Fee(3000).FromTx(other));
+    }
+    // Continuing from the snapshot returns the changes made after it
+    const auto after_snapshot{pool.GetDeltas(snapshot->delta_sequence, 10)};
+    BOOST_REQUIRE(after_snapshot && after_snapshot->size() == 3);
+    for (size_t i = 0; i < 2; ++i) {
+        BOOST_CHECK((*after_snapshot)[i].type == MempoolDelta::Type::REMOVED);
+        BOOST_CHECK((*after_snapshot)[i].reason == MemPoolRemovalReason::CONFLICT);
+    }
+    BOOST_CHECK((*after_snapshot)[2].type == MempoolDelta::Type::ADDED);
+    BOOST_CHECK((*after_snapshot)[2].txid == other->GetHash());
+
+    // The oldest change fell out of the journal
+    BOOST_CHECK_EQUAL(pool.GetNextDeltaSequence(), start + 5);
+    BOOST_CHECK(!pool.GetDeltas(start, 10));
+    BOOST_CHECK_EQUAL(pool.GetDeltas(start + 1, 10)->size(), 4U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolDeltaUpdateTest)
+{
+    LOCK(cs_main);
+    bilingual_str error;
+    CTxMemPool pool{MemPoolOptionsForTest(m_node), error};
+    TestMemPoolEntryHelper entry;
+
+    const auto parent{make_tx({COIN, COIN})};
+    const auto child{make_tx({COIN / 2}, {parent})};
+    {
+        LOCK(pool.cs);
+        pool.addUnchecked(entry.Fee(1000).FromTx(parent));
+        pool.addUnchecked(entry.Fee(2000).FromTx(child));
+    }
+
+    // Prioritising updates the transaction and, with their ancestor fees, its descendants
+    const uint64_t start{pool.GetNextDeltaSequence()};
+    pool.PrioritiseTransaction(parent->GetHash(), 500);
+    const auto prioritised{pool.GetDeltas(start, 10)};
+    BOOST_REQUIRE(prioritised && prioritised->size() == 2);
+    BOOST_CHECK((*prioritised)[0].type == MempoolDelta::Type::UPDATED);
+    BOOST_CHECK((*prioritised)[0].txid == parent->GetHash());
+    BOOST_CHECK_EQUAL((*prioritised)[0].fee, 1000);
+    BOOST_CHECK_EQUAL((*prioritised)[0].modified_fee, 1500);
+    BOOST_CHECK_EQUAL((*prioritised)[0].mod_fees_with_ancestors, 1500);
+    BOOST_CHECK((*prioritised)[1].type == MempoolDelta::Type::UPDATED);
+    BOOST_CHECK((*prioritised)[1].txid == child->GetHash());
+    BOOST_CHECK_EQUAL((*prioritised)[1].modified_fee, 2000);
+    BOOST_CHECK_EQUAL((*prioritised)[1].mod_fees_with_ancestors, 3500);
+
+    // Confirming the parent removes it and updates the child's ancestor state
+    const uint64_t before_block{pool.GetNextDeltaSequence()};
+    {
+        LOCK(pool.cs);
+        pool.removeForBlock({parent}, 1);
+    }
+    const auto confirmed{pool.GetDeltas(before_block, 10)};
+    BOOST_REQUIRE(confirmed && confirmed->size() == 2);
+    BOOST_CHECK((*confirmed)[0].type == MempoolDelta::Type::REMOVED);
+    BOOST_CHECK((*confirmed)[0].reason == MemPoolRemovalReason::BLOCK);
+    BOOST_CHECK((*confirmed)[1].type == MempoolDelta::Type::UPDATED);
+    BOOST_CHECK((*confirmed)[1].txid == child->GetHash());
+    BOOST_CHECK_EQUAL((*confirmed)[1].count_with_ancestors, 1U);
+    BOOST_CHECK_EQUAL((*confirmed)[1].size_with_ancestors, (*confirmed)[1].vsize);
+    BOOST_CHECK_EQUAL((*confirmed)[1].mod_fees_with_ancestors, 2000);
+
+    // A block confirming the rest of the chain only removes it
+    const auto grandchild{make_tx({COIN / 4}, {child})};
+    {
+        LOCK(pool.cs);
+        pool.addUnchecked(entry.Fee(1000).FromTx(grandchild));
+    }
+    const uint64_t before_chain{pool.GetNextDeltaSequence()};
+    {
+        LOCK(pool.cs);
+        pool.removeForBlock({child, grandchild}, 2);
+    }
+    const auto chain{pool.GetDeltas(before_chain, 10)};
+    BOOST_REQUIRE(chain && chain->size() == 2);
+    for (const auto& delta : *chain) BOOST_CHECK(delta.type == MempoolDelta::Type::REMOVED);
+}
+
 BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
 {
     size_t ancestors, descendants;
@@ -669,6 +669,47 @@ BOOST_AUTO_TEST_CASE(peer_eviction_test)
             BOOST_CHECK(SelectNodeToEvict(GetRandomNodeEvictionCandidates(number_of_nodes, random_context)));
         }
 
+        // Among the unprotected peers of the largest netgroup, the one that cost
+        // us the most processing time should be evicted rather than the youngest.
+        // Peers 0-19 are protected by the criteria above and the oldest half of
+        // the rest by uptime, leaving 20 (the youngest) and 21 unprotected.
+        if (number_of_nodes >= 29) {
+            BOOST_CHECK(IsEvicted(
+                number_of_nodes, [number_of_nodes](NodeEvictionCandidate& candidate) {
+                    candidate.nKeyedNetGroup = candidate.id < 4 ? 1000 + candidate.id : 0;
+                    candidate.m_min_ping_time = std::chrono::microseconds{candidate.id};
+                    candidate.m_last_tx_time = std::chrono::seconds{number_of_nodes - candidate.id};
+                    candidate.m_last_block_time = std::chrono::seconds{number_of_nodes - candidate.id};
+                    candidate.m_connected = std::chrono::seconds{number_of_nodes - candidate.id};
+                    candidate.m_processing_time = std::chrono::microseconds{candidate.id == 21 ? 1000 : 0};
+                    candidate.m_relay_txs = true;
+                    candidate.prefer_evict = false;
+                    candidate.m_is_local = false;
+                    candidate.m_network = NET_IPV4;
+                },
+                {21}, random_context));
+
+            // Processing time counts per second connected: an old peer that cost us more
+            // in total, but less per second, is kept over a young expensive one.
+            SetMockTime(std::chrono::seconds{(number_of_nodes - 20) * 1000 + 10});
+            BOOST_CHECK(IsEvicted(
+                number_of_nodes, [number_of_nodes](NodeEvictionCandidate& candidate) {
+                    candidate.nKeyedNetGroup = candidate.id < 4 ? 1000 + candidate.id : 0;
+                    candidate.m_min_ping_time = std::chrono::microseconds{candidate.id};
+                    candidate.m_last_tx_time = std::chrono::seconds{number_of_nodes - candidate.id};
+                    candidate.m_last_block_time = std::chrono::seconds{number_of_nodes - candidate.id};
+                    // Peer 20 connected 10 seconds ago, peer 21 1010 seconds ago.
+                    candidate.m_connected = std::chrono::seconds{(number_of_nodes - candidate.id) * 1000};
+                    candidate.m_processing_time = std::chrono::microseconds{candidate.id == 21 ? 1000 : candidate.id == 20 ? 500 : 0};
+                    candidate.m_relay_txs = true;
+                    candidate.prefer_evict = false;
+                    candidate.m_is_local = false;
+                    candidate.m_network = NET_IPV4;
+                },
+                {20}, random_context));
+            SetMockTime(std::chrono::seconds{0});
+        }
+
         // No eviction is expected given <= 20 random eviction candidates. The eviction logic protects at least
         // four peers by net group, eight by lowest ping time, four by last time of novel tx and four peers by last
         // novel block time.
@@ -16,6 +16,7 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <test/util/net.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <test/util/validation.h>
@@ -26,10 +27,12 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <array>
 #include <ios>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 using namespace std::literals;
 using namespace util::hex_literals;
@@ -1553,4 +1556,81 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(send_priority_queues)
+{
+    // Socket that accepts everything and remembers what was written.
+    class RecordingSock : public StaticContentsSock
+    {
+    public:
+        explicit RecordingSock(std::vector<uint8_t>& sent) : StaticContentsSock{""}, m_sent{sent} {}
+        using StaticContentsSock::operator=;
+        ssize_t Send(const void* data, size_t len, int) const override
+        {
+            const auto* bytes{static_cast<const uint8_t*>(data)};
+            m_sent.insert(m_sent.end(), bytes, bytes + len);
+            return len;
+        }
+
+    private:
+        std::vector<uint8_t>& m_sent;
+    };
+
+    // Message types in the order they were written to the socket.
+    std::vector<uint8_t> sent;
+    const auto sent_types{[&] {
+        std::vector<std::string> types;
+        DataStream stream{sent};
+        while (!stream.empty()) {
+            CMessageHeader hdr;
+            stream >> hdr;
+            types.push_back(hdr.GetCommand());
+            stream.ignore(hdr.nMessageSize);
+        }
+        return types;
+    }};
+
+    auto connman = std::make_unique<ConnmanTestMsg>(0x1337, 0x1337, *m_node.addrman, *m_node.netgroupman, Params());
+    connman->SetHistoricalSendRate(1000);
+
+    CNode node{/*id=*/0,
+               std::make_shared<RecordingSock>(sent),
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*pszDest=*/std::string{},
+               ConnectionType::OUTBOUND_FULL_RELAY,
+               /*inbound_onion=*/false};
+
+    SetMockTime(1000);
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::VERSION, std::vector<uint8_t>(100)));
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::VERACK));
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::HEADERS, std::vector<uint8_t>(100)));
+    BOOST_CHECK(sent_types() == std::vector<std::string>({NetMsgType::VERSION, NetMsgType::VERACK, NetMsgType::HEADERS}));
+
+    // Historical data is rate limited. The first block goes out at once while the allowance
+    // is positive, the rest has to wait for it to recover.
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::BLOCK, std::vector<uint8_t>(1500)), SendPriority::HISTORICAL);
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::BLOCK, std::vector<uint8_t>(1500)), SendPriority::HISTORICAL);
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::CFILTER, std::vector<uint8_t>(100)), SendPriority::HISTORICAL);
+    // Other messages are neither limited nor held up by it, and keep their order.
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::PONG, std::vector<uint8_t>(8)));
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::HEADERS, std::vector<uint8_t>(100)));
+    connman->PushMessage(&node, NetMsg::Make(NetMsgType::BLOCKTXN, std::vector<uint8_t>(2000)));
+    BOOST_CHECK(sent_types() == std::vector<std::string>({NetMsgType::VERSION, NetMsgType::VERACK, NetMsgType::HEADERS,
+                                                          NetMsgType::BLOCK, NetMsgType::PONG, NetMsgType::HEADERS,
+                                                          NetMsgType::BLOCKTXN}));
+
+    BOOST_CHECK_EQUAL(connman->SendQueuedData(node), 0U);
+    SetMockTime(1001);
+    BOOST_CHECK_GT(connman->SendQueuedData(node), 1500U);
+    SetMockTime(1003);
+    BOOST_CHECK_GT(connman->SendQueuedData(node), 100U);
+    BOOST_CHECK(sent_types() == std::vector<std::string>({NetMsgType::VERSION, NetMsgType::VERACK, NetMsgType::HEADERS,
+                                                          NetMsgType::BLOCK, NetMsgType::PONG, NetMsgType::HEADERS,
+                                                          NetMsgType::BLOCKTXN, NetMsgType::BLOCK, NetMsgType::CFILTER}));
+
+    SetMockTime(0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
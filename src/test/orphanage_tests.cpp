@@ -16,6 +16,8 @@
 
 #include <array>
 #include <cstdint>
+#include <set>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -373,6 +375,79 @@ BOOST_AUTO_TEST_CASE(get_children)
     }
 }
 
+BOOST_AUTO_TEST_CASE(peer_usage_budget)
+{
+    FastRandomContext det_rand{true};
+    auto now{GetTime<std::chrono::seconds>()};
+
+    // Budget for three of the test transactions.
+    const auto sample_tx{MakeTransactionSpending(/*outpoints=*/{}, det_rand)};
+    const size_t budget{3 * sample_tx->GetTotalSize()};
+    TxOrphanage orphanage{budget};
+
+    const NodeId flooder{0};
+    const NodeId honest{1};
+    std::vector<CTransactionRef> flooder_txs;
+    for (int i = 0; i < 6; ++i) {
+        // Distinct entry times so that eviction order is by age.
+        SetMockTime(now + std::chrono::seconds{i});
+        flooder_txs.push_back(MakeTransactionSpending(/*outpoints=*/{}, det_rand));
+        BOOST_CHECK(orphanage.AddTx(flooder_txs.back(), flooder));
+    }
+    const auto honest_tx{MakeTransactionSpending(/*outpoints=*/{}, det_rand)};
+    BOOST_CHECK(orphanage.AddTx(honest_tx, honest));
+    BOOST_CHECK_EQUAL(orphanage.UsageByPeer(flooder), 6 * sample_tx->GetTotalSize());
+    BOOST_CHECK_EQUAL(orphanage.TotalOrphanUsage(), 7 * sample_tx->GetTotalSize());
+
+    // Only the peer over its budget loses orphans, oldest first.
+    orphanage.LimitOrphans(/*max_orphans=*/100, det_rand);
+    BOOST_CHECK_EQUAL(orphanage.Size(), 4);
+    BOOST_CHECK_LE(orphanage.UsageByPeer(flooder), budget);
+    for (int i = 0; i < 6; ++i) {
+        BOOST_CHECK_EQUAL(orphanage.HaveTx(flooder_txs[i]->GetWitnessHash()), i >= 3);
+    }
+    BOOST_CHECK(orphanage.HaveTx(honest_tx->GetWitnessHash()));
+    BOOST_CHECK_EQUAL(orphanage.UsageByPeer(honest), honest_tx->GetTotalSize());
+
+    orphanage.EraseForPeer(flooder);
+    BOOST_CHECK_EQUAL(orphanage.UsageByPeer(flooder), 0);
+    BOOST_CHECK_EQUAL(orphanage.TotalOrphanUsage(), honest_tx->GetTotalSize());
+    orphanage.EraseTx(honest_tx->GetWitnessHash());
+    BOOST_CHECK_EQUAL(orphanage.TotalOrphanUsage(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(children_by_parent_txid)
+{
+    FastRandomContext det_rand{true};
+    TxOrphanage orphanage;
+    const NodeId peer{0};
+
+    const auto parent{MakeTransactionSpending(/*outpoints=*/{}, det_rand)};
+    // One child per parent output, and one spending both.
+    const auto child0{MakeTransactionSpending({{parent->GetHash(), 0}}, det_rand)};
+    const auto child1{MakeTransactionSpending({{parent->GetHash(), 1}}, det_rand)};
+    const auto child01{MakeTransactionSpending({{parent->GetHash(), 0}, {parent->GetHash(), 1}}, det_rand)};
+    for (const auto& child : {child0, child1, child01}) {
+        BOOST_CHECK(orphanage.AddTx(child, peer));
+    }
+    BOOST_CHECK(EqualTxns({child0, child1, child01}, orphanage.GetChildrenFromSamePeer(parent, peer)));
+
+    orphanage.AddChildrenToWorkSet(*parent);
+    std::set<CTransactionRef> reconsidered;
+    while (CTransactionRef tx = orphanage.GetTxToReconsider(peer)) {
+        BOOST_CHECK(reconsidered.insert(tx).second);
+    }
+    BOOST_CHECK(EqualTxns(reconsidered, {child0, child1, child01}));
+
+    // A block spending only output 1 of the parent conflicts with child1 and child01, not child0.
+    CBlock block;
+    block.vtx.push_back(MakeTransactionSpending({{parent->GetHash(), 1}}, det_rand));
+    orphanage.EraseForBlock(block);
+    BOOST_CHECK(orphanage.HaveTx(child0->GetWitnessHash()));
+    BOOST_CHECK(!orphanage.HaveTx(child1->GetWitnessHash()));
+    BOOST_CHECK(!orphanage.HaveTx(child01->GetWitnessHash()));
+}
+
 BOOST_AUTO_TEST_CASE(too_large_orphan_tx)
 {
     TxOrphanage orphanage;
@@ -7,7 +7,9 @@
 #include <policy/policy.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
+#include <streams.h>
 #include <uint256.h>
+#include <util/fs.h>
 #include <util/time.h>
 #include <validationinterface.h>
 
@@ -263,6 +265,66 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // The averages are decayed lazily, but are written out with the decay applied: an
+    // estimator loaded from the file gives the same smart fee estimates. The first
+    // query of each target fills the estimate cache, the second one is served from it.
+    feeEst.FlushUnconfirmed();
+    const fs::path copy_path{m_path_root / "fee_estimates_copy.dat"};
+    {
+        AutoFile est_file{fsbridge::fopen(copy_path, "wb")};
+        BOOST_REQUIRE(feeEst.Write(est_file));
+        BOOST_REQUIRE_EQUAL(est_file.fclose(), 0);
+    }
+    CBlockPolicyEstimator loaded_est{copy_path, /*read_stale_estimates=*/true};
+    for (int i = 1; i <= 48; i++) {
+        for (const bool conservative : {false, true}) {
+            FeeCalculation calc, cached_calc, loaded_calc;
+            const CFeeRate estimate{feeEst.estimateSmartFee(i, &calc, conservative)};
+            BOOST_CHECK(feeEst.estimateSmartFee(i, &cached_calc, conservative) == estimate);
+            BOOST_CHECK_EQUAL(cached_calc.returnedTarget, calc.returnedTarget);
+            BOOST_CHECK(cached_calc.reason == calc.reason);
+            BOOST_CHECK(loaded_est.estimateSmartFee(i, &loaded_calc, conservative) == estimate);
+            BOOST_CHECK_EQUAL(loaded_calc.returnedTarget, calc.returnedTarget);
+        }
+    }
+
+    // Smart fee estimates are only refreshed once per block. Transactions stuck in the
+    // mempool count against their feerate bucket. Removing them changes what a fresh
+    // calculation sees, but the cached estimate is kept until the next block.
+    const int64_t virtual_size = GetVirtualTransactionSize(CTransaction(tx));
+    std::vector<uint256> stuck_txids;
+    for (int k = 0; k < 100; k++) {
+        tx.vin[0].prevout.n = 10000*blocknum+k;
+        feeEst.processTransaction(NewMempoolTransactionInfo(MakeTransactionRef(tx), feeV[5], virtual_size, blocknum,
+                                                            /*mempool_limit_bypassed=*/false,
+                                                            /*submitted_in_package=*/false,
+                                                            /*chainstate_is_current=*/true,
+                                                            /*has_no_mempool_parents=*/true));
+        stuck_txids.push_back(tx.GetHash());
+    }
+    for (int i = 0; i < 10; i++) {
+        feeEst.processBlock({}, ++blocknum);
+    }
+    FeeCalculation stuck_calc;
+    const CFeeRate stuck_estimate{feeEst.estimateSmartFee(2, &stuck_calc, /*conservative=*/false)};
+    BOOST_CHECK_EQUAL(stuck_calc.est.fail.inMempool, 100);
+
+    for (const auto& txid : stuck_txids) {
+        BOOST_CHECK(feeEst.removeTx(txid));
+    }
+    EstimationResult raw_result;
+    feeEst.estimateRawFee(stuck_calc.returnedTarget, /*successThreshold=*/0.85, FeeEstimateHorizon::SHORT_HALFLIFE, &raw_result);
+    BOOST_CHECK_EQUAL(raw_result.fail.inMempool, 0);
+    FeeCalculation cached_calc;
+    BOOST_CHECK(feeEst.estimateSmartFee(2, &cached_calc, /*conservative=*/false) == stuck_estimate);
+    BOOST_CHECK_EQUAL(cached_calc.est.fail.inMempool, 100);
+
+    feeEst.processBlock({}, ++blocknum);
+    FeeCalculation refreshed_calc;
+    feeEst.estimateSmartFee(2, &refreshed_calc, /*conservative=*/false);
+    BOOST_CHECK_EQUAL(refreshed_calc.est.fail.inMempool, 0);
+    BOOST_CHECK_GT(refreshed_calc.est.fail.leftMempool, 0);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -352,6 +352,56 @@ BOOST_FIXTURE_TEST_CASE(rbf_helper_functions, TestChain100Setup)
 
 }
 
+BOOST_FIXTURE_TEST_CASE(rbf_fee_lower_bound, TestChain100Setup)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+    const uint256 unused_txid{GetRandHash()};
+    const CFeeRate incremental_relay_feerate{DEFAULT_INCREMENTAL_RELAY_FEE};
+
+    // Two conflicts with descendants, the first one with a chain of fee-paying descendants
+    const auto tx1 = make_tx(/*inputs=*/ {m_coinbase_txns[0]}, /*output_values=*/ {10 * COIN});
+    pool.addUnchecked(entry.Fee(CENT).FromTx(tx1));
+    auto tx_to_spend{tx1};
+    for (int i{0}; i < 10; ++i) {
+        tx_to_spend = make_tx(/*inputs=*/ {tx_to_spend}, /*output_values=*/ {(9 - i) * COIN});
+        pool.addUnchecked(entry.Fee(CENT).FromTx(tx_to_spend));
+    }
+    const auto tx2 = make_tx(/*inputs=*/ {m_coinbase_txns[1]}, /*output_values=*/ {10 * COIN});
+    pool.addUnchecked(entry.Fee(2 * CENT).FromTx(tx2));
+    const auto tx2_child = add_descendants(tx2, 1, pool);
+    const auto entry1{pool.GetIter(tx1->GetHash()).value()};
+    const auto entry2{pool.GetIter(tx2->GetHash()).value()};
+    const CAmount tx1_descendant_fees{entry1->GetModFeesWithDescendants()};
+    BOOST_CHECK_GT(tx1_descendant_fees, entry2->GetModFeesWithDescendants());
+
+    // The bound is the largest descendant fees of any conflict
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry1, entry2}, tx1_descendant_fees - 1, 1, CFeeRate(0), unused_txid).has_value());
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry1, entry2}, tx1_descendant_fees, 1, CFeeRate(0), unused_txid) == std::nullopt);
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry2}, tx1_descendant_fees - 1, 1, CFeeRate(0), unused_txid) == std::nullopt);
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry1}, tx1_descendant_fees + 1, 1000, incremental_relay_feerate, unused_txid).has_value());
+
+    // Whenever the pre-check rejects, so does PaysForRBF on the actual conflicts
+    CTxMemPool::setEntries all_conflicts;
+    BOOST_CHECK(GetEntriesForConflicts(*make_tx({m_coinbase_txns[0], m_coinbase_txns[1]}, {COIN}), pool, {entry1, entry2}, all_conflicts) == std::nullopt);
+    CAmount conflicting_fees{0};
+    for (const auto& it : all_conflicts) conflicting_fees += it->GetModifiedFee();
+    for (CAmount fees : {tx1_descendant_fees - 1, tx1_descendant_fees, conflicting_fees - 1, conflicting_fees}) {
+        if (PaysForRBFLowerBound(pool, {entry1, entry2}, fees, 1, CFeeRate(0), unused_txid)) {
+            BOOST_CHECK(PaysForRBF(conflicting_fees, fees, 1, CFeeRate(0), unused_txid).has_value());
+        }
+    }
+
+    // A negative modified fee anywhere in the mempool disables the pre-check
+    pool.PrioritiseTransaction(tx2_child->GetHash(), -COIN);
+    BOOST_CHECK(pool.HasNegativeModifiedFees());
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry1, entry2}, 0, 1, CFeeRate(0), unused_txid) == std::nullopt);
+    pool.PrioritiseTransaction(tx2_child->GetHash(), COIN);
+    BOOST_CHECK(!pool.HasNegativeModifiedFees());
+    BOOST_CHECK(PaysForRBFLowerBound(pool, {entry1, entry2}, 0, 1, CFeeRate(0), unused_txid).has_value());
+}
+
 BOOST_FIXTURE_TEST_CASE(improves_feerate, TestChain100Setup)
 {
     CTxMemPool& pool = *Assert(m_node.mempool);
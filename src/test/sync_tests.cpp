@@ -4,11 +4,14 @@
 
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <future>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -140,4 +143,55 @@ BOOST_AUTO_TEST_CASE(inconsistent_lock_order_detected)
 #endif // DEBUG_LOCKORDER
 }
 
+BOOST_AUTO_TEST_CASE(lock_wait_observer)
+{
+    struct Observer final : public LockWaitObserver {
+        const void* cs{nullptr};
+        std::chrono::nanoseconds waited{0};
+        void LockWaited(const void* cs_in, std::chrono::nanoseconds waited_in) override
+        {
+            cs = cs_in;
+            waited += waited_in;
+        }
+    } observer;
+
+    Mutex mutex;
+    {
+        const LockWaitScope scope{observer};
+        // Uncontended acquisitions are not reported.
+        { LOCK(mutex); }
+        BOOST_CHECK(observer.cs == nullptr);
+
+        // Hold the mutex on another thread so that our acquisition blocks. Retry
+        // a few times in case this thread is not scheduled before it is released.
+        for (int attempt = 0; attempt < 10 && observer.cs == nullptr; ++attempt) {
+            std::promise<void> locked;
+            std::thread holder{[&] {
+                LOCK(mutex);
+                locked.set_value();
+                UninterruptibleSleep(std::chrono::milliseconds{50});
+            }};
+            locked.get_future().wait();
+            { LOCK(mutex); }
+            holder.join();
+        }
+        BOOST_CHECK(observer.cs == &mutex);
+        BOOST_CHECK(observer.waited > 0ns);
+    }
+    BOOST_CHECK(g_lock_wait_observer == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(shared_lock_held)
+{
+    SharedMutex mutex;
+    {
+        READ_LOCK(mutex);
+        AssertSharedLockHeld(mutex);
+    }
+    {
+        LOCK(mutex);
+        AssertSharedLockHeld(mutex);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
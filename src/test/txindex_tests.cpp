@@ -77,4 +77,40 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_find_txs, TestChain100Setup)
+{
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(txindex.StartBackgroundSync());
+    IndexWaitSynced(txindex, *Assert(m_node.shutdown_signal));
+
+    // Ask for transactions out of block order, with an unknown and a repeated hash.
+    std::vector<uint256> hashes;
+    for (auto it{m_coinbase_txns.rbegin()}; it != m_coinbase_txns.rend(); ++it) {
+        hashes.push_back((*it)->GetHash());
+    }
+    hashes.push_back(uint256::ONE);
+    hashes.push_back(m_coinbase_txns[5]->GetHash());
+
+    const auto found{txindex.FindTxs(hashes)};
+    BOOST_REQUIRE_EQUAL(found.size(), hashes.size());
+    BOOST_CHECK(!found[m_coinbase_txns.size()]);
+    for (size_t i{0}; i < hashes.size(); ++i) {
+        if (i == m_coinbase_txns.size()) continue;
+        BOOST_REQUIRE(found[i]);
+        BOOST_CHECK_EQUAL(found[i]->tx->GetHash(), hashes[i]);
+        uint256 block_hash;
+        CTransactionRef tx;
+        BOOST_CHECK(txindex.FindTx(hashes[i], block_hash, tx));
+        BOOST_CHECK_EQUAL(found[i]->block_hash, block_hash);
+        // Found transactions are kept in memory.
+        BOOST_CHECK_EQUAL(found[i]->tx.get(), tx.get());
+    }
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_CHECK_EQUAL(found[0]->block_hash, tip->GetBlockHash());
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
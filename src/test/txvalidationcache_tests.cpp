@@ -4,10 +4,13 @@
 
 #include <consensus/validation.h>
 #include <key.h>
+#include <node/mempool_persist.h>
+#include <policy/policy.h>
 #include <random.h>
 #include <script/sigcache.h>
 #include <script/sign.h>
 #include <script/signingprovider.h>
+#include <test/util/logging.h>
 #include <test/util/setup_common.h>
 #include <txmempool.h>
 #include <util/chaintype.h>
@@ -380,9 +383,159 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
         // Make sure this transaction was not cached (ie because the first
         // input was valid)
         BOOST_CHECK(CheckInputScripts(CTransaction(tx), state, &m_node.chainman->ActiveChainstate().CoinsTip(), SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS, true, true, txdata, m_node.chainman->m_validation_cache, &scriptchecks));
-        // Should get 2 script checks back -- caching is on a whole-transaction basis.
+        // Should get 2 script checks back -- inputs are only cached once the whole transaction is valid.
         BOOST_CHECK_EQUAL(scriptchecks.size(), 2U);
     }
+
+    {
+        // Test that inputs are cached individually: a transaction that only differs
+        // from a validated one in the witness of one input re-verifies just that input.
+        constexpr unsigned int flags{SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS};
+        CMutableTransaction tx;
+        tx.version = 1;
+        tx.vin.resize(2);
+        tx.vin[0].prevout = COutPoint{spend_tx.GetHash(), 0};
+        tx.vin[1].prevout = COutPoint{spend_tx.GetHash(), 1};
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 21 * CENT;
+        tx.vout[0].scriptPubKey = p2pk_scriptPubKey;
+        for (int i = 0; i < 2; ++i) {
+            SignatureData sigdata;
+            BOOST_CHECK(ProduceSignature(keystore, MutableTransactionSignatureCreator(tx, i, 11 * CENT, SIGHASH_ALL), spend_tx.vout[i].scriptPubKey, sigdata));
+            UpdateInput(tx.vin[i], sigdata);
+        }
+        ValidationCache& validation_cache{m_node.chainman->m_validation_cache};
+        CCoinsViewCache& coins_tip{m_node.chainman->ActiveChainstate().CoinsTip()};
+        TxValidationState state;
+        {
+            PrecomputedTransactionData txdata;
+            BOOST_CHECK(CheckInputScripts(CTransaction(tx), state, coins_tip, flags, true, true, txdata, validation_cache, nullptr));
+        }
+        // Per-input entries live in their own cache.
+        const uint256 input_entry{validation_cache.InputScriptCacheEntry(CTransaction(tx), 0, flags)};
+        BOOST_CHECK(validation_cache.m_input_script_execution_cache.contains(input_entry, /*erase=*/false));
+        BOOST_CHECK(!validation_cache.m_script_execution_cache.contains(input_entry, /*erase=*/false));
+
+        // Same txid, different witness for the second input (e.g. re-signed).
+        CMutableTransaction malleated_tx{tx};
+        SignatureData sigdata;
+        BOOST_CHECK(ProduceSignature(keystore, MutableTransactionSignatureCreator(malleated_tx, 1, 11 * CENT, SIGHASH_ALL | SIGHASH_ANYONECANPAY), spend_tx.vout[1].scriptPubKey, sigdata));
+        UpdateInput(malleated_tx.vin[1], sigdata);
+        const CTransaction malleated{malleated_tx};
+        BOOST_CHECK(malleated.GetHash() == CTransaction(tx).GetHash());
+        BOOST_CHECK(malleated.GetWitnessHash() != CTransaction(tx).GetWitnessHash());
+
+        const uint64_t tx_hits{validation_cache.m_script_cache_tx_hits};
+        const uint64_t input_hits{validation_cache.m_script_cache_input_hits};
+        PrecomputedTransactionData txdata;
+        std::vector<CScriptCheck> scriptchecks;
+        BOOST_CHECK(CheckInputScripts(malleated, state, coins_tip, flags, true, false, txdata, validation_cache, &scriptchecks));
+        BOOST_CHECK_EQUAL(scriptchecks.size(), 1U);
+        BOOST_CHECK(scriptchecks[0]());
+        BOOST_CHECK_EQUAL(validation_cache.m_script_cache_tx_hits, tx_hits);
+        BOOST_CHECK_EQUAL(validation_cache.m_script_cache_input_hits, input_hits + 1);
+
+        // Per-input entries are keyed by flags too.
+        scriptchecks.clear();
+        BOOST_CHECK(CheckInputScripts(malleated, state, coins_tip, flags | SCRIPT_VERIFY_DERSIG, true, false, txdata, validation_cache, &scriptchecks));
+        BOOST_CHECK_EQUAL(scriptchecks.size(), 2U);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(mempool_parallel_script_checks, TestChain100Setup)
+{
+    // Transactions with many inputs have their scripts checked on the script
+    // check threads before PolicyScriptChecks. Valid ones must be accepted,
+    // and invalid ones still rejected with the serial path's script error.
+    BOOST_REQUIRE_EQUAL(m_node.chainman->GetCheckQueue().WorkerThreadCount(), 2U);
+    const CScript p2pk{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const auto sign{[&](CMutableTransaction& tx) {
+        for (unsigned int i = 0; i < tx.vin.size(); ++i) {
+            std::vector<unsigned char> sig;
+            const uint256 hash{SignatureHash(p2pk, tx, i, SIGHASH_ALL, 0, SigVersion::BASE)};
+            BOOST_CHECK(coinbaseKey.Sign(hash, sig));
+            sig.push_back((unsigned char)SIGHASH_ALL);
+            tx.vin[i].scriptSig = CScript() << sig;
+        }
+    }};
+    const auto submit{[&](const CMutableTransaction& tx) {
+        LOCK(cs_main);
+        return m_node.chainman->ProcessTransaction(MakeTransactionRef(tx));
+    }};
+
+    CMutableTransaction fanout;
+    fanout.vin.emplace_back(COutPoint{m_coinbase_txns[0]->GetHash(), 0});
+    for (int i = 0; i < 20; ++i) fanout.vout.emplace_back(2 * COIN, p2pk);
+    sign(fanout);
+    BOOST_CHECK(submit(fanout).m_result_type == MempoolAcceptResult::ResultType::VALID);
+
+    CMutableTransaction spend;
+    for (uint32_t i = 0; i < fanout.vout.size(); ++i) spend.vin.emplace_back(COutPoint{fanout.GetHash(), i});
+    spend.vout.emplace_back(39 * COIN, p2pk);
+    sign(spend);
+
+    // A signature that is valid, but for another input, in the last position.
+    CMutableTransaction bad_spend{spend};
+    bad_spend.vin.back().scriptSig = bad_spend.vin.front().scriptSig;
+    {
+        ASSERT_DEBUG_LOG("Verifying 20 mempool input scripts on 2 script check threads");
+        const auto bad_result{submit(bad_spend)};
+        BOOST_CHECK(bad_result.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+        BOOST_CHECK(bad_result.m_state.GetRejectReason().starts_with("mandatory-script-verify-flag-failed"));
+    }
+    {
+        ASSERT_DEBUG_LOG("Verifying 20 mempool input scripts on 2 script check threads");
+        BOOST_CHECK(submit(spend).m_result_type == MempoolAcceptResult::ResultType::VALID);
+    }
+}
+
+/** Accepts a signature only if it is in the signature cache. */
+class CacheOnlySignatureChecker : public TransactionSignatureChecker
+{
+    SignatureCache& m_signature_cache;
+
+public:
+    CacheOnlySignatureChecker(const CTransaction& tx, unsigned int n, CAmount amount, const PrecomputedTransactionData& txdata, SignatureCache& signature_cache)
+        : TransactionSignatureChecker(&tx, n, amount, txdata, MissingDataBehavior::ASSERT_FAIL), m_signature_cache{signature_cache} {}
+
+    bool VerifyECDSASignature(const std::vector<unsigned char>& sig, const CPubKey& pubkey, const uint256& sighash) const override
+    {
+        uint256 entry;
+        m_signature_cache.ComputeEntryECDSA(entry, sighash, sig, pubkey);
+        return m_signature_cache.Get(entry, /*erase=*/false);
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(mempool_load_preverify_scripts, TestChain100Setup)
+{
+    // Transactions loaded from mempool.dat have their signatures checked on the
+    // script check threads first. An invalid transaction must not keep the
+    // signatures of the others out of the signature cache.
+    BOOST_REQUIRE(m_node.chainman->GetCheckQueue().HasThreads());
+    const CScript p2pk{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 40; ++i) {
+        txs.push_back(MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[i], 0, i + 1, coinbaseKey, p2pk, CAmount(1 * COIN), /*submit=*/false)));
+    }
+    // The check queue works from the back, so the failure is found early.
+    CMutableTransaction invalid{CreateValidMempoolTransaction(m_coinbase_txns[40], 0, 41, coinbaseKey, p2pk, CAmount(1 * COIN), /*submit=*/false)};
+    std::vector<unsigned char> sig{invalid.vin[0].scriptSig.begin() + 1, invalid.vin[0].scriptSig.end()};
+    sig[10] ^= 1;
+    invalid.vin[0].scriptSig = CScript() << sig;
+    txs.push_back(MakeTransactionRef(invalid));
+
+    node::PreVerifyScripts(txs, *m_node.mempool, m_node.chainman->ActiveChainstate());
+
+    SignatureCache& signature_cache{m_node.chainman->m_validation_cache.m_signature_cache};
+    for (size_t i = 0; i < txs.size(); ++i) {
+        const CTransaction& tx{*txs[i]};
+        const CTxOut& spent{m_coinbase_txns[i]->vout[0]};
+        PrecomputedTransactionData txdata;
+        txdata.Init(tx, {spent});
+        const CacheOnlySignatureChecker checker{tx, 0, spent.nValue, txdata, signature_cache};
+        const bool cached{VerifyScript(tx.vin[0].scriptSig, spent.scriptPubKey, &tx.vin[0].scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, checker)};
+        BOOST_CHECK_EQUAL(cached, i + 1 < txs.size());
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
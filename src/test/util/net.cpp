@@ -79,7 +79,7 @@ void ConnmanTestMsg::NodeReceiveMsgBytes(CNode& node, Span<const uint8_t> msg_by
 void ConnmanTestMsg::FlushSendBuffer(CNode& node) const
 {
     LOCK(node.cs_vSend);
-    node.vSendMsg.clear();
+    for (auto& queue : node.m_send_queues) queue.clear();
     node.m_send_memusage = 0;
     while (true) {
         const auto& [to_send, _more, _msg_type] = node.m_transport->GetBytesToSend(false);
@@ -122,6 +122,7 @@ std::vector<NodeEvictionCandidate> GetRandomNodeEvictionCandidates(int n_candida
             .id=id,
             .m_connected=std::chrono::seconds{random_context.randrange(100)},
             .m_min_ping_time=std::chrono::microseconds{random_context.randrange(100)},
+            .m_processing_time=std::chrono::microseconds{random_context.randrange(100)},
             .m_last_block_time=std::chrono::seconds{random_context.randrange(100)},
             .m_last_tx_time=std::chrono::seconds{random_context.randrange(100)},
             .fRelevantServices=random_context.randbool(),
@@ -85,6 +85,14 @@ struct ConnmanTestMsg : public CConnman {
     bool ReceiveMsgFrom(CNode& node, CSerializedNetMsg&& ser_msg) const;
     void FlushSendBuffer(CNode& node) const;
 
+    void SetHistoricalSendRate(uint64_t rate) { m_historical_send_rate = rate; }
+
+    size_t SendQueuedData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(!node.cs_vSend)
+    {
+        LOCK(node.cs_vSend);
+        return SocketSendData(node).first;
+    }
+
     bool AlreadyConnectedPublic(const CAddress& addr) { return AlreadyConnectedToAddress(addr); };
 
     CNode* ConnectNodePublic(PeerManager& peerman, const char* pszDest, ConnectionType conn_type)
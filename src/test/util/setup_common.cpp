@@ -239,6 +239,7 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, TestOpts opts)
         };
         if (opts.min_validation_cache) {
             chainman_opts.script_execution_cache_bytes = 0;
+            chainman_opts.input_script_execution_cache_bytes = 0;
             chainman_opts.signature_cache_bytes = 0;
         }
         const BlockManager::Options blockman_opts{
@@ -21,6 +21,7 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/time.h>
+#include <util/vecset.h>
 #include <util/vector.h>
 
 #include <array>
@@ -29,6 +30,7 @@
 #include <limits>
 #include <map>
 #include <optional>
+#include <set>
 #include <stdint.h>
 #include <string.h>
 #include <thread>
@@ -1596,6 +1598,30 @@ BOOST_AUTO_TEST_CASE(test_tracked_vector)
     BOOST_CHECK_EQUAL(v8[2].copies, 0);
 }
 
+BOOST_AUTO_TEST_CASE(vecset_matches_set)
+{
+    VecSet<int> vs;
+    std::set<int> ref;
+    for (int i = 0; i < 1000; ++i) {
+        const int value = m_rng.randrange(64);
+        if (m_rng.randbool()) {
+            const bool inserted{vs.insert(value).second};
+            BOOST_CHECK_EQUAL(inserted, ref.insert(value).second);
+        } else {
+            BOOST_CHECK_EQUAL(vs.erase(value), ref.erase(value));
+        }
+        BOOST_CHECK_EQUAL(vs.size(), ref.size());
+        BOOST_CHECK_EQUAL(vs.count(value), ref.count(value));
+        BOOST_CHECK(std::equal(vs.begin(), vs.end(), ref.begin(), ref.end()));
+    }
+
+    const VecSet<int> copy{ref.rbegin(), ref.rend()};
+    BOOST_CHECK(std::equal(copy.begin(), copy.end(), ref.begin(), ref.end()));
+    vs.clear();
+    BOOST_CHECK(vs.empty());
+    BOOST_CHECK(vs.find(0) == vs.end());
+}
+
 BOOST_AUTO_TEST_CASE(message_sign)
 {
     const std::array<unsigned char, 32> privkey_bytes = {
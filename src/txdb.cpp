@@ -7,10 +7,12 @@
 
 #include <coins.h>
 #include <dbwrapper.h>
+#include <hashcoinsstore.h>
 #include <logging.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <serialize.h>
+#include <tinyformat.h>
 #include <uint256.h>
 #include <util/vector.h>
 
@@ -25,15 +27,6 @@ static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
 // Keys used in previous version that might still be found in the DB:
 static constexpr uint8_t DB_COINS{'c'};
 
-bool CCoinsViewDB::NeedsUpgrade()
-{
-    std::unique_ptr<CDBIterator> cursor{m_db->NewIterator()};
-    // DB_COINS was deprecated in v0.15.0, commit
-    // 1088b02f0ccd7358d2b7076bb9e122d59d502d02
-    cursor->Seek(std::make_pair(DB_COINS, uint256{}));
-    return cursor->Valid();
-}
-
 namespace {
 
 struct CoinEntry {
@@ -44,54 +37,237 @@ struct CoinEntry {
     SERIALIZE_METHODS(CoinEntry, obj) { READWRITE(obj.key, obj.outpoint->hash, VARINT(obj.outpoint->n)); }
 };
 
+/** Specialization of CCoinsViewCursor to iterate over a LevelDBCoinsStore */
+class CCoinsViewDBCursor: public CCoinsViewCursor
+{
+public:
+    // Prefer using LevelDBCoinsStore::Cursor() since we want to perform some
+    // cache warmup on instantiation.
+    CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256&hashBlockIn):
+        CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    ~CCoinsViewDBCursor() = default;
+
+    bool GetKey(COutPoint &key) const override;
+    bool GetValue(Coin &coin) const override;
+
+    bool Valid() const override;
+    void Next() override;
+
+private:
+    std::unique_ptr<CDBIterator> pcursor;
+    std::pair<char, COutPoint> keyTmp;
+
+    friend class LevelDBCoinsStore;
+};
+
+/** CoinsStore on LevelDB. */
+class LevelDBCoinsStore final : public CoinsStore
+{
+    DBParams m_db_params;
+    std::unique_ptr<CDBWrapper> m_db;
+
+    class LevelDBBatch final : public Batch
+    {
+    public:
+        CDBBatch m_batch;
+        explicit LevelDBBatch(const CDBWrapper& db) : m_batch{db} {}
+        void WriteCoin(const COutPoint& outpoint, const Coin& coin) override { m_batch.Write(CoinEntry(&outpoint), coin); }
+        void EraseCoin(const COutPoint& outpoint) override { m_batch.Erase(CoinEntry(&outpoint)); }
+        void WriteBestBlock(const uint256& hash) override { m_batch.Write(DB_BEST_BLOCK, hash); }
+        void EraseBestBlock() override { m_batch.Erase(DB_BEST_BLOCK); }
+        void WriteHeadBlocks(const std::vector<uint256>& hashes) override { m_batch.Write(DB_HEAD_BLOCKS, hashes); }
+        void EraseHeadBlocks() override { m_batch.Erase(DB_HEAD_BLOCKS); }
+        size_t SizeEstimate() const override { return m_batch.SizeEstimate(); }
+        void Clear() override { m_batch.Clear(); }
+    };
+
+public:
+    explicit LevelDBCoinsStore(DBParams db_params) :
+        m_db_params{std::move(db_params)},
+        m_db{std::make_unique<CDBWrapper>(m_db_params)} { }
+
+    std::optional<Coin> ReadCoin(const COutPoint& outpoint) const override
+    {
+        if (Coin coin; m_db->Read(CoinEntry(&outpoint), coin)) return coin;
+        return std::nullopt;
+    }
+
+    bool HaveCoin(const COutPoint& outpoint) const override
+    {
+        return m_db->Exists(CoinEntry(&outpoint));
+    }
+
+    std::optional<uint256> ReadBestBlock() const override
+    {
+        if (uint256 hash; m_db->Read(DB_BEST_BLOCK, hash)) return hash;
+        return std::nullopt;
+    }
+
+    std::vector<uint256> ReadHeadBlocks() const override
+    {
+        std::vector<uint256> hashes;
+        if (!m_db->Read(DB_HEAD_BLOCKS, hashes)) return {};
+        return hashes;
+    }
+
+    std::unique_ptr<Batch> NewBatch() override { return std::make_unique<LevelDBBatch>(*m_db); }
+
+    void WriteBatch(Batch& batch) override
+    {
+        m_db->WriteBatch(static_cast<LevelDBBatch&>(batch).m_batch);
+    }
+
+    std::unique_ptr<CCoinsViewCursor> Cursor() const override;
+
+    size_t EstimateSize() const override
+    {
+        return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
+    }
+
+    bool NeedsUpgrade() override
+    {
+        std::unique_ptr<CDBIterator> cursor{m_db->NewIterator()};
+        // DB_COINS was deprecated in v0.15.0, commit
+        // 1088b02f0ccd7358d2b7076bb9e122d59d502d02
+        cursor->Seek(std::make_pair(DB_COINS, uint256{}));
+        return cursor->Valid();
+    }
+
+    void ResizeCache(size_t new_cache_size) override
+    {
+        // We can't do this operation with an in-memory DB since we'll lose all the coins upon
+        // reset.
+        if (!m_db_params.memory_only) {
+            // Have to do a reset first to get the original `m_db` state to release its
+            // filesystem lock.
+            m_db.reset();
+            m_db_params.cache_bytes = new_cache_size;
+            m_db_params.wipe_data = false;
+            m_db = std::make_unique<CDBWrapper>(m_db_params);
+        }
+    }
+
+    std::optional<fs::path> StoragePath() const override { return m_db->StoragePath(); }
+    std::optional<DBStats> GetDBStats() const override { return m_db->GetStats(); }
+};
+
+std::unique_ptr<CCoinsViewCursor> LevelDBCoinsStore::Cursor() const
+{
+    uint256 best_block{ReadBestBlock().value_or(uint256{})};
+    auto i = std::make_unique<CCoinsViewDBCursor>(
+        const_cast<CDBWrapper&>(*m_db).NewIterator(), best_block);
+    /* It seems that there are no "const iterators" for LevelDB.  Since we
+       only need read operations on it, use a const-cast to get around
+       that restriction.  */
+    i->pcursor->Seek(DB_COIN);
+    // Cache key of first record
+    if (i->pcursor->Valid()) {
+        CoinEntry entry(&i->keyTmp.second);
+        i->pcursor->GetKey(entry);
+        i->keyTmp.first = entry.key;
+    } else {
+        i->keyTmp.first = 0; // Make sure Valid() and GetKey() return false
+    }
+    return i;
+}
+
+bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
+{
+    // Return cached key
+    if (keyTmp.first == DB_COIN) {
+        key = keyTmp.second;
+        return true;
+    }
+    return false;
+}
+
+bool CCoinsViewDBCursor::GetValue(Coin &coin) const
+{
+    return pcursor->GetValue(coin);
+}
+
+bool CCoinsViewDBCursor::Valid() const
+{
+    return keyTmp.first == DB_COIN;
+}
+
+void CCoinsViewDBCursor::Next()
+{
+    pcursor->Next();
+    CoinEntry entry(&keyTmp.second);
+    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+        keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
+    } else {
+        keyTmp.first = entry.key;
+    }
+}
+
 } // namespace
 
+std::optional<CoinsBackend> CoinsBackendFromString(std::string_view name)
+{
+    if (name == "leveldb") return CoinsBackend::LEVELDB;
+    if (name == "hashstore") return CoinsBackend::HASHSTORE;
+    return std::nullopt;
+}
+
+std::string CoinsBackendToString(CoinsBackend backend)
+{
+    switch (backend) {
+    case CoinsBackend::LEVELDB: return "leveldb";
+    case CoinsBackend::HASHSTORE: return "hashstore";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+static std::unique_ptr<CoinsStore> MakeCoinsStore(const DBParams& db_params, CoinsBackend backend)
+{
+    if (backend == CoinsBackend::HASHSTORE && !db_params.memory_only) {
+        return std::make_unique<HashCoinsStore>(HashCoinsStore::Options{.path = db_params.path, .wipe_data = db_params.wipe_data});
+    }
+    if (!db_params.memory_only && HashCoinsStore::IsHashStore(db_params.path)) {
+        if (!db_params.wipe_data) {
+            throw dbwrapper_error{strprintf("%s was created with -coinsbackend=hashstore", fs::PathToString(db_params.path))};
+        }
+        HashCoinsStore::Wipe(db_params.path);
+    }
+    return std::make_unique<LevelDBCoinsStore>(db_params);
+}
+
 CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options) :
     m_db_params{std::move(db_params)},
     m_options{std::move(options)},
-    m_db{std::make_unique<CDBWrapper>(m_db_params)} { }
+    m_store{MakeCoinsStore(m_db_params, m_options.backend)} { }
+
+bool CCoinsViewDB::NeedsUpgrade()
+{
+    return m_store->NeedsUpgrade();
+}
 
 void CCoinsViewDB::ResizeCache(size_t new_cache_size)
 {
-    // We can't do this operation with an in-memory DB since we'll lose all the coins upon
-    // reset.
-    if (!m_db_params.memory_only) {
-        // Have to do a reset first to get the original `m_db` state to release its
-        // filesystem lock.
-        m_db.reset();
-        m_db_params.cache_bytes = new_cache_size;
-        m_db_params.wipe_data = false;
-        m_db = std::make_unique<CDBWrapper>(m_db_params);
-    }
+    m_store->ResizeCache(new_cache_size);
 }
 
 std::optional<Coin> CCoinsViewDB::GetCoin(const COutPoint& outpoint) const
 {
-    if (Coin coin; m_db->Read(CoinEntry(&outpoint), coin)) return coin;
-    return std::nullopt;
+    return m_store->ReadCoin(outpoint);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
-    return m_db->Exists(CoinEntry(&outpoint));
+    return m_store->HaveCoin(outpoint);
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
-    uint256 hashBestChain;
-    if (!m_db->Read(DB_BEST_BLOCK, hashBestChain))
-        return uint256();
-    return hashBestChain;
+    return m_store->ReadBestBlock().value_or(uint256{});
 }
 
 std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
-    std::vector<uint256> vhashHeadBlocks;
-    if (!m_db->Read(DB_HEAD_BLOCKS, vhashHeadBlocks)) {
-        return std::vector<uint256>();
-    }
-    return vhashHeadBlocks;
+    return m_store->ReadHeadBlocks();
 }
 
 bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashBlock) {
-    CDBBatch batch(*m_db);
+    const std::unique_ptr<CoinsStore::Batch> batch{m_store->NewBatch()};
     size_t count = 0;
     size_t changed = 0;
     assert(!hashBlock.IsNull());
@@ -113,24 +289,23 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
     // transition from old_tip to hashBlock.
     // A vector is used for future extensibility, as we may want to support
     // interrupting after partial writes from multiple independent reorgs.
-    batch.Erase(DB_BEST_BLOCK);
-    batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+    batch->EraseBestBlock();
+    batch->WriteHeadBlocks(Vector(hashBlock, old_tip));
 
     for (auto it{cursor.Begin()}; it != cursor.End();) {
         if (it->second.IsDirty()) {
-            CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
-                batch.Erase(entry);
+                batch->EraseCoin(it->first);
             else
-                batch.Write(entry, it->second.coin);
+                batch->WriteCoin(it->first, it->second.coin);
             changed++;
         }
         count++;
         it = cursor.NextAndMaybeErase(*it);
-        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
-            LogDebug(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
+        if (batch->SizeEstimate() > m_options.batch_write_bytes) {
+            LogDebug(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+            m_store->WriteBatch(*batch);
+            batch->Clear();
             if (m_options.simulate_crash_ratio) {
                 static FastRandomContext rng;
                 if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
@@ -142,89 +317,21 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
     }
 
     // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
+    batch->EraseHeadBlocks();
+    batch->WriteBestBlock(hashBlock);
 
-    LogDebug(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-    bool ret = m_db->WriteBatch(batch);
+    LogDebug(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+    m_store->WriteBatch(*batch);
     LogDebug(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
-    return ret;
+    return true;
 }
 
 size_t CCoinsViewDB::EstimateSize() const
 {
-    return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
+    return m_store->EstimateSize();
 }
 
-/** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
-class CCoinsViewDBCursor: public CCoinsViewCursor
-{
-public:
-    // Prefer using CCoinsViewDB::Cursor() since we want to perform some
-    // cache warmup on instantiation.
-    CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256&hashBlockIn):
-        CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
-    ~CCoinsViewDBCursor() = default;
-
-    bool GetKey(COutPoint &key) const override;
-    bool GetValue(Coin &coin) const override;
-
-    bool Valid() const override;
-    void Next() override;
-
-private:
-    std::unique_ptr<CDBIterator> pcursor;
-    std::pair<char, COutPoint> keyTmp;
-
-    friend class CCoinsViewDB;
-};
-
 std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
 {
-    auto i = std::make_unique<CCoinsViewDBCursor>(
-        const_cast<CDBWrapper&>(*m_db).NewIterator(), GetBestBlock());
-    /* It seems that there are no "const iterators" for LevelDB.  Since we
-       only need read operations on it, use a const-cast to get around
-       that restriction.  */
-    i->pcursor->Seek(DB_COIN);
-    // Cache key of first record
-    if (i->pcursor->Valid()) {
-        CoinEntry entry(&i->keyTmp.second);
-        i->pcursor->GetKey(entry);
-        i->keyTmp.first = entry.key;
-    } else {
-        i->keyTmp.first = 0; // Make sure Valid() and GetKey() return false
-    }
-    return i;
-}
-
-bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
-{
-    // Return cached key
-    if (keyTmp.first == DB_COIN) {
-        key = keyTmp.second;
-        return true;
-    }
-    return false;
-}
-
-bool CCoinsViewDBCursor::GetValue(Coin &coin) const
-{
-    return pcursor->GetValue(coin);
-}
-
-bool CCoinsViewDBCursor::Valid() const
-{
-    return keyTmp.first == DB_COIN;
-}
-
-void CCoinsViewDBCursor::Next()
-{
-    pcursor->Next();
-    CoinEntry entry(&keyTmp.second);
-    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
-        keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
-    } else {
-        keyTmp.first = entry.key;
-    }
+    return m_store->Cursor();
 }
@@ -16,6 +16,8 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 class COutPoint;
@@ -38,6 +40,16 @@ static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
+//! Storage engines for the coin database.
+enum class CoinsBackend {
+    LEVELDB,   //!< Generic LevelDB key-value store
+    HASHSTORE, //!< Append-only log segments with an in-memory index, see HashCoinsStore
+};
+static constexpr CoinsBackend DEFAULT_COINS_BACKEND{CoinsBackend::LEVELDB};
+
+std::optional<CoinsBackend> CoinsBackendFromString(std::string_view name);
+std::string CoinsBackendToString(CoinsBackend backend);
+
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
     //! Maximum database write batch size in bytes.
@@ -45,6 +57,49 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Storage engine. In-memory databases always use LevelDB's memory environment.
+    CoinsBackend backend{DEFAULT_COINS_BACKEND};
+};
+
+/**
+ * Storage engine under CCoinsViewDB. Holds the coins plus the best block and head
+ * blocks markers. Write errors and corruption are reported by throwing dbwrapper_error.
+ */
+class CoinsStore
+{
+public:
+    /** Changes that WriteBatch() applies atomically. */
+    class Batch
+    {
+    public:
+        virtual ~Batch() = default;
+        virtual void WriteCoin(const COutPoint& outpoint, const Coin& coin) = 0;
+        virtual void EraseCoin(const COutPoint& outpoint) = 0;
+        virtual void WriteBestBlock(const uint256& hash) = 0;
+        virtual void EraseBestBlock() = 0;
+        virtual void WriteHeadBlocks(const std::vector<uint256>& hashes) = 0;
+        virtual void EraseHeadBlocks() = 0;
+        virtual size_t SizeEstimate() const = 0;
+        virtual void Clear() = 0;
+    };
+
+    virtual ~CoinsStore() = default;
+
+    virtual std::optional<Coin> ReadCoin(const COutPoint& outpoint) const = 0;
+    virtual bool HaveCoin(const COutPoint& outpoint) const = 0;
+    virtual std::optional<uint256> ReadBestBlock() const = 0;
+    virtual std::vector<uint256> ReadHeadBlocks() const = 0;
+    virtual std::unique_ptr<Batch> NewBatch() = 0;
+    virtual void WriteBatch(Batch& batch) = 0;
+    //! Iterate over a consistent view of the coins, ordered by outpoint.
+    virtual std::unique_ptr<CCoinsViewCursor> Cursor() const = 0;
+    virtual size_t EstimateSize() const = 0;
+    //! Whether an unsupported database format is used.
+    virtual bool NeedsUpgrade() { return false; }
+    virtual void ResizeCache(size_t new_cache_size) {}
+    virtual std::optional<fs::path> StoragePath() const = 0;
+    //! LevelDB statistics, for stores kept in LevelDB.
+    virtual std::optional<DBStats> GetDBStats() const { return std::nullopt; }
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -53,7 +108,7 @@ class CCoinsViewDB final : public CCoinsView
 protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
-    std::unique_ptr<CDBWrapper> m_db;
+    std::unique_ptr<CoinsStore> m_store;
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
@@ -72,7 +127,10 @@ public:
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     //! @returns filesystem path to on-disk storage or std::nullopt if in memory.
-    std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
+    std::optional<fs::path> StoragePath() { return m_store->StoragePath(); }
+
+    //! LevelDB statistics, unless a backend other than LevelDB is used.
+    std::optional<DBStats> GetDBStats() const { return m_store->GetDBStats(); }
 };
 
 #endif // BITCOIN_TXDB_H
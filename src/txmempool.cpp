@@ -12,6 +12,7 @@
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <logging.h>
+#include <memusage.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
 #include <random.h>
@@ -23,15 +24,18 @@
 #include <util/result.h>
 #include <util/time.h>
 #include <util/trace.h>
+#include <util/rbf.h>
 #include <util/translation.h>
 #include <validationinterface.h>
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <numeric>
 #include <optional>
 #include <ranges>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 
 bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
@@ -54,8 +58,10 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    // Descendant sets can get large during a reorg, so use node-based sets
+    // for the traversal rather than the entries' sorted vectors.
+    const CTxMemPoolEntry::Children& direct_children{updateIt->GetMemPoolChildrenConst()};
+    std::set<CTxMemPoolEntry::CTxMemPoolEntryRef, CompareIteratorByHash> stageEntries{direct_children.begin(), direct_children.end()}, descendants;
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -105,6 +111,7 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
 void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashesToUpdate)
 {
     AssertLockHeld(cs);
+    ++m_snapshot_epoch;
     // For each entry in vHashesToUpdate, store the set of in-mempool, but not
     // in-vHashesToUpdate transactions, so that we don't have to recalculate
     // descendants when we come across a previously seen entry.
@@ -148,6 +155,12 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
         UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded, descendants_to_remove);
     }
 
+    // Descendants of the re-added transactions gained ancestors
+    std::set<uint256> updated;
+    for (const auto& [_, descendants] : mapMemPoolDescendantsToUpdate) {
+        for (txiter dit : descendants) updated.insert(dit->GetTx().GetHash());
+    }
+
     for (const auto& txid : descendants_to_remove) {
         // This txid may have been removed already in a prior call to removeRecursive.
         // Therefore we ensure it is not yet removed already.
@@ -155,6 +168,12 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
             removeRecursive((*txiter)->GetTx(), MemPoolRemovalReason::SIZELIMIT);
         }
     }
+
+    for (const auto& txid : updated) {
+        if (const std::optional<txiter> it = GetIter(txid)) {
+            RecordDelta(MempoolDelta::Type::UPDATED, **it, /*reason=*/{});
+        }
+    }
 }
 
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimits(
@@ -320,7 +339,7 @@ void CTxMemPool::UpdateChildrenForRemoval(txiter it)
     }
 }
 
-void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants)
+void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants, std::set<uint256>* updated_descendants)
 {
     // For each entry, walk back all ancestors and decrement size associated with this
     // transaction
@@ -331,6 +350,7 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // Here we only update statistics and not data in CTxMemPool::Parents
         // and CTxMemPoolEntry::Children (which we need to preserve until we're
         // finished with all operations that need to traverse the mempool).
+        setEntries updated;
         for (txiter removeIt : entriesToRemove) {
             setEntries setDescendants;
             CalculateDescendants(removeIt, setDescendants);
@@ -340,6 +360,15 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
             int modifySigOps = -removeIt->GetSigOpCost();
             for (txiter dit : setDescendants) {
                 mapTx.modify(dit, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFee, -1, modifySigOps); });
+                if (!entriesToRemove.count(dit)) updated.insert(dit);
+            }
+        }
+        // Descendants that stay in the mempool lost ancestors
+        for (txiter dit : updated) {
+            if (updated_descendants) {
+                updated_descendants->insert(dit->GetTx().GetHash());
+            } else {
+                RecordDelta(MempoolDelta::Type::UPDATED, *dit, /*reason=*/{});
             }
         }
     }
@@ -409,7 +438,8 @@ static CTxMemPool::Options&& Flatten(CTxMemPool::Options&& opts, bilingual_str&
 }
 
 CTxMemPool::CTxMemPool(Options opts, bilingual_str& error)
-    : m_opts{Flatten(std::move(opts), error)}
+    : m_delta_journal_id{FastRandomContext().rand64()},
+      m_opts{Flatten(std::move(opts), error)}
 {
 }
 
@@ -444,6 +474,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     if (delta) {
         mapTx.modify(newit, [&delta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(delta); });
     }
+    if (newit->GetModifiedFee() < 0) ++m_negative_modified_fee_count;
 
     // Update cachedInnerUsage to include contained transaction's usage.
     // (When we update the entry for in-mempool parents, memory usage will be
@@ -471,12 +502,16 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     UpdateEntryForAncestors(newit, setAncestors);
 
     nTransactionsUpdated++;
+    ++m_snapshot_epoch;
     totalTxSize += entry.GetTxSize();
     m_total_fee += entry.GetFee();
 
     txns_randomized.emplace_back(newit->GetSharedTx());
+    wtxids_randomized.emplace_back(newit->GetTx().GetWitnessHash().ToUint256());
     newit->idx_randomized = txns_randomized.size() - 1;
 
+    RecordDelta(MempoolDelta::Type::ADDED, *newit, /*reason=*/{});
+
     TRACE3(mempool, added,
         entry.GetTx().GetHash().data(),
         entry.GetTxSize(),
@@ -509,6 +544,8 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         mapNextTx.erase(txin.prevout);
 
     RemoveUnbroadcastTx(it->GetTx().GetHash(), true /* add logging because unchecked */);
+    RecordDelta(MempoolDelta::Type::REMOVED, *it, reason);
+    if (it->GetModifiedFee() < 0) --m_negative_modified_fee_count;
 
     if (txns_randomized.size() > 1) {
         // Update idx_randomized of the to-be-moved entry.
@@ -516,10 +553,16 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         // Remove entry from txns_randomized by replacing it with the back and deleting the back.
         txns_randomized[it->idx_randomized] = std::move(txns_randomized.back());
         txns_randomized.pop_back();
-        if (txns_randomized.size() * 2 < txns_randomized.capacity())
+        wtxids_randomized[it->idx_randomized] = wtxids_randomized.back();
+        wtxids_randomized.pop_back();
+        if (txns_randomized.size() * 2 < txns_randomized.capacity()) {
             txns_randomized.shrink_to_fit();
-    } else
+            wtxids_randomized.shrink_to_fit();
+        }
+    } else {
         txns_randomized.clear();
+        wtxids_randomized.clear();
+    }
 
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
@@ -527,6 +570,7 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
     mapTx.erase(it);
     nTransactionsUpdated++;
+    ++m_snapshot_epoch;
 }
 
 // Calculates descendants of entry that are not already in setDescendants, and adds to
@@ -634,6 +678,9 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     AssertLockHeld(cs);
     std::vector<RemovedMempoolTransactionInfo> txs_removed_for_block;
     txs_removed_for_block.reserve(vtx.size());
+    // Descendants of the confirmed transactions are often confirmed later in the
+    // same block, so only record updates for those left at the end.
+    std::set<uint256> updated_descendants;
     for (const auto& tx : vtx)
     {
         txiter it = mapTx.find(tx->GetHash());
@@ -641,11 +688,16 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
             setEntries stage;
             stage.insert(it);
             txs_removed_for_block.emplace_back(*it);
-            RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
+            RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK, &updated_descendants);
         }
         removeConflicts(*tx);
         ClearPrioritisation(tx->GetHash());
     }
+    for (const auto& txid : updated_descendants) {
+        if (const std::optional<txiter> it = GetIter(txid)) {
+            RecordDelta(MempoolDelta::Type::UPDATED, **it, /*reason=*/{});
+        }
+    }
     if (m_opts.signals) {
         m_opts.signals->MempoolTransactionsRemovedForBlock(txs_removed_for_block, nBlockHeight);
     }
@@ -665,6 +717,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
 
     uint64_t checkTotal = 0;
     CAmount check_total_fee{0};
+    uint64_t check_negative_fee_count{0};
     uint64_t innerUsage = 0;
     uint64_t prev_ancestor_count{0};
 
@@ -673,9 +726,11 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     for (const auto& it : GetSortedDepthAndScore()) {
         checkTotal += it->GetTxSize();
         check_total_fee += it->GetFee();
+        if (it->GetModifiedFee() < 0) ++check_negative_fee_count;
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
         innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+        assert(wtxids_randomized[it->idx_randomized] == tx.GetWitnessHash().ToUint256());
         CTxMemPoolEntry::Parents setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
@@ -755,6 +810,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
 
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
+    assert(m_negative_modified_fee_count == check_negative_fee_count);
     assert(innerUsage == cachedInnerUsage);
 }
 
@@ -882,7 +938,9 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
         delta = SaturatingAdd(delta, nFeeDelta);
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
+            if (it->GetModifiedFee() < 0) --m_negative_modified_fee_count;
             mapTx.modify(it, [&nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta); });
+            if (it->GetModifiedFee() < 0) ++m_negative_modified_fee_count;
             // Now update all ancestors' modified fees with descendants
             auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits(), /*fSearchForParents=*/false)};
             for (txiter ancestorIt : ancestors) {
@@ -895,7 +953,12 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
             for (txiter descendantIt : setDescendants) {
                 mapTx.modify(descendantIt, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
             }
+            RecordDelta(MempoolDelta::Type::UPDATED, *it, /*reason=*/{});
+            for (txiter descendantIt : setDescendants) {
+                RecordDelta(MempoolDelta::Type::UPDATED, *descendantIt, /*reason=*/{});
+            }
             ++nTransactionsUpdated;
+            ++m_snapshot_epoch;
         }
         if (delta == 0) {
             mapDeltas.erase(hash);
@@ -1027,7 +1090,7 @@ void CCoinsViewMemPool::Reset()
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + memusage::DynamicUsage(wtxids_randomized) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1035,13 +1098,14 @@ void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked)
 
     if (m_unbroadcast_txids.erase(txid))
     {
+        ++m_snapshot_epoch;
         LogDebug(BCLog::MEMPOOL, "Removed %i from set of unbroadcast txns%s\n", txid.GetHex(), (unchecked ? " before confirmation that txn was sent out" : ""));
     }
 }
 
-void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
+void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason, std::set<uint256>* updated_descendants) {
     AssertLockHeld(cs);
-    UpdateForRemoveFromMempool(stage, updateDescendants);
+    UpdateForRemoveFromMempool(stage, updateDescendants, updated_descendants);
     for (txiter it : stage) {
         removeUnchecked(it, reason);
     }
@@ -1050,18 +1114,28 @@ void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPool
 int CTxMemPool::Expire(std::chrono::seconds time)
 {
     AssertLockHeld(cs);
-    indexed_transaction_set::index<entry_time>::type::iterator it = mapTx.get<entry_time>().begin();
-    setEntries toremove;
-    while (it != mapTx.get<entry_time>().end() && it->GetTime() < time) {
-        toremove.insert(mapTx.project<0>(it));
-        it++;
-    }
+    const auto time_start{SteadyClock::now()};
+    // The entry_time index is ordered, so the expired entries are a prefix of it. Stage them and
+    // their descendants in the same walk; descendants already staged are not walked again.
     setEntries stage;
-    for (txiter removeit : toremove) {
-        CalculateDescendants(removeit, stage);
+    for (auto it = mapTx.get<entry_time>().begin(); it != mapTx.get<entry_time>().end() && it->GetTime() < time; ++it) {
+        CalculateDescendants(mapTx.project<0>(it), stage);
     }
+    if (stage.empty()) return 0;
+
+    int64_t vsize_removed{0};
+    for (txiter it : stage) vsize_removed += it->GetTxSize();
+    const size_t num_removed{stage.size()};
     RemoveStaged(stage, false, MemPoolRemovalReason::EXPIRY);
-    return stage.size();
+
+    const auto duration{SteadyClock::now() - time_start};
+    TRACE4(mempool, evicted,
+        RemovalReasonToString(MemPoolRemovalReason::EXPIRY).c_str(),
+        uint64_t{num_removed},
+        vsize_removed,
+        Ticks<std::chrono::microseconds>(duration)
+    );
+    return num_removed;
 }
 
 void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry)
@@ -1073,23 +1147,27 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry)
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Children& children{entry->GetMemPoolChildren()};
+    cachedInnerUsage -= memusage::DynamicUsage(children);
+    if (add) {
+        children.insert(*child);
+    } else {
+        children.erase(*child);
     }
+    cachedInnerUsage += memusage::DynamicUsage(children);
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Parents& parents{entry->GetMemPoolParents()};
+    cachedInnerUsage -= memusage::DynamicUsage(parents);
+    if (add) {
+        parents.insert(*parent);
+    } else {
+        parents.erase(*parent);
     }
+    cachedInnerUsage += memusage::DynamicUsage(parents);
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1116,6 +1194,205 @@ CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
     return std::max(CFeeRate(llround(rollingMinimumFeeRate)), m_opts.incremental_relay_feerate);
 }
 
+/** Snapshot entry with BIP125 replaceability set from the transaction's own signal only. */
+static MempoolSnapshot::Entry ToSnapshotEntry(const CTxMemPoolEntry& e, bool unbroadcast)
+{
+    MempoolSnapshot::Entry ret{
+        .tx = e.GetSharedTx(),
+        .vsize = e.GetTxSize(),
+        .weight = e.GetTxWeight(),
+        .time = e.GetTime(),
+        .height = e.GetHeight(),
+        .count_with_descendants = e.GetCountWithDescendants(),
+        .size_with_descendants = e.GetSizeWithDescendants(),
+        .count_with_ancestors = e.GetCountWithAncestors(),
+        .size_with_ancestors = e.GetSizeWithAncestors(),
+        .fee = e.GetFee(),
+        .modified_fee = e.GetModifiedFee(),
+        .mod_fees_with_ancestors = e.GetModFeesWithAncestors(),
+        .mod_fees_with_descendants = e.GetModFeesWithDescendants(),
+        .parents = {},
+        .children = {},
+        .bip125_replaceable = SignalsOptInRBF(e.GetTx()),
+        .unbroadcast = unbroadcast,
+    };
+    ret.parents.reserve(e.GetMemPoolParentsConst().size());
+    for (const CTxMemPoolEntry& parent : e.GetMemPoolParentsConst()) {
+        ret.parents.push_back(parent.GetTx().GetHash());
+    }
+    ret.children.reserve(e.GetMemPoolChildrenConst().size());
+    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
+        ret.children.push_back(child.GetTx().GetHash());
+    }
+    return ret;
+}
+
+MempoolSnapshot::Entry CTxMemPool::GetSnapshotEntry(const CTxMemPoolEntry& e) const
+{
+    AssertLockHeld(cs);
+    MempoolSnapshot::Entry ret{ToSnapshotEntry(e, IsUnbroadcastTx(e.GetTx().GetHash()))};
+    if (!ret.bip125_replaceable) {
+        const auto ancestors{AssumeCalculateMemPoolAncestors(__func__, e, Limits::NoLimits(), /*fSearchForParents=*/false)};
+        ret.bip125_replaceable = std::ranges::any_of(ancestors, [](txiter it) { return SignalsOptInRBF(it->GetTx()); });
+    }
+    return ret;
+}
+
+namespace {
+/** Order of CTxMemPool::GetSortedDepthAndScore() for snapshot entries */
+bool CompareSnapshotEntryByDepthAndScore(const MempoolSnapshot::Entry& a, const MempoolSnapshot::Entry& b)
+{
+    if (a.count_with_ancestors != b.count_with_ancestors) return a.count_with_ancestors < b.count_with_ancestors;
+    double f1 = (double)a.fee * b.vsize;
+    double f2 = (double)b.fee * a.vsize;
+    if (f1 == f2) {
+        return b.tx->GetHash() < a.tx->GetHash();
+    }
+    return f1 > f2;
+}
+} // namespace
+
+std::shared_ptr<const MempoolSnapshot> CTxMemPool::GetSnapshot() const
+{
+    const uint64_t epoch{m_snapshot_epoch.load()};
+    {
+        LOCK(m_snapshot_mutex);
+        if (m_snapshot && m_snapshot->epoch == epoch) return m_snapshot;
+    }
+
+    LOCK(m_snapshot_build_mutex);
+    std::shared_ptr<const MempoolSnapshot> previous;
+    {
+        // A snapshot published while we waited reflects the mempool at some point
+        // during this call, which is as good as building one ourselves.
+        LOCK(m_snapshot_mutex);
+        if (m_snapshot && m_snapshot->epoch >= epoch) return m_snapshot;
+        previous = m_snapshot;
+    }
+
+    std::shared_ptr<const MempoolSnapshot> snapshot{previous ? RefreshSnapshot(*previous) : nullptr};
+    if (!snapshot) snapshot = BuildSnapshot();
+
+    LOCK(m_snapshot_mutex);
+    m_snapshot = snapshot;
+    return snapshot;
+}
+
+std::shared_ptr<MempoolSnapshot> CTxMemPool::BuildSnapshot() const
+{
+    auto snapshot{std::make_shared<MempoolSnapshot>()};
+    LOCK(cs);
+    snapshot->epoch = m_snapshot_epoch.load();
+    snapshot->sequence = m_sequence_number;
+    snapshot->delta_sequence = m_next_delta_sequence;
+
+    // Entries sorted by ancestor count come after all of their parents, so
+    // BIP125 replaceability can be inherited from the parents' snapshot
+    // entries instead of walking every entry's ancestors.
+    snapshot->entries.reserve(mapTx.size());
+    snapshot->index.reserve(mapTx.size());
+    for (const auto& it : GetSortedDepthAndScore()) {
+        auto& entry{snapshot->entries.emplace_back(ToSnapshotEntry(*it, IsUnbroadcastTx(it->GetTx().GetHash())))};
+        for (const Txid& parent : entry.parents) {
+            entry.bip125_replaceable = entry.bip125_replaceable || Assert(snapshot->Find(parent))->bip125_replaceable;
+        }
+        snapshot->index.emplace(it->GetTx().GetHash(), snapshot->entries.size() - 1);
+    }
+    return snapshot;
+}
+
+std::shared_ptr<MempoolSnapshot> CTxMemPool::RefreshSnapshot(const MempoolSnapshot& previous) const
+{
+    auto snapshot{std::make_shared<MempoolSnapshot>()};
+    // Copies of the entries that changed, and the txids of all previous entries
+    // that must not be reused.
+    std::vector<MempoolSnapshot::Entry> changed;
+    std::unordered_set<Txid, SaltedTxidHasher> stale;
+    std::set<uint256> unbroadcast;
+    {
+        LOCK(cs);
+        const uint64_t first{m_next_delta_sequence - m_deltas.size()};
+        if (m_opts.delta_journal_size == 0 || previous.delta_sequence < first) return nullptr;
+        snapshot->epoch = m_snapshot_epoch.load();
+        snapshot->sequence = m_sequence_number;
+        snapshot->delta_sequence = m_next_delta_sequence;
+
+        // The journal lists every transaction that was added or removed, or whose
+        // modified fee or ancestor state changed. The ancestors of those still in
+        // the mempool had their descendant state and children change with them, as
+        // did the remaining in-mempool parents of removed transactions.
+        setEntries seeds;
+        for (auto delta{m_deltas.begin() + (previous.delta_sequence - first)}; delta != m_deltas.end(); ++delta) {
+            stale.insert(delta->txid);
+            if (const std::optional<txiter> it{GetIter(delta->txid)}) {
+                seeds.insert(*it);
+            } else if (const MempoolSnapshot::Entry* entry{previous.Find(delta->txid)}) {
+                for (const auto* relatives : {&entry->parents, &entry->children}) {
+                    for (const Txid& txid : *relatives) {
+                        if (const std::optional<txiter> relative{GetIter(txid)}) seeds.insert(*relative);
+                    }
+                }
+            }
+        }
+        setEntries dirty;
+        for (txiter it : seeds) {
+            CalculateDescendants(it, dirty);
+        }
+        setEntries ancestors;
+        std::vector<txiter> stage{seeds.begin(), seeds.end()};
+        while (!stage.empty()) {
+            const txiter it{stage.back()};
+            stage.pop_back();
+            for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                const txiter parent_it{mapTx.iterator_to(parent)};
+                if (ancestors.insert(parent_it).second) stage.push_back(parent_it);
+            }
+        }
+        dirty.insert(ancestors.begin(), ancestors.end());
+
+        changed.reserve(dirty.size());
+        for (txiter it : dirty) {
+            changed.push_back(ToSnapshotEntry(*it, IsUnbroadcastTx(it->GetTx().GetHash())));
+            stale.insert(it->GetTx().GetHash());
+        }
+        unbroadcast = m_unbroadcast_txids;
+    }
+
+    // Inherit BIP125 replaceability in topological order. The ancestors of a
+    // changed entry are either changed as well, or unchanged since the previous
+    // snapshot.
+    std::sort(changed.begin(), changed.end(), CompareSnapshotEntryByDepthAndScore);
+    std::unordered_map<Txid, size_t, SaltedTxidHasher> changed_index;
+    changed_index.reserve(changed.size());
+    for (auto& entry : changed) {
+        for (const Txid& parent : entry.parents) {
+            if (entry.bip125_replaceable) break;
+            const auto it{changed_index.find(parent)};
+            entry.bip125_replaceable = it != changed_index.end() ? changed[it->second].bip125_replaceable :
+                                                                   Assert(previous.Find(parent))->bip125_replaceable;
+        }
+        changed_index.emplace(entry.tx->GetHash(), changed_index.size());
+    }
+
+    std::vector<MempoolSnapshot::Entry> kept;
+    kept.reserve(previous.entries.size());
+    for (const auto& entry : previous.entries) {
+        if (stale.count(entry.tx->GetHash())) continue;
+        kept.push_back(entry);
+        kept.back().unbroadcast = unbroadcast.count(entry.tx->GetHash());
+    }
+    snapshot->entries.reserve(kept.size() + changed.size());
+    std::merge(std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()),
+               std::make_move_iterator(changed.begin()), std::make_move_iterator(changed.end()),
+               std::back_inserter(snapshot->entries), CompareSnapshotEntryByDepthAndScore);
+    snapshot->index.reserve(snapshot->entries.size());
+    for (size_t i = 0; i < snapshot->entries.size(); ++i) {
+        snapshot->index.emplace(snapshot->entries[i].tx->GetHash(), i);
+    }
+    LogDebug(BCLog::MEMPOOL, "Refreshed mempool snapshot, copied %u of %u entries\n", changed.size(), snapshot->entries.size());
+    return snapshot;
+}
+
 void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
     AssertLockHeld(cs);
     if (rate.GetFeePerK() > rollingMinimumFeeRate) {
@@ -1127,34 +1404,80 @@ void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
 void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining) {
     AssertLockHeld(cs);
 
+    const auto time_start{SteadyClock::now()};
     unsigned nTxnRemoved = 0;
+    int64_t vsize_removed{0};
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
-
-        // We set the new mempool min fee to the feerate of the removed set, plus the
-        // "minimum reasonable fee rate" (ie some value under which we consider txn
-        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
-        // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
-        removed += m_opts.incremental_relay_feerate;
-        trackPackageRemoved(removed);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
+        const size_t excess{DynamicMemoryUsage() - sizelimit};
+
+        // Select a batch of packages in one pass over the descendant_score index, lowest
+        // score first, until the memory they free covers the excess. A package is the
+        // lowest-scoring entry plus its descendants. As long as no entry of a package has a
+        // parent outside of it, removing it changes no other entry's descendant score, so the
+        // next package in index order is the one a removal-at-a-time loop would pick next.
+        // Otherwise the remaining scores go stale: close the batch with that package and
+        // select again after the removal.
         setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
-        nTxnRemoved += stage.size();
+        size_t freed{0};
+        // Simulate the shrinking that removeUnchecked does to the randomized vectors, so that
+        // the freed estimate matches DynamicMemoryUsage().
+        size_t randomized_size{txns_randomized.size()};
+        size_t txns_capacity{txns_randomized.capacity()};
+        size_t wtxids_capacity{wtxids_randomized.capacity()};
+        const auto& index{mapTx.get<descendant_score>()};
+        for (auto it = index.begin(); it != index.end() && freed < excess; ++it) {
+            const txiter root{mapTx.project<0>(it)};
+            if (stage.count(root)) continue;
+
+            // We set the new mempool min fee to the feerate of the removed set, plus the
+            // "minimum reasonable fee rate" (ie some value under which we consider txn
+            // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
+            // equal to txn which were removed with no block in between.
+            CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            removed += m_opts.incremental_relay_feerate;
+            trackPackageRemoved(removed);
+            maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+
+            setEntries package;
+            CalculateDescendants(root, package);
+            bool self_contained{true};
+            for (txiter desc : package) {
+                freed += memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) +
+                         desc->DynamicMemoryUsage() +
+                         memusage::DynamicUsage(desc->GetMemPoolParentsConst()) +
+                         memusage::DynamicUsage(desc->GetMemPoolChildrenConst()) +
+                         desc->GetTx().vin.size() * memusage::IncrementalDynamicUsage(mapNextTx);
+                if (randomized_size > 1) {
+                    --randomized_size;
+                    if (randomized_size * 2 < txns_capacity) {
+                        freed += memusage::MallocUsage(txns_capacity * sizeof(CTransactionRef)) - memusage::MallocUsage(randomized_size * sizeof(CTransactionRef));
+                        freed += memusage::MallocUsage(wtxids_capacity * sizeof(uint256)) - memusage::MallocUsage(randomized_size * sizeof(uint256));
+                        txns_capacity = randomized_size;
+                        wtxids_capacity = randomized_size;
+                    }
+                } else {
+                    randomized_size = 0;
+                }
+                for (const CTxMemPoolEntry& parent : desc->GetMemPoolParentsConst()) {
+                    if (!package.count(mapTx.iterator_to(parent))) self_contained = false;
+                }
+            }
+            stage.insert(package.begin(), package.end());
+            if (!self_contained) break;
+        }
 
-        std::vector<CTransaction> txn;
-        if (pvNoSpendsRemaining) {
-            txn.reserve(stage.size());
-            for (txiter iter : stage)
-                txn.push_back(iter->GetTx());
+        nTxnRemoved += stage.size();
+        std::vector<CTransactionRef> txn;
+        txn.reserve(stage.size());
+        for (txiter iter : stage) {
+            vsize_removed += iter->GetTxSize();
+            if (pvNoSpendsRemaining) txn.push_back(iter->GetSharedTx());
         }
         RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
         if (pvNoSpendsRemaining) {
-            for (const CTransaction& tx : txn) {
-                for (const CTxIn& txin : tx.vin) {
+            for (const CTransactionRef& tx : txn) {
+                for (const CTxIn& txin : tx->vin) {
                     if (exists(GenTxid::Txid(txin.prevout.hash))) continue;
                     pvNoSpendsRemaining->push_back(txin.prevout);
                 }
@@ -1162,6 +1485,15 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
         }
     }
 
+    if (nTxnRemoved > 0) {
+        const auto duration{SteadyClock::now() - time_start};
+        TRACE4(mempool, evicted,
+            RemovalReasonToString(MemPoolRemovalReason::SIZELIMIT).c_str(),
+            uint64_t{nTxnRemoved},
+            vsize_removed,
+            Ticks<std::chrono::microseconds>(duration)
+        );
+    }
     if (maxFeeRateRemoved > CFeeRate(0)) {
         LogDebug(BCLog::MEMPOOL, "Removed %u txn, rolling minimum fee bumped to %s\n", nTxnRemoved, maxFeeRateRemoved.ToString());
     }
@@ -1201,6 +1533,40 @@ void CTxMemPool::GetTransactionAncestry(const uint256& txid, size_t& ancestors,
     }
 }
 
+void CTxMemPool::RecordDelta(MempoolDelta::Type type, const CTxMemPoolEntry& entry, MemPoolRemovalReason reason)
+{
+    AssertLockHeld(cs);
+    if (m_opts.delta_journal_size == 0) {
+        ++m_next_delta_sequence;
+        return;
+    }
+    if (m_deltas.size() >= m_opts.delta_journal_size) m_deltas.pop_front();
+    m_deltas.push_back(MempoolDelta{
+        .sequence = m_next_delta_sequence++,
+        .type = type,
+        .txid = entry.GetTx().GetHash(),
+        .wtxid = entry.GetTx().GetWitnessHash(),
+        .fee = entry.GetFee(),
+        .modified_fee = entry.GetModifiedFee(),
+        .vsize = entry.GetTxSize(),
+        .count_with_ancestors = entry.GetCountWithAncestors(),
+        .size_with_ancestors = entry.GetSizeWithAncestors(),
+        .mod_fees_with_ancestors = entry.GetModFeesWithAncestors(),
+        .reason = reason,
+    });
+}
+
+std::optional<std::vector<MempoolDelta>> CTxMemPool::GetDeltas(uint64_t since, size_t max_count) const
+{
+    LOCK(cs);
+    // The journal holds the changes [first, m_next_delta_sequence).
+    const uint64_t first{m_next_delta_sequence - m_deltas.size()};
+    if (since < first || since > m_next_delta_sequence) return std::nullopt;
+    const size_t begin{static_cast<size_t>(since - first)};
+    const size_t count{std::min(max_count, m_deltas.size() - begin)};
+    return std::vector<MempoolDelta>(m_deltas.begin() + begin, m_deltas.begin() + begin + count);
+}
+
 bool CTxMemPool::GetLoadTried() const
 {
     LOCK(cs);
@@ -32,11 +32,14 @@
 #include <boost/multi_index_container.hpp>
 
 #include <atomic>
+#include <deque>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -227,6 +230,82 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/**
+ * Immutable copy of the mempool entries, taken at one point in time.
+ *
+ * Obtained through CTxMemPool::GetSnapshot(). Readers such as the RPC and REST
+ * interfaces can inspect it without holding CTxMemPool::cs; the same snapshot is
+ * shared between readers until the mempool changes.
+ */
+struct MempoolSnapshot
+{
+    struct Entry
+    {
+        CTransactionRef tx;
+        int32_t vsize;
+        int32_t weight;
+        std::chrono::seconds time;
+        unsigned int height;
+        uint64_t count_with_descendants;
+        int64_t size_with_descendants;
+        uint64_t count_with_ancestors;
+        int64_t size_with_ancestors;
+        CAmount fee;
+        CAmount modified_fee;
+        CAmount mod_fees_with_ancestors;
+        CAmount mod_fees_with_descendants;
+        /** In-mempool parents and children, in the order of CTxMemPoolEntry::Parents/Children */
+        std::vector<Txid> parents;
+        std::vector<Txid> children;
+        /** Whether the transaction or one of its in-mempool ancestors signals BIP125 replaceability */
+        bool bip125_replaceable;
+        bool unbroadcast;
+    };
+
+    /** Value of CTxMemPool::GetSnapshotEpoch() this snapshot was taken at */
+    uint64_t epoch;
+    /** Value of CTxMemPool::GetSequence() this snapshot was taken at */
+    uint64_t sequence;
+    /** Delta sequence of the first change not reflected in this snapshot, see CTxMemPool::GetDeltas() */
+    uint64_t delta_sequence;
+
+    /** All entries, sorted by ancestor count and then by ancestor score like CTxMemPool::entryAll() */
+    std::vector<Entry> entries;
+    std::unordered_map<Txid, size_t, SaltedTxidHasher> index;
+
+    const Entry* Find(const Txid& txid) const
+    {
+        const auto it{index.find(txid)};
+        return it == index.end() ? nullptr : &entries[it->second];
+    }
+};
+
+/** One change to the mempool, as kept in the delta journal (see CTxMemPool::GetDeltas()). */
+struct MempoolDelta
+{
+    enum class Type : uint8_t {
+        ADDED,
+        REMOVED,
+        //! The modified fee or in-mempool ancestor state of a transaction that stays in the mempool changed
+        UPDATED,
+    };
+
+    /** Position in the journal, one higher than the previous change */
+    uint64_t sequence;
+    Type type;
+    Txid txid;
+    Wtxid wtxid;
+    /** Fees, size and ancestor state of the transaction at the time of the change */
+    CAmount fee;
+    CAmount modified_fee;
+    int32_t vsize;
+    uint64_t count_with_ancestors;
+    int64_t size_with_ancestors;
+    CAmount mod_fees_with_ancestors;
+    /** Only meaningful for REMOVED */
+    MemPoolRemovalReason reason;
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -308,12 +387,36 @@ protected:
     uint64_t totalTxSize GUARDED_BY(cs){0};      //!< sum of all mempool tx's virtual sizes. Differs from serialized tx size since witness data is discounted. Defined in BIP 141.
     CAmount m_total_fee GUARDED_BY(cs){0};       //!< sum of all mempool tx's fees (NOT modified fee)
     uint64_t cachedInnerUsage GUARDED_BY(cs){0}; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
+    uint64_t m_negative_modified_fee_count GUARDED_BY(cs){0}; //!< number of entries whose modified fee is negative
 
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs){GetTime()};
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs){false};
     mutable double rollingMinimumFeeRate GUARDED_BY(cs){0}; //!< minimum fee to get into the pool, decreases exponentially
     mutable Epoch m_epoch GUARDED_BY(cs){};
 
+    //! Incremented whenever anything captured by MempoolSnapshot changes
+    std::atomic<uint64_t> m_snapshot_epoch{0};
+    //! Held while building a snapshot, so that concurrent readers of a stale snapshot share one rebuild
+    mutable Mutex m_snapshot_build_mutex;
+    mutable Mutex m_snapshot_mutex;
+    mutable std::shared_ptr<const MempoolSnapshot> m_snapshot GUARDED_BY(m_snapshot_mutex);
+
+    /** Copy all entries into a new snapshot. */
+    std::shared_ptr<MempoolSnapshot> BuildSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+    /**
+     * Bring a previous snapshot up to date by copying only the entries changed since,
+     * as found through the delta journal. Returns nullptr if the journal no longer
+     * covers the changes since the previous snapshot.
+     */
+    std::shared_ptr<MempoolSnapshot> RefreshSnapshot(const MempoolSnapshot& previous) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    //! Most recent changes, oldest first, see GetDeltas()
+    std::deque<MempoolDelta> m_deltas GUARDED_BY(cs);
+    uint64_t m_next_delta_sequence GUARDED_BY(cs){1};
+    const uint64_t m_delta_journal_id;
+
+    void RecordDelta(MempoolDelta::Type type, const CTxMemPoolEntry& entry, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     // In-memory counter for external mempool tracking purposes.
     // This number is incremented once every time a transaction
     // is added or removed from the mempool for any reason.
@@ -392,6 +495,10 @@ public:
 
     using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
     std::vector<CTransactionRef> txns_randomized GUARDED_BY(cs); //!< All transactions in mapTx, in random order
+    /** Witness hashes of txns_randomized, at the same positions. Kept contiguous so that compact
+     *  block reconstruction can compute short IDs for the whole mempool with a batch SipHash pass
+     *  instead of dereferencing every transaction. */
+    std::vector<uint256> wtxids_randomized GUARDED_BY(cs);
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
@@ -525,8 +632,10 @@ public:
      *  in a block.
      *  Set updateDescendants to true when removing a tx that was in a block, so
      *  that any in-mempool descendants have their ancestor state updated.
+     *  See UpdateForRemoveFromMempool() for updated_descendants.
      */
-    void RemoveStaged(setEntries& stage, bool updateDescendants, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void RemoveStaged(setEntries& stage, bool updateDescendants, MemPoolRemovalReason reason,
+                      std::set<uint256>* updated_descendants = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** UpdateTransactionsFromBlock is called when adding transactions from a
      * disconnected block back to the mempool, new mempool entries may have
@@ -615,6 +724,42 @@ public:
         return GetMinFee(m_opts.max_size_bytes);
     }
 
+    /**
+     * Return an immutable snapshot of the mempool.
+     *
+     * The snapshot is cached and shared until the mempool changes, so repeated calls
+     * only take CTxMemPool::cs after a change. The previous snapshot is then refreshed
+     * with the entries the delta journal shows to have changed, together with their
+     * in-mempool ancestors and descendants; everything else is reused without taking
+     * cs. Only one thread rebuilds at a time; callers that find the snapshot stale wait
+     * for that rebuild and use its result instead of copying the mempool again.
+     */
+    std::shared_ptr<const MempoolSnapshot> GetSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(!m_snapshot_build_mutex, !m_snapshot_mutex);
+
+    /** Build a snapshot entry for an entry of this mempool. */
+    MempoolSnapshot::Entry GetSnapshotEntry(const CTxMemPoolEntry& entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    uint64_t GetSnapshotEpoch() const { return m_snapshot_epoch.load(); }
+
+    /**
+     * Return up to max_count mempool changes, in order, starting with the one at delta sequence since.
+     *
+     * Returns std::nullopt if the journal no longer holds all changes from since onwards, or since
+     * is ahead of the journal. Clients then have to start over from a snapshot, continuing with
+     * MempoolSnapshot::delta_sequence.
+     */
+    std::optional<std::vector<MempoolDelta>> GetDeltas(uint64_t since, size_t max_count) const;
+
+    /** Delta sequence the next mempool change will get. */
+    uint64_t GetNextDeltaSequence() const
+    {
+        LOCK(cs);
+        return m_next_delta_sequence;
+    }
+
+    /** Random identifier of the delta journal, which changes when the node restarts. */
+    uint64_t GetDeltaJournalId() const { return m_delta_journal_id; }
+
     /** Remove transactions from the mempool until its dynamic size is <= sizelimit.
       *  pvNoSpendsRemaining, if set, will be populated with the list of outpoints
       *  which are not in mempool which no longer have any spends in this mempool.
@@ -662,6 +807,14 @@ public:
         return m_total_fee;
     }
 
+    /** Whether any entry has a negative modified fee, in which case the modified fees of a set of
+     *  entries are not bounded from below by those of any of its subsets. */
+    bool HasNegativeModifiedFees() const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        AssertLockHeld(cs);
+        return m_negative_modified_fee_count > 0;
+    }
+
     bool exists(const GenTxid& gtxid) const
     {
         LOCK(cs);
@@ -695,7 +848,7 @@ public:
         LOCK(cs);
         // Sanity check the transaction is in the mempool & insert into
         // unbroadcast set.
-        if (exists(GenTxid::Txid(txid))) m_unbroadcast_txids.insert(txid);
+        if (exists(GenTxid::Txid(txid)) && m_unbroadcast_txids.insert(txid).second) ++m_snapshot_epoch;
     };
 
     /** Removes a transaction from the unbroadcast set */
@@ -783,8 +936,11 @@ private:
     void UpdateEntryForAncestors(txiter it, const setEntries &setAncestors) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** For each transaction being removed, update ancestors and any direct children.
       * If updateDescendants is true, then also update in-mempool descendants'
-      * ancestor state. */
-    void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs);
+      * ancestor state, and record an UPDATED delta for those that stay in the
+      * mempool. If updated_descendants is given, their txids are added to it
+      * instead, for the caller to record once it is done removing. */
+    void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants,
+                                    std::set<uint256>* updated_descendants = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -10,6 +10,7 @@
 #include <primitives/transaction.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <cassert>
 
 bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
@@ -33,15 +34,20 @@ bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
         return false;
     }
 
-    auto ret = m_orphans.emplace(wtxid, OrphanTx{{tx, peer, Now<NodeSeconds>() + ORPHAN_TX_EXPIRE_TIME}, m_orphan_list.size()});
+    const size_t usage{tx->GetTotalSize()};
+    auto ret = m_orphans.emplace(wtxid, OrphanTx{{tx, peer, Now<NodeSeconds>() + ORPHAN_TX_EXPIRE_TIME}, m_orphan_list.size(), usage});
     assert(ret.second);
     m_orphan_list.push_back(ret.first);
     for (const CTxIn& txin : tx->vin) {
-        m_outpoint_to_orphan_it[txin.prevout].insert(ret.first);
+        m_parent_to_orphan_it[txin.prevout.hash].insert(ret.first);
     }
+    PeerOrphanInfo& peer_info{m_peer_orphan_info[peer]};
+    peer_info.m_usage += usage;
+    peer_info.m_orphans_by_age.emplace(ret.first->second.nTimeExpire, wtxid);
+    m_total_usage += usage;
 
-    LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u outsz %u)\n", hash.ToString(), wtxid.ToString(), sz,
-             m_orphans.size(), m_outpoint_to_orphan_it.size());
+    LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u parentsz %u, peer=%d usage %u)\n", hash.ToString(), wtxid.ToString(), sz,
+             m_orphans.size(), m_parent_to_orphan_it.size(), peer, peer_info.m_usage);
     return true;
 }
 
@@ -52,14 +58,21 @@ int TxOrphanage::EraseTx(const Wtxid& wtxid)
         return 0;
     for (const CTxIn& txin : it->second.tx->vin)
     {
-        auto itPrev = m_outpoint_to_orphan_it.find(txin.prevout);
-        if (itPrev == m_outpoint_to_orphan_it.end())
+        auto itPrev = m_parent_to_orphan_it.find(txin.prevout.hash);
+        if (itPrev == m_parent_to_orphan_it.end())
             continue;
         itPrev->second.erase(it);
         if (itPrev->second.empty())
-            m_outpoint_to_orphan_it.erase(itPrev);
+            m_parent_to_orphan_it.erase(itPrev);
     }
 
+    const auto peer_it{m_peer_orphan_info.find(it->second.fromPeer)};
+    assert(peer_it != m_peer_orphan_info.end());
+    peer_it->second.m_usage -= it->second.usage;
+    peer_it->second.m_orphans_by_age.erase({it->second.nTimeExpire, wtxid});
+    if (peer_it->second.m_orphans_by_age.empty()) m_peer_orphan_info.erase(peer_it);
+    m_total_usage -= it->second.usage;
+
     size_t old_pos = it->second.list_pos;
     assert(m_orphan_list[old_pos] == it);
     if (old_pos + 1 != m_orphan_list.size()) {
@@ -85,14 +98,12 @@ void TxOrphanage::EraseForPeer(NodeId peer)
     m_peer_work_set.erase(peer);
 
     int nErased = 0;
-    std::map<Wtxid, OrphanTx>::iterator iter = m_orphans.begin();
-    while (iter != m_orphans.end())
-    {
-        // increment to avoid iterator becoming invalid after erasure
-        const auto& [wtxid, orphan] = *iter++;
-        if (orphan.fromPeer == peer) {
-            nErased += EraseTx(wtxid);
-        }
+    // EraseTx drops the peer's entry together with its last orphan.
+    while (true) {
+        const auto peer_it{m_peer_orphan_info.find(peer)};
+        if (peer_it == m_peer_orphan_info.end()) break;
+        const Wtxid oldest{peer_it->second.m_orphans_by_age.begin()->second};
+        nErased += EraseTx(oldest);
     }
     if (nErased > 0) LogDebug(BCLog::TXPACKAGES, "Erased %d orphan transaction(s) from peer=%d\n", nErased, peer);
 }
@@ -119,6 +130,21 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans, FastRandomContext& rng)
         m_next_sweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
         if (nErased > 0) LogDebug(BCLog::TXPACKAGES, "Erased %d orphan tx due to expiration\n", nErased);
     }
+    // Evict the oldest orphans of any peer that is over its budget. This only
+    // touches the peers responsible for the overflow.
+    for (auto peer_it = m_peer_orphan_info.begin(); peer_it != m_peer_orphan_info.end();) {
+        const NodeId peer{peer_it->first};
+        // EraseTx erases the peer's entry together with its last orphan, so advance first.
+        ++peer_it;
+        while (true) {
+            const auto it{m_peer_orphan_info.find(peer)};
+            if (it == m_peer_orphan_info.end() || it->second.m_usage <= m_max_peer_usage) break;
+            // Copy, as EraseTx removes the entry it is read from.
+            const Wtxid oldest{it->second.m_orphans_by_age.begin()->second};
+            EraseTx(oldest);
+            ++nEvicted;
+        }
+    }
     while (m_orphans.size() > max_orphans)
     {
         // Evict a random orphan:
@@ -131,19 +157,16 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans, FastRandomContext& rng)
 
 void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx)
 {
-    for (unsigned int i = 0; i < tx.vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(tx.GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& elem : it_by_prev->second) {
-                // Get this source peer's work set, emplacing an empty set if it didn't exist
-                // (note: if this peer wasn't still connected, we would have removed the orphan tx already)
-                std::set<Wtxid>& orphan_work_set = m_peer_work_set.try_emplace(elem->second.fromPeer).first->second;
-                // Add this tx to the work set
-                orphan_work_set.insert(elem->first);
-                LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
-                         tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), elem->second.fromPeer);
-            }
-        }
+    const auto it_by_parent = m_parent_to_orphan_it.find(tx.GetHash());
+    if (it_by_parent == m_parent_to_orphan_it.end()) return;
+    for (const auto& elem : it_by_parent->second) {
+        // Get this source peer's work set, emplacing an empty set if it didn't exist
+        // (note: if this peer wasn't still connected, we would have removed the orphan tx already)
+        std::set<Wtxid>& orphan_work_set = m_peer_work_set.try_emplace(elem->second.fromPeer).first->second;
+        // Add this tx to the work set
+        orphan_work_set.insert(elem->first);
+        LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
+                 tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), elem->second.fromPeer);
     }
 }
 
@@ -152,6 +175,12 @@ bool TxOrphanage::HaveTx(const Wtxid& wtxid) const
     return m_orphans.count(wtxid);
 }
 
+size_t TxOrphanage::UsageByPeer(NodeId peer) const
+{
+    const auto peer_it{m_peer_orphan_info.find(peer)};
+    return peer_it == m_peer_orphan_info.end() ? 0 : peer_it->second.m_usage;
+}
+
 CTransactionRef TxOrphanage::GetTxToReconsider(NodeId peer)
 {
     auto work_set_it = m_peer_work_set.find(peer);
@@ -189,11 +218,14 @@ void TxOrphanage::EraseForBlock(const CBlock& block)
 
         // Which orphan pool entries must we evict?
         for (const auto& txin : tx.vin) {
-            auto itByPrev = m_outpoint_to_orphan_it.find(txin.prevout);
-            if (itByPrev == m_outpoint_to_orphan_it.end()) continue;
-            for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
+            auto itByParent = m_parent_to_orphan_it.find(txin.prevout.hash);
+            if (itByParent == m_parent_to_orphan_it.end()) continue;
+            for (auto mi = itByParent->second.begin(); mi != itByParent->second.end(); ++mi) {
                 const CTransaction& orphanTx = *(*mi)->second.tx;
-                vOrphanErase.push_back(orphanTx.GetWitnessHash());
+                // Only orphans spending this very outpoint are included or conflicted.
+                const bool spends_prevout{std::any_of(orphanTx.vin.begin(), orphanTx.vin.end(),
+                                                      [&](const CTxIn& orphan_in) { return orphan_in.prevout == txin.prevout; })};
+                if (spends_prevout) vOrphanErase.push_back(orphanTx.GetWitnessHash());
             }
         }
     }
@@ -210,25 +242,22 @@ void TxOrphanage::EraseForBlock(const CBlock& block)
 
 std::vector<CTransactionRef> TxOrphanage::GetChildrenFromSamePeer(const CTransactionRef& parent, NodeId nodeid) const
 {
-    // First construct a vector of iterators to ensure we do not return duplicates of the same tx
-    // and so we can sort by nTimeExpire.
+    // First construct a vector of iterators so we can sort by nTimeExpire.
     std::vector<OrphanMap::iterator> iters;
 
-    // For each output, get all entries spending this prevout, filtering for ones from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(parent->GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& elem : it_by_prev->second) {
-                if (elem->second.fromPeer == nodeid) {
-                    iters.emplace_back(elem);
-                }
+    // Get all entries spending this parent, filtering for ones from the specified peer.
+    const auto it_by_parent = m_parent_to_orphan_it.find(parent->GetHash());
+    if (it_by_parent != m_parent_to_orphan_it.end()) {
+        for (const auto& elem : it_by_parent->second) {
+            if (elem->second.fromPeer == nodeid) {
+                iters.emplace_back(elem);
             }
         }
     }
 
-    // Sort by address so that duplicates can be deleted. At the same time, sort so that more recent
-    // orphans (which expire later) come first.  Break ties based on address, as nTimeExpire is
-    // quantified in seconds and it is possible for orphans to have the same expiry.
+    // Sort so that more recent orphans (which expire later) come first. Break ties based on
+    // address, as nTimeExpire is quantified in seconds and it is possible for orphans to have
+    // the same expiry.
     std::sort(iters.begin(), iters.end(), [](const auto& lhs, const auto& rhs) {
         if (lhs->second.nTimeExpire == rhs->second.nTimeExpire) {
             return &(*lhs) < &(*rhs);
@@ -236,8 +265,6 @@ std::vector<CTransactionRef> TxOrphanage::GetChildrenFromSamePeer(const CTransac
             return lhs->second.nTimeExpire > rhs->second.nTimeExpire;
         }
     });
-    // Erase duplicates
-    iters.erase(std::unique(iters.begin(), iters.end()), iters.end());
 
     // Convert to a vector of CTransactionRef
     std::vector<CTransactionRef> children_found;
@@ -250,25 +277,19 @@ std::vector<CTransactionRef> TxOrphanage::GetChildrenFromSamePeer(const CTransac
 
 std::vector<std::pair<CTransactionRef, NodeId>> TxOrphanage::GetChildrenFromDifferentPeer(const CTransactionRef& parent, NodeId nodeid) const
 {
-    // First construct vector of iterators to ensure we do not return duplicates of the same tx.
     std::vector<OrphanMap::iterator> iters;
 
-    // For each output, get all entries spending this prevout, filtering for ones not from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(parent->GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& elem : it_by_prev->second) {
-                if (elem->second.fromPeer != nodeid) {
-                    iters.emplace_back(elem);
-                }
+    // Get all entries spending this parent, filtering for ones not from the specified peer. The
+    // index holds each child once, ordered by wtxid.
+    const auto it_by_parent = m_parent_to_orphan_it.find(parent->GetHash());
+    if (it_by_parent != m_parent_to_orphan_it.end()) {
+        for (const auto& elem : it_by_parent->second) {
+            if (elem->second.fromPeer != nodeid) {
+                iters.emplace_back(elem);
             }
         }
     }
 
-    // Erase duplicates
-    std::sort(iters.begin(), iters.end(), IteratorComparator());
-    iters.erase(std::unique(iters.begin(), iters.end()), iters.end());
-
     // Convert iterators to pair<CTransactionRef, NodeId>
     std::vector<std::pair<CTransactionRef, NodeId>> children_found;
     children_found.reserve(iters.size());
@@ -11,22 +11,33 @@
 #include <sync.h>
 #include <util/time.h>
 
+#include <cstddef>
 #include <map>
 #include <set>
+#include <utility>
 
 /** Expiration time for orphan transactions */
 static constexpr auto ORPHAN_TX_EXPIRE_TIME{20min};
 /** Minimum time between orphan transactions expire time checks */
 static constexpr auto ORPHAN_TX_EXPIRE_INTERVAL{5min};
+/** Default for -maxorphanpeerusage, the total serialized size of the orphans a single peer may have
+ *  in the orphanage. A standard transaction's serialized size is at most its weight, so this equals
+ *  MAX_STANDARD_TX_WEIGHT: any single standard orphan fits. The -maxorphantx count cap still
+ *  bounds the orphanage as a whole. */
+static constexpr size_t DEFAULT_MAX_ORPHAN_PEER_USAGE{400'000};
 
 /** A class to track orphan transactions (failed on TX_MISSING_INPUTS)
  * Since we cannot distinguish orphans from bad transactions with
  * non-existent inputs, we heavily limit the number of orphans
- * we keep and the duration we keep them for.
+ * we keep and the duration we keep them for. Each orphan is charged to the
+ * peer that provided it, so a peer filling its budget only displaces its own
+ * orphans.
  * Not thread-safe. Requires external synchronization.
  */
 class TxOrphanage {
 public:
+    explicit TxOrphanage(size_t max_peer_usage = DEFAULT_MAX_ORPHAN_PEER_USAGE) : m_max_peer_usage{max_peer_usage} {}
+
     /** Add a new orphan transaction */
     bool AddTx(const CTransactionRef& tx, NodeId peer);
 
@@ -49,7 +60,8 @@ public:
     /** Erase all orphans included in or invalidated by a new block */
     void EraseForBlock(const CBlock& block);
 
-    /** Limit the orphanage to the given maximum */
+    /** Erase expired orphans, then the oldest orphans of every peer over its usage
+     *  budget, then random orphans until at most max_orphans remain. */
     void LimitOrphans(unsigned int max_orphans, FastRandomContext& rng);
 
     /** Add any orphans that list a particular tx as a parent into the from peer's work set */
@@ -72,6 +84,12 @@ public:
         return m_orphans.size();
     }
 
+    /** Total serialized size of the orphans provided by this peer */
+    size_t UsageByPeer(NodeId peer) const;
+
+    /** Total serialized size of all orphans */
+    size_t TotalOrphanUsage() const { return m_total_usage; }
+
     /** Allows providing orphan information externally */
     struct OrphanTxBase {
         CTransactionRef tx;
@@ -84,6 +102,8 @@ public:
 protected:
     struct OrphanTx : public OrphanTxBase {
         size_t list_pos;
+        /** Serialized size, charged to fromPeer's usage */
+        size_t usage;
     };
 
     /** Map from wtxid to orphan transaction record. Limited by
@@ -104,9 +124,26 @@ protected:
         }
     };
 
-    /** Index from the parents' COutPoint into the m_orphans. Used
-     *  to remove orphan transactions from the m_orphans */
-    std::map<COutPoint, std::set<OrphanMap::iterator, IteratorComparator>> m_outpoint_to_orphan_it;
+    /** Index from the parents' txid into the m_orphans. A parent arriving
+     *  finds all of its orphaned children with a single lookup, however
+     *  many outputs they spend. */
+    std::map<Txid, std::set<OrphanMap::iterator, IteratorComparator>> m_parent_to_orphan_it;
+
+    struct PeerOrphanInfo {
+        /** Total serialized size of this peer's orphans */
+        size_t m_usage{0};
+        /** This peer's orphans ordered by expiry time, i.e. oldest first */
+        std::set<std::pair<NodeSeconds, Wtxid>> m_orphans_by_age;
+    };
+
+    /** Usage accounting per peer that provided orphans */
+    std::map<NodeId, PeerOrphanInfo> m_peer_orphan_info;
+
+    /** Serialized size budget for each peer's orphans */
+    const size_t m_max_peer_usage;
+
+    /** Sum of the usage of all orphans */
+    size_t m_total_usage{0};
 
     /** Orphan transactions in vector for quick random eviction */
     std::vector<OrphanMap::iterator> m_orphan_list;
@@ -0,0 +1,102 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADPOOL_H
+#define BITCOIN_UTIL_THREADPOOL_H
+
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/thread.h>
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed set of worker threads running submitted tasks in submission order.
+ *
+ * Workers are named "<name>.<n>". Stop() lets the workers finish the queued
+ * tasks and joins them; it is called by the destructor.
+ */
+class ThreadPool
+{
+    const std::string m_name;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_queue GUARDED_BY(m_mutex);
+    std::vector<std::thread> m_workers GUARDED_BY(m_mutex);
+    bool m_stopping GUARDED_BY(m_mutex){false};
+
+    void Worker() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                task = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::string name) : m_name{std::move(name)} {}
+    ~ThreadPool() { Stop(); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Start(int num_workers) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        assert(m_workers.empty());
+        m_stopping = false;
+        for (int i{0}; i < num_workers; ++i) {
+            m_workers.emplace_back(&util::TraceThread, strprintf("%s.%d", m_name, i), [this] { Worker(); });
+        }
+    }
+
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::vector<std::thread> workers;
+        {
+            LOCK(m_mutex);
+            m_stopping = true;
+            workers.swap(m_workers);
+        }
+        m_cv.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    size_t WorkersCount() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) { return WITH_LOCK(m_mutex, return m_workers.size()); }
+
+    /** Queue fn and return a future for its result. Must only be called while the pool is started. */
+    template <typename F>
+    auto Submit(F&& fn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        using R = std::invoke_result_t<F>;
+        auto task{std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn))};
+        auto future{task->get_future()};
+        {
+            LOCK(m_mutex);
+            assert(!m_workers.empty());
+            m_queue.emplace_back([task] { (*task)(); });
+        }
+        m_cv.notify_one();
+        return future;
+    }
+};
+
+#endif // BITCOIN_UTIL_THREADPOOL_H
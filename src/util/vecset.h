@@ -0,0 +1,80 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_VECSET_H
+#define BITCOIN_UTIL_VECSET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/** Data structure mimicking the parts of std::set that small sets need, stored as a sorted vector.
+ *
+ * - One allocation for the whole set instead of one per element, and contiguous iteration.
+ * - Lookups are O(log n), insert() and erase() are O(n). Meant for sets that are
+ *   usually small, such as the in-mempool parents and children of a transaction
+ *   (bounded by the ancestor/descendant limits). See bench/vecset.cpp for how it
+ *   compares to std::set as the set grows.
+ * - Like std::set, elements are immutable; only const iterators are exposed.
+ * - Iterators are invalidated by insert() and erase().
+ */
+template <typename T, typename Compare = std::less<T>>
+class VecSet
+{
+    std::vector<T> m_data;
+    [[no_unique_address]] Compare m_comp;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using const_iterator = typename std::vector<T>::const_iterator;
+    using iterator = const_iterator;
+
+    VecSet() = default;
+    template <typename InputIt>
+    VecSet(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first) insert(*first);
+    }
+
+    const_iterator begin() const noexcept { return m_data.begin(); }
+    const_iterator end() const noexcept { return m_data.end(); }
+    const_iterator cbegin() const noexcept { return m_data.cbegin(); }
+    const_iterator cend() const noexcept { return m_data.cend(); }
+    size_t size() const noexcept { return m_data.size(); }
+    bool empty() const noexcept { return m_data.empty(); }
+    size_t capacity() const noexcept { return m_data.capacity(); }
+    void clear() noexcept { m_data.clear(); }
+
+    const_iterator lower_bound(const T& value) const { return std::lower_bound(m_data.begin(), m_data.end(), value, m_comp); }
+
+    const_iterator find(const T& value) const
+    {
+        const auto it{lower_bound(value)};
+        return it != end() && !m_comp(value, *it) ? it : end();
+    }
+
+    size_t count(const T& value) const { return find(value) != end(); }
+
+    std::pair<const_iterator, bool> insert(const T& value)
+    {
+        const auto it{lower_bound(value)};
+        if (it != end() && !m_comp(value, *it)) return {it, false};
+        return {m_data.insert(it, value), true};
+    }
+
+    const_iterator erase(const_iterator it) { return m_data.erase(it); }
+
+    size_t erase(const T& value)
+    {
+        const auto it{find(value)};
+        if (it == end()) return 0;
+        m_data.erase(it);
+        return 1;
+    }
+};
+
+#endif // BITCOIN_UTIL_VECSET_H
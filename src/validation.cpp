@@ -67,12 +67,14 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <numeric>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 
 using kernel::CCoinsStats;
@@ -93,6 +95,10 @@ static constexpr std::chrono::hours DATABASE_WRITE_INTERVAL{1};
 static constexpr std::chrono::hours DATABASE_FLUSH_INTERVAL{24};
 /** Maximum age of our tip for us to be considered current for fee estimation */
 static constexpr std::chrono::hours MAX_FEE_ESTIMATION_TIP_AGE{3};
+/** Minimum number of inputs (of a transaction, or of a package taken together)
+ *  for mempool acceptance to spread its policy script checks over the script
+ *  check threads. Below this the hand-off costs more than it saves. */
+static constexpr size_t MEMPOOL_PARALLEL_SCRIPT_CHECK_MIN_INPUTS{16};
 const std::vector<std::string> CHECKLEVEL_DOC {
     "level 0 reads the blocks from disk",
     "level 1 verifies block validity",
@@ -654,6 +660,8 @@ private:
         /** A temporary cache containing serialized transaction data for signature verification.
          * Reused across PolicyScriptChecks and ConsensusScriptChecks. */
         PrecomputedTransactionData m_precomputed_txdata;
+        /** Whether ParallelPolicyScriptChecks() already verified all input scripts with our policy flags. */
+        bool m_policy_scripts_checked{false};
     };
 
     // Run the policy checks on a given transaction, excluding any script checks.
@@ -676,6 +684,13 @@ private:
     // only invoke this on transactions that have otherwise passed policy checks.
     bool PolicyScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // If the transactions have enough inputs between them, run their policy script
+    // checks on the script check threads (the queue ConnectBlock uses) ahead of
+    // PolicyScriptChecks(). On success PolicyScriptChecks() has nothing left to
+    // do; on failure it re-checks serially to find and report the failing input,
+    // mostly hitting the signature cache for the inputs that did pass.
+    void ParallelPolicyScriptChecks(std::span<Workspace> workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
@@ -1096,6 +1111,24 @@ bool MemPoolAccept::ReplacementChecks(Workspace& ws)
                              strprintf("insufficient fee%s", ws.m_sibling_eviction ? " (including sibling eviction)" : ""), *err_string);
     }
 
+    // Enforce Rule #5 from the cached descendant counts, before the fee pre-check below.
+    if (const auto err_string{CheckReplacementCandidates(m_pool, ws.m_iters_conflicting, hash)}) {
+        return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY,
+                             strprintf("too many potential replacements%s", ws.m_sibling_eviction ? " (including sibling eviction)" : ""), *err_string);
+    }
+
+    // Reject replacements that cannot pay for Rules #3 and #4 before walking the descendants
+    // of the conflicts, using their cached descendant fees. Rule #2 is reported first, as it
+    // is without this shortcut. A replacement that passes it against the direct conflicts also
+    // passes it against all of them; otherwise the full checks below decide.
+    if (const auto err_string{PaysForRBFLowerBound(m_pool, ws.m_iters_conflicting, ws.m_modified_fees, ws.m_vsize,
+                                                   m_pool.m_opts.incremental_relay_feerate, hash)}) {
+        if (!HasNoNewUnconfirmed(tx, m_pool, ws.m_iters_conflicting)) {
+            return state.Invalid(TxValidationResult::TX_RECONSIDERABLE,
+                                 strprintf("insufficient fee%s", ws.m_sibling_eviction ? " (including sibling eviction)" : ""), *err_string);
+        }
+    }
+
     // Calculate all conflicting entries and enforce Rule #5.
     if (const auto err_string{GetEntriesForConflicts(tx, m_pool, ws.m_iters_conflicting, m_subpackage.m_all_conflicts)}) {
         return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY,
@@ -1229,6 +1262,8 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
 
     constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
 
+    if (ws.m_policy_scripts_checked) return true;
+
     // Check input scripts and signatures.
     // This is done last to help prevent CPU exhaustion denial-of-service attacks.
     if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false, ws.m_precomputed_txdata, GetValidationCache())) {
@@ -1248,6 +1283,34 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
     return true;
 }
 
+void MemPoolAccept::ParallelPolicyScriptChecks(std::span<Workspace> workspaces)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    CCheckQueue<CScriptCheck>& queue{m_active_chainstate.m_chainman.GetCheckQueue()};
+    if (!queue.HasThreads()) return;
+    const size_t total_inputs{std::accumulate(workspaces.begin(), workspaces.end(), size_t{0},
+        [](size_t sum, const Workspace& ws) { return sum + ws.m_ptx->vin.size(); })};
+    if (total_inputs < MEMPOOL_PARALLEL_SCRIPT_CHECK_MIN_INPUTS) return;
+
+    std::vector<CScriptCheck> checks;
+    checks.reserve(total_inputs);
+    for (Workspace& ws : workspaces) {
+        // Only collects the checks (or finds the whole transaction in the
+        // script execution cache), so the state is not used.
+        TxValidationState state_dummy;
+        CheckInputScripts(*ws.m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheSigStore=*/true,
+                          /*cacheFullScriptStore=*/false, ws.m_precomputed_txdata, GetValidationCache(), &checks);
+    }
+
+    LogDebug(BCLog::VALIDATION, "Verifying %u mempool input scripts on %u script check threads\n", checks.size(), queue.WorkerThreadCount());
+    CCheckQueueControl<CScriptCheck> control(&queue);
+    control.Add(std::move(checks));
+    if (!control.Wait()) return;
+    for (Workspace& ws : workspaces) ws.m_policy_scripts_checked = true;
+}
+
 bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
 {
     AssertLockHeld(cs_main);
@@ -1457,6 +1520,7 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     // Perform the inexpensive checks first and avoid hashing and signature verification unless
     // those checks pass, to mitigate CPU exhaustion denial-of-service attacks.
+    ParallelPolicyScriptChecks(std::span{&ws, 1});
     if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
     if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
@@ -1585,6 +1649,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         return PackageMempoolAcceptResult(package_state, std::move(results));
     }
 
+    ParallelPolicyScriptChecks(workspaces);
     for (Workspace& ws : workspaces) {
         ws.m_package_feerate = package_feerate;
         if (!PolicyScriptChecks(args, ws)) {
@@ -2090,7 +2155,7 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *m_signature_cache, *txdata), &error);
 }
 
-ValidationCache::ValidationCache(const size_t script_execution_cache_bytes, const size_t signature_cache_bytes)
+ValidationCache::ValidationCache(const size_t script_execution_cache_bytes, const size_t input_script_execution_cache_bytes, const size_t signature_cache_bytes)
     : m_signature_cache{signature_cache_bytes}
 {
     // Setup the salted hasher
@@ -2101,9 +2166,33 @@ ValidationCache::ValidationCache(const size_t script_execution_cache_bytes, cons
     m_script_execution_cache_hasher.Write(nonce.begin(), 32);
     m_script_execution_cache_hasher.Write(nonce.begin(), 32);
 
+    const uint256 input_nonce{GetRandHash()};
+    m_input_script_cache_hasher.Write(input_nonce.begin(), 32);
+    m_input_script_cache_hasher.Write(input_nonce.begin(), 32);
+
     const auto [num_elems, approx_size_bytes] = m_script_execution_cache.setup_bytes(script_execution_cache_bytes);
     LogPrintf("Using %zu MiB out of %zu MiB requested for script execution cache, able to store %zu elements\n",
               approx_size_bytes >> 20, script_execution_cache_bytes >> 20, num_elems);
+
+    const auto [num_input_elems, approx_input_size_bytes] = m_input_script_execution_cache.setup_bytes(input_script_execution_cache_bytes);
+    LogPrintf("Using %zu MiB out of %zu MiB requested for per-input script execution cache, able to store %zu elements\n",
+              approx_input_size_bytes >> 20, input_script_execution_cache_bytes >> 20, num_input_elems);
+}
+
+uint256 ValidationCache::InputScriptCacheEntry(const CTransaction& tx, uint32_t n_in, unsigned int flags) const
+{
+    uint256 entry;
+    CSHA256 hasher{m_input_script_cache_hasher};
+    hasher.Write(UCharCast(tx.GetHash().begin()), 32).Write((unsigned char*)&n_in, sizeof(n_in)).Write((unsigned char*)&flags, sizeof(flags));
+    const auto& stack{tx.vin[n_in].scriptWitness.stack};
+    const uint64_t stack_size{stack.size()};
+    hasher.Write((unsigned char*)&stack_size, sizeof(stack_size));
+    for (const auto& item : stack) {
+        const uint64_t item_size{item.size()};
+        hasher.Write((unsigned char*)&item_size, sizeof(item_size)).Write(item.data(), item.size());
+    }
+    hasher.Finalize(entry.begin());
+    return entry;
 }
 
 /**
@@ -2120,6 +2209,10 @@ ValidationCache::ValidationCache(const size_t script_execution_cache_bytes, cons
  * which are matched. This is useful for checking blocks where we will likely never need the cache
  * entry again.
  *
+ * On a whole-transaction miss, inputs are looked up individually, so a transaction that differs from
+ * a validated one only in some inputs' witnesses re-verifies just those inputs. Per-input entries are
+ * stored in their own cache when the whole-transaction entry is, under the same flags.
+ *
  * Note that we may set state.reason to NOT_STANDARD for extra soft-fork flags in flags, block-checking
  * callers should probably reset it to CONSENSUS in such cases.
  *
@@ -2147,6 +2240,7 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     hasher.Write(UCharCast(tx.GetWitnessHash().begin()), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
     AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
     if (validation_cache.m_script_execution_cache.contains(hashCacheEntry, !cacheFullScriptStore)) {
+        ++validation_cache.m_script_cache_tx_hits;
         return true;
     }
 
@@ -2164,7 +2258,15 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     }
     assert(txdata.m_spent_outputs.size() == tx.vin.size());
 
+    std::vector<uint256> input_cache_entries(tx.vin.size());
+    std::vector<bool> input_cached(tx.vin.size(), false);
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        input_cache_entries[i] = validation_cache.InputScriptCacheEntry(tx, i, flags);
+        if (validation_cache.m_input_script_execution_cache.contains(input_cache_entries[i], !cacheFullScriptStore)) {
+            ++validation_cache.m_script_cache_input_hits;
+            input_cached[i] = true;
+            continue;
+        }
 
         // We very carefully only pass in things to CScriptCheck which
         // are clearly committed to by tx' witness hash. This provides
@@ -2218,6 +2320,9 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
         // We executed all of the provided scripts, and were told to
         // cache the result. Do so now.
         validation_cache.m_script_execution_cache.insert(hashCacheEntry);
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            if (!input_cached[i]) validation_cache.m_input_script_execution_cache.insert(input_cache_entries[i]);
+        }
     }
 
     return true;
@@ -2614,6 +2719,8 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int nInputs = 0;
     int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
+    const uint64_t script_cache_tx_hits_start{m_chainman.m_validation_cache.m_script_cache_tx_hits};
+    const uint64_t script_cache_input_hits_start{m_chainman.m_validation_cache.m_script_cache_input_hits};
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
@@ -2690,6 +2797,12 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_3 - time_2) / (nInputs - 1),
              Ticks<SecondsDouble>(m_chainman.time_connect),
              Ticks<MillisecondsDouble>(m_chainman.time_connect) / m_chainman.num_blocks_total);
+    if (fScriptChecks) {
+        // Transactions and inputs whose scripts were already validated, typically on mempool acceptance.
+        LogDebug(BCLog::BENCH, "      - Script cache hits: %u/%u txs, plus %u txins of other txs\n",
+                 m_chainman.m_validation_cache.m_script_cache_tx_hits - script_cache_tx_hits_start, (unsigned)block.vtx.size() - 1,
+                 m_chainman.m_validation_cache.m_script_cache_input_hits - script_cache_input_hits_start);
+    }
 
     CAmount blockReward = nFees + GetBlockSubsidy(pindex->nHeight, params.GetConsensus());
     if (block.vtx[0]->GetValueOut() > blockReward) {
@@ -5021,6 +5134,106 @@ bool Chainstate::LoadGenesisBlock()
     return true;
 }
 
+bool ChainstateManager::ImportBlock(
+    const uint256& hash,
+    const uint256& prev_hash,
+    const FlatFilePos* dbp,
+    std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent,
+    const std::function<std::shared_ptr<const CBlock>()>& read_block,
+    int& loaded)
+{
+    const CChainParams& params{GetParams()};
+
+    std::shared_ptr<const CBlock> pblock{}; // needs to remain available after the cs_main lock is released to avoid duplicate reads from disk
+
+    {
+        LOCK(cs_main);
+        // detect out of order blocks, and store them for later
+        if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(prev_hash)) {
+            LogDebug(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                     prev_hash.ToString());
+            if (dbp && blocks_with_unknown_parent) {
+                blocks_with_unknown_parent->emplace(prev_hash, *dbp);
+            }
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
+        if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+            pblock = read_block();
+
+            BlockValidationState state;
+            if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
+                loaded++;
+            }
+            if (state.IsError()) {
+                return false;
+            }
+        } else if (hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+            LogDebug(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+        }
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == params.GetConsensus().hashGenesisBlock) {
+        for (auto c : GetAll()) {
+            BlockValidationState state;
+            if (!c->ActivateBestChain(state, nullptr)) {
+                return false;
+            }
+        }
+    }
+
+    if (m_blockman.IsPruneMode() && m_blockman.m_blockfiles_indexed && pblock) {
+        // must update the tip for pruning to work while importing with -loadblock.
+        // this is a tradeoff to conserve disk space at the expense of time
+        // spent updating the tip to be able to prune.
+        // otherwise, ActivateBestChain won't be called by the import process
+        // until after all of the block files are loaded. ActivateBestChain can be
+        // called by concurrent network message processing. but, that is not
+        // reliable for the purpose of pruning while importing.
+        for (auto c : GetAll()) {
+            BlockValidationState state;
+            if (!c->ActivateBestChain(state, pblock)) {
+                LogDebug(BCLog::REINDEX, "failed to activate chain (%s)\n", state.ToString());
+                return false;
+            }
+        }
+    }
+
+    NotifyHeaderTip();
+
+    if (!blocks_with_unknown_parent) return true;
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        auto range = blocks_with_unknown_parent->equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second)) {
+                LogDebug(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                BlockValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
+                    loaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            blocks_with_unknown_parent->erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
+
 void ChainstateManager::LoadExternalBlockFile(
     AutoFile& file_in,
     FlatFilePos* dbp,
@@ -5077,106 +5290,16 @@ void ChainstateManager::LoadExternalBlockFile(
                 nRewind = nBlockPos + nSize;
                 blkdat.SkipTo(nRewind);
 
-                std::shared_ptr<CBlock> pblock{}; // needs to remain available after the cs_main lock is released to avoid duplicate reads from disk
-
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(header.hashPrevBlock)) {
-                        LogDebug(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                 header.hashPrevBlock.ToString());
-                        if (dbp && blocks_with_unknown_parent) {
-                            blocks_with_unknown_parent->emplace(header.hashPrevBlock, *dbp);
-                        }
-                        continue;
-                    }
-
-                    // process in case the block isn't known yet
-                    const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                        // This block can be processed immediately; rewind to its start, read and deserialize it.
-                        blkdat.SetPos(nBlockPos);
-                        pblock = std::make_shared<CBlock>();
-                        blkdat >> TX_WITH_WITNESS(*pblock);
-                        nRewind = blkdat.GetPos();
-
-                        BlockValidationState state;
-                        if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
-                            nLoaded++;
-                        }
-                        if (state.IsError()) {
-                            break;
-                        }
-                    } else if (hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                        LogDebug(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
-                }
-
-                // Activate the genesis block so normal node progress can continue
-                if (hash == params.GetConsensus().hashGenesisBlock) {
-                    bool genesis_activation_failure = false;
-                    for (auto c : GetAll()) {
-                        BlockValidationState state;
-                        if (!c->ActivateBestChain(state, nullptr)) {
-                            genesis_activation_failure = true;
-                            break;
-                        }
-                    }
-                    if (genesis_activation_failure) {
-                        break;
-                    }
-                }
-
-                if (m_blockman.IsPruneMode() && m_blockman.m_blockfiles_indexed && pblock) {
-                    // must update the tip for pruning to work while importing with -loadblock.
-                    // this is a tradeoff to conserve disk space at the expense of time
-                    // spent updating the tip to be able to prune.
-                    // otherwise, ActivateBestChain won't be called by the import process
-                    // until after all of the block files are loaded. ActivateBestChain can be
-                    // called by concurrent network message processing. but, that is not
-                    // reliable for the purpose of pruning while importing.
-                    bool activation_failure = false;
-                    for (auto c : GetAll()) {
-                        BlockValidationState state;
-                        if (!c->ActivateBestChain(state, pblock)) {
-                            LogDebug(BCLog::REINDEX, "failed to activate chain (%s)\n", state.ToString());
-                            activation_failure = true;
-                            break;
-                        }
-                    }
-                    if (activation_failure) {
-                        break;
-                    }
-                }
-
-                NotifyHeaderTip();
-
-                if (!blocks_with_unknown_parent) continue;
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    auto range = blocks_with_unknown_parent->equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second)) {
-                            LogDebug(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        blocks_with_unknown_parent->erase(it);
-                        NotifyHeaderTip();
-                    }
+                const auto read_block{[&] {
+                    // This block can be processed immediately; rewind to its start, read and deserialize it.
+                    blkdat.SetPos(nBlockPos);
+                    auto pblock{std::make_shared<CBlock>()};
+                    blkdat >> TX_WITH_WITNESS(*pblock);
+                    nRewind = blkdat.GetPos();
+                    return std::shared_ptr<const CBlock>{std::move(pblock)};
+                }};
+                if (!ImportBlock(hash, header.hashPrevBlock, dbp, blocks_with_unknown_parent, read_block, nLoaded)) {
+                    break;
                 }
             } catch (const std::exception& e) {
                 // historical bugs added extra data to the block files that does not deserialize cleanly.
@@ -5199,6 +5322,73 @@ void ChainstateManager::LoadExternalBlockFile(
     LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
 }
 
+void ChainstateManager::LoadBlockFileEntries(
+    std::span<const node::BlockFileEntry> entries,
+    std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent)
+{
+    const auto start{SteadyClock::now()};
+    const uint256& genesis_hash{GetParams().GetConsensus().hashGenesisBlock};
+
+    // Blocks are read and deserialized on the read threads ahead of the one being
+    // loaded. Blocks that will wait for their parent are left for the out of order
+    // processing to read: their parent is neither indexed nor earlier in the file.
+    const size_t read_ahead_window{std::max<size_t>(1, 2 * m_blockman.BlockReadThreads())};
+    std::vector<std::future<std::shared_ptr<const CBlock>>> reads(entries.size());
+    std::unordered_set<uint256, BlockHasher> seen;
+    size_t next_read{0};
+
+    int nLoaded = 0;
+    try {
+        for (size_t i{0}; i < entries.size(); ++i) {
+            if (m_interrupt) return;
+
+            if (next_read <= i + read_ahead_window / 2) {
+                std::vector<node::BlockFileEntry> batch;
+                std::vector<size_t> batch_indices;
+                {
+                    LOCK(cs_main);
+                    for (; next_read < std::min(entries.size(), i + read_ahead_window); ++next_read) {
+                        const node::BlockFileEntry& entry{entries[next_read]};
+                        if (entry.hash == genesis_hash || seen.contains(entry.prev_hash) || m_blockman.LookupBlockIndex(entry.prev_hash)) {
+                            batch.push_back(entry);
+                            batch_indices.push_back(next_read);
+                        }
+                        seen.insert(entry.hash);
+                    }
+                }
+                auto futures{m_blockman.ReadBlocksAsync(batch)};
+                for (size_t j{0}; j < futures.size(); ++j) reads[batch_indices[j]] = std::move(futures[j]);
+            }
+
+            const node::BlockFileEntry& entry{entries[i]};
+            const auto read_block{[&] {
+                std::shared_ptr<const CBlock> pblock;
+                if (reads[i].valid()) {
+                    pblock = reads[i].get();
+                } else {
+                    auto block{std::make_shared<CBlock>()};
+                    if (m_blockman.ReadBlockFromDisk(*block, entry.pos) && block->GetHash() == entry.hash) pblock = std::move(block);
+                }
+                if (!pblock) throw std::runtime_error{"failed to read block"};
+                return pblock;
+            }};
+            try {
+                if (!ImportBlock(entry.hash, entry.prev_hash, &entry.pos, &blocks_with_unknown_parent, read_block, nLoaded)) {
+                    break;
+                }
+            } catch (const std::exception& e) {
+                // Data that looks like a block header but not like a block is skipped, as
+                // LoadExternalBlockFile() does.
+                LogDebug(BCLog::REINDEX, "%s: unexpected data at %s - %s. continuing\n", __func__, entry.pos.ToString(), e.what());
+            }
+            reads[i] = {};
+        }
+    } catch (const std::runtime_error& e) {
+        GetNotifications().fatalError(strprintf(_("System error while loading external block file: %s"), e.what()));
+    }
+    LogPrintf("Loaded %i blocks from block file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+}
+
 bool ChainstateManager::ShouldCheckBlockIndex() const
 {
     // Assert to verify Flatten() has been called.
@@ -6254,7 +6444,7 @@ ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Opt
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)},
-      m_validation_cache{m_options.script_execution_cache_bytes, m_options.signature_cache_bytes}
+      m_validation_cache{m_options.script_execution_cache_bytes, m_options.input_script_execution_cache_bytes, m_options.signature_cache_bytes}
 {
 }
 
@@ -6503,9 +6693,10 @@ std::pair<int, int> ChainstateManager::GetPruneRange(const Chainstate& chainstat
     }
 
     int max_prune = std::max<int>(
-        0, chainstate.m_chain.Height() - static_cast<int>(MIN_BLOCKS_TO_KEEP));
+        0, chainstate.m_chain.Height() - m_blockman.MinBlocksToKeep());
 
-    // last block to prune is the lesser of (caller-specified height, MIN_BLOCKS_TO_KEEP from the tip)
+    // last block to prune is the lesser of (caller-specified height, MIN_BLOCKS_TO_KEEP
+    // or -prunekeeprecent from the tip)
     //
     // While you might be tempted to prune the background chainstate more
     // aggressively (i.e. fewer MIN_BLOCKS_TO_KEEP), this won't work with index
@@ -35,6 +35,7 @@
 #include <versionbits.h>
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -367,18 +368,33 @@ class ValidationCache
 private:
     //! Pre-initialized hasher to avoid having to recreate it for every hash calculation.
     CSHA256 m_script_execution_cache_hasher;
+    //! Same for the per-input entries, salted differently so they cannot collide with
+    //! whole-transaction entries.
+    CSHA256 m_input_script_cache_hasher;
 
 public:
     CuckooCache::cache<uint256, SignatureCacheHasher> m_script_execution_cache;
+    //! Per-input entries, see CheckInputScripts(). Kept separate so that they do not
+    //! compete with whole-transaction entries for space.
+    CuckooCache::cache<uint256, SignatureCacheHasher> m_input_script_execution_cache;
     SignatureCache m_signature_cache;
 
-    ValidationCache(size_t script_execution_cache_bytes, size_t signature_cache_bytes);
+    //! Number of script execution cache hits on whole transactions and on individual
+    //! inputs (the latter only counted when the whole transaction missed).
+    uint64_t m_script_cache_tx_hits GUARDED_BY(::cs_main){0};
+    uint64_t m_script_cache_input_hits GUARDED_BY(::cs_main){0};
+
+    ValidationCache(size_t script_execution_cache_bytes, size_t input_script_execution_cache_bytes, size_t signature_cache_bytes);
 
     ValidationCache(const ValidationCache&) = delete;
     ValidationCache& operator=(const ValidationCache&) = delete;
 
     //! Return a copy of the pre-initialized hasher.
     CSHA256 ScriptExecutionCacheHasher() const { return m_script_execution_cache_hasher; }
+
+    /** Script execution cache key for a single input: the txid commits to every prevout
+     * and scriptSig, and no other input's witness affects this input's result. */
+    uint256 InputScriptCacheEntry(const CTransaction& tx, uint32_t n_in, unsigned int flags) const;
 };
 
 /** Functions for validating blocks and updating the block tree */
@@ -918,6 +934,20 @@ private:
         AutoFile& coins_file,
         const node::SnapshotMetadata& metadata);
 
+    /**
+     * Process one block found by LoadExternalBlockFile() or LoadBlockFileEntries(), given
+     * its hash and parent. If the parent is not known yet, the block is added to
+     * blocks_with_unknown_parent, when given, for when the parent is processed. read_block
+     * is only called if the block is not stored yet. Returns false if the import must stop.
+     */
+    bool ImportBlock(
+        const uint256& hash,
+        const uint256& prev_hash,
+        const FlatFilePos* dbp,
+        std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent,
+        const std::function<std::shared_ptr<const CBlock>()>& read_block,
+        int& loaded) LOCKS_EXCLUDED(::cs_main);
+
     /**
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to m_block_index.
@@ -1179,6 +1209,16 @@ public:
         FlatFilePos* dbp = nullptr,
         std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent = nullptr);
 
+    /**
+     * Import the blocks of one block file during reindexing, as found by
+     * BlockManager::ScanBlockFilesAsync(), in file order. This is LoadExternalBlockFile()
+     * for a file whose headers were already scanned: blocks are read and deserialized
+     * ahead on the block read threads while earlier blocks are being processed.
+     */
+    void LoadBlockFileEntries(
+        std::span<const node::BlockFileEntry> entries,
+        std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent);
+
     /**
      * Process an incoming block. This only returns after the best known valid
      * block is made active. Note that it does not, however, guarantee that the
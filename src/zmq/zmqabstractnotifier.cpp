@@ -42,3 +42,13 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyMempoolDelta(const MempoolDelta& /*delta*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyMempoolDeltasLost(uint64_t /*next_delta_sequence*/)
+{
+    return true;
+}
@@ -13,6 +13,7 @@
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
+struct MempoolDelta;
 
 using CZMQNotifierFactory = std::function<std::unique_ptr<CZMQAbstractNotifier>()>;
 
@@ -56,6 +57,10 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of every mempool addition and removal, in delta journal order
+    virtual bool NotifyMempoolDelta(const MempoolDelta& delta);
+    // Notifies that mempool changes were dropped from the delta journal before being published
+    virtual bool NotifyMempoolDeltasLost(uint64_t next_delta_sequence);
 
 protected:
     void* psocket{nullptr};
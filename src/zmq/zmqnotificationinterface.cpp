@@ -11,6 +11,7 @@
 #include <netbase.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <txmempool.h>
 #include <validationinterface.h>
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqpublishnotifier.h>
@@ -18,6 +19,7 @@
 
 #include <zmq.h>
 
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <string>
@@ -40,7 +42,8 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
-std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index)
+std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index,
+                                                                              std::function<const CTxMemPool*()> get_mempool)
 {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
@@ -50,6 +53,7 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std
     };
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubmempooldelta"] = CZMQAbstractNotifier::Create<CZMQPublishMempoolDeltaNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -73,6 +77,9 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std
     if (!notifiers.empty())
     {
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(new CZMQNotificationInterface());
+        if (std::any_of(notifiers.begin(), notifiers.end(), [](const auto& n) { return n->GetType() == "pubmempooldelta"; })) {
+            notificationInterface->m_get_mempool = std::move(get_mempool);
+        }
         notificationInterface->notifiers = std::move(notifiers);
 
         if (notificationInterface->Initialize()) {
@@ -164,6 +171,7 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const NewMempoolTransa
     TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyTransaction(tx) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
     });
+    PublishMempoolDeltas();
 }
 
 void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
@@ -174,6 +182,7 @@ void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransaction
     TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyTransactionRemoval(tx, mempool_sequence);
     });
+    PublishMempoolDeltas();
 }
 
 void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected)
@@ -192,6 +201,8 @@ void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::s
     TryForEachAndRemoveFailed(notifiers, [pindexConnected](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyBlockConnect(pindexConnected);
     });
+    // Transactions removed for the block are only reported through the delta journal
+    PublishMempoolDeltas();
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
@@ -209,4 +220,29 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     });
 }
 
+void CZMQNotificationInterface::PublishMempoolDeltas()
+{
+    if (!m_get_mempool) return;
+    const CTxMemPool* mempool{m_get_mempool()};
+    if (!mempool) return;
+    while (true) {
+        const auto deltas{mempool->GetDeltas(m_next_mempool_delta, /*max_count=*/1000)};
+        if (!deltas) {
+            // Fell behind the journal; subscribers have to resync, e.g. through REST.
+            m_next_mempool_delta = mempool->GetNextDeltaSequence();
+            TryForEachAndRemoveFailed(notifiers, [this](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyMempoolDeltasLost(m_next_mempool_delta);
+            });
+            continue;
+        }
+        if (deltas->empty()) return;
+        for (const MempoolDelta& delta : *deltas) {
+            TryForEachAndRemoveFailed(notifiers, [&delta](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyMempoolDelta(delta);
+            });
+        }
+        m_next_mempool_delta += deltas->size();
+    }
+}
+
 std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
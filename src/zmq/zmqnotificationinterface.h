@@ -16,6 +16,7 @@
 
 class CBlock;
 class CBlockIndex;
+class CTxMemPool;
 class CZMQAbstractNotifier;
 struct NewMempoolTransactionInfo;
 
@@ -26,7 +27,8 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
-    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index);
+    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index,
+                                                             std::function<const CTxMemPool*()> get_mempool);
 
 protected:
     bool Initialize();
@@ -42,8 +44,16 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    /** Publish the mempool changes recorded in the delta journal since the previous call. */
+    void PublishMempoolDeltas();
+
     void* pcontext{nullptr};
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+
+    //! Only set if a mempooldelta notifier is configured
+    std::function<const CTxMemPool*()> m_get_mempool;
+    //! Delta sequence of the next mempool change to publish
+    uint64_t m_next_mempool_delta{1};
 };
 
 extern std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
@@ -18,6 +18,7 @@
 #include <serialize.h>
 #include <streams.h>
 #include <sync.h>
+#include <txmempool.h>
 #include <uint256.h>
 #include <zmq/zmqutil.h>
 
@@ -45,6 +46,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_MEMPOOLDELTA = "mempooldelta";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -301,3 +303,50 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogDebug(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+static char MempoolDeltaLabel(MempoolDelta::Type type)
+{
+    switch (type) {
+    case MempoolDelta::Type::ADDED: return /* Mempool (A)ddition */ 'A';
+    case MempoolDelta::Type::REMOVED: return /* Mempool (R)emoval */ 'R';
+    case MempoolDelta::Type::UPDATED: return /* Mempool entry (U)pdate */ 'U';
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+bool CZMQPublishMempoolDeltaNotifier::NotifyMempoolDelta(const MempoolDelta& delta)
+{
+    const char label{MempoolDeltaLabel(delta.type)};
+    LogDebug(BCLog::ZMQ, "Publish mempooldelta %c %s to %s\n", label, delta.txid.GetHex(), this->address);
+    unsigned char data[8 + 1 + 32 + 8 + 8 + 4 + 8 + 8 + 8];
+    unsigned char* p{data};
+    WriteLE64(p, delta.sequence);
+    p += 8;
+    *p++ = label;
+    const uint256& hash{delta.txid.ToUint256()};
+    for (unsigned int i = 0; i < 32; ++i) {
+        p[31 - i] = hash.begin()[i];
+    }
+    p += 32;
+    WriteLE64(p, delta.fee);
+    p += 8;
+    WriteLE64(p, delta.modified_fee);
+    p += 8;
+    WriteLE32(p, delta.vsize);
+    p += 4;
+    WriteLE64(p, delta.count_with_ancestors);
+    p += 8;
+    WriteLE64(p, delta.size_with_ancestors);
+    p += 8;
+    WriteLE64(p, delta.mod_fees_with_ancestors);
+    return SendZmqMessage(MSG_MEMPOOLDELTA, data, sizeof(data));
+}
+
+bool CZMQPublishMempoolDeltaNotifier::NotifyMempoolDeltasLost(uint64_t next_delta_sequence)
+{
+    LogDebug(BCLog::ZMQ, "Publish mempooldelta lost, continuing at %d, to %s\n", next_delta_sequence, this->address);
+    unsigned char data[8 + 1];
+    WriteLE64(data, next_delta_sequence);
+    data[8] = /* Deltas (L)ost */ 'L';
+    return SendZmqMessage(MSG_MEMPOOLDELTA, data, sizeof(data));
+}
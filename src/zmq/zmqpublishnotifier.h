@@ -72,4 +72,11 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+class CZMQPublishMempoolDeltaNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyMempoolDelta(const MempoolDelta& delta) override;
+    bool NotifyMempoolDeltasLost(uint64_t next_delta_sequence) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Copyright (c) The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test loading the block index from a flat snapshot (`-blockindexsnapshot` option)."""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class BlockIndexSnapshotTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [['-blockindexsnapshot']]
+
+    def run_test(self):
+        node = self.nodes[0]
+        snapshot_path = node.blocks_path / "blockindex.dat"
+
+        self.log.info("The snapshot is written at shutdown")
+        self.generate(node, 10)
+        best_block = node.getbestblockhash()
+        num_entries = node.getblockcount() + 1
+        self.stop_node(0)
+        assert snapshot_path.exists()
+
+        self.log.info("The next startup loads the block index from the snapshot and checks it against the database")
+        with node.assert_debug_log(expected_msgs=[
+            f"Loaded {num_entries} block index entries from",
+            "Block index snapshot matches the block index database",
+        ], timeout=10):
+            self.start_node(0)
+        assert_equal(node.getbestblockhash(), best_block)
+
+        self.log.info("A snapshot older than the database is not used")
+        self.restart_node(0, extra_args=[])
+        self.generate(node, 5)
+        best_block = node.getbestblockhash()
+        self.stop_node(0)
+        with node.assert_debug_log(expected_msgs=["No block index snapshot matching the block index database"]):
+            self.start_node(0)
+        assert_equal(node.getbestblockhash(), best_block)
+
+        self.log.info("A corrupt snapshot is not used")
+        self.stop_node(0)
+        with open(snapshot_path, "r+b") as f:
+            f.seek(100)
+            byte = f.read(1)
+            f.seek(100)
+            f.write(bytes([byte[0] ^ 0xff]))
+        with node.assert_debug_log(expected_msgs=["block index snapshot checksum mismatch"]):
+            self.start_node(0)
+        assert_equal(node.getbestblockhash(), best_block)
+
+
+if __name__ == '__main__':
+    BlockIndexSnapshotTest(__file__).main()
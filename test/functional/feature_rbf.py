@@ -10,6 +10,7 @@ from test_framework.messages import (
     MAX_BIP125_RBF_SEQUENCE,
     COIN,
     SEQUENCE_FINAL,
+    tx_from_hex,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -322,7 +323,7 @@ class ReplaceByFeeTest(BitcoinTestFramework):
         confirmed_utxo = self.make_utxo(self.nodes[0], int(1.1 * COIN))
         unconfirmed_utxo = self.make_utxo(self.nodes[0], int(0.1 * COIN), confirmed=False)
 
-        self.wallet.send_self_transfer(
+        tx1 = self.wallet.send_self_transfer(
             from_node=self.nodes[0],
             utxo_to_spend=confirmed_utxo,
             sequence=0,
@@ -338,6 +339,16 @@ class ReplaceByFeeTest(BitcoinTestFramework):
         # This will raise an exception
         assert_raises_rpc_error(-26, "replacement-adds-unconfirmed", self.nodes[0].sendrawtransaction, tx2_hex, 0)
 
+        # Once the original has a child paying more than the replacement, the replacement also
+        # fails Rule #3, but it is still reported for adding a new unconfirmed input.
+        self.wallet.send_self_transfer(
+            from_node=self.nodes[0],
+            utxo_to_spend=tx1["new_utxo"],
+            sequence=0,
+            fee=Decimal("0.5"),
+        )
+        assert_raises_rpc_error(-26, "replacement-adds-unconfirmed", self.nodes[0].sendrawtransaction, tx2_hex, 0)
+
     def test_too_many_replacements(self):
         """Replacements that evict too many transactions are rejected"""
         # Try directly replacing more than MAX_REPLACEMENT_LIMIT
@@ -420,6 +431,7 @@ class ReplaceByFeeTest(BitcoinTestFramework):
             # "Root" utxos of each txn graph that we will attempt to double-spend with
             # an RBF replacement.
             root_utxos = []
+            root_txids = []
 
             # For each root UTXO, create a package that contains the spend of that
             # UTXO and `txs_per_graph` children tx.
@@ -433,6 +445,7 @@ class ReplaceByFeeTest(BitcoinTestFramework):
                     num_outputs=txs_per_graph,
                 )
                 assert_equal(True, normal_node.getmempoolentry(optin_parent_tx['txid'])['bip125-replaceable'])
+                root_txids.append(optin_parent_tx['txid'])
                 new_utxos = optin_parent_tx['new_utxos']
 
                 for utxo in new_utxos:
@@ -461,6 +474,19 @@ class ReplaceByFeeTest(BitcoinTestFramework):
             if failure_expected:
                 assert_raises_rpc_error(
                     -26, "too many potential replacements", normal_node.sendrawtransaction, tx_hex, 0)
+
+                # A replacement paying a higher feerate than the roots, but less than a root
+                # with its descendants, also fails Rule #3. It is still reported for Rule #5.
+                root_entry = normal_node.getmempoolentry(root_txids[0])
+                replacement_vsize = tx_from_hex(tx_hex).get_vsize()
+                low_fee = int(2 * root_entry['fees']['base'] * COIN * replacement_vsize / root_entry['vsize'])
+                assert low_fee < root_entry['fees']['descendant'] * COIN
+                low_fee_hex = wallet.create_self_transfer_multi(
+                    utxos_to_spend=root_utxos,
+                    fee_per_output=low_fee,
+                )["hex"]
+                assert_raises_rpc_error(
+                    -26, "too many potential replacements", normal_node.sendrawtransaction, low_fee_hex, 0)
             else:
                 txid = normal_node.sendrawtransaction(tx_hex, 0)
                 assert normal_node.getmempoolentry(txid)
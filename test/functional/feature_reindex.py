@@ -7,7 +7,7 @@
 - Start a single node and generate 3 blocks.
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
-- Verify that out-of-order blocks are correctly processed, see LoadExternalBlockFile()
+- Verify that out-of-order blocks are correctly processed, see ChainstateManager::ImportBlock()
 """
 
 from test_framework.test_framework import BitcoinTestFramework
@@ -69,8 +69,8 @@ class ReindexTest(BitcoinTestFramework):
 
         # The reindexing code should detect and accommodate out of order blocks.
         with self.nodes[0].assert_debug_log([
-            'LoadExternalBlockFile: Out of order block',
-            'LoadExternalBlockFile: Processing out of order child',
+            'ImportBlock: Out of order block',
+            'ImportBlock: Processing out of order child',
         ]):
             extra_args = [["-reindex"]]
             self.start_nodes(extra_args)
@@ -385,9 +385,46 @@ class RESTTest (BitcoinTestFramework):
         resp = self.test_rest_request("/mempool/contents", ret_type=RetType.OBJ, status=400, query_params={"verbose": "false", "mempool_sequence": "TRUE"})
         assert_equal(resp.read().decode('utf-8').strip(), 'The "mempool_sequence" query parameter must be either "true" or "false".')
 
+        # Start following the mempool, this resets to the full contents first
+        deltas = self.test_rest_request("/mempool/deltas")
+        assert_equal(deltas['reset'], True)
+        assert_equal(set(deltas['txs']), set(txs))
+        for tx in txs:
+            assert_equal(deltas['txs'][tx]['fee'], raw_mempool_verbose[tx]['fees']['base'])
+            assert_equal(deltas['txs'][tx]['ancestorcount'], raw_mempool_verbose[tx]['ancestorcount'])
+        assert_equal(deltas['deltas'], [])
+
+        resp = self.test_rest_request("/mempool/deltas", ret_type=RetType.OBJ, status=400, query_params={"since": "-1"})
+        assert_equal(resp.read().decode('utf-8').strip(), 'The "since" query parameter must be a non-negative integer.')
+        resp = self.test_rest_request("/mempool/deltas", ret_type=RetType.OBJ, status=400, query_params={"journal_id": "xyz"})
+        assert_equal(resp.read().decode('utf-8').strip(), 'The "journal_id" query parameter must be 16 hex characters.')
+
+        # Prioritising a transaction updates it and its descendant
+        self.nodes[0].prioritisetransaction(txid=txs[1], fee_delta=1000)
+        updates = self.test_rest_request("/mempool/deltas", query_params={"since": deltas['next'], "journal_id": deltas['journal_id']})
+        assert_equal(updates['reset'], False)
+        assert_equal([(d['type'], d['txid']) for d in updates['deltas']], [('updated', txs[1]), ('updated', txs[2])])
+        for d in updates['deltas']:
+            entry = self.nodes[0].getmempoolentry(d['txid'])
+            assert_equal(d['modifiedfee'], entry['fees']['modified'])
+            assert_equal(d['ancestorfees'], entry['fees']['ancestor'])
+        assert_equal(updates['deltas'][0]['modifiedfee'], updates['deltas'][0]['fee'] + Decimal("0.00001"))
+
         # Now mine the transactions
         newblockhash = self.generate(self.nodes[1], 1)
 
+        # Only the removals are returned when continuing from the previous reply
+        follow_up = self.test_rest_request("/mempool/deltas", query_params={"since": updates['next'], "journal_id": updates['journal_id']})
+        assert_equal(follow_up['reset'], False)
+        assert 'txs' not in follow_up
+        assert_equal([d['type'] for d in follow_up['deltas']], ['removed'] * 3)
+        assert_equal({d['txid'] for d in follow_up['deltas']}, set(txs))
+        assert_equal({d['reason'] for d in follow_up['deltas']}, {'block'})
+        assert_equal([d['sequence'] for d in follow_up['deltas']], list(range(updates['next'], updates['next'] + 3)))
+        assert_equal(follow_up['next'], updates['next'] + 3)
+        # A different journal starts over
+        assert_equal(self.test_rest_request("/mempool/deltas", query_params={"since": follow_up['next'], "journal_id": "0" * 16})['reset'], True)
+
         # Check if the 3 tx show up in the new block
         json_obj = self.test_rest_request(f"/block/{newblockhash[0]}")
         non_coinbase_txs = {tx['txid'] for tx in json_obj['tx']
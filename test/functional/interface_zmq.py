@@ -20,6 +20,7 @@ from test_framework.blocktools import (
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.messages import (
+    COIN,
     CBlock,
     hash256,
     tx_from_hex,
@@ -80,6 +81,27 @@ class ZMQSubscriber:
             assert label == "D" or label == "C"
         return (hash, label, mempool_sequence)
 
+    def receive_mempool_delta(self):
+        body = self._receive_from_publisher_and_check()
+        delta_sequence = struct.unpack("<Q", body[:8])[0]
+        label = chr(body[8])
+        if label == "L":
+            assert_equal(len(body), 8+1)
+            return (delta_sequence, label, None, None)
+        assert label in ("A", "R", "U")
+        assert_equal(len(body), 8+1+32+8+8+4+8+8+8)
+        hash = body[9:41].hex()
+        fee, modified_fee, vsize, ancestor_count, ancestor_size, ancestor_fees = struct.unpack("<qqiQqq", body[41:])
+        info = {
+            "fee": fee,
+            "modifiedfee": modified_fee,
+            "vsize": vsize,
+            "ancestorcount": ancestor_count,
+            "ancestorsize": ancestor_size,
+            "ancestorfees": ancestor_fees,
+        }
+        return (delta_sequence, label, hash, info)
+
 
 class ZMQTestSetupBlock:
     """Helper class for setting up a ZMQ test via the "sync up" procedure.
@@ -127,6 +149,7 @@ class ZMQTest (BitcoinTestFramework):
                 self.log.info("Skipping ipc test, because UNIX sockets are not supported.")
             self.test_sequence()
             self.test_mempool_sync()
+            self.test_mempool_delta()
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
@@ -557,6 +580,92 @@ class ZMQTest (BitcoinTestFramework):
 
         self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE)
 
+    def test_mempool_delta(self):
+        self.log.info("Testing 'mempooldelta' publisher")
+        address = f"tcp://127.0.0.1:{self.zmq_port_base}"
+        socket = self.ctx.socket(zmq.SUB)
+        delta = ZMQSubscriber(socket, b"mempooldelta")
+        self.restart_node(0, [f"-zmqpubmempooldelta={address}"])
+        socket.connect(address)
+
+        # Blocks without mempool transactions are not published on this topic, so
+        # unlike setup_zmq_test(), sync up by sending transactions until the last
+        # one sent is received.
+        socket.set(zmq.RCVTIMEO, 1000)
+        while True:
+            txid = self.wallet.send_self_transfer(from_node=self.nodes[0])["txid"]
+            try:
+                delta_seq, label, hash_str, _ = delta.receive_mempool_delta()
+                while hash_str != txid:
+                    self.log.debug("Ignoring sync-up notification for previously sent transaction.")
+                    delta_seq, label, hash_str, _ = delta.receive_mempool_delta()
+                break
+            except zmq.error.Again:
+                self.log.debug("Didn't receive sync-up notification, trying again.")
+        socket.set(zmq.RCVTIMEO, 60000)
+        assert_equal(label, "A")
+        next_delta_seq = delta_seq + 1
+
+        def check_delta(expected_label, expected_txid, entry=None):
+            nonlocal next_delta_seq
+            delta_seq, label, hash_str, info = delta.receive_mempool_delta()
+            assert_equal((delta_seq, label, hash_str), (next_delta_seq, expected_label, expected_txid))
+            next_delta_seq += 1
+            if entry is not None:
+                assert_equal(info["fee"], entry["fees"]["base"] * COIN)
+                assert_equal(info["modifiedfee"], entry["fees"]["modified"] * COIN)
+                assert_equal(info["vsize"], entry["vsize"])
+                assert_equal(info["ancestorcount"], entry["ancestorcount"])
+                assert_equal(info["ancestorsize"], entry["ancestorsize"])
+                assert_equal(info["ancestorfees"], entry["fees"]["ancestor"] * COIN)
+            return info
+
+        self.log.info("Testing mempooldelta additions with fees and ancestor state")
+        parent = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        child = self.wallet.send_self_transfer(from_node=self.nodes[0], utxo_to_spend=parent["new_utxo"])
+        check_delta("A", parent["txid"], self.nodes[0].getmempoolentry(parent["txid"]))
+        child_info = check_delta("A", child["txid"], self.nodes[0].getmempoolentry(child["txid"]))
+        assert_equal(child_info["ancestorcount"], 2)
+
+        self.log.info("Testing mempooldelta replacement")
+        replacement = self.wallet.create_self_transfer(utxo_to_spend=parent["new_utxo"], fee=child["fee"] * 10)
+        self.wallet.get_utxo(txid=child["txid"])
+        self.wallet.sendrawtransaction(from_node=self.nodes[0], tx_hex=replacement["hex"])
+        # The replaced transaction is removed before its replacement is added
+        check_delta("R", child["txid"])
+        check_delta("A", replacement["txid"], self.nodes[0].getmempoolentry(replacement["txid"]))
+
+        self.log.info("Testing mempooldelta updates after prioritisetransaction")
+        self.nodes[0].prioritisetransaction(txid=parent["txid"], fee_delta=1000)
+        # The prioritised transaction is updated, then its descendants
+        parent_info = check_delta("U", parent["txid"], self.nodes[0].getmempoolentry(parent["txid"]))
+        assert_equal(parent_info["modifiedfee"], parent_info["fee"] + 1000)
+        replacement_info = check_delta("U", replacement["txid"], self.nodes[0].getmempoolentry(replacement["txid"]))
+        assert_equal(replacement_info["ancestorfees"], parent_info["modifiedfee"] + replacement_info["modifiedfee"])
+
+        self.log.info("Testing mempooldelta removals for block inclusion")
+        mempool = set(self.nodes[0].getrawmempool())
+        self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)
+        removed = set()
+        for _ in range(len(mempool)):
+            delta_seq, label, hash_str, _ = delta.receive_mempool_delta()
+            assert_equal((delta_seq, label), (next_delta_seq, "R"))
+            next_delta_seq += 1
+            removed.add(hash_str)
+        assert_equal(removed, mempool)
+        assert_equal(self.nodes[0].getrawmempool(), [])
+
+        # Blocks without mempool transactions don't cause messages, so the next
+        # one is the next change
+        self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)
+        final_txid = self.wallet.send_self_transfer(from_node=self.nodes[0])["txid"]
+        check_delta("A", final_txid, self.nodes[0].getmempoolentry(final_txid))
+        self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)
+        check_delta("R", final_txid)
+
+        self.connect_nodes(0, 1)
+        self.sync_blocks()
+
     def test_multiple_interfaces(self):
         # Set up two subscribers with different addresses
         # (note that after the reorg test, syncing would fail due to different
@@ -142,6 +142,39 @@ class PackageRelayTest(BitcoinTestFramework):
         assert low_fee_parent["txid"] in node_mempool
         assert high_fee_child["txid"] in node_mempool
 
+    @cleanup
+    def test_orphan_parent_then_child(self):
+        node = self.nodes[0]
+
+        high_fee_grandparent = self.wallet.create_self_transfer(fee_rate=20*FEERATE_1SAT_VB, confirmed_only=True)
+        low_fee_parent = self.wallet.create_self_transfer(utxo_to_spend=high_fee_grandparent["new_utxo"], fee_rate=FEERATE_1SAT_VB)
+        high_fee_child = self.wallet.create_self_transfer(utxo_to_spend=low_fee_parent["new_utxo"], fee_rate=20*FEERATE_1SAT_VB)
+
+        peer_sender = node.add_p2p_connection(P2PInterface())
+
+        # 1. Child is received first. It is missing an input.
+        peer_sender.send_and_ping(msg_tx(high_fee_child["tx"]))
+
+        # 2. Node requests the missing parent, which is also missing an input. Both are now orphans.
+        peer_sender.wait_for_getdata([int(low_fee_parent["txid"], 16)])
+        peer_sender.send_and_ping(msg_tx(low_fee_parent["tx"]))
+        assert low_fee_parent["txid"] not in node.getrawmempool()
+
+        # 3. Node requests the grandparent, which is accepted on its own. Reconsidering the parent
+        # fails for being too low feerate, so it is submitted as a package with the orphaned child.
+        peer_sender.wait_for_getdata([int(high_fee_grandparent["txid"], 16)])
+        with node.assert_debug_log(expected_msgs=[
+            f"invalid orphan tx {low_fee_parent['txid']}",
+            f"package evaluation for parent {low_fee_parent['txid']}",
+        ]):
+            peer_sender.send_and_ping(msg_tx(high_fee_grandparent["tx"]))
+
+        # 4. All three transactions should now be in mempool.
+        node_mempool = node.getrawmempool()
+        assert high_fee_grandparent["txid"] in node_mempool
+        assert low_fee_parent["txid"] in node_mempool
+        assert high_fee_child["txid"] in node_mempool
+
     @cleanup
     def test_low_and_high_child(self, wallet):
         node = self.nodes[0]
@@ -399,6 +432,9 @@ class PackageRelayTest(BitcoinTestFramework):
         self.log.info("Check opportunistic 1p1c logic when child is received before parent")
         self.test_basic_child_then_parent()
 
+        self.log.info("Check opportunistic 1p1c logic when the parent is an orphan when the child arrives")
+        self.test_orphan_parent_then_child()
+
         self.log.info("Check opportunistic 1p1c logic when 2 candidate children exist (parent txid != wtxid)")
         self.test_low_and_high_child(self.wallet)
 
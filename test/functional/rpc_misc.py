@@ -14,6 +14,7 @@ from test_framework.util import (
 )
 
 from test_framework.authproxy import JSONRPCException
+from test_framework.test_node import ErrorMatch
 
 
 class RpcMiscTest(BitcoinTestFramework):
@@ -100,6 +101,36 @@ class RpcMiscTest(BitcoinTestFramework):
         # Specifying an unknown index name returns an empty result
         assert_equal(node.getindexinfo("foo"), {})
 
+        self.log.info("test getdbinfo and -dboption")
+        self.restart_node(0, ["-txindex", "-blockfilterindex", "-coinstatsindex", "-dboption=txindex:block_size=65536", "-dboption=chainstate:bloom_filter_bits=0"])
+        self.wait_until(lambda: all(i["synced"] for i in node.getindexinfo().values()))
+        dbinfo = node.getdbinfo()
+        assert_equal(
+            {name: info["profile"] for name, info in dbinfo.items()},
+            {
+                "chainstate": "chainstate",
+                "blockindex": "blockindex",
+                "txindex": "txindex",
+                "basic block filter index": "blockfilterindex",
+                "coinstatsindex": "coinstatsindex",
+            }
+        )
+        assert_equal(dbinfo["txindex"]["block_size"], 65536)
+        assert_equal(dbinfo["chainstate"]["bloom_filter_bits"], 0)
+        assert_equal(dbinfo["blockindex"]["block_size"], 4096)
+        assert_equal(dbinfo["blockindex"]["bloom_filter_bits"], 10)
+        for info in dbinfo.values():
+            assert_equal(len(info["levels"]), 7)
+            assert_equal(info["approximate_bytes"] > 0, any(level["files"] > 0 for level in info["levels"]))
+            assert_equal(info["read_amplification"], info["levels"][0]["files"] + sum(1 for level in info["levels"][1:] if level["files"] > 0))
+        assert_equal(list(node.getdbinfo("txindex").keys()), ["txindex"])
+        assert_equal(node.getdbinfo("foo"), {})
+
+        self.stop_node(0)
+        self.nodes[0].assert_start_raises_init_error(["-dboption=txindex:compression=1"], "Error: Unknown option 'compression' in -dboption", match=ErrorMatch.PARTIAL_REGEX)
+        self.nodes[0].assert_start_raises_init_error(["-dboption=wallet:block_size=4096"], "Error: Unknown database 'wallet' in -dboption", match=ErrorMatch.PARTIAL_REGEX)
+        self.start_node(0)
+
 
 if __name__ == '__main__':
     RpcMiscTest(__file__).main()
@@ -162,6 +162,8 @@ class NetTest(BitcoinTestFramework):
                 "network": "not_publicly_routable",
                 "permissions": [],
                 "presynced_headers": -1,
+                "processing_time": {"count": 0, "total": 0, "cs_main_wait": 0, "tx_download_wait": 0},
+                "processing_time_per_msg": {},
                 "relaytxes": False,
                 "services": "0000000000000000",
                 "servicesnames": [],
@@ -85,6 +85,7 @@ class RawTransactionsTest(BitcoinTestFramework):
         self.wallet = MiniWallet(self.nodes[0])
 
         self.getrawtransaction_tests()
+        self.getrawtransactions_tests()
         self.createrawtransaction_tests()
         self.sendrawtransaction_tests()
         self.sendrawtransaction_testmempoolaccept_tests()
@@ -181,6 +182,31 @@ class RawTransactionsTest(BitcoinTestFramework):
         block = self.nodes[0].getblock(self.nodes[0].getblockhash(0))
         assert_raises_rpc_error(-5, "The genesis block coinbase is not considered an ordinary transaction", self.nodes[0].getrawtransaction, block['merkleroot'])
 
+    def getrawtransactions_tests(self):
+        self.log.info("Test getrawtransactions")
+        confirmed = [self.wallet.send_self_transfer(from_node=self.nodes[0]) for _ in range(3)]
+        self.generate(self.nodes[0], 1)
+        mempool_tx = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        unknown = "00" * 32
+        txids = [confirmed[2]['txid'], unknown, mempool_tx['txid'], confirmed[0]['txid'], confirmed[1]['txid'], confirmed[0]['txid']]
+        hexes = [confirmed[2]['hex'], None, mempool_tx['hex'], confirmed[0]['hex'], confirmed[1]['hex'], confirmed[0]['hex']]
+        assert_equal(self.nodes[0].getrawtransactions(txids), hexes)
+        assert_equal(self.nodes[0].getrawtransactions(txids, 0), hexes)
+        # Repeated calls are served from the transaction cache.
+        verbose = self.nodes[0].getrawtransactions(txids=txids, verbosity=1)
+        assert_equal(verbose, self.nodes[0].getrawtransactions(txids, True))
+        assert_equal([tx['hex'] if tx else None for tx in verbose], hexes)
+        for tx in verbose:
+            if tx and tx['txid'] != mempool_tx['txid']:
+                assert_equal(tx, self.nodes[0].getrawtransaction(tx['txid'], 1))
+        assert 'blockhash' not in verbose[2]
+        assert_equal(self.nodes[0].getrawtransactions([]), [])
+
+        assert_raises_rpc_error(-8, "Verbosity must be 0 or 1", self.nodes[0].getrawtransactions, txids, 2)
+        assert_raises_rpc_error(-8, "txids[0] must be of length 64", self.nodes[0].getrawtransactions, ["abcd"])
+        assert_raises_rpc_error(-1, "getrawtransactions requires -txindex", self.nodes[2].getrawtransactions, txids)
+        self.generate(self.nodes[0], 1)
+
     def getrawtransaction_verbosity_tests(self):
         tx = self.wallet.send_self_transfer(from_node=self.nodes[1])['txid']
         [block1] = self.generate(self.nodes[1], 1)
@@ -289,6 +289,7 @@ BASE_SCRIPTS = [
     'mempool_package_rbf.py',
     'feature_versionbits_warning.py',
     'feature_blocksxor.py',
+    'feature_blockindex_snapshot.py',
     'rpc_preciousblock.py',
     'wallet_importprunedfunds.py --legacy-wallet',
     'wallet_importprunedfunds.py --descriptors',